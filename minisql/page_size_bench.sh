@@ -0,0 +1,9 @@
+# build with every supported page size and compare insert, point lookup and range scan throughput
+# build directories are bench_build_<page size>, pass -jN or other build options as arguments
+for page_size in 4096 8192 16384 32768; do
+  build_dir="bench_build_${page_size}"
+  cmake -S . -B "${build_dir}" -DCMAKE_BUILD_TYPE=Release -DMINISQL_PAGE_SIZE="${page_size}" > /dev/null || exit 1
+  cmake --build "${build_dir}" --target minisql_test "$@" > /dev/null || exit 1
+  (cd "${build_dir}/test" && ./minisql_test --gtest_also_run_disabled_tests \
+    --gtest_filter=BPlusTreeTests.DISABLED_PageSizeBenchmark | grep "page size")
+done
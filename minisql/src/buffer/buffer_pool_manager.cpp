@@ -1,219 +1,247 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
 
-static const char EMPTY_PAGE_DATA[PAGE_SIZE] = {0};
+BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances,
+                                     ReplacerType replacer_type)
+    : BufferPoolManager(new SharedBufferPool(pool_size, num_instances, replacer_type), disk_manager) {
+  owned_pool_.reset(pool_);
+}
 
-BufferPoolManager::BufferPoolManager(size_t pool_size, DiskManager *disk_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager) {
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size_);
-  for (size_t i = 0; i < pool_size_; i++) {
-    free_list_.emplace_back(i);
+BufferPoolManager::BufferPoolManager(SharedBufferPool *pool, DiskManager *disk_manager)
+    : pool_(pool), disk_manager_(disk_manager) {
+  file_id_ = pool_->AttachFile(disk_manager_);
+  if (file_id_ == INVALID_FILE_ID) {
+    throw std::length_error("Too many databases attached to the buffer pool.");
+  }
+  if (disk_manager_->IsReadOnly()) {
+    // The file cannot grow, so every page it will ever have exists already.
+    for (page_id_t page_id = 0; page_id < MAX_VALID_PAGE_ID; page_id++) {
+      const char *data = disk_manager_->GetMappedPage(page_id);
+      if (data == nullptr) {
+        break;
+      }
+      mapped_pages_.emplace_back(const_cast<char *>(data));
+    }
   }
 }
 
 BufferPoolManager::~BufferPoolManager() {
-  for (auto page : page_table_) {
-    FlushPage(page.first);
+  if (warmup_.joinable()) {
+    warmup_stop_ = true;
+    warmup_.join();
+  }
+  if (!detached_) {
+    pool_->DetachFile(file_id_);
   }
-  delete[] pages_;
-  delete replacer_;
 }
 
-/**
- * TODO: Student Implement
- */
+void BufferPoolManager::Discard() {
+  if (warmup_.joinable()) {
+    warmup_stop_ = true;
+    warmup_.join();
+  }
+  pool_->DetachFile(file_id_, true);
+  detached_ = true;
+}
+
 Page *BufferPoolManager::FetchPage(page_id_t page_id) {
-  // 1.     Search the page table for the requested page (P).
-  // 1.1    If P exists, pin it and return it immediately.
-  // 1.2    If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  //        Note that pages are always found from the free list first.
-  // 2.     If R is dirty, write it back to the disk.
-  // 3.     Delete R from the page table and insert P.
-  // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  frame_id_t frame_id_temp;
   if (page_id >= MAX_VALID_PAGE_ID || page_id <= INVALID_PAGE_ID) {
     return nullptr;
   }
-  bool found = false;
-  // search the table to get the requested page
-  for (auto it = page_table_.begin(); it != page_table_.end(); it++) {
-    if (it->first == page_id) {
-      frame_id_temp = it->second;
-      found = true;
-      break;
-    }
+  if (IsReadOnly()) {
+    return static_cast<size_t>(page_id) < mapped_pages_.size() ? &mapped_pages_[page_id] : nullptr;
   }
-  // if P exisit pin it  and  return it immediately
- if (found == true) {
-   frame_id_temp = page_table_[page_id];
-   replacer_->Pin(frame_id_temp);
-   //pin it
-   pages_[frame_id_temp].pin_count_ = 1;
-   return &pages_[frame_id_temp];
- }
-  //If P does not exist, find a replacement page (R) from either the free list or the replacer.
-  if (free_list_.size() == 0 && replacer_->Size() == 0) {
+  return pool_->FetchPage(file_id_, page_id);
+}
+
+Page *BufferPoolManager::FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (page_id >= MAX_VALID_PAGE_ID || page_id <= INVALID_PAGE_ID) {
     return nullptr;
   }
-  else if (free_list_.size() > 0) {
-    frame_id_temp = free_list_.front();
-    free_list_.pop_front();
-    page_table_[page_id] = frame_id_temp; // insert in to it
-    disk_manager_->ReadPage(page_id , pages_[frame_id_temp].data_);
-    //replacer_->Pin(frame_id_temp);
-    pages_[frame_id_temp].pin_count_ = 1;
-    pages_[frame_id_temp].page_id_ = page_id;
-    return &pages_[frame_id_temp];
+  if (IsReadOnly()) {
+    return FetchPage(page_id);
   }
-  else {
-   if ( replacer_->Victim(&frame_id_temp) == false)
-      return nullptr; // get the newline
-
-
-    page_id_t old_page_id = pages_[frame_id_temp].page_id_;
-    if (old_page_id != INVALID_PAGE_ID) {
-      page_table_.erase(old_page_id); // 删除旧映射
-      }
-    if (pages_[frame_id_temp].is_dirty_ == true) {
-      disk_manager_->WritePage(pages_[frame_id_temp].GetPageId() , pages_[frame_id_temp].GetData());
+  return pool_->FetchPage(file_id_, page_id, strategy);
+}
 
-    }
-    pages_[frame_id_temp].page_id_ = page_id;
-    pages_[frame_id_temp].pin_count_ = 1;
-    page_table_[page_id] = frame_id_temp;
-    disk_manager_->ReadPage(page_id , pages_[frame_id_temp].data_);
-    return &pages_[frame_id_temp];
-  }
-  return nullptr;
-}
-
-/**
- * TODO: Student Implement
- */
-Page *BufferPoolManager::NewPage(page_id_t &page_id) {
-  // 0.   Make sure you call AllocatePage!
-  // 1.   If all the pages in the buffer pool are pinned, return nullptr.
-  // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
-  // 3.   Update P's metadata, zero out memory and add P to the page table.
-  // 4.   Set the page ID output parameter. Return a pointer to P.
-  // all things are pined
-  frame_id_t frame_id_temp;
-  if (free_list_.size() == 0 && replacer_->Size() == 0) {
+Page *BufferPoolManager::NewPage(page_id_t &page_id, PageSegment *segment) {
+  // The owning instance is only known once the page id is allocated, so hand the id back if that instance turns out
+  // to have every frame pinned. The bitmap reuses the freed slot first, keeping page ids dense.
+  page_id_t new_page_id = AllocatePage(segment);
+  if (new_page_id == INVALID_PAGE_ID) {
     return nullptr;
-  }else if (free_list_.size() > 0) {
-    frame_id_temp = free_list_.front();
-    free_list_.pop_front();
-  }else {
-    if (replacer_->Victim(&frame_id_temp) == false)
-      return nullptr;
-    if (pages_[frame_id_temp].IsDirty() == true) {
-      disk_manager_->WritePage(pages_[frame_id_temp].GetPageId() , pages_[frame_id_temp].data_);
-      pages_[frame_id_temp].is_dirty_ = false;
-    }
-   page_table_.erase(pages_[frame_id_temp].GetPageId());
   }
-  page_id = AllocatePage();
-  pages_[frame_id_temp].ResetMemory();
-  pages_[frame_id_temp].page_id_ = page_id;
-  pages_[frame_id_temp].pin_count_ = 1;
-  pages_[frame_id_temp].is_dirty_ = false;
-  page_table_[page_id] = frame_id_temp;
-
-
-  return &pages_[frame_id_temp];
+  Page *page = pool_->NewPage(file_id_, new_page_id);
+  if (page == nullptr) {
+    DeallocatePage(new_page_id);
+    return nullptr;
+  }
+  page_id = new_page_id;
+  return page;
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::DeletePage(page_id_t page_id) {
-  // 0.   Make sure you call DeallocatePage!
-  // 1.   Search the page table for the requested page (P).
-  // 1.   If P does not exist, return true.
-  // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
-  // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  bool found = false;
-  frame_id_t frame_id_temp;
-  if (page_id == INVALID_PAGE_ID) {
-    return  true;
-  }
-  if (page_id > MAX_VALID_PAGE_ID || page_id < INVALID_PAGE_ID) {
+  if (page_id >= MAX_VALID_PAGE_ID || page_id <= INVALID_PAGE_ID) {
     return true;
   }
-  for (auto it = page_table_.begin(); it != page_table_.end(); it++) {
-    if (it->first == page_id) {
-      found = true;
-      frame_id_temp = it->second;
-
-      break;
-    }
+  if (IsReadOnly()) {
+    return false;
   }
-  // iF P dosen't exit return true
-  if (found == false) {
-    return true;
-  }else {
-    if (pages_[frame_id_temp].pin_count_ > 0) {
-      return false;
-    }else {
-      page_table_.erase(page_id);
-
-      pages_[frame_id_temp].ResetMemory();
-      pages_[frame_id_temp].page_id_ =  INVALID_PAGE_ID;
-      pages_[frame_id_temp].is_dirty_ = false;
-      // we can delete it
-      free_list_.push_back(frame_id_temp);
-      DeallocatePage(page_id);
-
-
-      return true;
-
-    }
-
+  if (!pool_->DeletePage(file_id_, page_id)) {
+    return false;
   }
+  DeallocatePage(page_id);
+  return true;
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::UnpinPage(page_id_t page_id, bool is_dirty) {
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  if (page_table_.count(page_id) == 0) {
-    return false;
-  }
-  frame_id_t frame_id_temp = page_table_[page_id];
-  if (pages_[frame_id_temp].GetPinCount() == 0) {
-    return false;
+  if (IsReadOnly()) {
+    // Mapped pages are neither pinned nor written back.
+    return true;
   }
-  pages_[frame_id_temp].pin_count_--;
-  replacer_->Unpin(frame_id_temp);
-
-  pages_[frame_id_temp].is_dirty_ = is_dirty;
-  return true;
+  return pool_->UnpinPage(file_id_, page_id, is_dirty);
 }
 
-/**
- * TODO: Student Implement
- */
 bool BufferPoolManager::FlushPage(page_id_t page_id) {
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
-  if (page_table_.count(page_id) == 0) {
+  if (IsReadOnly()) {
+    return true;
+  }
+  return pool_->FlushPage(file_id_, page_id);
+}
+
+void BufferPoolManager::PrefetchChain(page_id_t start_page_id, size_t depth, NextPageIdFunc next_page_id) {
+  if (IsReadOnly()) {
+    return;
+  }
+  pool_->PrefetchChain(file_id_, start_page_id, depth, std::move(next_page_id));
+}
+
+bool BufferPoolManager::SaveResidentPages(const std::string &file_name) {
+  if (IsReadOnly()) {
     return false;
   }
-  frame_id_t frame_id_temp = page_table_[page_id];
-  disk_manager_->WritePage(page_id , pages_[frame_id_temp].data_);
-  pages_[frame_id_temp].is_dirty_ = false;
-  return true;
+  std::vector<page_id_t> page_ids;
+  pool_->GetResidentPages(file_id_, &page_ids);
+  std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+  uint32_t magic = WARMUP_FILE_MAGIC;
+  uint32_t count = page_ids.size();
+  out.write(reinterpret_cast<const char *>(&magic), sizeof(magic));
+  out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+  out.write(reinterpret_cast<const char *>(page_ids.data()), count * sizeof(page_id_t));
+  return out.good();
+}
+
+void BufferPoolManager::StartWarmUp(const std::string &file_name) {
+  std::ifstream in(file_name, std::ios::binary);
+  if (IsReadOnly() || !in.is_open() || warmup_.joinable()) {
+    return;
+  }
+  uint32_t magic = 0;
+  uint32_t count = 0;
+  in.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  std::vector<page_id_t> page_ids;
+  if (in.good() && magic == WARMUP_FILE_MAGIC) {
+    // Pages beyond the pool size would only be loaded to be evicted again.
+    page_ids.resize(std::min<size_t>(count, pool_->GetPoolSize()));
+    in.read(reinterpret_cast<char *>(page_ids.data()), page_ids.size() * sizeof(page_id_t));
+    if (!in.good()) {
+      page_ids.clear();
+    }
+  }
+  in.close();
+  remove(file_name.c_str());
+  if (page_ids.empty()) {
+    return;
+  }
+  warmup_running_ = true;
+  warmup_ = std::thread([this, page_ids = std::move(page_ids)]() mutable {
+    std::sort(page_ids.begin(), page_ids.end());
+    // The list is only a hint, a page may have been freed by a drop after it was written.
+    page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(),
+                                  [this](page_id_t page_id) {
+                                    return page_id >= MAX_VALID_PAGE_ID || page_id <= INVALID_PAGE_ID ||
+                                           disk_manager_->IsPageFree(page_id);
+                                  }),
+                   page_ids.end());
+    pool_->WarmUp(file_id_, page_ids, warmup_stop_);
+    warmup_running_ = false;
+  });
 }
 
-page_id_t BufferPoolManager::AllocatePage() {
-  int next_page_id = disk_manager_->AllocatePage();
+std::unordered_map<page_id_t, page_id_t> BufferPoolManager::CompactFile() {
+  std::unordered_map<page_id_t, page_id_t> moved;
+  if (IsReadOnly()) {
+    return moved;
+  }
+  // Reserved pages are not worth moving, and the segments would hand out pages that are gone.
+  disk_manager_->ReleaseSegments();
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_manager_->GetMetaData());
+  auto num_pages = static_cast<page_id_t>(meta_page->GetAllocatedPages());
+  auto page_id = static_cast<page_id_t>(meta_page->GetExtentNums() * DiskManager::BITMAP_SIZE);
+  while (page_id-- > num_pages) {
+    if (IsPageFree(page_id)) {
+      continue;
+    }
+    Page *page = FetchPage(page_id);
+    if (page == nullptr) {
+      break;
+    }
+    // NewPage hands out the lowest free page, which lies below num_pages as long as a page above it is allocated.
+    page_id_t new_page_id;
+    Page *new_page = NewPage(new_page_id);
+    if (new_page == nullptr || new_page_id > page_id) {
+      UnpinPage(page_id, false);
+      if (new_page != nullptr) {
+        UnpinPage(new_page_id, false);
+        DeletePage(new_page_id);
+      }
+      break;
+    }
+    memcpy(new_page->GetData(), page->GetData(), PAGE_SIZE);
+    UnpinPage(new_page_id, true);
+    UnpinPage(page_id, false);
+    if (!DeletePage(page_id)) {
+      // Still pinned by someone, it stays where it is.
+      DeletePage(new_page_id);
+      continue;
+    }
+    moved.emplace(page_id, new_page_id);
+  }
+  return moved;
+}
+
+uint64_t BufferPoolManager::TruncateFile() {
+  if (IsReadOnly()) {
+    return 0;
+  }
+  FlushAllPages();
+  return disk_manager_->Truncate();
+}
+
+std::shared_ptr<PageSegment> BufferPoolManager::CreateSegment() {
+  DiskManager *disk_manager = disk_manager_;
+  return std::shared_ptr<PageSegment>(new PageSegment(), [disk_manager](PageSegment *segment) {
+    disk_manager->ReleaseSegment(segment);
+    delete segment;
+  });
+}
+
+page_id_t BufferPoolManager::AllocatePage(PageSegment *segment) {
+  int next_page_id = segment == nullptr ? disk_manager_->AllocatePage() : disk_manager_->AllocatePage(segment);
   return next_page_id;
 }
 
@@ -224,15 +252,3 @@ void BufferPoolManager::DeallocatePage(__attribute__((unused)) page_id_t page_id
 bool BufferPoolManager::IsPageFree(page_id_t page_id) {
   return disk_manager_->IsPageFree(page_id);
 }
-
-// Only used for debug
-bool BufferPoolManager::CheckAllUnpinned() {
-  bool res = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].pin_count_ != 0) {
-      res = false;
-      LOG(ERROR) << "page " << pages_[i].page_id_ << " pin count:" << pages_[i].pin_count_ << endl;
-    }
-  }
-  return res;
-}
\ No newline at end of file
@@ -0,0 +1,619 @@
+#include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "glog/logging.h"
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, BufferPoolFiles *files,
+                                                     ReplacerType replacer_type, size_t instance_index,
+                                                     size_t num_instances, bool use_huge_pages)
+    : pool_size_(0),
+      instance_index_(instance_index),
+      num_instances_(num_instances),
+      use_huge_pages_(use_huge_pages),
+      files_(files),
+      file_pages_(BufferPoolFiles::MAX_FILES),
+      file_io_(BufferPoolFiles::MAX_FILES) {
+  switch (replacer_type) {
+    case ReplacerType::LRU:
+      replacer_ = new LRUReplacer(pool_size);
+      break;
+    case ReplacerType::CLOCK:
+      replacer_ = new CLOCKReplacer(pool_size);
+      break;
+    case ReplacerType::LRU_K:
+    default:
+      replacer_ = new LRUKReplacer(pool_size);
+      break;
+  }
+  page_table_.reserve(pool_size);
+  Resize(pool_size);
+}
+
+BufferPoolManagerInstance::~BufferPoolManagerInstance() { delete replacer_; }
+
+Page *BufferPoolManagerInstance::FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy) {
+  std::unique_lock<std::mutex> lock(latch_);
+  page_key_t key = MakePageKey(file_id, page_id);
+  // 1. Search the page table for the requested page, pin it and return it immediately if it exists.
+  auto iter = page_table_.find(key);
+  // The page may have been evicted clean while the background writer still has its last version in flight, reading it
+  // back now would see the version before that.
+  while (iter == page_table_.end() && writing_.count(key) != 0) {
+    io_cv_.wait(lock);
+    iter = page_table_.find(key);
+  }
+  stats_.fetches_++;
+  if (iter != page_table_.end()) {
+    stats_.hits_++;
+    frame_id_t frame_id = iter->second;
+    // The prefetch already recorded an access, counting this one too would make every scanned page look hot.
+    if (prefetched_[frame_id]) {
+      prefetched_[frame_id] = false;
+      stats_.prefetch_used_++;
+    } else {
+      replacer_->RecordAccess(frame_id);
+    }
+    last_access_[frame_id] = ++access_clock_;
+    if (pages_[frame_id]->pin_count_++ == 0) {
+      replacer_->Pin(frame_id);
+      stats_.pinned_frames_++;
+    }
+    return pages_[frame_id];
+  }
+  // 2. Otherwise find a replacement frame from either the free list or the replacer, or from the ring of a scan.
+  frame_id_t frame_id;
+  if (strategy != nullptr ? !GetRingFrame(strategy, file_id, page_id, &frame_id)
+                          : !GetVictimFrame(file_id, &frame_id)) {
+    return nullptr;
+  }
+  // 3. Update the frame's metadata and read in the page content from disk.
+  Page &page = *pages_[frame_id];
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  DiskManager *disk_manager = files_->GetDiskManager(file_id);
+  if (stats_.misses_++ % BufferPoolStats::READ_LATENCY_SAMPLE_RATE == 0) {
+    auto start = std::chrono::steady_clock::now();
+    disk_manager->ReadPage(page_id, page.data_);
+    stats_.read_latency_.Record(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+  } else {
+    disk_manager->ReadPage(page_id, page.data_);
+  }
+  stats_.pinned_frames_++;
+  MapPage(frame_id, file_id, page_id);
+  prefetching_.erase(key);
+  replacer_->RecordAccess(frame_id);
+  last_access_[frame_id] = ++access_clock_;
+  return &page;
+}
+
+Page *BufferPoolManagerInstance::NewPage(file_id_t file_id, page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  page_key_t key = MakePageKey(file_id, page_id);
+  // A write of the previous page with this id must not land on top of the new one.
+  io_cv_.wait(lock, [&] { return writing_.count(key) == 0; });
+  frame_id_t frame_id;
+  auto iter = page_table_.find(key);
+  if (iter != page_table_.end()) {
+    // A stale copy of a page that was freed and is now reused, e.g. read ahead while its table was being dropped.
+    frame_id = iter->second;
+    if (pages_[frame_id]->pin_count_ > 0) {
+      return nullptr;
+    }
+    replacer_->Remove(frame_id);
+    if (prefetched_[frame_id]) {
+      prefetched_[frame_id] = false;
+      stats_.prefetch_wasted_++;
+    }
+    UnmapPage(frame_id);
+  } else if (!GetVictimFrame(file_id, &frame_id)) {
+    return nullptr;
+  }
+  Page &page = *pages_[frame_id];
+  page.ResetMemory();
+  page.pin_count_ = 1;
+  // The page does not exist on disk yet.
+  page.is_dirty_ = true;
+  stats_.new_pages_++;
+  stats_.pinned_frames_++;
+  MapPage(frame_id, file_id, page_id);
+  prefetching_.erase(key);
+  replacer_->RecordAccess(frame_id);
+  last_access_[frame_id] = ++access_clock_;
+  return &page;
+}
+
+bool BufferPoolManagerInstance::DeletePage(file_id_t file_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto iter = page_table_.find(MakePageKey(file_id, page_id));
+  if (iter == page_table_.end()) {
+    return true;
+  }
+  frame_id_t frame_id = iter->second;
+  Page &page = *pages_[frame_id];
+  if (page.pin_count_ > 0) {
+    return false;
+  }
+  UnmapPage(frame_id);
+  replacer_->Remove(frame_id);
+  prefetched_[frame_id] = false;
+  stats_.deleted_pages_++;
+  page.ResetMemory();
+  page.is_dirty_ = false;
+  free_list_.push_back(frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  auto iter = page_table_.find(MakePageKey(file_id, page_id));
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  frame_id_t frame_id = iter->second;
+  Page &page = *pages_[frame_id];
+  if (page.pin_count_ <= 0) {
+    return false;
+  }
+  page.is_dirty_ |= is_dirty;
+  if (--page.pin_count_ == 0) {
+    stats_.pinned_frames_--;
+    // A page the background writer is writing back is released by the writer once the write is done.
+    if (IsWriting(frame_id)) {
+      return true;
+    }
+    if (static_cast<size_t>(frame_id) >= pool_size_) {
+      // A shrink is waiting for this frame.
+      RetireFrame(frame_id);
+      retire_cv_.notify_all();
+    } else {
+      replacer_->Unpin(frame_id);
+    }
+  }
+  return true;
+}
+
+bool BufferPoolManagerInstance::FlushPage(file_id_t file_id, page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
+  page_key_t key = MakePageKey(file_id, page_id);
+  // The older version the background writer has in flight must not land on top of this one.
+  io_cv_.wait(lock, [&] { return writing_.count(key) == 0; });
+  auto iter = page_table_.find(key);
+  if (iter == page_table_.end()) {
+    return false;
+  }
+  Page &page = *pages_[iter->second];
+  files_->GetDiskManager(file_id)->WritePage(page_id, page.data_);
+  page.is_dirty_ = false;
+  return true;
+}
+
+page_id_t BufferPoolManagerInstance::PrefetchPage(file_id_t file_id, page_id_t page_id,
+                                                  const NextPageIdFunc &next_page_id) {
+  page_id_t next = INVALID_PAGE_ID;
+  if (BeginPrefetch(file_id, page_id, next_page_id, &next) != PrefetchStart::READ) {
+    return next;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char data[PAGE_SIZE];
+  files_->GetDiskManager(file_id)->ReadPage(page_id, data);
+  next = next_page_id(data);
+  FinishPrefetch(file_id, page_id, data);
+  return next;
+}
+
+PrefetchStart BufferPoolManagerInstance::BeginPrefetch(file_id_t file_id, page_id_t page_id,
+                                                       const NextPageIdFunc &next_page_id,
+                                                       page_id_t *next_page_id_out) {
+  page_key_t key = MakePageKey(file_id, page_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+  if ((*files_)[file_id].detaching_ || files_->GetDiskManager(file_id) == nullptr) {
+    return PrefetchStart::SKIP;
+  }
+  auto iter = page_table_.find(key);
+  if (iter != page_table_.end()) {
+    *next_page_id_out = next_page_id(pages_[iter->second]->data_);
+    return PrefetchStart::RESIDENT;
+  }
+  if (writing_.count(key) != 0 || prefetching_.count(key) != 0) {
+    return PrefetchStart::SKIP;
+  }
+  prefetching_.insert(key);
+  file_io_[file_id]++;
+  return PrefetchStart::READ;
+}
+
+void BufferPoolManagerInstance::FinishPrefetch(file_id_t file_id, page_id_t page_id, const char *data) {
+  page_key_t key = MakePageKey(file_id, page_id);
+  std::scoped_lock<std::mutex> lock(latch_);
+  file_io_[file_id]--;
+  io_cv_.notify_all();
+  // Drop the copy if the page was loaded by someone else while it was being read, it may have been modified and
+  // written back since.
+  if (prefetching_.erase(key) == 0 || data == nullptr) {
+    stats_.prefetch_wasted_++;
+    return;
+  }
+  frame_id_t frame_id;
+  if (!GetVictimFrame(file_id, &frame_id)) {
+    stats_.prefetch_wasted_++;
+    return;
+  }
+  Page &page = *pages_[frame_id];
+  memcpy(page.data_, data, PAGE_SIZE);
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  MapPage(frame_id, file_id, page_id);
+  replacer_->RecordAccess(frame_id);
+  replacer_->Unpin(frame_id);
+  prefetched_[frame_id] = true;
+  last_access_[frame_id] = 0;
+}
+
+bool BufferPoolManagerInstance::WarmUpPage(file_id_t file_id, page_id_t page_id) {
+  page_key_t key = MakePageKey(file_id, page_id);
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (free_list_.empty()) {
+      return false;
+    }
+    if ((*files_)[file_id].detaching_ || page_table_.count(key) != 0 || writing_.count(key) != 0 ||
+        prefetching_.count(key) != 0) {
+      return true;
+    }
+    prefetching_.insert(key);
+    file_io_[file_id]++;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char data[PAGE_SIZE];
+  files_->GetDiskManager(file_id)->ReadPage(page_id, data);
+  std::scoped_lock<std::mutex> lock(latch_);
+  file_io_[file_id]--;
+  io_cv_.notify_all();
+  // Loaded by a query meanwhile, or the frames were all taken while the page was being read.
+  if (prefetching_.erase(key) == 0) {
+    return true;
+  }
+  if (free_list_.empty()) {
+    return false;
+  }
+  size_t max_pages = GetInstanceShare((*files_)[file_id].max_pages_);
+  if (max_pages != 0 && file_pages_[file_id] >= max_pages) {
+    return true;
+  }
+  frame_id_t frame_id = free_list_.front();
+  free_list_.pop_front();
+  Page &page = *pages_[frame_id];
+  memcpy(page.data_, data, PAGE_SIZE);
+  page.pin_count_ = 0;
+  page.is_dirty_ = false;
+  MapPage(frame_id, file_id, page_id);
+  // One access, like a page read once before the restart, the first query that fetches it makes it hot.
+  replacer_->RecordAccess(frame_id);
+  replacer_->Unpin(frame_id);
+  last_access_[frame_id] = 0;
+  stats_.warmed_up_pages_++;
+  return true;
+}
+
+void BufferPoolManagerInstance::GetResidentPages(file_id_t file_id, std::vector<page_id_t> *pages) {
+  std::vector<std::pair<uint64_t, page_id_t>> resident;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    resident.reserve(file_pages_[file_id]);
+    for (const auto &entry : page_table_) {
+      Page *page = pages_[entry.second];
+      if (page->file_id_ == file_id) {
+        resident.emplace_back(last_access_[entry.second], page->page_id_);
+      }
+    }
+  }
+  std::sort(resident.begin(), resident.end(), std::greater<>());
+  for (const auto &entry : resident) {
+    pages->push_back(entry.second);
+  }
+}
+
+size_t BufferPoolManagerInstance::GetNumFilePages(file_id_t file_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return file_pages_[file_id];
+}
+
+size_t BufferPoolManagerInstance::WriteBackDirtyPages(size_t clean_target, size_t max_pages, AsyncDiskManager *aio) {
+  std::vector<std::tuple<file_id_t, page_id_t, const char *>> batch;
+  std::unique_ptr<PageArena> batch_data;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    size_t clean = free_list_.size();
+    for (size_t i = 0; i < pool_size_; i++) {
+      if (pages_[i]->page_id_ != INVALID_PAGE_ID && pages_[i]->pin_count_ == 0 && !pages_[i]->is_dirty_) {
+        clean++;
+      }
+    }
+    if (clean >= clean_target) {
+      return 0;
+    }
+    max_pages = std::min(max_pages, clean_target - clean);
+    // Only unpinned pages are taken, so nobody is modifying them while they are copied.
+    batch_data = std::make_unique<PageArena>(max_pages);
+    for (size_t i = 0; i < pool_size_ && batch.size() < max_pages; i++) {
+      Page &page = *pages_[writer_hand_];
+      if (page.page_id_ != INVALID_PAGE_ID && page.pin_count_ == 0 && page.is_dirty_) {
+        char *data = batch_data->GetPage(batch.size());
+        memcpy(data, page.data_, PAGE_SIZE);
+        batch.emplace_back(page.file_id_, page.page_id_, data);
+        writing_.insert(MakePageKey(page.file_id_, page.page_id_));
+        file_io_[page.file_id_]++;
+        page.is_dirty_ = false;
+        // Not evictable until the write is done, a newer version written back by the eviction could be overwritten.
+        replacer_->Pin(writer_hand_);
+      }
+      writer_hand_ = (writer_hand_ + 1) % pool_size_;
+    }
+  }
+  if (batch.empty()) {
+    return 0;
+  }
+  // One sorted write per file, or all of them in flight at once.
+  std::sort(batch.begin(), batch.end());
+  if (aio != nullptr) {
+    std::vector<std::tuple<DiskManager *, page_id_t, const char *>> requests;
+    requests.reserve(batch.size());
+    for (const auto &page : batch) {
+      requests.emplace_back(files_->GetDiskManager(std::get<0>(page)), std::get<1>(page), std::get<2>(page));
+    }
+    aio->WritePages(requests);
+  } else {
+    std::vector<std::pair<page_id_t, const char *>> file_batch;
+    for (size_t i = 0; i < batch.size(); i++) {
+      file_batch.emplace_back(std::get<1>(batch[i]), std::get<2>(batch[i]));
+      if (i + 1 == batch.size() || std::get<0>(batch[i + 1]) != std::get<0>(batch[i])) {
+        files_->GetDiskManager(std::get<0>(batch[i]))->WritePages(file_batch);
+        file_batch.clear();
+      }
+    }
+  }
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (const auto &page : batch) {
+      page_key_t key = MakePageKey(std::get<0>(page), std::get<1>(page));
+      writing_.erase(key);
+      file_io_[std::get<0>(page)]--;
+      // Give the frame back to the replacer, unless it was pinned or the page was deleted meanwhile.
+      auto iter = page_table_.find(key);
+      if (iter == page_table_.end() || pages_[iter->second]->pin_count_ > 0) {
+        continue;
+      }
+      if (static_cast<size_t>(iter->second) >= pool_size_) {
+        RetireFrame(iter->second);
+        retire_cv_.notify_all();
+      } else {
+        replacer_->Unpin(iter->second);
+      }
+    }
+  }
+  io_cv_.notify_all();
+  return batch.size();
+}
+
+bool BufferPoolManagerInstance::GetVictimFrame(file_id_t file_id, frame_id_t *frame_id) {
+  size_t max_pages = GetInstanceShare((*files_)[file_id].max_pages_);
+  if (max_pages != 0 && file_pages_[file_id] >= max_pages) {
+    // The file is at its maximum share, it replaces one of its own pages.
+    if (!replacer_->Victim(frame_id, [&](frame_id_t frame) { return pages_[frame]->file_id_ == file_id; })) {
+      return false;
+    }
+  } else if (!free_list_.empty()) {
+    *frame_id = free_list_.front();
+    free_list_.pop_front();
+    return true;
+  } else if (files_->HasMinShare()) {
+    // Pages of files within their minimum share are taken only when nothing else is left.
+    auto unprotected = [&](frame_id_t frame) {
+      file_id_t owner = pages_[frame]->file_id_;
+      return owner == file_id || file_pages_[owner] > GetInstanceShare((*files_)[owner].min_pages_);
+    };
+    if (!replacer_->Victim(frame_id, unprotected) && !replacer_->Victim(frame_id)) {
+      return false;
+    }
+  } else if (!replacer_->Victim(frame_id)) {
+    return false;
+  }
+  stats_.evictions_++;
+  EvictFrame(*frame_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::GetRingFrame(BufferAccessStrategy *strategy, file_id_t file_id, page_id_t page_id,
+                                             frame_id_t *frame_id) {
+  auto &ring = strategy->GetRing(instance_index_);
+  auto &slot = ring.slots_[ring.current_];
+  ring.current_ = (ring.current_ + 1) % ring.slots_.size();
+  if (slot.frame_id_ != INVALID_FRAME_ID && static_cast<size_t>(slot.frame_id_) < pool_size_ &&
+      MakePageKey(pages_[slot.frame_id_]->file_id_, pages_[slot.frame_id_]->page_id_) == slot.page_key_ &&
+      pages_[slot.frame_id_]->pin_count_ == 0 && !IsWriting(slot.frame_id_)) {
+    replacer_->Remove(slot.frame_id_);
+    stats_.evictions_++;
+    EvictFrame(slot.frame_id_);
+    *frame_id = slot.frame_id_;
+  } else if (GetVictimFrame(file_id, frame_id)) {
+    slot.frame_id_ = *frame_id;
+  } else {
+    return false;
+  }
+  slot.page_key_ = MakePageKey(file_id, page_id);
+  ring.num_reads_++;
+  return true;
+}
+
+void BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id) {
+  Page &victim = *pages_[frame_id];
+  if (victim.is_dirty_) {
+    stats_.dirty_evictions_++;
+    files_->GetDiskManager(victim.file_id_)->WritePage(victim.page_id_, victim.data_);
+    victim.is_dirty_ = false;
+  }
+  if (prefetched_[frame_id]) {
+    prefetched_[frame_id] = false;
+    stats_.prefetch_wasted_++;
+  }
+  UnmapPage(frame_id);
+}
+
+void BufferPoolManagerInstance::RetireFrame(frame_id_t frame_id) {
+  replacer_->Remove(frame_id);
+  stats_.evictions_++;
+  EvictFrame(frame_id);
+}
+
+void BufferPoolManagerInstance::MapPage(frame_id_t frame_id, file_id_t file_id, page_id_t page_id) {
+  Page &page = *pages_[frame_id];
+  page.file_id_ = file_id;
+  page.page_id_ = page_id;
+  page_table_.emplace(MakePageKey(file_id, page_id), frame_id);
+  file_pages_[file_id]++;
+}
+
+void BufferPoolManagerInstance::UnmapPage(frame_id_t frame_id) {
+  Page &page = *pages_[frame_id];
+  page_table_.erase(MakePageKey(page.file_id_, page.page_id_));
+  file_pages_[page.file_id_]--;
+  page.file_id_ = INVALID_FILE_ID;
+  page.page_id_ = INVALID_PAGE_ID;
+}
+
+void BufferPoolManagerInstance::Resize(size_t pool_size) {
+  std::unique_lock<std::mutex> lock(latch_);
+  size_t old_size = pool_size_;
+  if (pool_size >= old_size) {
+    // Frames left allocated by an earlier shrink are reused before a new chunk is allocated.
+    if (pages_.size() < pool_size) {
+      size_t chunk_size = pool_size - pages_.size();
+      chunk_starts_.push_back(pages_.size());
+      frame_arenas_.emplace_back(new PageArena(chunk_size, use_huge_pages_));
+      page_chunks_.emplace_back();
+      for (size_t i = 0; i < chunk_size; i++) {
+        // The arena starts zeroed, the frames are only backed by memory once used.
+        pages_.push_back(&page_chunks_.back().emplace_back(frame_arenas_.back()->GetPage(i)));
+      }
+    }
+    prefetched_.resize(pool_size, false);
+    last_access_.resize(pool_size, 0);
+    replacer_->Resize(pool_size);
+    for (size_t i = old_size; i < pool_size; i++) {
+      free_list_.emplace_back(i);
+    }
+    pool_size_ = pool_size;
+    return;
+  }
+  // From now on the frames beyond pool_size are neither handed out by the free list or the replacer, nor given back to
+  // the replacer when unpinned.
+  pool_size_ = pool_size;
+  writer_hand_ = 0;
+  free_list_.remove_if([pool_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= pool_size; });
+  for (size_t i = pool_size; i < old_size; i++) {
+    if (pages_[i]->page_id_ != INVALID_PAGE_ID && pages_[i]->pin_count_ == 0 && !IsWriting(i)) {
+      RetireFrame(i);
+    }
+  }
+  // Pinned pages are retired by UnpinPage once their last user is done, pages being written back by the background
+  // writer once the write is done.
+  retire_cv_.wait(lock, [&] {
+    for (size_t i = pool_size; i < old_size; i++) {
+      if (pages_[i]->page_id_ != INVALID_PAGE_ID) {
+        return false;
+      }
+    }
+    return true;
+  });
+  prefetched_.resize(pool_size);
+  last_access_.resize(pool_size);
+  replacer_->Resize(pool_size);
+  while (!chunk_starts_.empty() && chunk_starts_.back() >= pool_size) {
+    pages_.resize(chunk_starts_.back());
+    chunk_starts_.pop_back();
+    page_chunks_.pop_back();
+    frame_arenas_.pop_back();
+  }
+}
+
+void BufferPoolManagerInstance::DropFile(file_id_t file_id, bool discard) {
+  std::unique_lock<std::mutex> lock(latch_);
+  io_cv_.wait(lock, [&] { return file_io_[file_id] == 0; });
+  std::vector<std::tuple<file_id_t, page_id_t, const char *>> dirty_pages;
+  CollectDirtyPages(lock, file_id, &dirty_pages);
+  std::vector<std::pair<page_id_t, const char *>> file_pages;
+  for (const auto &page : dirty_pages) {
+    file_pages.emplace_back(std::get<1>(page), std::get<2>(page));
+  }
+  if (!discard && !file_pages.empty()) {
+    files_->GetDiskManager(file_id)->WritePages(file_pages);
+  }
+  for (size_t i = 0; i < pages_.size(); i++) {
+    Page &page = *pages_[i];
+    if (page.file_id_ != file_id) {
+      continue;
+    }
+    // Nobody can unpin a page of a closed database anymore.
+    if (page.pin_count_ > 0) {
+      page.pin_count_ = 0;
+      stats_.pinned_frames_--;
+    }
+    replacer_->Remove(i);
+    if (prefetched_[i]) {
+      prefetched_[i] = false;
+      stats_.prefetch_wasted_++;
+    }
+    UnmapPage(i);
+    if (i < pool_size_) {
+      free_list_.push_back(i);
+    }
+  }
+  retire_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::CollectDirtyPages(
+    std::unique_lock<std::mutex> &lock, file_id_t file_id,
+    std::vector<std::tuple<file_id_t, page_id_t, const char *>> *pages) {
+  // A page written back by the background writer and dirtied again must not be overtaken by its older version.
+  io_cv_.wait(lock, [&] { return writing_.empty(); });
+  // Frames being retired by a shrink may still hold a pinned dirty page.
+  for (size_t i = 0; i < pages_.size(); i++) {
+    Page &page = *pages_[i];
+    if (page.page_id_ != INVALID_PAGE_ID && page.is_dirty_ && (file_id == INVALID_FILE_ID || page.file_id_ == file_id)) {
+      pages->emplace_back(page.file_id_, page.page_id_, page.data_);
+      page.is_dirty_ = false;
+    }
+  }
+}
+
+void BufferPoolManagerInstance::MarkDirty(file_id_t file_id, page_id_t page_id) {
+  auto iter = page_table_.find(MakePageKey(file_id, page_id));
+  if (iter != page_table_.end()) {
+    pages_[iter->second]->is_dirty_ = true;
+  }
+}
+
+bool BufferPoolManagerInstance::IsWriting(frame_id_t frame_id) const {
+  const Page &page = *pages_[frame_id];
+  return !writing_.empty() && writing_.count(MakePageKey(page.file_id_, page.page_id_)) != 0;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckAllUnpinned(file_id_t file_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  bool res = true;
+  for (size_t i = 0; i < pages_.size(); i++) {
+    if (pages_[i]->pin_count_ != 0 && (file_id == INVALID_FILE_ID || pages_[i]->file_id_ == file_id)) {
+      res = false;
+      LOG(ERROR) << "page " << pages_[i]->page_id_ << " pin count:" << pages_[i]->pin_count_ << endl;
+    }
+  }
+  return res;
+}
+
+// Only used for debug
+bool BufferPoolManagerInstance::CheckPageResident(file_id_t file_id, page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return page_table_.find(MakePageKey(file_id, page_id)) != page_table_.end();
+}
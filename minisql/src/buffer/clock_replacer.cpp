@@ -0,0 +1,76 @@
+#include "buffer/clock_replacer.h"
+
+CLOCKReplacer::CLOCKReplacer(size_t num_pages)
+    : capacity(num_pages), clock_present(num_pages, false), clock_reference(num_pages, false) {}
+
+CLOCKReplacer::~CLOCKReplacer() = default;
+
+bool CLOCKReplacer::Victim(frame_id_t *frame_id) {
+  if (clock_size == 0) {
+    return false;
+  }
+  // A frame with its reference bit set gets a second chance: the bit is cleared and the hand moves past it. At most
+  // two sweeps are needed before a frame with a cleared bit is found.
+  while (true) {
+    size_t frame = clock_hand;
+    clock_hand = (clock_hand + 1) % capacity;
+    if (!clock_present[frame]) {
+      continue;
+    }
+    if (clock_reference[frame]) {
+      clock_reference[frame] = false;
+      continue;
+    }
+    clock_present[frame] = false;
+    clock_size--;
+    *frame_id = static_cast<frame_id_t>(frame);
+    return true;
+  }
+}
+
+bool CLOCKReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) {
+  // The same sweep, passing over the frames the filter rejects. Two sweeps visit every accepted frame twice, which is
+  // enough to clear its reference bit and then take it.
+  for (size_t steps = 0; clock_size > 0 && steps < 2 * capacity; steps++) {
+    size_t frame = clock_hand;
+    clock_hand = (clock_hand + 1) % capacity;
+    if (!clock_present[frame] || !filter(static_cast<frame_id_t>(frame))) {
+      continue;
+    }
+    if (clock_reference[frame]) {
+      clock_reference[frame] = false;
+      continue;
+    }
+    clock_present[frame] = false;
+    clock_size--;
+    *frame_id = static_cast<frame_id_t>(frame);
+    return true;
+  }
+  return false;
+}
+
+void CLOCKReplacer::Pin(frame_id_t frame_id) {
+  if (!clock_present[frame_id]) {
+    return;
+  }
+  clock_present[frame_id] = false;
+  clock_size--;
+}
+
+void CLOCKReplacer::Unpin(frame_id_t frame_id) {
+  if (clock_present[frame_id]) {
+    return;
+  }
+  clock_present[frame_id] = true;
+  clock_reference[frame_id] = true;
+  clock_size++;
+}
+
+void CLOCKReplacer::Resize(size_t num_pages) {
+  capacity = num_pages;
+  clock_present.resize(num_pages, false);
+  clock_reference.resize(num_pages, false);
+  clock_hand %= capacity;
+}
+
+size_t CLOCKReplacer::Size() { return clock_size; }
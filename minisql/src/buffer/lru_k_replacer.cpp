@@ -0,0 +1,74 @@
+#include "buffer/lru_k_replacer.h"
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), frames_(num_pages) {}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  // Frames with an infinite k-distance go first, then the one whose k-th most recent access is the oldest.
+  auto &queue = history_queue_.empty() ? cache_queue_ : history_queue_;
+  if (queue.empty()) {
+    return false;
+  }
+  *frame_id = queue.begin()->second;
+  queue.erase(queue.begin());
+  frames_[*frame_id].history_.clear();
+  frames_[*frame_id].evictable_ = false;
+  return true;
+}
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) {
+  for (auto queue : {&history_queue_, &cache_queue_}) {
+    for (auto iter = queue->begin(); iter != queue->end(); ++iter) {
+      if (filter(iter->second)) {
+        *frame_id = iter->second;
+        queue->erase(iter);
+        frames_[*frame_id].history_.clear();
+        frames_[*frame_id].evictable_ = false;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (!frame.evictable_) {
+    return;
+  }
+  QueueOf(frame).erase(KeyOf(frame_id));
+  frame.evictable_ = false;
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    return;
+  }
+  QueueOf(frame).insert(KeyOf(frame_id));
+  frame.evictable_ = true;
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  FrameHistory &frame = frames_[frame_id];
+  if (frame.evictable_) {
+    QueueOf(frame).erase(KeyOf(frame_id));
+  }
+  frame.history_.push_back(current_timestamp_++);
+  if (frame.history_.size() > k_) {
+    frame.history_.pop_front();
+  }
+  if (frame.evictable_) {
+    QueueOf(frame).insert(KeyOf(frame_id));
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  Pin(frame_id);
+  frames_[frame_id].history_.clear();
+}
+
+void LRUKReplacer::Resize(size_t num_pages) { frames_.resize(num_pages); }
+
+size_t LRUKReplacer::Size() { return history_queue_.size() + cache_queue_.size(); }
@@ -24,6 +24,18 @@ bool LRUReplacer::Victim(frame_id_t *frame_id) {
   return true;
 }
 
+bool LRUReplacer::Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) {
+  for (auto iter = lru_list_.rbegin(); iter != lru_list_.rend(); ++iter) {
+    if (filter(*iter)) {
+      *frame_id = *iter;
+      lru_list_.erase(std::next(iter).base());
+      frame_map_.erase(*frame_id);
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -0,0 +1,411 @@
+#include "buffer/shared_buffer_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "glog/logging.h"
+
+SharedBufferPool::SharedBufferPool(size_t pool_size, size_t num_instances, ReplacerType replacer_type,
+                                   bool use_huge_pages)
+    : pool_size_(pool_size) {
+  if (num_instances == 0) {
+    num_instances = std::max<size_t>(1, std::thread::hardware_concurrency());
+    num_instances = std::min(num_instances, std::max<size_t>(1, pool_size_ / MIN_INSTANCE_POOL_SIZE));
+  }
+  num_instances = std::min(num_instances, std::max<size_t>(1, pool_size_));
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.push_back(new BufferPoolManagerInstance(GetInstancePoolSize(i, num_instances), &files_, replacer_type,
+                                                       i, num_instances, use_huge_pages));
+  }
+  bg_writer_ = std::thread(&SharedBufferPool::BackgroundWriter, this);
+}
+
+SharedBufferPool::~SharedBufferPool() {
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  for (auto &worker : prefetch_workers_) {
+    worker.join();
+  }
+  {
+    std::scoped_lock<std::mutex> lock(bg_writer_latch_);
+    bg_writer_stop_ = true;
+  }
+  bg_writer_cv_.notify_all();
+  bg_writer_.join();
+  FlushAllPages();
+  for (auto instance : instances_) {
+    delete instance;
+  }
+}
+
+file_id_t SharedBufferPool::AttachFile(DiskManager *disk_manager) { return files_.Attach(disk_manager); }
+
+void SharedBufferPool::DetachFile(file_id_t file_id, bool discard) {
+  files_[file_id].detaching_ = true;
+  for (auto instance : instances_) {
+    instance->DropFile(file_id, discard);
+  }
+  if (!discard) {
+    files_.GetDiskManager(file_id)->Sync();
+  }
+  files_.Detach(file_id);
+}
+
+void SharedBufferPool::SetFileShare(file_id_t file_id, size_t min_pages, size_t max_pages) {
+  files_.SetShare(file_id, min_pages, max_pages);
+}
+
+size_t SharedBufferPool::GetNumFilePages(file_id_t file_id) {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetNumFilePages(file_id);
+  }
+  return res;
+}
+
+Page *SharedBufferPool::FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy) {
+  return GetInstance(file_id, page_id)->FetchPage(file_id, page_id, strategy);
+}
+
+std::shared_ptr<BufferAccessStrategy> SharedBufferPool::GetBulkReadStrategy() {
+  return std::make_shared<BufferAccessStrategy>(BULK_READ_RING_SIZE, instances_.size());
+}
+
+Page *SharedBufferPool::NewPage(file_id_t file_id, page_id_t page_id) {
+  return GetInstance(file_id, page_id)->NewPage(file_id, page_id);
+}
+
+bool SharedBufferPool::DeletePage(file_id_t file_id, page_id_t page_id) {
+  return GetInstance(file_id, page_id)->DeletePage(file_id, page_id);
+}
+
+bool SharedBufferPool::UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty) {
+  return GetInstance(file_id, page_id)->UnpinPage(file_id, page_id, is_dirty);
+}
+
+bool SharedBufferPool::FlushPage(file_id_t file_id, page_id_t page_id) {
+  return GetInstance(file_id, page_id)->FlushPage(file_id, page_id);
+}
+
+void SharedBufferPool::PrefetchChain(file_id_t file_id, page_id_t start_page_id, size_t depth,
+                                     NextPageIdFunc next_page_id) {
+  if (depth == 0 || start_page_id >= MAX_VALID_PAGE_ID || start_page_id <= INVALID_PAGE_ID) {
+    return;
+  }
+  {
+    std::scoped_lock<std::mutex> lock(prefetch_latch_);
+    if (prefetch_stop_ || prefetch_queue_.size() >= PREFETCH_QUEUE_CAPACITY) {
+      return;
+    }
+    if (prefetch_workers_.empty()) {
+      for (size_t i = 0; i < PREFETCH_WORKERS; i++) {
+        prefetch_workers_.emplace_back(&SharedBufferPool::PrefetchWorker, this);
+      }
+    }
+    prefetch_queue_.push_back({file_id, start_page_id, depth, std::move(next_page_id)});
+  }
+  prefetch_cv_.notify_one();
+}
+
+void SharedBufferPool::PrefetchWorker() {
+  // A chain being followed asynchronously, with at most one read in flight, into data_.
+  struct Chain {
+    PrefetchRequest request_;
+    page_id_t page_id_;
+    size_t remaining_;
+    bool active_{false};
+    char *data_;
+  };
+  std::unique_ptr<AsyncDiskManager> aio;
+  std::unique_ptr<PageArena> chain_data;
+  std::vector<Chain> chains;
+  size_t num_active = 0;
+  std::vector<AsyncIOCompletion> completions;
+  // Step over the resident pages of a chain until a page has to be read, or the chain ends.
+  auto advance = [&](size_t index) {
+    Chain &chain = chains[index];
+    file_id_t file_id = chain.request_.file_id_;
+    while (chain.remaining_ > 0 && chain.page_id_ > INVALID_PAGE_ID && chain.page_id_ < MAX_VALID_PAGE_ID) {
+      page_id_t next = INVALID_PAGE_ID;
+      switch (GetInstance(file_id, chain.page_id_)->BeginPrefetch(file_id, chain.page_id_, chain.request_.next_page_id_,
+                                                                  &next)) {
+        case PrefetchStart::RESIDENT:
+          chain.page_id_ = next;
+          chain.remaining_--;
+          break;
+        case PrefetchStart::SKIP:
+          chain.remaining_ = 0;
+          break;
+        case PrefetchStart::READ:
+          // Never full, there are as many chains as slots.
+          aio->QueueRead(files_.GetDiskManager(file_id), chain.page_id_, chain.data_, index);
+          return;
+      }
+    }
+    chain.active_ = false;
+    num_active--;
+  };
+  // Install a page read by a chain.
+  auto finish = [&](const AsyncIOCompletion &completion) {
+    Chain &chain = chains[completion.tag_];
+    file_id_t file_id = chain.request_.file_id_;
+    const char *data = completion.ok_ ? chain.data_ : nullptr;
+    page_id_t next = data == nullptr ? INVALID_PAGE_ID : chain.request_.next_page_id_(data);
+    GetInstance(file_id, chain.page_id_)->FinishPrefetch(file_id, chain.page_id_, data);
+    chain.page_id_ = next;
+    chain.remaining_--;
+  };
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      if (num_active == 0) {
+        prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+        // Idle, pick up a change of the queue depth.
+        if ((aio == nullptr ? 0 : aio->GetQueueDepth()) != io_queue_depth_) {
+          aio.reset(io_queue_depth_ == 0 ? nullptr : new AsyncDiskManager(io_queue_depth_));
+          chains = std::vector<Chain>(io_queue_depth_);
+          chain_data = std::make_unique<PageArena>(io_queue_depth_);
+          for (size_t i = 0; i < chains.size(); i++) {
+            chains[i].data_ = chain_data->GetPage(i);
+          }
+        }
+      }
+      if (prefetch_stop_) {
+        break;
+      }
+      if (aio == nullptr) {
+        PrefetchRequest request = std::move(prefetch_queue_.front());
+        prefetch_queue_.pop_front();
+        lock.unlock();
+        page_id_t page_id = request.start_page_id_;
+        for (size_t i = 0; i < request.depth_ && page_id > INVALID_PAGE_ID && page_id < MAX_VALID_PAGE_ID; i++) {
+          page_id =
+              GetInstance(request.file_id_, page_id)->PrefetchPage(request.file_id_, page_id, request.next_page_id_);
+        }
+        continue;
+      }
+      for (size_t index = 0; index < chains.size() && !prefetch_queue_.empty(); index++) {
+        Chain &chain = chains[index];
+        if (chain.active_) {
+          continue;
+        }
+        chain.request_ = std::move(prefetch_queue_.front());
+        prefetch_queue_.pop_front();
+        chain.page_id_ = chain.request_.start_page_id_;
+        chain.remaining_ = chain.request_.depth_;
+        chain.active_ = true;
+        num_active++;
+        lock.unlock();
+        advance(index);
+        lock.lock();
+      }
+    }
+    if (num_active == 0) {
+      continue;
+    }
+    completions.clear();
+    aio->WaitCompletions(1, &completions);
+    for (const auto &completion : completions) {
+      finish(completion);
+      advance(completion.tag_);
+    }
+  }
+  // Install the reads still in flight, the files they belong to may be waiting for them to be detached.
+  if (aio != nullptr) {
+    completions.clear();
+    aio->WaitCompletions(aio->GetNumPending(), &completions);
+    for (const auto &completion : completions) {
+      finish(completion);
+    }
+  }
+}
+
+void SharedBufferPool::WarmUp(file_id_t file_id, const std::vector<page_id_t> &page_ids, const atomic<bool> &stop) {
+  std::vector<bool> full(instances_.size(), false);
+  size_t num_full = 0;
+  for (auto page_id : page_ids) {
+    if (stop || num_full == instances_.size()) {
+      break;
+    }
+    size_t instance_index = GetInstanceIndex(file_id, page_id);
+    if (!full[instance_index] && !instances_[instance_index]->WarmUpPage(file_id, page_id)) {
+      full[instance_index] = true;
+      num_full++;
+    }
+  }
+}
+
+void SharedBufferPool::GetResidentPages(file_id_t file_id, std::vector<page_id_t> *page_ids) {
+  // Each instance orders its own pages by its own clock. Pages are spread over the instances by hash, so taking them
+  // in turns approximates the global recency order.
+  std::vector<std::vector<page_id_t>> resident(instances_.size());
+  size_t total = 0;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->GetResidentPages(file_id, &resident[i]);
+    total += resident[i].size();
+  }
+  page_ids->reserve(page_ids->size() + total);
+  for (size_t rank = 0, taken = 0; taken < total; rank++) {
+    for (const auto &pages : resident) {
+      if (rank < pages.size()) {
+        page_ids->push_back(pages[rank]);
+        taken++;
+      }
+    }
+  }
+}
+
+bool SharedBufferPool::Resize(size_t pool_size) {
+  if (pool_size < instances_.size()) {
+    return false;
+  }
+  std::scoped_lock<std::mutex> lock(resize_latch_);
+  pool_size_ = pool_size;
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->Resize(GetInstancePoolSize(i, instances_.size()));
+  }
+  return true;
+}
+
+void SharedBufferPool::BackgroundWriter() {
+  std::unique_ptr<AsyncDiskManager> aio;
+  std::unique_lock<std::mutex> lock(bg_writer_latch_);
+  while (!bg_writer_cv_.wait_for(lock, std::chrono::milliseconds(BG_WRITER_INTERVAL_MS),
+                                 [this] { return bg_writer_stop_; })) {
+    lock.unlock();
+    if ((aio == nullptr ? 0 : aio->GetQueueDepth()) != io_queue_depth_) {
+      aio.reset(io_queue_depth_ == 0 ? nullptr : new AsyncDiskManager(io_queue_depth_));
+    }
+    auto start = std::chrono::steady_clock::now();
+    size_t written = 0;
+    for (auto instance : instances_) {
+      written += instance->WriteBackDirtyPages(instance->GetPoolSize() / BG_WRITER_CLEAN_RATIO, BG_WRITER_MAX_PAGES,
+                                               aio.get());
+    }
+    if (written > 0) {
+      bg_writer_pages_ += written;
+      bg_writer_busy_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                                .count();
+    }
+    lock.lock();
+  }
+}
+
+void SharedBufferPool::FlushAllPages(file_id_t file_id) {
+  std::scoped_lock<std::mutex> flush_lock(flush_latch_);
+  std::vector<std::unique_lock<std::mutex>> locks;
+  std::vector<std::tuple<file_id_t, page_id_t, const char *>> dirty_pages;
+  for (auto instance : instances_) {
+    locks.emplace_back(instance->latch_);
+    instance->CollectDirtyPages(locks.back(), file_id, &dirty_pages);
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+  if (io_queue_depth_ > 0 && !dirty_pages.empty()) {
+    // Every page of every file in flight at once, then one sync per file.
+    std::vector<std::tuple<DiskManager *, page_id_t, const char *>> requests;
+    requests.reserve(dirty_pages.size());
+    for (const auto &page : dirty_pages) {
+      requests.emplace_back(files_.GetDiskManager(std::get<0>(page)), std::get<1>(page), std::get<2>(page));
+    }
+    if ((flush_aio_ == nullptr ? 0 : flush_aio_->GetQueueDepth()) != io_queue_depth_) {
+      flush_aio_ = std::make_unique<AsyncDiskManager>(io_queue_depth_);
+    }
+    std::vector<size_t> failed;
+    if (!flush_aio_->WritePages(requests, &failed)) {
+      // The pages stay dirty, to be written again by the next flush or when they are evicted.
+      for (size_t i : failed) {
+        file_id_t page_file_id = std::get<0>(dirty_pages[i]);
+        page_id_t page_id = std::get<1>(dirty_pages[i]);
+        instances_[GetInstanceIndex(page_file_id, page_id)]->MarkDirty(page_file_id, page_id);
+      }
+    }
+    for (size_t i = 0; i < requests.size(); i++) {
+      if (i + 1 == requests.size() || std::get<0>(requests[i + 1]) != std::get<0>(requests[i])) {
+        std::get<0>(requests[i])->Sync();
+      }
+    }
+    return;
+  }
+  // One sorted write and one sync per file.
+  std::vector<std::pair<page_id_t, const char *>> file_pages;
+  for (size_t i = 0; i < dirty_pages.size(); i++) {
+    file_pages.emplace_back(std::get<1>(dirty_pages[i]), std::get<2>(dirty_pages[i]));
+    if (i + 1 == dirty_pages.size() || std::get<0>(dirty_pages[i + 1]) != std::get<0>(dirty_pages[i])) {
+      DiskManager *disk_manager = files_.GetDiskManager(std::get<0>(dirty_pages[i]));
+      disk_manager->WritePages(file_pages);
+      disk_manager->Sync();
+      file_pages.clear();
+    }
+  }
+}
+
+size_t SharedBufferPool::GetNumEvictions() {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetStats().evictions_;
+  }
+  return res;
+}
+
+size_t SharedBufferPool::GetNumDirtyEvictions() {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetStats().dirty_evictions_;
+  }
+  return res;
+}
+
+size_t SharedBufferPool::GetNumWarmedUpPages() {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetStats().warmed_up_pages_;
+  }
+  return res;
+}
+
+void SharedBufferPool::ResetStats() {
+  for (auto instance : instances_) {
+    instance->GetStats().Reset();
+  }
+  bg_writer_pages_ = 0;
+  bg_writer_busy_ns_ = 0;
+}
+
+double SharedBufferPool::GetBackgroundWriterThroughput() const {
+  uint64_t busy_ns = bg_writer_busy_ns_;
+  return busy_ns == 0 ? 0 : bg_writer_pages_ * 1e9 / busy_ns;
+}
+
+size_t SharedBufferPool::GetNumPrefetchUsed() {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetStats().prefetch_used_;
+  }
+  return res;
+}
+
+size_t SharedBufferPool::GetNumPrefetchWasted() {
+  size_t res = 0;
+  for (auto instance : instances_) {
+    res += instance->GetStats().prefetch_wasted_;
+  }
+  return res;
+}
+
+// Only used for debug
+bool SharedBufferPool::CheckAllUnpinned(file_id_t file_id) {
+  bool res = true;
+  for (auto instance : instances_) {
+    res = instance->CheckAllUnpinned(file_id) && res;
+  }
+  return res;
+}
+
+// Only used for debug
+bool SharedBufferPool::CheckPageResident(file_id_t file_id, page_id_t page_id) {
+  return GetInstance(file_id, page_id)->CheckPageResident(file_id, page_id);
+}
@@ -65,8 +65,11 @@ CatalogMeta::CatalogMeta() {
  * TODO: Student Implement
  */
 CatalogManager::CatalogManager(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager,
-                               LogManager *log_manager, bool init)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
+                               LogManager *log_manager, bool init, std::string tablespace_dir)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      tablespace_dir_(std::move(tablespace_dir)) {
 
   if (init) {
     // page_id_t catalog_page_id_new;
@@ -121,6 +124,11 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   if (table_names_.find(table_name) != table_names_.end()) {
     return DB_TABLE_ALREADY_EXIST;
   }
+  // The file of the table comes first, nothing is left to undo if it cannot be created.
+  Tablespace *tablespace = nullptr;
+  if (OpenTablespace("table_", next_table_id_ + 1, true, tablespace) != DB_SUCCESS) {
+    return DB_FAILED;
+  }
 
   page_id_t page_id = 0;
 
@@ -133,13 +141,15 @@ dberr_t CatalogManager::CreateTable(const string &table_name, TableSchema *schem
   next_table_id_++;
 
   // create table heap
-  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, deepCopySchema, txn, log_manager_, lock_manager_);
+  BufferPoolManager *heap_bpm = tablespace != nullptr ? tablespace->GetBufferPoolManager() : buffer_pool_manager_;
+  TableHeap *table_heap = TableHeap::Create(heap_bpm, deepCopySchema, txn, log_manager_, lock_manager_);
   // create table metadata
-  TableMetadata *table_meta = TableMetadata::Create(next_table_id_, table_name,table_heap->GetFirstPageId() , deepCopySchema);
+  TableMetadata *table_meta = TableMetadata::Create(next_table_id_, table_name,table_heap->GetFirstPageId() , deepCopySchema,
+                                                    table_heap->GetFreeSpaceMapPageId());
 
   // createable info
   table_info = TableInfo::Create();
-  table_info->Init(table_meta, table_heap);
+  table_info->Init(table_meta, table_heap, tablespace);
 
   // add to tables and table_names in catalog manager
   table_names_.emplace(table_name, next_table_id_);
@@ -210,9 +220,15 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
     key_map.push_back(index_id);
   }
 
+  Tablespace *tablespace = nullptr;
+  if (OpenTablespace("index_", next_index_id_ + 1, true, tablespace) != DB_SUCCESS) {
+    return DB_FAILED;
+  }
+
   // try to get schema from table_info
   Schema *key_schema = Schema::ShallowCopySchema(tables_[table_names_[table_name]]->GetSchema(), key_map);
 
+
   index_id_t index_id = next_index_id_;
   next_index_id_ ++;
 
@@ -220,6 +236,10 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   page_id_t page_id = 0;
   Page* page = buffer_pool_manager_->NewPage(page_id);
   if (page == nullptr) {
+    if (tablespace != nullptr) {
+      tablespace->Drop();
+      delete tablespace;
+    }
     return DB_FAILED;
   }
 
@@ -227,7 +247,7 @@ dberr_t CatalogManager::CreateIndex(const std::string &table_name, const string
   IndexMetadata *index_meta = IndexMetadata::Create(next_index_id_, index_name, table_names_[table_name], key_map);
   // create index info
   index_info = IndexInfo::Create();
-  index_info->Init(index_meta, tables_[table_names_[table_name]], buffer_pool_manager_);
+  index_info->Init(index_meta, tables_[table_names_[table_name]], buffer_pool_manager_, tablespace);
 
   // write to page
   index_meta->SerializeTo(page->GetData());
@@ -317,7 +337,12 @@ dberr_t CatalogManager::DropTable(table_id_t table_id) {
   auto root_page_id = tables_[table_id]->GetRootPageId();
   auto table_heap = table_info_tobe_deleted->GetTableHeap();
 
-  table_heap->FreeTableHeap();
+  if (table_info_tobe_deleted->GetTablespace() != nullptr) {
+    // Deleting the file frees all the pages at once.
+    table_info_tobe_deleted->GetTablespace()->Drop();
+  } else {
+    table_heap->FreeTableHeap();
+  }
 
   // delete table info
   LOG(INFO) << page_id << " in DropTable Function" << std::endl;
@@ -352,10 +377,14 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
     return error_num;
   }
 
-  auto bpindex = dynamic_cast<BPlusTreeIndex*>(index_info_tobe_deleted->GetIndex());
-  auto bptree = bpindex->GetContainer();
-  auto root_page_id = bptree.GetRootPageId();
-  bptree.Destroy(root_page_id);
+  if (index_info_tobe_deleted->GetTablespace() != nullptr) {
+    index_info_tobe_deleted->GetTablespace()->Drop();
+  } else {
+    auto bpindex = dynamic_cast<BPlusTreeIndex*>(index_info_tobe_deleted->GetIndex());
+    auto bptree = bpindex->GetContainer();
+    auto root_page_id = bptree.GetRootPageId();
+    bptree.Destroy(root_page_id);
+  }
 
 
   index_id_t index_id = index_names_[table_name][index_name];
@@ -369,15 +398,108 @@ dberr_t CatalogManager::DropIndex(const string &table_name, const string &index_
   return DB_SUCCESS;
 }
 
+dberr_t CatalogManager::VacuumFile(size_t &num_moved_pages, uint64_t &truncated_bytes) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return DB_READ_ONLY;
+  }
+  auto moved = buffer_pool_manager_->CompactFile();
+  for (auto &iter : catalog_meta_->table_meta_pages_) {
+    iter.second = BufferPoolManager::GetRelocatedPageId(moved, iter.second);
+  }
+  for (auto &iter : catalog_meta_->index_meta_pages_) {
+    iter.second = BufferPoolManager::GetRelocatedPageId(moved, iter.second);
+  }
+  num_moved_pages = moved.size();
+  truncated_bytes = 0;
+  // pages moved in the tablespace of every table, the indexes of the table need them for their row ids
+  std::unordered_map<table_id_t, std::unordered_map<page_id_t, page_id_t>> table_moved;
+  for (auto iter : tables_) {
+    TableInfo *table_info = iter.second;
+    Tablespace *tablespace = table_info->GetTablespace();
+    if (tablespace == nullptr) {
+      table_info->GetTableHeap()->RelocatePages(moved);
+    } else {
+      auto &heap_moved = table_moved[iter.first];
+      heap_moved = tablespace->GetBufferPoolManager()->CompactFile();
+      table_info->GetTableHeap()->RelocatePages(heap_moved);
+      num_moved_pages += heap_moved.size();
+      truncated_bytes += tablespace->GetBufferPoolManager()->TruncateFile();
+    }
+    UpdateTableMetadata(iter.first, table_info);
+  }
+  for (auto iter : indexes_) {
+    auto index = dynamic_cast<BPlusTreeIndex *>(iter.second->GetIndex());
+    if (index == nullptr) {
+      continue;
+    }
+    auto rows_iter = table_moved.find(iter.second->GetTableId());
+    auto moved_rows = rows_iter == table_moved.end() ? &moved : &rows_iter->second;
+    Tablespace *tablespace = iter.second->GetTablespace();
+    if (tablespace == nullptr) {
+      index->RelocatePages(moved, moved_rows);
+    } else {
+      auto index_moved = tablespace->GetBufferPoolManager()->CompactFile();
+      index->RelocatePages(index_moved, moved_rows);
+      num_moved_pages += index_moved.size();
+      truncated_bytes += tablespace->GetBufferPoolManager()->TruncateFile();
+    }
+  }
+  FlushCatalogMetaPage();
+  truncated_bytes += buffer_pool_manager_->TruncateFile();
+  return DB_SUCCESS;
+}
+
+dberr_t CatalogManager::VacuumTable(const std::string &table_name, VacuumReport &report) {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return DB_READ_ONLY;
+  }
+  auto name_iter = table_names_.find(table_name);
+  if (name_iter == table_names_.end()) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  TableInfo *table_info = tables_[name_iter->second];
+  std::vector<std::pair<RowId, Row>> moved_rows;
+  report = table_info->GetTableHeap()->Vacuum(nullptr, moved_rows);
+  std::vector<IndexInfo *> indexes;
+  GetTableIndexes(table_name, indexes);
+  for (auto index_info : indexes) {
+    for (auto &moved : moved_rows) {
+      Row key_row;
+      moved.second.GetKeyFromRow(table_info->GetSchema(), index_info->GetIndexKeySchema(), key_row);
+      index_info->GetIndex()->RemoveEntry(key_row, moved.first, nullptr);
+      index_info->GetIndex()->InsertEntry(key_row, moved.second.GetRowId(), nullptr);
+    }
+  }
+  UpdateTableMetadata(name_iter->second, table_info);
+  return DB_SUCCESS;
+}
+
+void CatalogManager::UpdateTableMetadata(table_id_t table_id, TableInfo *table_info) {
+  page_id_t first_page_id = table_info->GetTableHeap()->GetFirstPageId();
+  page_id_t free_space_map_page_id = table_info->GetTableHeap()->GetFreeSpaceMapPageId();
+  if (first_page_id == table_info->GetRootPageId() && free_space_map_page_id == table_info->GetFreeSpaceMapPageId()) {
+    return;
+  }
+  table_info->SetRootPageId(first_page_id);
+  table_info->SetFreeSpaceMapPageId(free_space_map_page_id);
+  page_id_t meta_page_id = catalog_meta_->table_meta_pages_[table_id];
+  Page *page = buffer_pool_manager_->FetchPage(meta_page_id);
+  table_info->GetTableMetadata()->SerializeTo(page->GetData());
+  buffer_pool_manager_->UnpinPage(meta_page_id, true);
+}
+
 /**
  * TODO: Student Implement
  */
 dberr_t CatalogManager::FlushCatalogMetaPage() const {
+  if (buffer_pool_manager_->IsReadOnly()) {
+    return DB_SUCCESS;
+  }
   Page *meta_page = buffer_pool_manager_->FetchPage(CATALOG_META_PAGE_ID);
   // meta_page->WLatch();
   catalog_meta_->SerializeTo(meta_page->GetData()); // write to meta page
 
-  // buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, true);
+  buffer_pool_manager_->UnpinPage(CATALOG_META_PAGE_ID, true);
   buffer_pool_manager_->FlushPage(CATALOG_META_PAGE_ID);
   return DB_SUCCESS;
 }
@@ -397,9 +519,24 @@ dberr_t CatalogManager::FlushCatalogMetaPage() const {
   ASSERT(table_meta != nullptr, "Unable to deserialize table_meta_data");
   buffer_pool_manager_->UnpinPage(page_id, false);
 
-  TableHeap *table_heap = TableHeap::Create(buffer_pool_manager_, table_meta->GetFirstPageId(), table_meta->GetSchema(), log_manager_, lock_manager_);
+  Tablespace *tablespace = nullptr;
+  if (OpenTablespace("table_", table_id, false, tablespace) != DB_SUCCESS) {
+    delete table_meta;
+    return DB_FAILED;
+  }
+  BufferPoolManager *heap_bpm = tablespace != nullptr ? tablespace->GetBufferPoolManager() : buffer_pool_manager_;
+  TableHeap *table_heap = TableHeap::Create(heap_bpm, table_meta->GetFirstPageId(), table_meta->GetSchema(), log_manager_,
+                                           lock_manager_, table_meta->GetFreeSpaceMapPageId());
   TableInfo *table_info = TableInfo::Create();
-  table_info->Init(table_meta, table_heap);
+  table_info->Init(table_meta, table_heap, tablespace);
+  if (table_meta->GetFreeSpaceMapPageId() == INVALID_PAGE_ID && !heap_bpm->IsReadOnly()) {
+    // Metadata written before tables had a free space map, build the map once and record it.
+    table_heap->LoadFreeSpaceMap();
+    table_info->SetFreeSpaceMapPageId(table_heap->GetFreeSpaceMapPageId());
+    page = buffer_pool_manager_->FetchPage(page_id);
+    table_meta->SerializeTo(page->GetData());
+    buffer_pool_manager_->UnpinPage(page_id, true);
+  }
 
   // add to tables and table_names and update catalog meta
   table_names_.insert({table_info->GetTableName(), table_info->GetTableId()});
@@ -422,6 +559,11 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
   char* buf = page->GetData();
   IndexMetadata::DeserializeFrom(buf, index_meta);
   buffer_pool_manager_->UnpinPage(page_id, false);
+  Tablespace *tablespace = nullptr;
+  if (OpenTablespace("index_", index_id, false, tablespace) != DB_SUCCESS) {
+    delete index_meta;
+    return DB_FAILED;
+  }
   auto table_name = tables_[index_meta->GetTableId()]->GetTableName();
   index_names_[table_name].emplace(index_meta->GetIndexName(), index_id);
 
@@ -429,7 +571,7 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
 
   TableInfo *table_info = tables_[table_id];
   IndexInfo *index_info = IndexInfo::Create();
-  index_info->Init(index_meta, table_info, buffer_pool_manager_);
+  index_info->Init(index_meta, table_info, buffer_pool_manager_, tablespace);
   indexes_.emplace(index_id, index_info);
 
   catalog_meta_->index_meta_pages_.emplace(index_id, page_id);
@@ -437,6 +579,21 @@ dberr_t CatalogManager::LoadIndex(const index_id_t index_id, const page_id_t pag
   return DB_SUCCESS;
 }
 
+dberr_t CatalogManager::OpenTablespace(const std::string &prefix, uint32_t id, bool init,
+                                      Tablespace *&tablespace) const {
+  tablespace = nullptr;
+  if (tablespace_dir_.empty()) {
+    return DB_SUCCESS;
+  }
+  try {
+    tablespace = new Tablespace(tablespace_dir_ + "/" + prefix + std::to_string(id), buffer_pool_manager_, init);
+  } catch (const std::exception &e) {
+    LOG(ERROR) << e.what();
+    return DB_FAILED;
+  }
+  return DB_SUCCESS;
+}
+
 /**
  * TODO: Student Implement
  */
@@ -5,7 +5,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   uint32_t ofs = GetSerializedSize();
   ASSERT(ofs <= PAGE_SIZE, "Failed to serialize table info.");
   // magic num
-  MACH_WRITE_UINT32(buf, TABLE_METADATA_MAGIC_NUM);
+  MACH_WRITE_UINT32(buf, TABLE_METADATA_FSM_MAGIC_NUM);
   buf += 4;
   // table id
   MACH_WRITE_TO(table_id_t, buf, table_id_);
@@ -18,6 +18,9 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
   // table heap root page id
   MACH_WRITE_TO(page_id_t, buf, root_page_id_);
   buf += 4;
+  // free space map first page id
+  MACH_WRITE_TO(page_id_t, buf, free_space_map_page_id_);
+  buf += 4;
   // table schema
   buf += schema_->SerializeTo(buf);
   ASSERT(buf - p == ofs, "Unexpected serialize size.");
@@ -28,7 +31,7 @@ uint32_t TableMetadata::SerializeTo(char *buf) const {
  * TODO: Student Implement
  */
 uint32_t TableMetadata::GetSerializedSize() const {
-  return 4 + 4 + 4 + table_name_.length() + 4 + schema_->GetSerializedSize();
+  return 4 + 4 + 4 + table_name_.length() + 4 + 4 + schema_->GetSerializedSize();
 }
 
 /*
@@ -43,7 +46,8 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // magic num
   uint32_t magic_num = MACH_READ_UINT32(buf);
   buf += 4;
-  ASSERT(magic_num == TABLE_METADATA_MAGIC_NUM, "Failed to deserialize table info.");
+  ASSERT(magic_num == TABLE_METADATA_FSM_MAGIC_NUM || magic_num == TABLE_METADATA_MAGIC_NUM,
+         "Failed to deserialize table info.");
   // table id
   table_id_t table_id = MACH_READ_FROM(table_id_t, buf);
   buf += 4;
@@ -55,12 +59,18 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
   // table heap root page id
   page_id_t root_page_id = MACH_READ_FROM(page_id_t, buf);
   buf += 4;
+  // free space map first page id, none in older metadata
+  page_id_t free_space_map_page_id = INVALID_PAGE_ID;
+  if (magic_num == TABLE_METADATA_FSM_MAGIC_NUM) {
+    free_space_map_page_id = MACH_READ_FROM(page_id_t, buf);
+    buf += 4;
+  }
   // table schema
   TableSchema *schema = nullptr;
   uint32_t schema_size = TableSchema::DeserializeFrom(buf, schema);
   buf += schema_size;
   // allocate space for table metadata
-  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema);
+  table_meta = new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
   return buf - p;
 }
 
@@ -70,10 +80,15 @@ uint32_t TableMetadata::DeserializeFrom(char *buf, TableMetadata *&table_meta) {
  * @param heap Memory heap passed by TableInfo
  */
 TableMetadata *TableMetadata::Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                                     TableSchema *schema) {
+                                     TableSchema *schema, page_id_t free_space_map_page_id) {
   // allocate space for table metadata
-  return new TableMetadata(table_id, table_name, root_page_id, schema);
+  return new TableMetadata(table_id, table_name, root_page_id, schema, free_space_map_page_id);
 }
 
-TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema)
-    : table_id_(table_id), table_name_(table_name), root_page_id_(root_page_id), schema_(schema) {}
\ No newline at end of file
+TableMetadata::TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                             page_id_t free_space_map_page_id)
+    : table_id_(table_id),
+      table_name_(table_name),
+      root_page_id_(root_page_id),
+      free_space_map_page_id_(free_space_map_page_id),
+      schema_(schema) {}
\ No newline at end of file
@@ -3,16 +3,37 @@
 //
 #include "common/instance.h"
 
-DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size)
-    : db_file_name_(std::move(db_name)), init_(init) {
+#include <filesystem>
+
+DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer_pool_size,
+                                 SharedBufferPool *buffer_pool, bool direct_io, bool read_only, bool compress,
+                                 bool file_per_table)
+    : db_name_(std::move(db_name)), init_(init) {
+  if (init_ && read_only) {
+    throw logic_error("Cannot create a read-only database.");
+  }
   // Init database file if needed
-  db_file_name_ = "./databases/" + db_file_name_;
+  db_file_name_ = "./databases/" + db_name_;
   if (init_) {
     remove(db_file_name_.c_str());
+    remove(GetWarmUpFileName(db_name_).c_str());
+    CompressedPageStore::Remove(db_file_name_);
+    std::filesystem::remove_all(GetTablespaceDirectory(db_name_));
+    if (file_per_table) {
+      std::filesystem::create_directories(GetTablespaceDirectory(db_name_));
+    }
+  }
+  if (std::filesystem::is_directory(GetTablespaceDirectory(db_name_))) {
+    tablespace_dir_ = GetTablespaceDirectory(db_name_);
   }
   // Initialize components
-  disk_mgr_ = new DiskManager(db_file_name_);
-  bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  disk_mgr_ = new DiskManager(db_file_name_, read_only ? DiskIOBackend::MMAP : DiskIOBackend::PREAD, direct_io,
+                              compress);
+  if (buffer_pool != nullptr) {
+    bpm_ = new BufferPoolManager(buffer_pool, disk_mgr_);
+  } else {
+    bpm_ = new BufferPoolManager(buffer_pool_size, disk_mgr_);
+  }
 
   // Allocate static page for db storage engine
   if (init) {
@@ -37,16 +58,37 @@ DBStorageEngine::DBStorageEngine(std::string db_name, bool init, uint32_t buffer
   } else {
     ASSERT(!bpm_->IsPageFree(CATALOG_META_PAGE_ID), "Invalid catalog meta page.");
     ASSERT(!bpm_->IsPageFree(INDEX_ROOTS_PAGE_ID), "Invalid header page.");
+    bpm_->StartWarmUp(GetWarmUpFileName(db_name_));
   }
-  catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init);
+  catalog_mgr_ = new CatalogManager(bpm_, nullptr, nullptr, init, tablespace_dir_);
 }
 
 DBStorageEngine::~DBStorageEngine() {
+  bpm_->SaveResidentPages(GetWarmUpFileName(db_name_));
   delete catalog_mgr_;
   delete bpm_;
   delete disk_mgr_;
 }
 
+std::vector<DiskManager *> DBStorageEngine::GetDiskManagers() const {
+  std::vector<DiskManager *> disk_managers{disk_mgr_};
+  std::vector<TableInfo *> tables;
+  catalog_mgr_->GetTables(tables);
+  for (auto table_info : tables) {
+    if (table_info->GetTablespace() != nullptr) {
+      disk_managers.push_back(table_info->GetTablespace()->GetDiskManager());
+    }
+    std::vector<IndexInfo *> indexes;
+    catalog_mgr_->GetTableIndexes(table_info->GetTableName(), indexes);
+    for (auto index_info : indexes) {
+      if (index_info->GetTablespace() != nullptr) {
+        disk_managers.push_back(index_info->GetTablespace()->GetDiskManager());
+      }
+    }
+  }
+  return disk_managers;
+}
+
 std::unique_ptr<ExecuteContext> DBStorageEngine::MakeExecuteContext(Txn *txn) {
   return std::make_unique<ExecuteContext>(txn, catalog_mgr_, bpm_);
 }
@@ -0,0 +1,35 @@
+#include "common/page_arena.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+PageArena::PageArena(size_t num_pages, bool use_huge_pages) : num_pages_(num_pages) {
+  size_t size = std::max<size_t>(1, num_pages) * PAGE_SIZE;
+  bool huge = use_huge_pages && size >= HUGE_PAGE_SIZE;
+  // Map one extra huge page so that the arena can start on a huge page boundary, the slack is unmapped right away.
+  size_t map_size = huge ? size + HUGE_PAGE_SIZE : size;
+  void *addr = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    throw std::bad_alloc();
+  }
+  auto begin = reinterpret_cast<uintptr_t>(addr);
+  if (huge) {
+    uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    if (aligned > begin) {
+      munmap(addr, aligned - begin);
+    }
+    size_t tail = begin + map_size - (aligned + size);
+    if (tail > 0) {
+      munmap(reinterpret_cast<void *>(aligned + size), tail);
+    }
+    begin = aligned;
+    madvise(reinterpret_cast<void *>(begin), size, MADV_HUGEPAGE);
+  }
+  data_ = reinterpret_cast<char *>(begin);
+  mapped_size_ = size;
+}
+
+PageArena::~PageArena() { munmap(data_, mapped_size_); }
@@ -3,8 +3,14 @@
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <strings.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
 
 #include "common/result_writer.h"
 #include "executor/executors/delete_executor.h"
@@ -14,6 +20,7 @@
 #include "executor/executors/update_executor.h"
 #include "executor/executors/values_executor.h"
 #include "glog/logging.h"
+#include "index/b_plus_tree_index.h"
 #include "planner/planner.h"
 #include "utils/utils.h"
 
@@ -23,7 +30,9 @@ extern "C" {
 #include "parser/parser.h"
 }
 
-ExecuteEngine::ExecuteEngine() {
+ExecuteEngine::ExecuteEngine(std::chrono::milliseconds idle_timeout, bool read_only)
+    : idle_timeout_(idle_timeout), read_only_(read_only), autovacuum_interval_(DEFAULT_AUTOVACUUM_INTERVAL) {
+  buffer_pool_ = new SharedBufferPool(DEFAULT_BUFFER_POOL_SIZE);
   char path[] = "./databases";
   DIR *dir;
   if ((dir = opendir(path)) == nullptr) {
@@ -37,10 +46,113 @@ ExecuteEngine::ExecuteEngine() {
         strcmp( stdir->d_name , "..") == 0 ||
         stdir->d_name[0] == '.')
       continue;
-    dbs_[stdir->d_name] = new DBStorageEngine(stdir->d_name, false);
+    dbs_[stdir->d_name] = nullptr;
   }
 
   closedir(dir);
+  autovacuum_worker_ = std::thread(&ExecuteEngine::AutoVacuumWorker, this);
+}
+
+DBStorageEngine *ExecuteEngine::GetDatabase(const std::string &db_name) {
+  auto iter = dbs_.find(db_name);
+  if (iter == dbs_.end()) {
+    return nullptr;
+  }
+  if (iter->second == nullptr) {
+    try {
+      iter->second = new DBStorageEngine(db_name, false, DEFAULT_BUFFER_POOL_SIZE, buffer_pool_, false,
+                                         IsReadOnlyDatabase(db_name));
+    } catch (const std::exception &ex) {
+      cout << "Can not open database " << db_name << ": " << ex.what() << endl;
+      return nullptr;
+    }
+  }
+  last_used_[db_name] = std::chrono::steady_clock::now();
+  return iter->second;
+}
+
+void ExecuteEngine::CloseIdleDatabases() {
+  if (idle_timeout_.count() == 0) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  for (auto iter = last_used_.begin(); iter != last_used_.end();) {
+    if (iter->first != current_db_ && now - iter->second >= idle_timeout_) {
+      delete dbs_[iter->first];
+      dbs_[iter->first] = nullptr;
+      iter = last_used_.erase(iter);
+    } else {
+      ++iter;
+    }
+  }
+}
+
+size_t ExecuteEngine::GetNumOpenDatabases() const { return last_used_.size(); }
+
+size_t ExecuteEngine::AutoVacuum() {
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
+  size_t num_vacuumed = 0;
+  for (const auto &iter : last_used_) {
+    DBStorageEngine *db = dbs_[iter.first];
+    if (db == nullptr || db->IsReadOnly()) {
+      continue;
+    }
+    vector<TableInfo *> tables;
+    db->catalog_mgr_->GetTables(tables);
+    for (auto table : tables) {
+      if (!table->GetTableHeap()->NeedsVacuum()) {
+        continue;
+      }
+      VacuumReport report;
+      if (db->catalog_mgr_->VacuumTable(table->GetTableName(), report) == DB_SUCCESS) {
+        num_vacuumed++;
+        LOG(INFO) << "autovacuum of " << iter.first << "." << table->GetTableName() << ": "
+                  << report.num_pages_before_ << " -> " << report.num_pages_after_ << " pages, freed "
+                  << report.num_freed_pages_ << " pages (" << report.GetNumBytesReclaimed() << " bytes)"
+                  << std::endl;
+      }
+    }
+  }
+  return num_vacuumed;
+}
+
+void ExecuteEngine::AutoVacuumWorker() {
+  std::unique_lock<std::mutex> lock(autovacuum_latch_);
+  while (!autovacuum_stop_) {
+    auto interval = autovacuum_interval_;
+    if (interval.count() == 0) {
+      autovacuum_cv_.wait(lock);
+      continue;
+    }
+    // A change of the interval restarts the wait.
+    if (autovacuum_cv_.wait_for(lock, interval, [&] { return autovacuum_stop_ || autovacuum_interval_ != interval; })) {
+      continue;
+    }
+    lock.unlock();
+    AutoVacuum();
+    lock.lock();
+  }
+}
+
+bool ExecuteEngine::IsReadOnlyDatabase(const std::string &db_name) const {
+  return read_only_ || access(("./databases/" + db_name).c_str(), W_OK) != 0;
+}
+
+bool ExecuteEngine::IsWriteStatement(SyntaxNodeType type) {
+  switch (type) {
+    case kNodeCreateTable:
+    case kNodeDropTable:
+    case kNodeCreateIndex:
+    case kNodeDropIndex:
+    case kNodeInsert:
+    case kNodeDelete:
+    case kNodeUpdate:
+    case kNodeVacuum:
+    case kNodeLoad:
+      return true;
+    default:
+      return false;
+  }
 }
 
 std::unique_ptr<AbstractExecutor> ExecuteEngine::CreateExecutor(ExecuteContext *exec_ctx,
@@ -108,9 +220,23 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
   if (ast == nullptr) {
     return DB_FAILED;
   }
+  std::scoped_lock<std::recursive_mutex> lock(latch_);
   auto start_time = std::chrono::system_clock::now();
+  CloseIdleDatabases();
   unique_ptr<ExecuteContext> context(nullptr);
-  if (!current_db_.empty()) context = dbs_[current_db_]->MakeExecuteContext(nullptr);
+  if (!current_db_.empty()) {
+    // Null if the database could not be opened, it is deselected so that USE and QUIT still work.
+    DBStorageEngine *db = GetDatabase(current_db_);
+    if (db == nullptr) {
+      cout << "Database " << current_db_ << " is not available, no database selected" << endl;
+      current_db_.clear();
+      return DB_FAILED;
+    }
+    context = db->MakeExecuteContext(nullptr);
+    if (IsWriteStatement(ast->type_) && db->IsReadOnly()) {
+      return DB_READ_ONLY;
+    }
+  }
   switch (ast->type_) {
     case kNodeCreateDB:
       return ExecuteCreateDatabase(ast, context.get());
@@ -142,6 +268,16 @@ dberr_t ExecuteEngine::Execute(pSyntaxNode ast) {
       return ExecuteExecfile(ast, context.get());
     case kNodeQuit:
       return ExecuteQuit(ast, context.get());
+    case kNodeShowStatus:
+      return ExecuteShowStatus(ast, context.get());
+    case kNodeResetStatus:
+      return ExecuteResetStatus(ast, context.get());
+    case kNodeSetVariable:
+      return ExecuteSetVariable(ast, context.get());
+    case kNodeVacuum:
+      return ExecuteVacuum(ast, context.get());
+    case kNodeLoad:
+      return ExecuteLoad(ast, context.get());
     default:
       break;
   }
@@ -239,6 +375,9 @@ void ExecuteEngine::ExecuteInformation(dberr_t result) {
     case DB_KEY_NOT_FOUND:
       cout << "Key not exists." << endl;
       break;
+    case DB_READ_ONLY:
+      cout << "Database is read only." << endl;
+      break;
     case DB_QUIT:
       cout << "Bye." << endl;
       break;
@@ -255,7 +394,13 @@ dberr_t ExecuteEngine::ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *co
   if (dbs_.find(db_name) != dbs_.end()) {
     return DB_ALREADY_EXIST;
   }
-  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true)));
+  if (read_only_) {
+    return DB_READ_ONLY;
+  }
+  dbs_.insert(make_pair(db_name, new DBStorageEngine(db_name, true, DEFAULT_BUFFER_POOL_SIZE, buffer_pool_, false,
+                                                     false, compress_new_databases_,
+                                                     file_per_table_new_databases_)));
+  last_used_[db_name] = std::chrono::steady_clock::now();
   return DB_SUCCESS;
 }
 
@@ -267,9 +412,16 @@ dberr_t ExecuteEngine::ExecuteDropDatabase(pSyntaxNode ast, ExecuteContext *cont
   if (dbs_.find(db_name) == dbs_.end()) {
     return DB_NOT_EXIST;
   }
+  if (IsReadOnlyDatabase(db_name)) {
+    return DB_READ_ONLY;
+  }
   remove(("./databases/" + db_name).c_str());
+  CompressedPageStore::Remove("./databases/" + db_name);
   delete dbs_[db_name];
+  std::filesystem::remove_all(DBStorageEngine::GetTablespaceDirectory(db_name));
   dbs_.erase(db_name);
+  last_used_.erase(db_name);
+  remove(DBStorageEngine::GetWarmUpFileName(db_name).c_str());
   if (db_name == current_db_)
     current_db_ = "";
   return DB_SUCCESS;
@@ -306,7 +458,7 @@ dberr_t ExecuteEngine::ExecuteUseDatabase(pSyntaxNode ast, ExecuteContext *conte
   LOG(INFO) << "ExecuteUseDatabase" << std::endl;
 #endif
   string db_name = ast->child_->val_;
-  if (dbs_.find(db_name) != dbs_.end()) {
+  if (GetDatabase(db_name) != nullptr) {
     current_db_ = db_name;
     cout << "Database changed" << endl;
     return DB_SUCCESS;
@@ -323,7 +475,7 @@ dberr_t ExecuteEngine::ExecuteShowTables(pSyntaxNode ast, ExecuteContext *contex
     return DB_FAILED;
   }
   vector<TableInfo *> tables;
-  if (dbs_[current_db_]->catalog_mgr_->GetTables(tables) == DB_FAILED) {
+  if (GetDatabase(current_db_)->catalog_mgr_->GetTables(tables) == DB_FAILED) {
     cout << "Empty set (0.00 sec)" << endl;
     return DB_FAILED;
   }
@@ -385,7 +537,7 @@ dberr_t ExecuteEngine::ExecuteCreateTable(pSyntaxNode ast, ExecuteContext *conte
           return DB_FAILED;
         }
         int tmp_length = atoi(i->child_->next_->child_->val_);
-        if(tmp_length < 0){
+        if(tmp_length < 0 || static_cast<uint32_t>(tmp_length) >= VARCHAR_MAX_LEN){
           LOG(ERROR) << "Invalid char length: " << tmp_length;
           return DB_FAILED;
         }
@@ -681,3 +833,557 @@ dberr_t ExecuteEngine::ExecuteQuit(pSyntaxNode ast, ExecuteContext *context) {
 #endif
   return DB_QUIT;
 }
+
+/** @return true if the identifier equals the lower case keyword, ignoring case */
+static bool MatchKeyword(const char *identifier, const char *keyword) {
+  return identifier != nullptr && strcasecmp(identifier, keyword) == 0;
+}
+
+/** @return true if the two identifiers are "<name> status" */
+static bool IsStatus(pSyntaxNode first, const char *name) {
+  return first != nullptr && first->next_ != nullptr && MatchKeyword(first->val_, name) &&
+         MatchKeyword(first->next_->val_, "status");
+}
+
+static bool IsBufferPoolStatus(pSyntaxNode first) { return IsStatus(first, "bufferpool"); }
+
+/** Print rows as a table, like the result of a query. */
+static void WriteTable(const vector<string> &header, const vector<vector<string>> &rows) {
+  vector<int> data_width;
+  for (const auto &cell : header) {
+    data_width.push_back(cell.length());
+  }
+  for (const auto &row : rows) {
+    for (size_t i = 0; i < row.size(); i++) {
+      data_width[i] = max(data_width[i], static_cast<int>(row[i].length()));
+    }
+  }
+  ResultWriter writer(cout);
+  writer.Divider(data_width);
+  writer.BeginRow();
+  for (size_t i = 0; i < header.size(); i++) {
+    writer.WriteHeaderCell(header[i], data_width[i]);
+  }
+  writer.EndRow();
+  writer.Divider(data_width);
+  for (const auto &row : rows) {
+    writer.BeginRow();
+    for (size_t i = 0; i < row.size(); i++) {
+      writer.WriteCell(row[i], data_width[i]);
+    }
+    writer.EndRow();
+  }
+  writer.Divider(data_width);
+}
+
+dberr_t ExecuteEngine::ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteShowStatus" << std::endl;
+#endif
+  if (IsStatus(ast->child_, "fragmentation")) {
+    return ShowFragmentationStatus(context);
+  }
+  if (IsStatus(ast->child_, "compression")) {
+    return ShowCompressionStatus();
+  }
+  if (IsStatus(ast->child_, "io")) {
+    return ShowIOStatus();
+  }
+  if (!IsBufferPoolStatus(ast->child_)) {
+    cout << "Unknown status, only \"show bufferpool status\", \"show fragmentation status\", \"show compression "
+            "status\" and \"show io status\" are supported."
+         << endl;
+    return DB_FAILED;
+  }
+  vector<vector<string>> rows;
+  for (size_t i = 0; i < buffer_pool_->GetNumInstances(); i++) {
+    const auto &stats = buffer_pool_->GetInstanceStats(i);
+    size_t fetches = stats.fetches_;
+    size_t hits = stats.hits_;
+    stringstream hit_ratio;
+    hit_ratio << fixed << setprecision(4) << (fetches == 0 ? 0.0 : static_cast<double>(hits) / fetches);
+    rows.push_back({to_string(i), to_string(fetches), to_string(hits), to_string(stats.misses_), hit_ratio.str(),
+                    to_string(stats.evictions_), to_string(stats.dirty_evictions_), to_string(stats.new_pages_),
+                    to_string(stats.deleted_pages_), to_string(stats.pinned_frames_), to_string(stats.prefetch_used_),
+                    to_string(stats.prefetch_wasted_)});
+  }
+  WriteTable({"Instance", "Fetches", "Hits", "Misses", "Hit Ratio", "Evictions", "Dirty Writebacks", "New Pages",
+              "Deleted Pages", "Pinned Frames", "Prefetch Used", "Prefetch Wasted"},
+             rows);
+
+  // How the frames are shared among the opened databases.
+  vector<string> db_names;
+  for (const auto &itr : last_used_) {
+    db_names.emplace_back(itr.first);
+  }
+  sort(db_names.begin(), db_names.end());
+  if (!db_names.empty()) {
+    rows.clear();
+    for (const auto &db_name : db_names) {
+      auto bpm = dbs_[db_name]->bpm_;
+      rows.push_back({db_name, to_string(bpm->GetNumResidentPages()), to_string(bpm->GetMinShare()),
+                      bpm->GetMaxShare() == 0 ? "-" : to_string(bpm->GetMaxShare()),
+                      bpm->IsWarmingUp() ? "running" : "-", bpm->IsReadOnly() ? "read only" : "read write"});
+    }
+    WriteTable({"Database", "Resident Pages", "Min Share", "Max Share", "Warm-up", "Mode"}, rows);
+  }
+
+  // Writer activity and the sampled read latency of the whole pool, summed over its instances.
+  LatencyHistogram read_latency;
+  for (size_t i = 0; i < buffer_pool_->GetNumInstances(); i++) {
+    read_latency.Merge(buffer_pool_->GetInstanceStats(i).read_latency_);
+  }
+  uint64_t samples = read_latency.GetTotal();
+  cout << "Pool size " << buffer_pool_->GetPoolSize() << " frames, background writer "
+       << buffer_pool_->GetNumBackgroundWrites() << " pages, " << fixed << setprecision(1)
+       << buffer_pool_->GetBackgroundWriterThroughput() << " pages/s, warm-up " << buffer_pool_->GetNumWarmedUpPages()
+       << " pages, I/O queue depth " << buffer_pool_->GetIOQueueDepth() << endl;
+  cout << "Read latency (1/" << BufferPoolStats::READ_LATENCY_SAMPLE_RATE << " sampled) " << samples << " samples";
+  if (samples != 0) {
+    cout << ", p50 < " << read_latency.GetPercentile(50) << "us, p99 < " << read_latency.GetPercentile(99) << "us,";
+    for (size_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++) {
+      if (read_latency.GetCount(b) != 0) {
+        cout << " " << LatencyHistogram::GetBucketLabel(b) << ":" << read_latency.GetCount(b);
+      }
+    }
+  }
+  cout << endl;
+  return DB_SUCCESS;
+}
+
+/** Append a row of the fragmentation table. */
+static void AddFragmentationRow(vector<vector<string>> &rows, const string &name, const string &kind,
+                                const FragmentationReport &report) {
+  stringstream average, fragmentation;
+  average << fixed << setprecision(1) << report.GetAverageRunLength();
+  fragmentation << fixed << setprecision(4) << report.GetFragmentation();
+  rows.push_back({name, kind, to_string(report.GetNumPages()), to_string(report.GetNumRuns()), average.str(),
+                  fragmentation.str()});
+}
+
+dberr_t ExecuteEngine::ShowFragmentationStatus(ExecuteContext *context) {
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  vector<TableInfo *> tables;
+  context->GetCatalog()->GetTables(tables);
+  vector<vector<string>> rows;
+  for (auto table : tables) {
+    AddFragmentationRow(rows, table->GetTableName(), "table", table->GetTableHeap()->GetFragmentation());
+    vector<IndexInfo *> indexes;
+    context->GetCatalog()->GetTableIndexes(table->GetTableName(), indexes);
+    for (auto index : indexes) {
+      auto tree = dynamic_cast<BPlusTreeIndex *>(index->GetIndex());
+      if (tree != nullptr) {
+        AddFragmentationRow(rows, index->GetIndexName(), "index", tree->GetFragmentation());
+      }
+    }
+  }
+  WriteTable({"Name", "Kind", "Pages", "Runs", "Avg Run", "Fragmentation"}, rows);
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ShowCompressionStatus() {
+  vector<string> db_names;
+  for (const auto &itr : last_used_) {
+    db_names.emplace_back(itr.first);
+  }
+  sort(db_names.begin(), db_names.end());
+  vector<vector<string>> rows;
+  for (const auto &db_name : db_names) {
+    DiskManager *disk_manager = dbs_[db_name]->disk_mgr_;
+    uint64_t file_size, disk_usage;
+    disk_manager->GetFileUsage(&file_size, &disk_usage);
+    CompressedPageStore *page_store = disk_manager->GetPageStore();
+    if (page_store == nullptr) {
+      rows.push_back({db_name, "-", "-", "-", "-", to_string(file_size), to_string(disk_usage)});
+      continue;
+    }
+    uint64_t page_bytes = static_cast<uint64_t>(page_store->GetNumPages()) * PAGE_SIZE;
+    uint64_t stored_bytes = page_store->GetStoredBytes();
+    stringstream ratio;
+    ratio << fixed << setprecision(2) << (stored_bytes == 0 ? 0.0 : static_cast<double>(page_bytes) / stored_bytes);
+    rows.push_back({db_name, to_string(page_store->GetNumPages()), to_string(page_bytes), to_string(stored_bytes),
+                    ratio.str(), to_string(file_size), to_string(disk_usage)});
+  }
+  WriteTable({"Database", "Pages", "Page Bytes", "Stored Bytes", "Ratio", "File Size", "Disk Usage"}, rows);
+  cout << "New databases are created " << (compress_new_databases_ ? "with" : "without") << " page compression"
+       << endl;
+  return DB_SUCCESS;
+}
+
+/** Add a row of SHOW IO STATUS for the I/O recorded in a histogram. */
+static void AddIORow(vector<vector<string>> &rows, const string &db_name, const string &page_class,
+                     const string &operation, const LatencyHistogram &latency, uint64_t total_ns) {
+  uint64_t count = latency.GetTotal();
+  if (count == 0) {
+    return;
+  }
+  stringstream total_ms, avg_us;
+  total_ms << fixed << setprecision(3) << total_ns / 1e6;
+  avg_us << fixed << setprecision(1) << total_ns / 1e3 / count;
+  rows.push_back({db_name, page_class, operation, to_string(count), total_ms.str(), avg_us.str(),
+                  "< " + to_string(latency.GetPercentile(50)), "< " + to_string(latency.GetPercentile(99))});
+}
+
+dberr_t ExecuteEngine::ShowIOStatus() {
+  vector<string> db_names;
+  for (const auto &itr : last_used_) {
+    db_names.emplace_back(itr.first);
+  }
+  sort(db_names.begin(), db_names.end());
+  ofstream json(IO_STATUS_FILE_NAME);
+  json << "{\"page_size\": " << PAGE_SIZE << ", \"files\": [";
+  bool first_file = true;
+  vector<vector<string>> class_rows;
+  vector<vector<string>> file_rows;
+  for (const auto &db_name : db_names) {
+    IOStats db_stats;
+    for (auto disk_manager : dbs_[db_name]->GetDiskManagers()) {
+      const IOStats &stats = disk_manager->GetIOStats();
+      db_stats.Merge(stats);
+      uint64_t counts[IOStats::NUM_IO_TYPES] = {0, 0};
+      uint64_t total_ns = stats.GetTotalFlushLatency();
+      for (size_t c = 0; c < IOStats::NUM_PAGE_CLASSES; c++) {
+        for (size_t t = 0; t < IOStats::NUM_IO_TYPES; t++) {
+          counts[t] += stats.GetCount(static_cast<PageClass>(c), static_cast<IOType>(t));
+          total_ns += stats.GetTotalLatency(static_cast<PageClass>(c), static_cast<IOType>(t));
+        }
+      }
+      stringstream total_ms;
+      total_ms << fixed << setprecision(3) << total_ns / 1e6;
+      file_rows.push_back({db_name, disk_manager->GetFileName(), to_string(counts[0]), to_string(counts[1]),
+                           to_string(stats.GetNumFlushes()), total_ms.str()});
+      json << (first_file ? "" : ", ") << "{\"database\": \"" << db_name << "\", \"file\": \""
+           << disk_manager->GetFileName() << "\", \"io\": ";
+      stats.WriteJson(json);
+      json << "}";
+      first_file = false;
+    }
+    for (size_t c = 0; c < IOStats::NUM_PAGE_CLASSES; c++) {
+      for (size_t t = 0; t < IOStats::NUM_IO_TYPES; t++) {
+        auto page_class = static_cast<PageClass>(c);
+        auto type = static_cast<IOType>(t);
+        AddIORow(class_rows, db_name, IOStats::GetPageClassName(page_class), IOStats::GetIOTypeName(type),
+                 db_stats.GetLatency(page_class, type), db_stats.GetTotalLatency(page_class, type));
+      }
+    }
+    AddIORow(class_rows, db_name, "-", "flush", db_stats.GetFlushLatency(), db_stats.GetTotalFlushLatency());
+  }
+  json << "]}" << endl;
+  WriteTable({"Database", "Class", "Operation", "Count", "Total ms", "Avg us", "p50 us", "p99 us"}, class_rows);
+  WriteTable({"Database", "File", "Reads", "Writes", "Flushes", "I/O ms"}, file_rows);
+  if (!json) {
+    cout << "Failed to write " << IO_STATUS_FILE_NAME << endl;
+    return DB_FAILED;
+  }
+  cout << "I/O status written to " << IO_STATUS_FILE_NAME << endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteResetStatus(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteResetStatus" << std::endl;
+#endif
+  // The parser only accepts "reset <name> status".
+  if (IsStatus(ast->child_->next_, "io")) {
+    for (const auto &itr : last_used_) {
+      for (auto disk_manager : dbs_[itr.first]->GetDiskManagers()) {
+        disk_manager->GetIOStats().Reset();
+      }
+    }
+    cout << "I/O status reset" << endl;
+    return DB_SUCCESS;
+  }
+  if (!IsBufferPoolStatus(ast->child_->next_)) {
+    cout << "Unknown status, only \"reset bufferpool status\" and \"reset io status\" are supported." << endl;
+    return DB_FAILED;
+  }
+  buffer_pool_->ResetStats();
+  cout << "Buffer pool status reset" << endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::VacuumTables(const char *table_name, ExecuteContext *context) {
+  CatalogManager *catalog = context->GetCatalog();
+  vector<TableInfo *> tables;
+  if (table_name == nullptr) {
+    catalog->GetTables(tables);
+  } else {
+    TableInfo *table_info = nullptr;
+    if (catalog->GetTable(table_name, table_info) != DB_SUCCESS) {
+      return DB_TABLE_NOT_EXIST;
+    }
+    tables.push_back(table_info);
+  }
+  vector<vector<string>> rows;
+  for (auto table : tables) {
+    VacuumReport report;
+    dberr_t result = catalog->VacuumTable(table->GetTableName(), report);
+    if (result != DB_SUCCESS) {
+      return result;
+    }
+    stringstream speedup;
+    speedup << fixed << setprecision(2) << report.GetScanSpeedup() << "x";
+    rows.push_back({table->GetTableName(),
+                    to_string(report.num_pages_before_) + " -> " + to_string(report.num_pages_after_),
+                    to_string(report.num_freed_pages_), to_string(report.GetNumBytesReclaimed()),
+                    to_string(report.num_purged_rows_), to_string(report.num_moved_rows_), speedup.str()});
+  }
+  WriteTable({"Table", "Pages", "Pages Freed", "Bytes Reclaimed", "Rows Purged", "Rows Moved", "Scan Speedup"}, rows);
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteVacuum" << std::endl;
+#endif
+  // The parser only accepts "vacuum [<table> | file]".
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  pSyntaxNode target = ast->child_->next_;
+  if (target == nullptr || !MatchKeyword(target->val_, "file")) {
+    return VacuumTables(target == nullptr ? nullptr : target->val_, context);
+  }
+  DiskManager *disk_manager = GetDatabase(current_db_)->disk_mgr_;
+  uint64_t file_size, disk_usage;
+  disk_manager->GetFileUsage(&file_size, &disk_usage);
+  size_t num_moved_pages;
+  uint64_t truncated_bytes;
+  dberr_t result = context->GetCatalog()->VacuumFile(num_moved_pages, truncated_bytes);
+  if (result != DB_SUCCESS) {
+    return result;
+  }
+  uint64_t new_file_size, new_disk_usage;
+  disk_manager->GetFileUsage(&new_file_size, &new_disk_usage);
+  // The disk usage also drops by the pages freed since the last sync, whose holes are punched now.
+  cout << "Moved " << num_moved_pages << " pages, file size " << file_size << " -> " << new_file_size
+       << " bytes, disk usage " << disk_usage << " -> " << new_disk_usage << " bytes, "
+       << (disk_usage > new_disk_usage ? disk_usage - new_disk_usage : 0) << " bytes reclaimed" << endl;
+  return DB_SUCCESS;
+}
+
+dberr_t ExecuteEngine::ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteSetVariable" << std::endl;
+#endif
+  string name = ast->child_->val_;
+  string value = ast->child_->next_->val_;
+  char *end;
+  long long number = strtoll(value.c_str(), &end, 10);
+  bool valid = *end == '\0' && number >= 0;
+  if (MatchKeyword(name.c_str(), "buffer_pool_size")) {
+    if (!valid || number == 0 || !buffer_pool_->Resize(number)) {
+      cout << "Invalid buffer_pool_size " << value << ", it needs at least one frame per instance ("
+           << buffer_pool_->GetNumInstances() << ")." << endl;
+      return DB_FAILED;
+    }
+    cout << "Buffer pool resized to " << number << " frames" << endl;
+    return DB_SUCCESS;
+  }
+  if (MatchKeyword(name.c_str(), "io_queue_depth")) {
+    if (!valid) {
+      cout << "Invalid io_queue_depth " << value << ", it is a number of requests, 0 for blocking I/O." << endl;
+      return DB_FAILED;
+    }
+    buffer_pool_->SetIOQueueDepth(number);
+    cout << "I/O queue depth set to " << number << endl;
+    return DB_SUCCESS;
+  }
+  if (MatchKeyword(name.c_str(), "database_idle_timeout")) {
+    if (!valid) {
+      cout << "Invalid database_idle_timeout " << value << ", it is a number of seconds, 0 keeps databases open."
+           << endl;
+      return DB_FAILED;
+    }
+    idle_timeout_ = std::chrono::seconds(number);
+    cout << "Database idle timeout set to " << number << " seconds" << endl;
+    return DB_SUCCESS;
+  }
+  if (MatchKeyword(name.c_str(), "autovacuum_interval")) {
+    if (!valid) {
+      cout << "Invalid autovacuum_interval " << value << ", it is a number of seconds, 0 for no autovacuum." << endl;
+      return DB_FAILED;
+    }
+    {
+      std::scoped_lock<std::mutex> lock(autovacuum_latch_);
+      autovacuum_interval_ = std::chrono::seconds(number);
+    }
+    autovacuum_cv_.notify_all();
+    cout << "Autovacuum interval set to " << number << " seconds" << endl;
+    return DB_SUCCESS;
+  }
+  if (MatchKeyword(name.c_str(), "page_compression")) {
+    if (!valid || number > 1) {
+      cout << "Invalid page_compression " << value << ", it is 1 to compress the pages of new databases, 0 not to."
+           << endl;
+      return DB_FAILED;
+    }
+    compress_new_databases_ = number == 1;
+    cout << "Page compression " << (compress_new_databases_ ? "enabled" : "disabled") << " for new databases" << endl;
+    return DB_SUCCESS;
+  }
+  if (MatchKeyword(name.c_str(), "file_per_table")) {
+    if (!valid || number > 1) {
+      cout << "Invalid file_per_table " << value
+           << ", it is 1 to give every table and index of new databases a file of its own, 0 not to." << endl;
+      return DB_FAILED;
+    }
+    file_per_table_new_databases_ = number == 1;
+    cout << "File per table " << (file_per_table_new_databases_ ? "enabled" : "disabled") << " for new databases"
+         << endl;
+    return DB_SUCCESS;
+  }
+  bool is_min = MatchKeyword(name.c_str(), "buffer_pool_min_share");
+  if (!is_min && !MatchKeyword(name.c_str(), "buffer_pool_max_share")) {
+    cout << "Unknown variable " << name
+         << ", only buffer_pool_size, buffer_pool_min_share, buffer_pool_max_share, io_queue_depth, "
+            "database_idle_timeout, autovacuum_interval, page_compression and file_per_table can be set."
+         << endl;
+    return DB_FAILED;
+  }
+  if (context == nullptr) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  auto bpm = GetDatabase(current_db_)->bpm_;
+  size_t min_share = is_min ? number : bpm->GetMinShare();
+  size_t max_share = is_min ? bpm->GetMaxShare() : number;
+  if (!valid || (max_share != 0 && min_share > max_share)) {
+    cout << "Invalid " << name << " " << value << ", the minimum share can not exceed the maximum share." << endl;
+    return DB_FAILED;
+  }
+  bpm->SetShare(min_share, max_share);
+  cout << "Buffer pool share of " << current_db_ << " set to " << min_share << " - "
+       << (max_share == 0 ? "unlimited" : to_string(max_share)) << " frames" << endl;
+  return DB_SUCCESS;
+}
+
+/**
+ * Parse a line of a file to load into the fields of a row of the schema.
+ * @return an empty string, or what is wrong with the line
+ */
+static string ParseLoadLine(const string &line, const Schema *schema, vector<Field> &fields) {
+  fields.clear();
+  size_t pos = 0;
+  for (auto column : schema->GetColumns()) {
+    if (pos > line.size()) {
+      return "fewer values than columns";
+    }
+    while (pos < line.size() && isspace(static_cast<unsigned char>(line[pos]))) {
+      pos++;
+    }
+    string value;
+    bool quoted = pos < line.size() && line[pos] == '"';
+    if (quoted) {
+      size_t end = line.find('"', pos + 1);
+      if (end == string::npos) {
+        return "unterminated string";
+      }
+      value = line.substr(pos + 1, end - pos - 1);
+      pos = line.find(',', end + 1);
+    } else {
+      size_t end = line.find(',', pos);
+      value = line.substr(pos, end == string::npos ? string::npos : end - pos);
+      while (!value.empty() && isspace(static_cast<unsigned char>(value.back()))) {
+        value.pop_back();
+      }
+      pos = end;
+    }
+    pos = pos == string::npos ? line.size() + 1 : pos + 1;
+    if (!quoted && MatchKeyword(value.c_str(), "null")) {
+      fields.emplace_back(column->GetType());
+      continue;
+    }
+    try {
+      switch (column->GetType()) {
+        case kTypeInt:
+          fields.emplace_back(kTypeInt, stoi(value));
+          break;
+        case kTypeFloat:
+          fields.emplace_back(kTypeFloat, stof(value));
+          break;
+        case kTypeChar:
+          if (value.size() > column->GetLength()) {
+            return "value too long for column " + column->GetName();
+          }
+          fields.emplace_back(kTypeChar, const_cast<char *>(value.c_str()), value.size(), true);
+          break;
+        default:
+          return "unsupported column type";
+      }
+    } catch (const exception &) {
+      return "invalid value \"" + value + "\" for column " + column->GetName();
+    }
+  }
+  if (pos <= line.size()) {
+    return "more values than columns";
+  }
+  return "";
+}
+
+dberr_t ExecuteEngine::ExecuteLoad(pSyntaxNode ast, ExecuteContext *context) {
+#ifdef ENABLE_EXECUTE_DEBUG
+  LOG(INFO) << "ExecuteLoad" << std::endl;
+#endif
+  if (current_db_.empty()) {
+    cout << "No database selected" << endl;
+    return DB_FAILED;
+  }
+  auto start_time = std::chrono::system_clock::now();
+  string table_name = ast->child_->next_->val_;
+  string file_name = ast->child_->next_->next_->val_;
+  CatalogManager *catalog = context->GetCatalog();
+  TableInfo *table_info = nullptr;
+  if (catalog->GetTable(table_name, table_info) != DB_SUCCESS) {
+    return DB_TABLE_NOT_EXIST;
+  }
+  vector<IndexInfo *> indexes;
+  catalog->GetTableIndexes(table_name, indexes);
+  ifstream in(file_name);
+  if (!in.is_open()) {
+    cout << "Can not open " << file_name << endl;
+    return DB_FAILED;
+  }
+  vector<Row> rows;
+  vector<Field> fields;
+  size_t num_loaded = 0;
+  size_t line_no = 0;
+  string line;
+  bool more = true;
+  while (more) {
+    more = static_cast<bool>(getline(in, line));
+    if (more) {
+      line_no++;
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
+      if (line.empty()) {
+        continue;
+      }
+      string error = ParseLoadLine(line, table_info->GetSchema(), fields);
+      if (!error.empty()) {
+        cout << file_name << ":" << line_no << ": " << error << ", " << num_loaded << " rows loaded" << endl;
+        return DB_FAILED;
+      }
+      rows.emplace_back(fields);
+    }
+    if (rows.size() == LOAD_BATCH_SIZE || (!more && !rows.empty())) {
+      if (InsertExecutor::InsertRows(context, table_info, indexes, rows) != DB_SUCCESS) {
+        cout << "Failed to load the rows up to line " << line_no << ", " << num_loaded << " rows loaded" << endl;
+        return DB_FAILED;
+      }
+      num_loaded += rows.size();
+      rows.clear();
+    }
+  }
+  auto stop_time = std::chrono::system_clock::now();
+  double duration_time =
+      double((std::chrono::duration_cast<std::chrono::milliseconds>(stop_time - start_time)).count());
+  ResultWriter writer(cout);
+  writer.EndInformation(num_loaded, duration_time, false);
+  return DB_SUCCESS;
+}
@@ -16,27 +16,92 @@ void InsertExecutor::Init() {
 }
 
 bool InsertExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
-  Row insert_row;
-  RowId insert_rid;
-  if (child_executor_->Next(&insert_row, &insert_rid)) {
-    for (auto info: index_info_) {
-      Row key_row;
-      insert_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), key_row);
+  if (!inserted_) {
+    inserted_ = true;
+    std::vector<Row> rows;
+    Row insert_row;
+    RowId insert_rid;
+    while (child_executor_->Next(&insert_row, &insert_rid)) {
+      rows.emplace_back(insert_row);
+    }
+    if (InsertRows(exec_ctx_, table_info_, index_info_, rows) == DB_SUCCESS) {
+      num_inserted_ = rows.size();
+    }
+  }
+  if (cursor_ < num_inserted_) {
+    cursor_++;
+    return true;
+  }
+  return false;
+}
+
+dberr_t InsertExecutor::InsertRows(ExecuteContext *exec_ctx, TableInfo *table_info,
+                                   const std::vector<IndexInfo *> &indexes, std::vector<Row> &rows) {
+  Schema *schema = table_info->GetSchema();
+  Txn *txn = exec_ctx->GetTransaction();
+  // The keys of every index, and the order of the rows by key.
+  std::vector<std::vector<Row>> keys(indexes.size());
+  std::vector<std::vector<size_t>> orders(indexes.size());
+  for (size_t i = 0; i < indexes.size(); i++) {
+    IndexInfo *info = indexes[i];
+    auto &index_keys = keys[i];
+    index_keys.resize(rows.size());
+    for (size_t j = 0; j < rows.size(); j++) {
+      rows[j].GetKeyFromRow(schema, info->GetIndexKeySchema(), index_keys[j]);
+    }
+    auto &order = orders[i];
+    order.resize(rows.size());
+    for (size_t j = 0; j < order.size(); j++) {
+      order[j] = j;
+    }
+    auto compare = [&index_keys](size_t lhs, size_t rhs) { return CompareKeys(index_keys[lhs], index_keys[rhs]) < 0; };
+    std::stable_sort(order.begin(), order.end(), compare);
+    for (size_t j = 0; j < order.size(); j++) {
+      const Row &key_row = index_keys[order[j]];
+      if (key_row.GetFieldCount() == 0) {
+        continue;
+      }
       std::vector<RowId> result;
-      if (!key_row.GetFields().empty() &&
-          info->GetIndex()->ScanKey(key_row, result, exec_ctx_->GetTransaction()) == DB_SUCCESS) {
+      if ((j > 0 && CompareKeys(index_keys[order[j - 1]], key_row) == 0) ||
+          info->GetIndex()->ScanKey(key_row, result, txn) == DB_SUCCESS) {
         std::cout << "key already exists" << std::endl;
-        return false;
-          }
-    }
-    if (table_info_->GetTableHeap()->InsertTuple(insert_row, exec_ctx_->GetTransaction())) {
-      Row key_row;
-      for (auto info: index_info_) {  // 更新索引
-        insert_row.GetKeyFromRow(schema_, info->GetIndexKeySchema(), key_row);
-        info->GetIndex()->InsertEntry(key_row, insert_row.GetRowId(), exec_ctx_->GetTransaction());
+        return DB_FAILED;
       }
-      return true;
     }
   }
-  return false;
-}
\ No newline at end of file
+  TableHeap *table_heap = table_info->GetTableHeap();
+  size_t num_inserted = table_heap->BulkInsert(rows, txn);
+  if (num_inserted != rows.size()) {
+    // The rows inserted before the heap ran out of pages have no index entries, they are taken out again.
+    for (size_t i = 0; i < num_inserted; i++) {
+      table_heap->ApplyDelete(rows[i].GetRowId(), txn);
+    }
+    return DB_FAILED;
+  }
+  for (size_t i = 0; i < indexes.size(); i++) {
+    std::vector<Row> sorted_keys;
+    std::vector<RowId> row_ids;
+    sorted_keys.reserve(rows.size());
+    row_ids.reserve(rows.size());
+    for (size_t j : orders[i]) {
+      if (keys[i][j].GetFieldCount() != 0) {
+        sorted_keys.emplace_back(keys[i][j]);
+        row_ids.emplace_back(rows[j].GetRowId());
+      }
+    }
+    indexes[i]->GetIndex()->InsertEntries(sorted_keys, row_ids, txn);
+  }
+  return DB_SUCCESS;
+}
+
+int InsertExecutor::CompareKeys(const Row &lhs, const Row &rhs) {
+  for (uint32_t i = 0; i < lhs.GetFieldCount() && i < rhs.GetFieldCount(); i++) {
+    if (lhs.GetField(i)->CompareLessThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return -1;
+    }
+    if (lhs.GetField(i)->CompareGreaterThan(*rhs.GetField(i)) == CmpBool::kTrue) {
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -3,6 +3,8 @@
 //
 #include "executor/executors/seq_scan_executor.h"
 
+#include "planner/expressions/column_value_expression.h"
+
 SeqScanExecutor::SeqScanExecutor(ExecuteContext *exec_ctx, const SeqScanPlanNode *plan)
     : AbstractExecutor(exec_ctx),
       plan_(plan),
@@ -38,28 +40,48 @@ void SeqScanExecutor::TupleTransfer(const Schema *table_schema, const Schema *ou
   *output_row = Row(dest_row);
 }
 
+void SeqScanExecutor::CollectColumns(const AbstractExpressionRef &expression, std::vector<uint32_t> &column_ids) {
+  if (expression == nullptr) {
+    return;
+  }
+  if (expression->GetType() == ExpressionType::ColumnExpression) {
+    column_ids.push_back(std::dynamic_pointer_cast<ColumnValueExpression>(expression)->GetColIdx());
+  }
+  for (const auto &child : expression->GetChildren()) {
+    CollectColumns(child, column_ids);
+  }
+}
+
 void SeqScanExecutor::Init() {
   exec_ctx_->GetCatalog()->GetTable(plan_->GetTableName(), table_info_);
-  auto first_row = table_info_->GetTableHeap()->Begin(nullptr);
-  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction()));
+  iterator_ = (table_info_->GetTableHeap()->Begin(exec_ctx_->GetTransaction(), false));
   schema_ = plan_->OutputSchema();
   is_schema_same_ = SchemaEqual(table_info_->GetSchema(), schema_);
+  predicate_columns_.clear();
+  CollectColumns(plan_->GetPredicate(), predicate_columns_);
+  output_columns_.clear();
+  for (const auto column : schema_->GetColumns()) {
+    output_columns_.push_back(column->GetTableInd());
+  }
 }
 
 bool SeqScanExecutor::Next(Row *row, RowId *rid) {
   auto predicate = plan_->GetPredicate();
   auto table_schema = table_info_->GetSchema();
+  auto table_heap = table_info_->GetTableHeap();
 
   //add the temporary table iterator
   TableIterator tmp = table_info_->GetTableHeap()->End();
   while (iterator_ != tmp) {
-    auto p_row = &(*iterator_);
+    Row *p_row = iterator_.operator->();
     if (predicate != nullptr) {
+      table_heap->FetchOverflow(p_row, predicate_columns_);
       if (!predicate->Evaluate(p_row).CompareEquals(Field(kTypeInt, 1))) {
         iterator_++;
         continue;
       }
     }
+    table_heap->FetchOverflow(p_row, output_columns_);
     *rid = iterator_->GetRowId();
     if (!is_schema_same_) {
       TupleTransfer(table_schema, schema_, p_row, row);
@@ -29,7 +29,7 @@ bool UpdateExecutor::Next([[maybe_unused]] Row *row, RowId *rid) {
       src_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), src_key_row);
       dest_row.GetKeyFromRow(table_info_->GetSchema(), info->GetIndexKeySchema(), dest_key_row);
       info->GetIndex()->RemoveEntry(src_key_row, src_rid, txn_);
-      info->GetIndex()->InsertEntry(dest_key_row, src_rid, txn_);
+      info->GetIndex()->InsertEntry(dest_key_row, dest_row.GetRowId(), txn_);
     }
     return true;
   }
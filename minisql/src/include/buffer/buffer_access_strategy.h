@@ -0,0 +1,57 @@
+#ifndef MINISQL_BUFFER_ACCESS_STRATEGY_H
+#define MINISQL_BUFFER_ACCESS_STRATEGY_H
+
+#include <vector>
+
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * BufferAccessStrategy gives a large sequential scan a small private ring of frames. Pages the scan misses on are read
+ * into the ring and recycled there, instead of evicting the working set of the shared pool. Pages that are already
+ * resident are used in place and never enter the ring.
+ *
+ * The ring is split among the buffer pool instances, because each page can only live in the instance it hashes to.
+ * A ring slot is only reused if its frame still holds the page the ring put there and nobody has it pinned, otherwise
+ * the slot is refilled with a frame taken from the shared pool the usual way.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+ public:
+  /**
+   * @param ring_size total number of frames in the ring
+   * @param num_instances number of buffer pool instances the ring is split among
+   */
+  explicit BufferAccessStrategy(size_t ring_size, size_t num_instances)
+      : rings_(num_instances, Ring((ring_size + num_instances - 1) / num_instances)) {}
+
+  /** @return the number of pages the scan read into its ring instead of the shared pool */
+  inline size_t GetNumRingReads() const {
+    size_t res = 0;
+    for (const auto &ring : rings_) {
+      res += ring.num_reads_;
+    }
+    return res;
+  }
+
+ private:
+  struct Ring {
+    explicit Ring(size_t size) : slots_(size, {INVALID_FRAME_ID, 0}) {}
+
+    struct Slot {
+      frame_id_t frame_id_;
+      uint64_t page_key_;  // file and page id of the page the ring read into the frame
+    };
+    vector<Slot> slots_;
+    size_t current_{0};
+    size_t num_reads_{0};
+  };
+
+  inline Ring &GetRing(size_t instance_index) { return rings_[instance_index]; }
+
+  vector<Ring> rings_;  // one ring per buffer pool instance
+};
+
+#endif  // MINISQL_BUFFER_ACCESS_STRATEGY_H
@@ -0,0 +1,81 @@
+#ifndef MINISQL_BUFFER_POOL_FILES_H
+#define MINISQL_BUFFER_POOL_FILES_H
+
+#include <atomic>
+#include <mutex>
+
+#include "common/config.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/** Identifies a page in a buffer pool shared by several database files. */
+using page_key_t = uint64_t;
+
+inline page_key_t MakePageKey(file_id_t file_id, page_id_t page_id) {
+  return (static_cast<page_key_t>(static_cast<uint32_t>(file_id)) << 32) | static_cast<uint32_t>(page_id);
+}
+
+/**
+ * BufferPoolFiles maps the file ids of a shared buffer pool to the disk managers of the databases attached to it,
+ * together with the share of the pool each database is given. Slots are written when a database attaches, detaches or
+ * changes its share, and read without latch by the buffer pool instances.
+ */
+class BufferPoolFiles {
+ public:
+  static constexpr size_t MAX_FILES = 4096;
+
+  struct File {
+    atomic<DiskManager *> disk_manager_{nullptr};  // null while the slot is free
+    atomic<bool> detaching_{false};                // no new background I/O is started once set
+    atomic<size_t> min_pages_{0};                  // pages the other files cannot evict, 0 for none
+    atomic<size_t> max_pages_{0};                  // most pages the file can have resident, 0 for no limit
+  };
+
+  /**
+   * @return the id of a free slot now bound to disk_manager, INVALID_FILE_ID if every slot is taken
+   */
+  file_id_t Attach(DiskManager *disk_manager) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < MAX_FILES; i++) {
+      if (files_[i].disk_manager_ == nullptr) {
+        files_[i].disk_manager_ = disk_manager;
+        return static_cast<file_id_t>(i);
+      }
+    }
+    return INVALID_FILE_ID;
+  }
+
+  /** Free the slot, the caller has dropped every page of the file from the pool. */
+  void Detach(file_id_t file_id) {
+    SetShare(file_id, 0, 0);
+    std::scoped_lock<std::mutex> lock(latch_);
+    files_[file_id].disk_manager_ = nullptr;
+    files_[file_id].detaching_ = false;
+  }
+
+  void SetShare(file_id_t file_id, size_t min_pages, size_t max_pages) {
+    std::scoped_lock<std::mutex> lock(latch_);
+    files_[file_id].min_pages_ = min_pages;
+    files_[file_id].max_pages_ = max_pages;
+    bool has_min_share = false;
+    for (const auto &file : files_) {
+      has_min_share = has_min_share || file.min_pages_ != 0;
+    }
+    has_min_share_ = has_min_share;
+  }
+
+  inline File &operator[](file_id_t file_id) { return files_[file_id]; }
+
+  inline DiskManager *GetDiskManager(file_id_t file_id) const { return files_[file_id].disk_manager_; }
+
+  /** @return true if some file has a minimum share, eviction has to look at the owner of a victim only then */
+  inline bool HasMinShare() const { return has_min_share_; }
+
+ private:
+  mutex latch_;  // serializes attach, detach and share changes
+  File files_[MAX_FILES];
+  atomic<bool> has_min_share_{false};
+};
+
+#endif  // MINISQL_BUFFER_POOL_FILES_H
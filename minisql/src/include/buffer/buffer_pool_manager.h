@@ -1,58 +1,228 @@
 #ifndef MINISQL_BUFFER_POOL_MANAGER_H
 #define MINISQL_BUFFER_POOL_MANAGER_H
 
-#include <list>
-#include <mutex>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 
-#include "buffer/lru_replacer.h"
+#include "buffer/shared_buffer_pool.h"
 #include "page/disk_file_meta_page.h"
 #include "page/page.h"
 #include "storage/disk_manager.h"
 
 using namespace std;
 
+/**
+ * BufferPoolManager gives one database file access to a SharedBufferPool. It attaches the file to the pool, qualifies
+ * every page id with the file id it got, and allocates and frees pages in the file through its disk manager. The pool
+ * is either private to this database or shared with the other open databases.
+ *
+ * A database whose disk manager is read only, see DiskIOBackend::MMAP, bypasses the pool: FetchPage hands out pages
+ * pointing straight into the mapping of the file, which are never copied, evicted or written back. Their data must not
+ * be modified.
+ */
 class BufferPoolManager {
  public:
-  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager);
+  /**
+   * Create a private pool for the database.
+   * @param pool_size total number of frames, split evenly among the instances
+   * @param num_instances number of partitions, 0 picks one per hardware thread as long as every instance keeps at
+   *                      least SharedBufferPool::MIN_INSTANCE_POOL_SIZE frames
+   * @param replacer_type replacement policy used by every instance
+   */
+  explicit BufferPoolManager(size_t pool_size, DiskManager *disk_manager, size_t num_instances = 0,
+                             ReplacerType replacer_type = ReplacerType::LRU_K);
+
+  /**
+   * Attach the database to a pool shared with other databases, the pool must outlive this BufferPoolManager.
+   */
+  explicit BufferPoolManager(SharedBufferPool *pool, DiskManager *disk_manager);
 
+  /**
+   * Write back the dirty pages of the database and drop its pages from the pool.
+   */
   ~BufferPoolManager();
 
   Page *FetchPage(page_id_t page_id);
 
+  /**
+   * Fetch a page on behalf of a large sequential scan. Misses are read into the strategy's ring.
+   */
+  Page *FetchPage(page_id_t page_id, BufferAccessStrategy *strategy);
+
+  /**
+   * Create a ring of SharedBufferPool::BULK_READ_RING_SIZE frames for a large sequential scan.
+   */
+  inline std::shared_ptr<BufferAccessStrategy> GetBulkReadStrategy() { return pool_->GetBulkReadStrategy(); }
+
   bool UnpinPage(page_id_t page_id, bool is_dirty);
 
   bool FlushPage(page_id_t page_id);
 
-  Page *NewPage(page_id_t &page_id);
+  /**
+   * @param segment if set, the page is taken from the contiguous pages reserved for the segment, see
+   *                DiskManager::AllocatePage(PageSegment *)
+   */
+  Page *NewPage(page_id_t &page_id, PageSegment *segment = nullptr);
+
+  /**
+   * Create a segment for the pages of a table heap or an index. The pages reserved for it and not used yet are freed
+   * when the last reference goes away, which must happen before the disk manager is closed.
+   */
+  std::shared_ptr<PageSegment> CreateSegment();
 
   bool DeletePage(page_id_t page_id);
 
   bool IsPageFree(page_id_t page_id);
 
-  bool CheckAllUnpinned();
+  /**
+   * Move the allocated pages at the end of the file into the free pages below, highest first, until no free page is
+   * left below an allocated one. Only the content is copied: the page ids stored in the moved pages and in the pages
+   * referring to them are up to the caller, see GetRelocatedPageId, and must be updated before TruncateFile.
+   * @return the new id of every moved page, by old id
+   */
+  std::unordered_map<page_id_t, page_id_t> CompactFile();
+
+  /**
+   * Write back every dirty page and cut the free pages off the end of the file, see DiskManager::Truncate.
+   * @return the number of bytes cut off the file
+   */
+  uint64_t TruncateFile();
+
+  /** @return the id a page was moved to by CompactFile, the page id itself if it was not moved */
+  static inline page_id_t GetRelocatedPageId(const std::unordered_map<page_id_t, page_id_t> &moved,
+                                             page_id_t page_id) {
+    auto iter = moved.find(page_id);
+    return iter == moved.end() ? page_id : iter->second;
+  }
+
+  /**
+   * Write back every dirty page of the database, see SharedBufferPool::FlushAllPages.
+   */
+  inline void FlushAllPages() { pool_->FlushAllPages(file_id_); }
+
+  /**
+   * Ask the prefetcher to read up to depth pages of a page chain in the background, starting at start_page_id.
+   * @param next_page_id extracts the id of the following page from the content of a page of the chain
+   */
+  void PrefetchChain(page_id_t start_page_id, size_t depth, NextPageIdFunc next_page_id);
+
+  /** @return how many pages ahead of a sequential scan the prefetcher reads, 0 disables read-ahead */
+  inline size_t GetPrefetchDepth() const { return pool_->GetPrefetchDepth(); }
+
+  inline void SetPrefetchDepth(size_t depth) { pool_->SetPrefetchDepth(depth); }
+
+  /**
+   * Write the ids of the resident pages of the database to file_name, most recently accessed first, for StartWarmUp to
+   * read after a restart.
+   * @return false if the file could not be written
+   */
+  bool SaveResidentPages(const std::string &file_name);
+
+  /**
+   * Start loading the pages listed in file_name by SaveResidentPages in the background. Only the most recent pages
+   * that fit in the pool are kept, and they are read in physical order. They go into free frames only, so queries
+   * running meanwhile never wait for the warm-up and never lose a frame to it. The file is consumed, a crash before
+   * the next clean shutdown leaves no stale list behind.
+   */
+  void StartWarmUp(const std::string &file_name);
+
+  /** @return true while the warm-up started by StartWarmUp is loading pages */
+  inline bool IsWarmingUp() const { return warmup_running_; }
+
+  /**
+   * Reserve min_pages frames of the pool for this database and let it use at most max_pages, 0 for no limit. See
+   * SharedBufferPool::SetFileShare.
+   */
+  inline void SetShare(size_t min_pages, size_t max_pages) { pool_->SetFileShare(file_id_, min_pages, max_pages); }
+
+  inline size_t GetMinShare() { return pool_->GetFileMinShare(file_id_); }
+
+  inline size_t GetMaxShare() { return pool_->GetFileMaxShare(file_id_); }
+
+  /** @return the number of pages of this database resident in the pool */
+  inline size_t GetNumResidentPages() { return pool_->GetNumFilePages(file_id_); }
+
+  /** @return true if the pages come from the read-only mapping of the file rather than from the pool */
+  inline bool IsReadOnly() const { return disk_manager_->IsReadOnly(); }
+
+  /** @return the pool this database uses, shared or not */
+  inline SharedBufferPool *GetSharedPool() { return pool_; }
+
+  inline DiskManager *GetDiskManager() const { return disk_manager_; }
+
+  /**
+   * Drop the pages of the database from the pool without writing them back, for a file about to be deleted. Nothing
+   * but the destructor may be called afterwards.
+   */
+  void Discard();
+
+  inline file_id_t GetFileId() const { return file_id_; }
+
+  // Counters and sizes of the pool, which cover every database attached to it.
+
+  inline size_t GetNumPrefetchUsed() { return pool_->GetNumPrefetchUsed(); }
+
+  inline size_t GetNumPrefetchWasted() { return pool_->GetNumPrefetchWasted(); }
+
+  inline size_t GetNumEvictions() { return pool_->GetNumEvictions(); }
+
+  inline size_t GetNumDirtyEvictions() { return pool_->GetNumDirtyEvictions(); }
+
+  inline size_t GetNumWarmedUpPages() { return pool_->GetNumWarmedUpPages(); }
+
+  inline size_t GetNumBackgroundWrites() const { return pool_->GetNumBackgroundWrites(); }
+
+  inline double GetBackgroundWriterThroughput() const { return pool_->GetBackgroundWriterThroughput(); }
+
+  inline const BufferPoolStats &GetInstanceStats(size_t instance_index) const {
+    return pool_->GetInstanceStats(instance_index);
+  }
+
+  inline void ResetStats() { pool_->ResetStats(); }
+
+  inline bool Resize(size_t pool_size) { return pool_->Resize(pool_size); }
+
+  inline size_t GetPoolSize() const { return pool_->GetPoolSize(); }
+
+  inline size_t GetNumInstances() const { return pool_->GetNumInstances(); }
+
+  /** @return true if no page of this database is pinned */
+  inline bool CheckAllUnpinned() { return pool_->CheckAllUnpinned(file_id_); }
+
+  inline bool CheckPageResident(page_id_t page_id) { return pool_->CheckPageResident(file_id_, page_id); }
+
+  static constexpr uint32_t WARMUP_FILE_MAGIC = 0x5741524d;
+
+  /** Scans switch to a ring once they have read more than 1 / BULK_READ_THRESHOLD_RATIO of the pool. */
+  static constexpr size_t BULK_READ_THRESHOLD_RATIO = 4;
 
  private:
   /**
    * Allocate new page (operations like create index/table) For now just keep an increasing counter
    */
-  page_id_t AllocatePage();
+  page_id_t AllocatePage(PageSegment *segment = nullptr);
 
   /**
    * Deallocate page (operations like drop index/table) Need bitmap in header page for tracking pages
    */
   void DeallocatePage(page_id_t page_id);
 
-  frame_id_t TryToFindFreePage();
-
  private:
-  size_t pool_size_;                                 // number of pages in buffer pool
-  Page *pages_;                                      // array of pages
-  DiskManager *disk_manager_;                        // pointer to the disk manager.
-  unordered_map<page_id_t, frame_id_t> page_table_;  // to keep track of pages
-  Replacer *replacer_;                               // to find an unpinned page for replacement
-  list<frame_id_t> free_list_;                       // to find a free page for replacement
-  recursive_mutex latch_;                            // to protect shared data structure
+  unique_ptr<SharedBufferPool> owned_pool_;  // set if the pool is private to this database
+  SharedBufferPool *pool_;
+  DiskManager *disk_manager_;                // pointer to the disk manager.
+  file_id_t file_id_;                        // id of the database file in the pool
+  deque<Page> mapped_pages_;                 // pages of a read-only file by page id, pointing into its mapping
+
+  thread warmup_;
+  atomic<bool> warmup_running_{false};
+  atomic<bool> warmup_stop_{false};
+  bool detached_{false};  // set by Discard
 };
 
 #endif  // MINISQL_BUFFER_POOL_MANAGER_H
@@ -0,0 +1,225 @@
+#ifndef MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+#define MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_files.h"
+#include "buffer/buffer_pool_stats.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "common/page_arena.h"
+#include "page/page.h"
+#include "storage/async_disk_manager.h"
+#include "storage/disk_manager.h"
+
+using namespace std;
+
+/** Extracts the id of the next page in a chain (table heap, B+ tree leaves) from the raw content of a page. */
+using NextPageIdFunc = std::function<page_id_t(const char *page_data)>;
+
+/** Outcome of BufferPoolManagerInstance::BeginPrefetch. */
+enum class PrefetchStart { RESIDENT, SKIP, READ };
+
+/**
+ * BufferPoolManagerInstance is one partition of the buffer pool. It owns a set of frames, a hash page table, a replacer
+ * and a free list, all protected by a single latch. SharedBufferPool routes every page to exactly one instance, so
+ * instances never share state and can serve requests from different threads in parallel. Pages are identified by
+ * their file and page id, the files are the databases attached to the pool.
+ */
+class BufferPoolManagerInstance {
+  // Flushing the whole pool sorts the dirty pages of every instance together, under all instance latches.
+  friend class SharedBufferPool;
+
+ public:
+  /**
+   * @param files the files of the pool, shared by all its instances
+   * @param instance_index position of this instance in its pool, used to pick its share of a ring
+   * @param num_instances number of instances of the pool, the share of a file is split evenly among them
+   * @param use_huge_pages back the frames with transparent huge pages, see PageArena
+   */
+  explicit BufferPoolManagerInstance(size_t pool_size, BufferPoolFiles *files,
+                                     ReplacerType replacer_type = ReplacerType::LRU_K, size_t instance_index = 0,
+                                     size_t num_instances = 1, bool use_huge_pages = true);
+
+  ~BufferPoolManagerInstance();
+
+  /**
+   * @param strategy if not null, a miss reads the page into the strategy's ring instead of a frame of the shared pool
+   */
+  Page *FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  bool UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Bring a page that has just been allocated on disk into the pool.
+   * @return nullptr if every frame this file can use in this instance is pinned
+   */
+  Page *NewPage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Drop a page from the pool.
+   * @return false if the page is resident and still pinned, true otherwise
+   */
+  bool DeletePage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Bring a page into the pool without pinning it, so that a later FetchPage hits. The disk read happens outside the
+   * latch. Does nothing if the page is already resident, every frame is pinned or the file is being detached.
+   * @return the id of the page that follows it in its chain
+   */
+  page_id_t PrefetchPage(file_id_t file_id, page_id_t page_id, const NextPageIdFunc &next_page_id);
+
+  /**
+   * First half of PrefetchPage, for a prefetcher that reads pages asynchronously.
+   * RESIDENT: the page is in the pool, *next_page_id is set to the page following it.
+   * SKIP: the page must not be prefetched.
+   * READ: the page is reserved for the caller, who reads it and calls FinishPrefetch.
+   */
+  PrefetchStart BeginPrefetch(file_id_t file_id, page_id_t page_id, const NextPageIdFunc &next_page_id,
+                              page_id_t *next_page_id_out);
+
+  /**
+   * Second half of PrefetchPage, install a page reserved by BeginPrefetch.
+   * @param data content read from disk, nullptr if the read failed
+   */
+  void FinishPrefetch(file_id_t file_id, page_id_t page_id, const char *data);
+
+  /**
+   * Bring a page listed in the warm-up file into a free frame, unpinned. The warm-up never evicts anything, so it
+   * cannot push out a page a query has already loaded. The disk read happens outside the latch.
+   * @return false if this instance has no free frame left, true otherwise
+   */
+  bool WarmUpPage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Append the ids of the resident pages of a file to pages, most recently accessed first.
+   */
+  void GetResidentPages(file_id_t file_id, std::vector<page_id_t> *pages);
+
+  /** @return the number of pages of the file resident in this instance */
+  size_t GetNumFilePages(file_id_t file_id);
+
+  /**
+   * One round of the background writer. If fewer than clean_target frames are free or hold a clean unpinned page,
+   * write back up to max_pages dirty unpinned pages, picked by a sweep that continues where the last round stopped.
+   * The pages are copied under the latch and written outside of it. Their frames are not evictable until the write is
+   * done, and FlushPage and FlushAllPages wait for it, so an older version can never land on top of a newer one.
+   * @param aio if not null, the pages are written through it with many writes in flight
+   * @return the number of pages written
+   */
+  size_t WriteBackDirtyPages(size_t clean_target, size_t max_pages, AsyncDiskManager *aio = nullptr);
+
+  /**
+   * Change the number of frames of this instance. Growing adds the new frames to the free list. Shrinking retires the
+   * frames at the end, writing back and evicting their pages. It waits until pages pinned in them are unpinned, the
+   * retired frames are no longer handed out meanwhile. The Page of every remaining frame stays at the same address.
+   */
+  void Resize(size_t pool_size);
+
+  /**
+   * Write back the dirty pages of a file and drop all its pages, pinned or not, once the background I/O on the file
+   * started before it was marked as detaching is done.
+   * @param discard drop the dirty pages without writing them back, the file is about to be deleted
+   */
+  void DropFile(file_id_t file_id, bool discard = false);
+
+  /**
+   * @param file_id only look at the pages of this file, INVALID_FILE_ID for all pages
+   */
+  bool CheckAllUnpinned(file_id_t file_id = INVALID_FILE_ID);
+
+  bool CheckPageResident(file_id_t file_id, page_id_t page_id);
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  inline BufferPoolStats &GetStats() { return stats_; }
+
+ private:
+  /**
+   * Pick a frame for a page of file_id from the free list, or evict one chosen by the replacer. A file at its maximum
+   * share replaces one of its own pages, and pages of a file within its minimum share are only taken when there is
+   * nothing else. A dirty victim is written back and its mapping removed from the page table. Caller must hold latch_.
+   */
+  bool GetVictimFrame(file_id_t file_id, frame_id_t *frame_id);
+
+  /**
+   * Pick the frame the next page of a ring scan is read into, recycling the current ring slot when it still holds the
+   * page the ring put there and that page is unpinned. Caller must hold latch_.
+   */
+  bool GetRingFrame(BufferAccessStrategy *strategy, file_id_t file_id, page_id_t page_id, frame_id_t *frame_id);
+
+  /**
+   * Write back the page in an unpinned frame if it is dirty and remove its mapping. Caller must hold latch_.
+   */
+  void EvictFrame(frame_id_t frame_id);
+
+  /**
+   * Write back and drop the page of a frame that is being retired by a shrink. Caller must hold latch_.
+   */
+  void RetireFrame(frame_id_t frame_id);
+
+  /** Map a page to a frame. Caller must hold latch_. */
+  void MapPage(frame_id_t frame_id, file_id_t file_id, page_id_t page_id);
+
+  /** Remove the mapping of the page in a frame, the frame is left empty. Caller must hold latch_. */
+  void UnmapPage(frame_id_t frame_id);
+
+  /**
+   * Append every dirty page of the file, or of all files if file_id is INVALID_FILE_ID, to pages and mark it clean.
+   * Waits for the writes of the background writer first. The caller writes them back before releasing latch_.
+   * @param lock the caller's lock on latch_
+   */
+  void CollectDirtyPages(std::unique_lock<std::mutex> &lock, file_id_t file_id,
+                         std::vector<std::tuple<file_id_t, page_id_t, const char *>> *pages);
+
+  /** Mark a page collected by CollectDirtyPages dirty again after its write failed. Caller must hold latch_. */
+  void MarkDirty(file_id_t file_id, page_id_t page_id);
+
+  /** @return whether the page in a frame is being written back by the background writer. Caller must hold latch_. */
+  bool IsWriting(frame_id_t frame_id) const;
+
+  /** @return the part of a share of the pool that falls on this instance */
+  inline size_t GetInstanceShare(size_t pages) const { return (pages + num_instances_ - 1) / num_instances_; }
+
+ private:
+  atomic<size_t> pool_size_;                         // number of pages in this instance
+  size_t instance_index_;                            // position of this instance in its pool
+  size_t num_instances_;                             // number of instances of the pool
+  vector<Page *> pages_;                             // frames, indexed by frame id
+  vector<deque<Page>> page_chunks_;                  // the frames, one chunk per allocation
+  vector<unique_ptr<PageArena>> frame_arenas_;       // data of the frames, one arena per chunk
+  vector<size_t> chunk_starts_;                      // frame id of the first frame of each chunk
+  bool use_huge_pages_;                              // frame arenas use transparent huge pages
+  condition_variable retire_cv_;                     // signaled when a frame being retired by a shrink is emptied
+  BufferPoolFiles *files_;                           // disk managers and shares of the files, owned by the pool
+  vector<size_t> file_pages_;                        // resident pages of each file, indexed by file id
+  unordered_map<page_key_t, frame_id_t> page_table_; // to keep track of pages
+  Replacer *replacer_;                               // to find an unpinned page for replacement
+  list<frame_id_t> free_list_;                       // to find a free page for replacement
+  mutex latch_;                                      // to protect shared data structure
+  vector<bool> prefetched_;                          // frame holds a prefetched page that was not fetched yet
+  unordered_set<page_key_t> prefetching_;            // pages being read by a prefetch, cleared if loaded meanwhile
+  unordered_set<page_key_t> writing_;                // pages the background writer is writing outside the latch
+  vector<size_t> file_io_;                           // background reads and writes in flight, indexed by file id
+  condition_variable io_cv_;                         // signaled when background I/O outside the latch finishes
+  size_t writer_hand_{0};                            // next frame the background writer looks at
+  vector<uint64_t> last_access_;                     // access_clock_ at the last fetch of each frame
+  uint64_t access_clock_{0};                         // counts the fetches of this instance
+  BufferPoolStats stats_;
+};
+
+#endif  // MINISQL_BUFFER_POOL_MANAGER_INSTANCE_H
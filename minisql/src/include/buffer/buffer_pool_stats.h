@@ -0,0 +1,46 @@
+#ifndef MINISQL_BUFFER_POOL_STATS_H
+#define MINISQL_BUFFER_POOL_STATS_H
+
+#include <atomic>
+
+#include "common/latency_histogram.h"
+
+using namespace std;
+
+/**
+ * Counters of one buffer pool instance. They are updated without holding any latch and read by SHOW BUFFERPOOL STATUS,
+ * so a snapshot of several counters is not guaranteed to be consistent with each other.
+ */
+struct BufferPoolStats {
+  /** Only every READ_LATENCY_SAMPLE_RATE-th disk read is timed. */
+  static constexpr size_t READ_LATENCY_SAMPLE_RATE = 16;
+
+  atomic<size_t> fetches_{0};           // FetchPage calls
+  atomic<size_t> hits_{0};              // FetchPage calls that found the page resident
+  atomic<size_t> misses_{0};            // FetchPage calls that read the page from disk
+  atomic<size_t> evictions_{0};         // pages evicted to make room for another one
+  atomic<size_t> dirty_evictions_{0};   // evictions that wrote the victim back first
+  atomic<size_t> new_pages_{0};         // NewPage calls that got a frame
+  atomic<size_t> deleted_pages_{0};     // DeletePage calls that dropped a resident page
+  atomic<size_t> prefetch_used_{0};     // prefetched pages that were fetched before being evicted
+  atomic<size_t> prefetch_wasted_{0};   // prefetched pages that were evicted or dropped without being fetched
+  atomic<size_t> warmed_up_pages_{0};   // pages loaded by the warm-up after a restart
+  atomic<size_t> pinned_frames_{0};     // frames with a non zero pin count, not affected by Reset
+  LatencyHistogram read_latency_;       // sampled latency of the disk reads done by FetchPage
+
+  void Reset() {
+    fetches_ = 0;
+    hits_ = 0;
+    misses_ = 0;
+    evictions_ = 0;
+    dirty_evictions_ = 0;
+    new_pages_ = 0;
+    deleted_pages_ = 0;
+    prefetch_used_ = 0;
+    prefetch_wasted_ = 0;
+    warmed_up_pages_ = 0;
+    read_latency_.Reset();
+  }
+};
+
+#endif  // MINISQL_BUFFER_POOL_STATS_H
@@ -32,16 +32,22 @@ class CLOCKReplacer : public Replacer {
 
   bool Victim(frame_id_t *frame_id) override;
 
+  bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) override;
+
   void Pin(frame_id_t frame_id) override;
 
   void Unpin(frame_id_t frame_id) override;
 
+  void Resize(size_t num_pages) override;
+
   size_t Size() override;
 
  private:
   size_t capacity;
-  list<frame_id_t> clock_list;               // replacer中可以被替换的数据页
-  map<frame_id_t, frame_id_t> clock_status;  // 数据页的存储状态
+  size_t clock_hand{0};          // next frame the clock looks at
+  size_t clock_size{0};          // number of frames that can be victimized
+  vector<bool> clock_present;    // whether the frame is in the replacer, indexed by frame id
+  vector<bool> clock_reference;  // reference bit of the frame, indexed by frame id
 };
 
 #endif  // MINISQL_CLOCK_REPLACER_H
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef MINISQL_LRU_K_REPLACER_H
+#define MINISQL_LRU_K_REPLACER_H
+
+#include <deque>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+using namespace std;
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy.
+ *
+ * The backward k-distance of a frame is the difference between the current timestamp and the timestamp of its k-th
+ * most recent access. The frame with the largest backward k-distance is evicted first. Frames with fewer than k
+ * accesses have an infinite k-distance and are evicted before all others, oldest access first. A page that is only
+ * touched once by a scan therefore never pushes out a page that is looked up repeatedly.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of historical accesses used to rank a frame
+   */
+  explicit LRUKReplacer(size_t num_pages, size_t k = LRUK_REPLACER_K);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  void Resize(size_t num_pages) override;
+
+  size_t Size() override;
+
+ private:
+  struct FrameHistory {
+    deque<size_t> history_;  // timestamps of the last k accesses, oldest first
+    bool evictable_{false};
+  };
+
+  /** Both queues are ordered by the oldest remembered access, which is the k-th most recent one once k are known. */
+  inline set<pair<size_t, frame_id_t>> &QueueOf(const FrameHistory &frame) {
+    return frame.history_.size() < k_ ? history_queue_ : cache_queue_;
+  }
+
+  inline pair<size_t, frame_id_t> KeyOf(frame_id_t frame_id) const {
+    return {frames_[frame_id].history_.empty() ? 0 : frames_[frame_id].history_.front(), frame_id};
+  }
+
+  size_t k_;
+  size_t current_timestamp_{0};
+  vector<FrameHistory> frames_;                  // indexed by frame id
+  set<pair<size_t, frame_id_t>> history_queue_;  // evictable frames with fewer than k accesses
+  set<pair<size_t, frame_id_t>> cache_queue_;    // evictable frames with at least k accesses
+};
+
+#endif  // MINISQL_LRU_K_REPLACER_H
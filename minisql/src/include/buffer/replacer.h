@@ -2,9 +2,15 @@
 #define MINISQL_REPLACER_H
 
 #include <cstdio>
+#include <functional>
 
 #include "common/config.h"
 
+/**
+ * Replacement policies the buffer pool can be built with.
+ */
+enum class ReplacerType { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -21,6 +27,14 @@ class Replacer {
    */
   virtual bool Victim(frame_id_t *frame_id) = 0;
 
+  /**
+   * Remove the victim frame as defined by the replacement policy, considering only the frames accepted by filter.
+   * @param[out] frame_id id of frame that was removed
+   * @param filter returns true for the frames that may be victimized
+   * @return true if an accepted victim frame was found, false otherwise
+   */
+  virtual bool Victim(frame_id_t *frame_id, const std::function<bool(frame_id_t)> &filter) = 0;
+
   /**
    * Pins a frame, indicating that it should not be victimized until it is unpinned.
    * @param frame_id the id of the frame to pin
@@ -33,6 +47,25 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Records that a frame has been accessed. Policies that only look at the unpin order can ignore it.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(__attribute__((unused)) frame_id_t frame_id) {}
+
+  /**
+   * Forgets everything about a frame whose page has been dropped from the buffer pool.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
+  /**
+   * Changes the number of frames the replacer is required to track, when the buffer pool is resized. Frames beyond a
+   * smaller size have been removed beforehand. Policies without per frame state can ignore it.
+   * @param num_pages the new number of frames
+   */
+  virtual void Resize(__attribute__((unused)) size_t num_pages) {}
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
 };
@@ -0,0 +1,249 @@
+#ifndef MINISQL_SHARED_BUFFER_POOL_H
+#define MINISQL_SHARED_BUFFER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "buffer/buffer_pool_files.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "page/disk_file_meta_page.h"
+#include "page/page.h"
+
+using namespace std;
+
+/**
+ * SharedBufferPool holds the frames of one or more databases. Every database attaches its file and gets a file id, and
+ * pages are identified by file and page id, so memory goes to whichever database is busy. The frames are split into
+ * several independent BufferPoolManagerInstance partitions and each page is routed to one of them by hash, so that
+ * threads touching different pages rarely contend on the same latch.
+ *
+ * Databases use the pool through a BufferPoolManager, which adds their file id to every call.
+ */
+class SharedBufferPool {
+ public:
+  /**
+   * @param pool_size total number of frames, split evenly among the instances
+   * @param num_instances number of partitions, 0 picks one per hardware thread as long as every instance keeps at
+   *                      least MIN_INSTANCE_POOL_SIZE frames
+   * @param replacer_type replacement policy used by every instance
+   * @param use_huge_pages back the frames with transparent huge pages
+   */
+  explicit SharedBufferPool(size_t pool_size, size_t num_instances = 0,
+                            ReplacerType replacer_type = ReplacerType::LRU_K, bool use_huge_pages = true);
+
+  ~SharedBufferPool();
+
+  /**
+   * Give a database file access to the pool.
+   * @return the id the pages of the file are known by, INVALID_FILE_ID if MAX_FILES are attached already
+   */
+  file_id_t AttachFile(DiskManager *disk_manager);
+
+  /**
+   * Write back the dirty pages of a file, sync it and drop all its pages from the pool. Background reads and writes of
+   * the file are waited for, the disk manager can be closed afterwards.
+   * @param discard drop the dirty pages without writing them back nor syncing, for a file about to be deleted
+   */
+  void DetachFile(file_id_t file_id, bool discard = false);
+
+  /**
+   * Reserve part of the pool for a file and cap its usage, both counted in frames and split evenly among the
+   * instances. Pages of a file within its minimum share are only evicted by other files when nothing else can be. A
+   * file at its maximum share replaces its own pages.
+   * @param max_pages 0 for no limit
+   */
+  void SetFileShare(file_id_t file_id, size_t min_pages, size_t max_pages);
+
+  inline size_t GetFileMinShare(file_id_t file_id) { return files_[file_id].min_pages_; }
+
+  inline size_t GetFileMaxShare(file_id_t file_id) { return files_[file_id].max_pages_; }
+
+  /** @return the number of pages of the file resident in the pool */
+  size_t GetNumFilePages(file_id_t file_id);
+
+  Page *FetchPage(file_id_t file_id, page_id_t page_id, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Create a ring of BULK_READ_RING_SIZE frames for a large sequential scan.
+   */
+  std::shared_ptr<BufferAccessStrategy> GetBulkReadStrategy();
+
+  bool UnpinPage(file_id_t file_id, page_id_t page_id, bool is_dirty);
+
+  bool FlushPage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Bring a page that has just been allocated on disk into the pool.
+   */
+  Page *NewPage(file_id_t file_id, page_id_t page_id);
+
+  bool DeletePage(file_id_t file_id, page_id_t page_id);
+
+  /**
+   * Write back every dirty page of a file, or of all files if file_id is INVALID_FILE_ID. The pages of all instances
+   * are sorted by physical page id and written in contiguous runs, or up to the I/O queue depth at a time when it is
+   * not 0. Every instance is latched for the duration. Every file written is synced once at the end. A page whose
+   * asynchronous write failed stays dirty.
+   */
+  void FlushAllPages(file_id_t file_id = INVALID_FILE_ID);
+
+  /**
+   * Ask the prefetcher to read up to depth pages of a page chain in the background, starting at start_page_id. The
+   * request is dropped if the prefetcher is already backlogged, prefetching is only a hint.
+   * @param next_page_id extracts the id of the following page from the content of a page of the chain
+   */
+  void PrefetchChain(file_id_t file_id, page_id_t start_page_id, size_t depth, NextPageIdFunc next_page_id);
+
+  /** @return how many pages ahead of a sequential scan the prefetcher reads, 0 disables read-ahead */
+  inline size_t GetPrefetchDepth() const { return prefetch_depth_; }
+
+  inline void SetPrefetchDepth(size_t depth) { prefetch_depth_ = depth; }
+
+  /**
+   * @return the number of reads or writes the prefetcher, the background writer and FlushAllPages each keep in flight
+   *         through an AsyncDiskManager, 0 if they use blocking I/O
+   */
+  inline size_t GetIOQueueDepth() const { return io_queue_depth_; }
+
+  /** Takes effect at the next flush, and when the prefetcher and the background writer are next idle. */
+  inline void SetIOQueueDepth(size_t depth) { io_queue_depth_ = depth; }
+
+  /**
+   * Load pages of a file into free frames, in the given order, until every instance is full or stop is set.
+   */
+  void WarmUp(file_id_t file_id, const std::vector<page_id_t> &page_ids, const atomic<bool> &stop);
+
+  /**
+   * Append the ids of the resident pages of a file to page_ids, approximately most recently accessed first.
+   */
+  void GetResidentPages(file_id_t file_id, std::vector<page_id_t> *page_ids);
+
+  /**
+   * Grow or shrink the pool while it is in use, keeping the number of instances. See BufferPoolManagerInstance::Resize,
+   * a shrink blocks until the pages pinned in the retired frames are unpinned. Resizes are serialized.
+   * @return false if pool_size is smaller than the number of instances
+   */
+  bool Resize(size_t pool_size);
+
+  /** @return the number of prefetched pages that were fetched before being evicted */
+  size_t GetNumPrefetchUsed();
+
+  /** @return the number of prefetched pages that were evicted or dropped without being fetched */
+  size_t GetNumPrefetchWasted();
+
+  /** @return the number of pages evicted to make room for another one */
+  size_t GetNumEvictions();
+
+  /** @return the number of evictions that had to write the victim back first */
+  size_t GetNumDirtyEvictions();
+
+  /** @return the number of pages loaded by warm-ups */
+  size_t GetNumWarmedUpPages();
+
+  /** @return the number of pages written by the background writer */
+  inline size_t GetNumBackgroundWrites() const { return bg_writer_pages_; }
+
+  /** @return pages per second written by the background writer while it was busy */
+  double GetBackgroundWriterThroughput() const;
+
+  /** @return the counters of one instance, used by SHOW BUFFERPOOL STATUS */
+  inline const BufferPoolStats &GetInstanceStats(size_t instance_index) const {
+    return instances_[instance_index]->GetStats();
+  }
+
+  /**
+   * Zero every counter and histogram, e.g. between two benchmark runs. The pinned frame count is a gauge and is kept.
+   */
+  void ResetStats();
+
+  /**
+   * @param file_id only look at the pages of this file, INVALID_FILE_ID for all pages
+   */
+  bool CheckAllUnpinned(file_id_t file_id = INVALID_FILE_ID);
+
+  bool CheckPageResident(file_id_t file_id, page_id_t page_id);
+
+  inline size_t GetPoolSize() const { return pool_size_; }
+
+  inline size_t GetNumInstances() const { return instances_.size(); }
+
+  static constexpr size_t MIN_INSTANCE_POOL_SIZE = 1024;
+
+  static constexpr size_t BULK_READ_RING_SIZE = 32;
+
+  static constexpr size_t PREFETCH_WORKERS = 2;
+
+  static constexpr size_t PREFETCH_QUEUE_CAPACITY = 64;
+
+  static constexpr size_t BG_WRITER_INTERVAL_MS = 100;
+
+  /** The background writer keeps 1 / BG_WRITER_CLEAN_RATIO of every instance free or clean and unpinned. */
+  static constexpr size_t BG_WRITER_CLEAN_RATIO = 8;
+
+  /** Upper bound on the pages written per instance in one round, so a burst of dirtying is spread out. */
+  static constexpr size_t BG_WRITER_MAX_PAGES = 256;
+
+ private:
+  /**
+   * Body of a prefetch worker, serves chain requests until the pool shuts down. With a non zero I/O queue depth, a
+   * worker follows that many chains at once, one asynchronous read in flight per chain.
+   */
+  void PrefetchWorker();
+
+  /**
+   * Body of the background writer, runs a write back round over every instance each BG_WRITER_INTERVAL_MS.
+   */
+  void BackgroundWriter();
+
+  /**
+   * Spread the frames as evenly as possible, the first (pool_size % num_instances) instances get one extra frame.
+   */
+  inline size_t GetInstancePoolSize(size_t instance_index, size_t num_instances) const {
+    return pool_size_ / num_instances + (instance_index < pool_size_ % num_instances ? 1 : 0);
+  }
+
+  inline size_t GetInstanceIndex(file_id_t file_id, page_id_t page_id) const {
+    return (static_cast<uint32_t>(page_id) + static_cast<uint32_t>(file_id)) % instances_.size();
+  }
+
+  inline BufferPoolManagerInstance *GetInstance(file_id_t file_id, page_id_t page_id) {
+    return instances_[GetInstanceIndex(file_id, page_id)];
+  }
+
+ private:
+  atomic<size_t> pool_size_;                       // number of pages in buffer pool
+  mutex resize_latch_;                             // serializes Resize
+  BufferPoolFiles files_;                          // the attached database files
+  vector<BufferPoolManagerInstance *> instances_;  // partitions, see GetInstanceIndex
+
+  struct PrefetchRequest {
+    file_id_t file_id_;
+    page_id_t start_page_id_;
+    size_t depth_;
+    NextPageIdFunc next_page_id_;
+  };
+  atomic<size_t> io_queue_depth_{DEFAULT_IO_QUEUE_DEPTH};
+  mutex flush_latch_;                       // serializes FlushAllPages, protects flush_aio_
+  unique_ptr<AsyncDiskManager> flush_aio_;  // of FlushAllPages, made again when the I/O queue depth changes
+
+  atomic<size_t> prefetch_depth_{DEFAULT_PREFETCH_DEPTH};
+  mutex prefetch_latch_;                  // protects the prefetch queue and workers
+  condition_variable prefetch_cv_;
+  deque<PrefetchRequest> prefetch_queue_;
+  vector<thread> prefetch_workers_;       // started on the first request
+  bool prefetch_stop_{false};
+
+  mutex bg_writer_latch_;
+  condition_variable bg_writer_cv_;
+  thread bg_writer_;
+  bool bg_writer_stop_{false};
+  atomic<size_t> bg_writer_pages_{0};
+  atomic<uint64_t> bg_writer_busy_ns_{0};  // time spent in rounds that wrote at least one page
+};
+
+#endif  // MINISQL_SHARED_BUFFER_POOL_H
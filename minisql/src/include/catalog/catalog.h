@@ -80,8 +80,12 @@ class CatalogMeta {
  */
 class CatalogManager {
  public:
+  /**
+   * @param tablespace_dir directory holding a file per table heap and per index, see Tablespace, empty to keep them all
+   *                       in the database file. The catalog itself always lives in the database file.
+   */
   explicit CatalogManager(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                          bool init);
+                          bool init, std::string tablespace_dir = "");
 
   ~CatalogManager();
 
@@ -103,21 +107,47 @@ class CatalogManager {
 
   dberr_t DropIndex(const std::string &table_name, const std::string &index_name);
 
+  /**
+   * Compact the database file: move the pages at its end into the free pages below, update every page id referring
+   * to them, in the catalog, the table heaps and the indexes, and cut the free pages off the end of the file. The
+   * tablespace of every table and index is compacted the same way.
+   * @param num_moved_pages set to the number of pages moved
+   * @param truncated_bytes set to the number of bytes cut off the file
+   */
+  dberr_t VacuumFile(size_t &num_moved_pages, uint64_t &truncated_bytes);
+
+  /**
+   * Reclaim the space of the deleted rows and sparse pages of a table, see TableHeap::Vacuum. The entries of the rows
+   * moved to other pages are moved in every index of the table.
+   */
+  dberr_t VacuumTable(const std::string &table_name, VacuumReport &report);
+
  private:
   dberr_t DropTable(table_id_t table_id);
 
   dberr_t FlushCatalogMetaPage() const;
 
+  /** Write the metadata of a table again if the first page of its heap or of its free space map changed. */
+  void UpdateTableMetadata(table_id_t table_id, TableInfo *table_info);
+
   dberr_t LoadTable(const table_id_t table_id, const page_id_t page_id);
 
   dberr_t LoadIndex(const index_id_t index_id, const page_id_t page_id);
 
   dberr_t GetTable(const table_id_t table_id, TableInfo *&table_info);
 
+  /**
+   * Open the tablespace of a table or an index if the database has a file per table and per index.
+   * @param prefix "table_" or "index_", followed by the id in the file name
+   * @param tablespace set to the tablespace, null if the database has a single file
+   */
+  dberr_t OpenTablespace(const std::string &prefix, uint32_t id, bool init, Tablespace *&tablespace) const;
+
  private:
   [[maybe_unused]] BufferPoolManager *buffer_pool_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
+  std::string tablespace_dir_;
   CatalogMeta *catalog_meta_;
   std::atomic<table_id_t> next_table_id_;
   std::atomic<index_id_t> next_index_id_;
@@ -33,6 +33,9 @@ class IndexMetadata {
 
   inline index_id_t GetIndexId() const { return index_id_; }
 
+  /** First word of a serialized index metadata, a page starting with it holds one. */
+  static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
+
  private:
   IndexMetadata() = delete;
 
@@ -40,7 +43,6 @@ class IndexMetadata {
                          const std::vector<uint32_t> &key_map);
 
  private:
-  static constexpr uint32_t INDEX_METADATA_MAGIC_NUM = 344528;
   index_id_t index_id_;
   std::string index_name_;
   table_id_t table_id_;
@@ -62,20 +64,28 @@ class IndexInfo {
 
 /**
  * TODO: Student Implement
+ * @param tablespace file of the index, owned by the index info, null if the index lives in the file of
+ *                   buffer_pool_manager
  */
-  void Init(IndexMetadata *meta_data, TableInfo *table_info, BufferPoolManager *buffer_pool_manager) {
+  void Init(IndexMetadata *meta_data, TableInfo *table_info, BufferPoolManager *buffer_pool_manager,
+            Tablespace *tablespace = nullptr) {
     // Step1: init index metadata and table info
     // Step2: mapping index key to key schema
     // Step3: call CreateIndex to create the index
     meta_data_ = meta_data;
+    tablespace_.reset(tablespace);
     key_schema_ = table_info->GetSchema()->ShallowCopySchema(table_info->GetSchema(), meta_data_->GetKeyMapping());
-    index_ = CreateIndex(buffer_pool_manager, "bptree");
+    index_ = CreateIndex(tablespace != nullptr ? tablespace->GetBufferPoolManager() : buffer_pool_manager, "bptree");
   }
 
   inline Index *GetIndex() { return index_; }
 
+  inline Tablespace *GetTablespace() const { return tablespace_.get(); }
+
   std::string GetIndexName() { return meta_data_->GetIndexName(); }
 
+  inline table_id_t GetTableId() const { return meta_data_->GetTableId(); }
+
   IndexSchema *GetIndexKeySchema() { return key_schema_; }
 
  private:
@@ -87,6 +97,7 @@ class IndexInfo {
   IndexMetadata *meta_data_;
   Index *index_;
   IndexSchema *key_schema_;
+  std::unique_ptr<Tablespace> tablespace_;  // destroyed after the index
 };
 
 #endif  // MINISQL_INDEXES_H
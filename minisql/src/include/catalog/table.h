@@ -6,6 +6,7 @@
 #include "glog/logging.h"
 #include "record/schema.h"
 #include "storage/table_heap.h"
+#include "storage/tablespace.h"
 
 class TableMetadata {
   friend class TableInfo;
@@ -23,7 +24,7 @@ class TableMetadata {
    * will create new table schema and owned by mem heap
    */
   static TableMetadata *Create(table_id_t table_id, std::string table_name, page_id_t root_page_id,
-                               TableSchema *schema);
+                               TableSchema *schema, page_id_t free_space_map_page_id = INVALID_PAGE_ID);
 
   inline table_id_t GetTableId() const { return table_id_; }
 
@@ -31,18 +32,27 @@ class TableMetadata {
 
   inline uint32_t GetFirstPageId() const { return root_page_id_; }
 
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_page_id_; }
+
   inline Schema *GetSchema() const { return schema_; }
 
+  /** First word of a serialized table metadata without a free space map, still read but no longer written. */
+  static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
+
+  /** First word of a serialized table metadata, a page starting with it holds one. */
+  static constexpr uint32_t TABLE_METADATA_FSM_MAGIC_NUM = 344529;
+
  private:
   TableMetadata() = delete;
 
-  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema);
+  TableMetadata(table_id_t table_id, std::string table_name, page_id_t root_page_id, TableSchema *schema,
+                page_id_t free_space_map_page_id);
 
  private:
-  static constexpr uint32_t TABLE_METADATA_MAGIC_NUM = 344528;
   table_id_t table_id_;
   std::string table_name_;
   page_id_t root_page_id_;
+  page_id_t free_space_map_page_id_;
   Schema *schema_;
 };
 
@@ -58,13 +68,19 @@ class TableInfo {
     delete table_heap_;
   }
 
-  void Init(TableMetadata *table_meta, TableHeap *table_heap) {
+  /**
+   * @param tablespace file of the table heap, owned by the table info, null if the heap lives in the database file
+   */
+  void Init(TableMetadata *table_meta, TableHeap *table_heap, Tablespace *tablespace = nullptr) {
     table_meta_ = table_meta;
     table_heap_ = table_heap;
+    tablespace_.reset(tablespace);
   }
 
   inline TableHeap *GetTableHeap() const { return table_heap_; }
 
+  inline Tablespace *GetTablespace() const { return tablespace_.get(); }
+
   inline table_id_t GetTableId() const { return table_meta_->table_id_; }
 
   inline std::string GetTableName() const { return table_meta_->table_name_; }
@@ -73,12 +89,21 @@ class TableInfo {
 
   inline page_id_t GetRootPageId() const { return table_meta_->root_page_id_; }
 
+  inline void SetRootPageId(page_id_t root_page_id) { table_meta_->root_page_id_ = root_page_id; }
+
+  inline page_id_t GetFreeSpaceMapPageId() const { return table_meta_->free_space_map_page_id_; }
+
+  inline void SetFreeSpaceMapPageId(page_id_t page_id) { table_meta_->free_space_map_page_id_ = page_id; }
+
+  inline TableMetadata *GetTableMetadata() const { return table_meta_; }
+
  private:
   explicit TableInfo(){};
 
  private:
   TableMetadata *table_meta_;
   TableHeap *table_heap_;
+  std::unique_ptr<Tablespace> tablespace_;  // destroyed after the table heap
 };
 
 #endif  // MINISQL_TABLE_H
@@ -1,6 +1,7 @@
 #ifndef MINISQL_CONFIG_H
 #define MINISQL_CONFIG_H
 
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 
@@ -8,20 +9,36 @@ static constexpr int INVALID_PAGE_ID = -1;   // invalid page id
 static constexpr int INVALID_FRAME_ID = -1;  // invalid recovery id
 static constexpr int INVALID_TXN_ID = -1;    // invalid recovery id
 static constexpr int INVALID_LSN = -1;       // invalid log sequence number
+static constexpr int INVALID_FILE_ID = -1;   // invalid file id of a shared buffer pool
 
 static constexpr int META_PAGE_ID = 0;          // physical page id of the disk file meta info
 static constexpr int CATALOG_META_PAGE_ID = 0;  // logical page id of the catalog meta data
 static constexpr int INDEX_ROOTS_PAGE_ID = 1;   // logical page id of the index roots
 
-static constexpr int PAGE_SIZE = 4096;                  // size of a data page in byte
-static constexpr int DEFAULT_BUFFER_POOL_SIZE = 20480;  // default size of buffer pool
+#ifndef MINISQL_PAGE_SIZE
+#define MINISQL_PAGE_SIZE 4096  // set by the MINISQL_PAGE_SIZE build option
+#endif
+
+static constexpr int PAGE_SIZE = MINISQL_PAGE_SIZE;       // size of a data page in byte
+static constexpr int MIN_PAGE_SIZE = 4096;                // smallest and largest page size supported
+static constexpr int MAX_PAGE_SIZE = 32768;
+static_assert(PAGE_SIZE >= MIN_PAGE_SIZE && PAGE_SIZE <= MAX_PAGE_SIZE && (PAGE_SIZE & (PAGE_SIZE - 1)) == 0,
+              "The page size must be 4096, 8192, 16384 or 32768.");
+static constexpr int DEFAULT_BUFFER_POOL_SIZE = 80 * 1024 * 1024 / PAGE_SIZE;  // default size of buffer pool, 80 MB
+static constexpr size_t LRUK_REPLACER_K = 2;              // number of accesses remembered by the LRU-K replacer
+static constexpr size_t DEFAULT_PREFETCH_DEPTH = 8;       // pages read ahead of a sequential scan
+static constexpr uint32_t DEFAULT_DB_IDLE_TIMEOUT = 300;  // seconds an unused database stays open, 0 for ever
+static constexpr uint32_t DEFAULT_AUTOVACUUM_INTERVAL = 60;  // seconds between autovacuum rounds, 0 for none
+static constexpr size_t DEFAULT_IO_QUEUE_DEPTH = 32;      // asynchronous page I/Os kept in flight, 0 for blocking I/O
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;       // O_DIRECT alignment of buffers, offsets and sizes
 
 static constexpr uint32_t FIELD_NULL_LEN = UINT32_MAX;
-static constexpr uint32_t VARCHAR_MAX_LEN = PAGE_SIZE / 2;  // max length of varchar
+static constexpr uint32_t VARCHAR_MAX_LEN = 1 << 20;  // max length of varchar, long values go to overflow pages
 
 // static std::string DB_META_FILE = "minisql.meta.db";
 
 using page_id_t = int32_t;
+using file_id_t = int32_t;
 using frame_id_t = int32_t;
 using txn_id_t = int32_t;
 using lsn_t = int32_t;
@@ -14,17 +14,53 @@
 
 class DBStorageEngine {
  public:
-  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE);
+  /**
+   * @param buffer_pool pool shared with other databases, if null the database gets a private pool of buffer_pool_size
+   *                    frames
+   * @param direct_io open the database file with O_DIRECT, the pages are then only cached by the buffer pool
+   * @param read_only map an existing database file read only, its pages are used in place instead of being read into
+   *                  the buffer pool, and nothing is ever written back
+   * @param compress compress the data pages of a new database, an existing one keeps the way it was created
+   * @param file_per_table give every table heap and index of a new database a file of its own in the tablespace
+   *                       directory, see Tablespace, an existing one keeps the layout it was created with
+   */
+  explicit DBStorageEngine(std::string db_name, bool init = true, uint32_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE,
+                           SharedBufferPool *buffer_pool = nullptr, bool direct_io = false, bool read_only = false,
+                           bool compress = false, bool file_per_table = false);
 
   ~DBStorageEngine();
 
   std::unique_ptr<ExecuteContext> MakeExecuteContext(Txn *txn);
 
+  inline bool IsReadOnly() const { return disk_mgr_->IsReadOnly(); }
+
+  /**
+   * @return path of the file listing the pages resident at the last clean shutdown, hidden so that it is not taken for
+   *         a database
+   */
+  static std::string GetWarmUpFileName(const std::string &db_name) { return "./databases/." + db_name + ".warmup"; }
+
+  /**
+   * @return path of the directory of the table and index files of a database laid out one file per table and per
+   *         index, hidden like the warm-up file. The database has that layout if and only if the directory exists.
+   */
+  static std::string GetTablespaceDirectory(const std::string &db_name) {
+    return "./databases/." + db_name + ".tablespaces";
+  }
+
+  /** @return true if the tables and indexes of the database have files of their own */
+  inline bool IsFilePerTable() const { return !tablespace_dir_.empty(); }
+
+  /** @return the disk manager of the database file, followed by those of its tablespaces if any */
+  std::vector<DiskManager *> GetDiskManagers() const;
+
  public:
   DiskManager *disk_mgr_;
   BufferPoolManager *bpm_;
   CatalogManager *catalog_mgr_;
+  std::string db_name_;
   std::string db_file_name_;
+  std::string tablespace_dir_;  // empty if the database is a single file
   bool init_;
 };
 
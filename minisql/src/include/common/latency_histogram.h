@@ -0,0 +1,91 @@
+#ifndef MINISQL_LATENCY_HISTOGRAM_H
+#define MINISQL_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * LatencyHistogram counts latency samples in power-of-two microsecond buckets. Bucket 0 holds samples below 1us and
+ * bucket i holds samples in [2^(i-1), 2^i) us, the last bucket also takes everything above. Recording is lock free,
+ * so it can be shared by concurrent readers of the same file.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t NUM_BUCKETS = 24;
+
+  void Record(uint64_t latency_ns) {
+    uint64_t latency_us = latency_ns / 1000;
+    size_t bucket = 0;
+    while (latency_us > 0 && bucket < NUM_BUCKETS - 1) {
+      latency_us >>= 1;
+      bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void Reset() {
+    for (auto &bucket : buckets_) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /** Add the samples of another histogram to this one, e.g. to sum up the instances of a buffer pool. */
+  void Merge(const LatencyHistogram &other) {
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      buckets_[i].fetch_add(other.GetCount(i), std::memory_order_relaxed);
+    }
+  }
+
+  inline uint64_t GetCount(size_t bucket) const { return buckets_[bucket].load(std::memory_order_relaxed); }
+
+  uint64_t GetTotal() const {
+    uint64_t total = 0;
+    for (const auto &bucket : buckets_) {
+      total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  /** @return the exclusive upper bound in us of the bucket, the last bucket has none and reports UINT64_MAX */
+  static uint64_t GetBucketUpperBound(size_t bucket) {
+    return bucket == NUM_BUCKETS - 1 ? UINT64_MAX : static_cast<uint64_t>(1) << bucket;
+  }
+
+  /** @return a label like "<1us", "4-8us" or ">=4194304us" for the bucket */
+  static std::string GetBucketLabel(size_t bucket) {
+    if (bucket == 0) {
+      return "<1us";
+    }
+    if (bucket == NUM_BUCKETS - 1) {
+      return ">=" + std::to_string(static_cast<uint64_t>(1) << (bucket - 1)) + "us";
+    }
+    return std::to_string(static_cast<uint64_t>(1) << (bucket - 1)) + "-" + std::to_string(GetBucketUpperBound(bucket)) +
+           "us";
+  }
+
+  /**
+   * @param percentile between 0 and 100
+   * @return the upper bound in us of the bucket the percentile falls into, 0 if nothing was recorded
+   */
+  uint64_t GetPercentile(double percentile) const {
+    uint64_t total = GetTotal();
+    if (total == 0) {
+      return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(total * percentile / 100);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+      seen += GetCount(i);
+      if (seen > rank) {
+        return GetBucketUpperBound(i);
+      }
+    }
+    return GetBucketUpperBound(NUM_BUCKETS - 1);
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[NUM_BUCKETS]{};
+};
+
+#endif  // MINISQL_LATENCY_HISTOGRAM_H
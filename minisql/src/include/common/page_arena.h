@@ -0,0 +1,35 @@
+#ifndef MINISQL_PAGE_ARENA_H
+#define MINISQL_PAGE_ARENA_H
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+/**
+ * PageArena is a block of page sized buffers, aligned to DIRECT_IO_ALIGNMENT so that they can be handed to a file
+ * opened with O_DIRECT. The memory is mapped anonymously and starts zeroed, it is only backed once touched. With
+ * use_huge_pages, an arena of at least HUGE_PAGE_SIZE is aligned to it and advised for transparent huge pages, which
+ * saves TLB misses when a large pool is scanned.
+ */
+class PageArena {
+ public:
+  explicit PageArena(size_t num_pages, bool use_huge_pages = false);
+
+  ~PageArena();
+
+  DISALLOW_COPY_AND_MOVE(PageArena)
+
+  inline char *GetPage(size_t index) { return data_ + index * PAGE_SIZE; }
+
+  inline size_t GetNumPages() const { return num_pages_; }
+
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+ private:
+  char *data_;
+  size_t num_pages_;
+  size_t mapped_size_;
+};
+
+#endif  // MINISQL_PAGE_ARENA_H
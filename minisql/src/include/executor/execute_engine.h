@@ -1,8 +1,12 @@
 #ifndef MINISQL_EXECUTE_ENGINE_H
 #define MINISQL_EXECUTE_ENGINE_H
 
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 
 #include "common/dberr.h"
@@ -22,12 +26,26 @@ extern "C" {
  */
 class ExecuteEngine {
  public:
-  ExecuteEngine();
+  /**
+   * Register the databases found in ./databases. They are only opened when first used, see GetDatabase.
+   * @param idle_timeout how long a database other than the current one stays open without being used, 0 for ever
+   * @param read_only open every database read only, e.g. for a reporting copy. A database whose file is not writable
+   *                  is opened read only anyway. Statements modifying a read-only database fail with DB_READ_ONLY.
+   */
+  explicit ExecuteEngine(std::chrono::milliseconds idle_timeout = std::chrono::seconds(DEFAULT_DB_IDLE_TIMEOUT),
+                         bool read_only = false);
 
   ~ExecuteEngine() {
+    {
+      std::scoped_lock<std::mutex> lock(autovacuum_latch_);
+      autovacuum_stop_ = true;
+    }
+    autovacuum_cv_.notify_all();
+    autovacuum_worker_.join();
     for (auto it : dbs_) {
       delete it.second;
     }
+    delete buffer_pool_;
   }
 
   /**
@@ -40,7 +58,38 @@ class ExecuteEngine {
 
   void ExecuteInformation(dberr_t result);
 
+  /** @return the number of registered databases that are currently open */
+  size_t GetNumOpenDatabases() const;
+
+  /**
+   * Vacuum the tables of the open databases that need it, see TableHeap::NeedsVacuum. Done by the autovacuum worker
+   * every autovacuum_interval seconds, between statements.
+   * @return the number of tables vacuumed
+   */
+  size_t AutoVacuum();
+
  private:
+  /**
+   * Open a registered database if it is not open yet and mark it as used.
+   * @return nullptr if no database of that name exists
+   */
+  DBStorageEngine *GetDatabase(const std::string &db_name);
+
+  /**
+   * Close the databases other than the current one that have not been used for idle_timeout_. Closing saves the
+   * resident pages for the warm-up of the next open.
+   */
+  void CloseIdleDatabases();
+
+  /** Run AutoVacuum every autovacuum_interval_ until the engine is destroyed. */
+  void AutoVacuumWorker();
+
+  /** @return true if a registered database is to be opened read only */
+  bool IsReadOnlyDatabase(const std::string &db_name) const;
+
+  /** @return true for the statements that modify the current database */
+  static bool IsWriteStatement(SyntaxNodeType type);
+
   static std::unique_ptr<AbstractExecutor> CreateExecutor(ExecuteContext *exec_ctx, const AbstractPlanNodeRef &plan);
 
   dberr_t ExecuteCreateDatabase(pSyntaxNode ast, ExecuteContext *context);
@@ -73,9 +122,67 @@ class ExecuteEngine {
 
   dberr_t ExecuteQuit(pSyntaxNode ast, ExecuteContext *context);
 
+  dberr_t ExecuteShowStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteResetStatus(pSyntaxNode ast, ExecuteContext *context);
+
+  dberr_t ExecuteSetVariable(pSyntaxNode ast, ExecuteContext *context);
+
+  /**
+   * "vacuum file" compacts the file of the current database, see CatalogManager::VacuumFile. "vacuum" reclaims the
+   * space of the deleted rows and sparse pages of every table of the current database, "vacuum <table>" of one table,
+   * see CatalogManager::VacuumTable, and prints the table and overflow pages freed and the speedup of a full scan of
+   * the table, estimated from its pages before and after.
+   */
+  dberr_t ExecuteVacuum(pSyntaxNode ast, ExecuteContext *context);
+
+  /** Vacuum a table of the current database, every table if table_name is null, and print what it did. */
+  dberr_t VacuumTables(const char *table_name, ExecuteContext *context);
+
+  /**
+   * Load the rows of a text file into a table, one row per line, its values separated by commas, strings optionally in
+   * double quotes, null for a null value. The rows are inserted by batches of LOAD_BATCH_SIZE, see
+   * InsertExecutor::InsertRows, a batch that fails stops the load and the batches before it stay loaded.
+   */
+  dberr_t ExecuteLoad(pSyntaxNode ast, ExecuteContext *context);
+
+  /**
+   * Print how the pages of every table, in scan order, and of every index, the leaves in key order, are laid out in
+   * the file of the current database.
+   */
+  dberr_t ShowFragmentationStatus(ExecuteContext *context);
+
+  /** Print how well the pages of every open database compress. */
+  dberr_t ShowCompressionStatus();
+
+  /**
+   * Print the count and latency of the reads and writes of every open database by page class, and the I/O of each of
+   * its files. The same counts, with the full latency histograms, are written to IO_STATUS_FILE_NAME as JSON.
+   */
+  dberr_t ShowIOStatus();
+
+ public:
+  /** Dump of the last SHOW IO STATUS, hidden so that it is not taken for a database. */
+  static constexpr const char *IO_STATUS_FILE_NAME = "./databases/.io_status.json";
+
+  /** Rows inserted at once by a load. */
+  static constexpr size_t LOAD_BATCH_SIZE = 65536;
+
  private:
-  std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all opened databases */
+  std::unordered_map<std::string, DBStorageEngine *> dbs_; /** all databases, nullptr until opened */
   std::string current_db_;                                 /** current database */
+  SharedBufferPool *buffer_pool_;                          /** buffer pool shared by all opened databases */
+  std::chrono::milliseconds idle_timeout_;                 /** see CloseIdleDatabases */
+  bool read_only_;                                         /** open every database read only */
+  bool compress_new_databases_{false};                     /** create databases with compressed pages */
+  bool file_per_table_new_databases_{false};               /** create databases with a file per table and index */
+  std::unordered_map<std::string, std::chrono::steady_clock::time_point> last_used_; /** of the open databases */
+  std::recursive_mutex latch_;                             /** held by a statement or an autovacuum round */
+  std::chrono::seconds autovacuum_interval_;               /** 0 for no autovacuum */
+  std::mutex autovacuum_latch_;                            /** protects autovacuum_interval_ and autovacuum_stop_ */
+  std::condition_variable autovacuum_cv_;                  /** signaled when either of them changes */
+  bool autovacuum_stop_{false};
+  std::thread autovacuum_worker_;
 };
 
 #endif  // MINISQL_EXECUTE_ENGINE_H
@@ -12,7 +12,8 @@
 /**
  * InsertExecutor executes an insert on a table.
  *
- * Inserted values are always pulled from a child executor.
+ * Inserted values are always pulled from a child executor. All of them are pulled by the first Next and inserted at
+ * once by InsertRows, the following calls yield one row per inserted row.
  */
 class InsertExecutor : public AbstractExecutor {
 public:
@@ -41,13 +42,30 @@ public:
   /** @return The output schema for the insert */
   const Schema *GetOutputSchema() const override { return plan_->OutputSchema(); }
 
+  /**
+   * Insert a batch of rows into a table and its indexes. The keys of every index are checked in key order, then handed
+   * to the index in that order at once, so that the keys that go to the same leaf are inserted without searching the
+   * tree again. Every index is treated as unique.
+   * @param[in/out] rows Rows to insert, the rid of every inserted row is set in it
+   * @return DB_FAILED if a key is already in an index or twice in the batch, or the table heap runs out of pages,
+   * nothing is inserted then
+   */
+  static dberr_t InsertRows(ExecuteContext *exec_ctx, TableInfo *table_info, const std::vector<IndexInfo *> &indexes,
+                            std::vector<Row> &rows);
+
 private:
+  /** @return the order of two keys of an index, field by field */
+  static int CompareKeys(const Row &lhs, const Row &rhs);
+
   /** The insert plan node to be executed*/
   const InsertPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_executor_;
   TableInfo *table_info_{};
   const Schema *schema_{};
   std::vector<IndexInfo *> index_info_;
+  bool inserted_{false};
+  size_t num_inserted_{0};
+  size_t cursor_{0};
 };
 
 #endif  // MINISQL_INSERT_EXECUTOR_H
@@ -41,6 +41,9 @@ public:
 
   void TupleTransfer(const Schema *table_schema, const Schema *output_schema, const Row *row, Row *output_row);
 
+  /** Append the table columns an expression reads. */
+  static void CollectColumns(const AbstractExpressionRef &expression, std::vector<uint32_t> &column_ids);
+
 private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
@@ -48,6 +51,9 @@ private:
   TableIterator iterator_;
   const Schema *schema_{};
   bool is_schema_same_;
+  // The rows are scanned with their overflow values deferred, the ones of these columns are read when needed.
+  std::vector<uint32_t> predicate_columns_;
+  std::vector<uint32_t> output_columns_;
 };
 
 #endif  // MINISQL_SEQ_SCAN_EXECUTOR_H
@@ -3,6 +3,7 @@
 
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "concurrency/txn.h"
@@ -10,6 +11,7 @@
 #include "page/b_plus_tree_internal_page.h"
 #include "page/b_plus_tree_leaf_page.h"
 #include "page/b_plus_tree_page.h"
+#include "storage/page_segment.h"
 
 /**
  * Main class providing the API for the Interactive B+ Tree.
@@ -35,6 +37,12 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   bool Insert(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
 
+  // Insert key-value pairs given in ascending key order. The pairs that go to the leaf of the one before are inserted
+  // into it without searching the tree again, until it is full. Returns the number of pairs inserted, a key already
+  // in the tree is skipped.
+  size_t InsertSorted(const std::vector<GenericKey *> &keys, const std::vector<RowId> &values,
+                      Txn *transaction = nullptr);
+
   // Remove a key and its value from this B+ tree.
   void Remove(const GenericKey *key, Txn *transaction = nullptr);
 
@@ -58,6 +66,14 @@ class BPlusTree {
 
   inline page_id_t GetRootPageId() const {return root_page_id_;}
 
+  // layout in the file of the leaf pages, in key order
+  FragmentationReport GetFragmentation();
+
+  // update the page ids kept in the pages of the tree, row ids included, after pages of the file were moved.
+  // moved_rows gives the moved table pages if the table heap is in another file than the tree, see Tablespace
+  void RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved,
+                     const std::unordered_map<page_id_t, page_id_t> *moved_rows = nullptr);
+
   void PrintTree(std::ofstream &out, Schema *schema) {
     if (IsEmpty()) {
       return;
@@ -74,6 +90,10 @@ class BPlusTree {
 
   bool InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transaction = nullptr);
 
+  // the leaf page that key goes to, and in upper_bound the separator key that bounds the keys of that leaf from above,
+  // returns false in bounded if the leaf is the last one
+  page_id_t FindLeafPageId(const GenericKey *key, GenericKey *upper_bound, bool &bounded);
+
   void InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlusTreePage *new_node, Txn *transaction = nullptr);
 
   LeafPage *Split(LeafPage *node, Txn *transaction);
@@ -97,6 +117,9 @@ class BPlusTree {
 
   void UpdateRootPageId(int insert_record = 0);
 
+  void RelocateSubtree(page_id_t page_id, const std::unordered_map<page_id_t, page_id_t> &moved,
+                       const std::unordered_map<page_id_t, page_id_t> &moved_rows);
+
   /* Debug Routines for FREE!! */
   void ToGraph(BPlusTreePage *page, BufferPoolManager *bpm, std::ofstream &out, Schema *schema) const;
 
@@ -109,6 +132,7 @@ class BPlusTree {
   KeyManager processor_;
   int leaf_max_size_;
   int internal_max_size_;
+  std::shared_ptr<PageSegment> segment_;  // new pages of the tree are taken from it, shared by the copies of the tree
 };
 
 #endif  // MINISQL_B_PLUS_TREE_H
@@ -11,6 +11,8 @@ public:
 
   dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) override;
 
+  dberr_t InsertEntries(const std::vector<Row> &keys, const std::vector<RowId> &row_ids, Txn *txn) override;
+
   dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) override;
 
   dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") override;
@@ -25,6 +27,13 @@ public:
 
   BPlusTree GetContainer() { return container_; }
 
+  FragmentationReport GetFragmentation() { return container_.GetFragmentation(); }
+
+  void RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved,
+                     const std::unordered_map<page_id_t, page_id_t> *moved_rows = nullptr) {
+    container_.RelocatePages(moved, moved_rows);
+  }
+
 protected:
   // comparator for key
   KeyManager processor_;
@@ -2,6 +2,7 @@
 #define MINISQL_INDEX_H
 
 #include <memory>
+#include <vector>
 
 #include "common/dberr.h"
 #include "concurrency/txn.h"
@@ -15,6 +16,17 @@ class Index {
 
   virtual dberr_t InsertEntry(const Row &key, RowId row_id, Txn *txn) = 0;
 
+  // keys in ascending order, an index can insert them faster than one by one
+  virtual dberr_t InsertEntries(const std::vector<Row> &keys, const std::vector<RowId> &row_ids, Txn *txn) {
+    dberr_t result = DB_SUCCESS;
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (InsertEntry(keys[i], row_ids[i], txn) != DB_SUCCESS) {
+        result = DB_FAILED;
+      }
+    }
+    return result;
+  }
+
   virtual dberr_t RemoveEntry(const Row &key, RowId row_id, Txn *txn) = 0;
 
   virtual dberr_t ScanKey(const Row &key, std::vector<RowId> &result, Txn *txn, string compare_operator = "=") = 0;
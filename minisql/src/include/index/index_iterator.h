@@ -27,11 +27,18 @@ class IndexIterator {
   bool operator!=(const IndexIterator &itr) const;
 
  private:
+  /**
+   * Called when the iterator enters a new leaf. Keeps the prefetcher reading ahead along the leaf chain, issuing a new
+   * request whenever less than half of the previous read-ahead window is left.
+   */
+  void ReadAhead();
+
   page_id_t current_page_id{INVALID_PAGE_ID};
   LeafPage *page{nullptr};
   int item_index{0};
   BufferPoolManager *buffer_pool_manager{nullptr};
   // add your own private member variables here
+  size_t prefetch_remaining_{0};  // leaves left in the current read-ahead window
 };
 
 #endif  // MINISQL_INDEX_ITERATOR_H
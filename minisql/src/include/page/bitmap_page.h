@@ -2,6 +2,8 @@
 #define MINISQL_BITMAP_PAGE_H
 
 #include <bitset>
+#include <cstdint>
+#include <cstring>
 
 #include "common/config.h"
 #include "common/macros.h"
@@ -14,12 +16,22 @@ class BitmapPage {
    */
   static constexpr size_t GetMaxSupportedSize() { return 8 * MAX_CHARS; }
 
+  /** Pages of a run allocated by AllocateRun, one word of the bitmap. */
+  static constexpr uint32_t RUN_SIZE = 64;
+
   /**
    * @param page_offset Index in extent of the page allocated.
    * @return true if successfully allocate a page.
    */
   bool AllocatePage(uint32_t &page_offset);
 
+  /**
+   * Allocate RUN_SIZE contiguous pages at once, the first free run at or after page_offset, wrapping around.
+   * @param run_offset Index in extent of the first page of the run.
+   * @return true if a run was free.
+   */
+  bool AllocateRun(uint32_t page_offset, uint32_t &run_offset);
+
   /**
    * @return true if successfully de-allocate a page.
    */
@@ -31,7 +43,35 @@ class BitmapPage {
   bool IsPageFree(uint32_t page_offset) const;
   uint32_t GetNextFreePage();
 
+  /** @return the number of allocated pages according to the header */
+  inline uint32_t GetNumAllocatedPages() const { return page_allocated_; }
+
+  /**
+   * Recount the allocated pages from the bits and fix the header if it disagrees.
+   * @return the number of allocated pages
+   */
+  uint32_t RecountAllocatedPages();
+
+  /**
+   * @param page_offset Index in extent of the allocated page with the highest index.
+   * @return false if every page is free.
+   */
+  bool FindLastAllocatedPage(uint32_t &page_offset) const;
+
  private:
+  /**
+   * Find a free page, a word of 64 pages at a time, starting at page_offset and wrapping around.
+   * @return the offset of the free page, GetMaxSupportedSize() if there is none
+   */
+  uint32_t FindFreePage(uint32_t page_offset) const;
+
+  /** @return the 64 bits of pages word_index * 64 to word_index * 64 + 63, a set bit is an allocated page */
+  inline uint64_t GetWord(uint32_t word_index) const {
+    uint64_t word;
+    memcpy(&word, bytes + word_index * sizeof(uint64_t), sizeof(word));
+    return word;
+  }
+
   /**
    * check a bit(byte_index, bit_index) in bytes is free(value 0).
    *
@@ -43,11 +83,15 @@ class BitmapPage {
 
   /** Note: need to update if modify page structure. */
   static constexpr size_t MAX_CHARS = PageSize - 2 * sizeof(uint32_t);
+  static constexpr uint32_t NUM_WORDS = MAX_CHARS / sizeof(uint64_t);
+  static_assert(MAX_CHARS % sizeof(uint64_t) == 0, "The bitmap must be made of whole words.");
+  static_assert(RUN_SIZE == 8 * sizeof(uint64_t), "A run is one word of the bitmap.");
+  static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Bit i % 8 of byte i / 8 is bit i % 64 of word i / 64.");
 
  private:
   /** The space occupied by all members of the class should be equal to the PageSize */
   [[maybe_unused]] uint32_t page_allocated_;
-  [[maybe_unused]] uint32_t next_free_page_;
+  [[maybe_unused]] uint32_t next_free_page_;  // where the search for a free page starts
   [[maybe_unused]] unsigned char bytes[MAX_CHARS];
 };
 
@@ -5,8 +5,6 @@
 
 #include "page/bitmap_page.h"
 
-static constexpr page_id_t MAX_VALID_PAGE_ID = (PAGE_SIZE - 8) / 4 * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
-
 class DiskFileMetaPage {
  public:
   uint32_t GetExtentNums() { return num_extents_; }
@@ -20,10 +18,49 @@ class DiskFileMetaPage {
     return extent_used_page_[extent_id];
   }
 
+  /**
+   * @return the lowest extent that may have a free page, every extent below it is full. Reads as 0 in files written
+   *         before it existed.
+   */
+  uint32_t GetFreeExtentHint() { return extent_used_page_[MAX_EXTENTS]; }
+
+  void SetFreeExtentHint(uint32_t extent_id) { extent_used_page_[MAX_EXTENTS] = extent_id; }
+
+  /**
+   * @return the page size the file was written with. Kept in the last word of the first MIN_PAGE_SIZE bytes, found at
+   *         the same place whatever the page size of the file. Files written before it was recorded have 4 KB pages and
+   *         the free extent hint in this word, or 0 if they are older than the hint, see GetLegacyFreeExtentHint.
+   */
+  uint32_t GetPageSize() { return extent_used_page_[MAX_EXTENTS + 1]; }
+
+  void SetPageSize(uint32_t page_size) { extent_used_page_[MAX_EXTENTS + 1] = page_size; }
+
+  /** @return the free extent hint of a file written before the page size was recorded, only valid in such a file */
+  uint32_t GetLegacyFreeExtentHint() { return extent_used_page_[MAX_EXTENTS + 1]; }
+
+  /**
+   * @return whether the word of the page size can be a free extent hint of a file written before the page size was
+   *         recorded. Those files had room for one more extent, a hint is at most that count.
+   */
+  bool HasLegacyLayout() { return GetPageSize() <= MAX_EXTENTS + 1; }
+
+  /**
+   * Number of extents a file can have, limited by the room for their used page counts in the smallest page. Even with
+   * 4 KB pages, that is more than 100 GB of pages.
+   */
+  static constexpr uint32_t MAX_EXTENTS = (MIN_PAGE_SIZE - 4 * sizeof(uint32_t)) / sizeof(uint32_t);
+
  public:
   uint32_t num_allocated_pages_{0};
   uint32_t num_extents_{0};  // each extent consists with a bit map and BIT_MAP_SIZE pages
   uint32_t extent_used_page_[0];
 };
 
+static_assert(static_cast<uint64_t>(DiskFileMetaPage::MAX_EXTENTS) * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize() <
+                  INT32_MAX,
+              "Every page id must fit in a page_id_t.");
+
+static constexpr page_id_t MAX_VALID_PAGE_ID =
+    DiskFileMetaPage::MAX_EXTENTS * BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
+
 #endif  // MINISQL_DISK_FILE_META_PAGE_H
@@ -3,6 +3,7 @@
 
 #include <cstring>
 #include <iostream>
+#include <new>
 #include <shared_mutex>
 
 #include "common/config.h"
@@ -15,16 +16,23 @@
  */
 class Page {
   // There is book-keeping information inside the page that should only be relevant to the buffer pool manager.
-  friend class BufferPoolManager;
+  friend class BufferPoolManagerInstance;
 
  public:
   DISALLOW_COPY(Page)
 
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Zeros out the page data, which the page owns, for a page used outside a buffer pool. */
+  Page() : data_(new (std::align_val_t(DIRECT_IO_ALIGNMENT)) char[PAGE_SIZE]), owns_data_(true) { ResetMemory(); }
 
-  /** Default destructor. */
-  ~Page() = default;
+  /** Constructor of a buffer pool frame, the data belongs to the arena of its buffer pool instance. */
+  explicit Page(char *data) : data_(data) {}
+
+  /** Destructor. Frees the page data if the page owns it. */
+  ~Page() {
+    if (owns_data_) {
+      ::operator delete[](data_, std::align_val_t(DIRECT_IO_ALIGNMENT));
+    }
+  }
 
   /** @return the actual data contained within this page */
   inline char *GetData() { return data_; }
@@ -68,10 +76,13 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** The actual data that is stored within a page, PAGE_SIZE bytes aligned for direct I/O. */
+  char *data_{nullptr};
+  bool owns_data_{false};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
+  /** The file of this page in a buffer pool shared by several databases. */
+  file_id_t file_id_ = INVALID_FILE_ID;
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
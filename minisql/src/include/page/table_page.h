@@ -18,6 +18,7 @@
  **/
 
 #include <cstring>
+#include <functional>
 
 #include "common/macros.h"
 #include "common/rowid.h"
@@ -43,6 +44,13 @@ class TablePage : public Page {
 
   page_id_t GetNextPageId() { return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_NEXT_PAGE_ID); }
 
+  /** Read the next page id out of the raw content of a table page that is not held in a frame. */
+  static page_id_t GetNextPageId(const char *page_data) {
+    return *reinterpret_cast<const page_id_t *>(page_data + OFFSET_NEXT_PAGE_ID);
+  }
+
+  void SetTablePageId(page_id_t page_id) { memcpy(GetData(), &page_id, sizeof(page_id_t)); }
+
   void SetPrevPageId(page_id_t prev_page_id) {
     memcpy(GetData() + OFFSET_PREV_PAGE_ID, &prev_page_id, sizeof(page_id_t));
   }
@@ -68,6 +76,28 @@ class TablePage : public Page {
 
   bool GetNextTupleRid(const RowId &cur_rid, RowId *next_rid);
 
+  /** @return the bytes left for new tuples, a tuple takes its serialized size plus SIZE_TUPLE */
+  uint32_t GetFreeSpaceRemaining() {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** @return the bytes the tuples of this page take, with their slots, the free space of an empty page minus it */
+  uint32_t GetUsedSpace() { return PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - GetFreeSpaceRemaining(); }
+
+  /**
+   * Defragment the page in place: the tuples marked deleted are removed, the others are packed at the end of the page
+   * in one pass and the empty slots at the end of the slot array are dropped. Slot numbers, hence row ids, of the
+   * tuples left do not change.
+   * @return the number of tuples marked deleted that were removed
+   */
+  uint32_t Compact(Txn *txn, LogManager *log_manager);
+
+  /**
+   * Visit the serialized data of every tuple of the page, the ones marked deleted too, e.g. to find the overflow pages
+   * a tuple refers to. The data may be changed in place as long as its size does not.
+   */
+  void ForEachTuple(const std::function<void(const RowId &rid, char *data, bool is_deleted)> &visit);
+
  private:
   uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
 
@@ -79,10 +109,6 @@ class TablePage : public Page {
 
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  uint32_t GetFreeSpaceRemaining() {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   uint32_t GetTupleOffsetAtSlot(uint32_t slot_num) {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
   }
@@ -109,7 +135,6 @@ class TablePage : public Page {
   static_assert(sizeof(page_id_t) == 4);
   static constexpr uint64_t DELETE_MASK = (1U << (8 * sizeof(uint32_t) - 1));
   static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
@@ -118,6 +143,7 @@ class TablePage : public Page {
   static constexpr size_t OFFSET_TUPLE_SIZE = 28;
 
  public:
+  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t SIZE_MAX_ROW = PAGE_SIZE - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE;
 };
 
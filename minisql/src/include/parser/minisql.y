@@ -1,12 +1,20 @@
 %{
   #include <stdio.h>
+  #include <strings.h>
   #include "parser/parser.h"
 
   extern char *yytext;
   extern int yylex(void);
   int yyerror(char* error);
+
+  /* Words the lexer has no token for arrive as identifiers, this tells whether one is the keyword, ignoring case. */
+  static int MatchKeyword(pSyntaxNode node, const char *keyword) {
+    return node->val_ != NULL && strcasecmp(node->val_, keyword) == 0;
+  }
 %}
 
+%define api.header.include {"parser/minisql_yacc.h"}
+
 %union {
 	pSyntaxNode syntax_node;
 }
@@ -26,8 +34,9 @@
 %type <syntax_node> sql_trx_begin sql_trx_commit sql_trx_rollback
 %type <syntax_node> sql_select select_columns column_values column_value operator
 %type <syntax_node> connector where_conditions where_condition
-%type <syntax_node> sql_insert sql_delete sql_update update_values update_value
+%type <syntax_node> sql_insert insert_rows insert_row sql_delete sql_update update_values update_value
 %type <syntax_node> sql_quit sql_exec_file
+%type <syntax_node> sql_show_status sql_reset_status sql_set_variable sql_vacuum sql_load
 
 %%
 
@@ -58,6 +67,11 @@ sql:
   | sql_trx_rollback { $$ = $1; }
   | sql_quit { $$ = $1; }
   | sql_exec_file { $$ = $1; }
+  | sql_show_status { $$ = $1; }
+  | sql_reset_status { $$ = $1; }
+  | sql_set_variable { $$ = $1; }
+  | sql_vacuum { $$ = $1; }
+  | sql_load { $$ = $1; }
   ;
 
 sql_create_database:
@@ -289,12 +303,37 @@ operator:
   ;
 
 sql_insert:
-  INSERT INTO IDENTIFIER VALUES '(' column_values ')' {
+  INSERT INTO IDENTIFIER VALUES insert_rows {
     $$ = CreateSyntaxNode(kNodeInsert, NULL);
     SyntaxNodeAddChildren($$, $3);
-    pSyntaxNode col_val_node = CreateSyntaxNode(kNodeColumnValues, NULL);
-    SyntaxNodeAddChildren(col_val_node, $6);
-    SyntaxNodeAddChildren($$, col_val_node);
+    // the rows are linked last first, put them back in order
+    pSyntaxNode rows = NULL;
+    pSyntaxNode row = $5;
+    while (row != NULL) {
+      pSyntaxNode next = row->next_;
+      row->next_ = rows;
+      rows = row;
+      row = next;
+    }
+    SyntaxNodeAddChildren($$, rows);
+  }
+  ;
+
+/* left recursive, a long list of rows does not grow the parser stack, each row is linked before the previous ones */
+insert_rows:
+  insert_rows ',' insert_row {
+    $$ = $3;
+    $$->next_ = $1;
+  }
+  | insert_row {
+    $$ = $1;
+  }
+  ;
+
+insert_row:
+  '(' column_values ')' {
+    $$ = CreateSyntaxNode(kNodeColumnValues, NULL);
+    SyntaxNodeAddChildren($$, $2);
   }
   ;
 
@@ -393,6 +432,81 @@ sql_exec_file:
   }
   ;
 
+sql_show_status:
+  SHOW IDENTIFIER IDENTIFIER {
+    $$ = CreateSyntaxNode(kNodeShowStatus, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $3);
+  }
+  ;
+
+/* "reset" and "status" are not keywords of the lexer, eg: reset bufferpool status; */
+sql_reset_status:
+  IDENTIFIER IDENTIFIER IDENTIFIER {
+    if (!MatchKeyword($1, "reset") || !MatchKeyword($3, "status")) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeResetStatus, NULL);
+    SyntaxNodeAddChildren($$, $1);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $3);
+  }
+  ;
+
+sql_set_variable:
+  SET IDENTIFIER EQ NUMBER {
+    $$ = CreateSyntaxNode(kNodeSetVariable, NULL);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  ;
+
+/* "vacuum" is not a keyword of the lexer either, eg: vacuum; vacuum t; vacuum file; */
+sql_vacuum:
+  IDENTIFIER {
+    if (!MatchKeyword($1, "vacuum")) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+    SyntaxNodeAddChildren($$, $1);
+  }
+  | IDENTIFIER IDENTIFIER {
+    if (!MatchKeyword($1, "vacuum")) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeVacuum, NULL);
+    SyntaxNodeAddChildren($$, $1);
+    SyntaxNodeAddChildren($$, $2);
+  }
+  ;
+
+/* "load" and "data" are not keywords of the lexer either, eg: load t from "t.csv"; load data t from "t.csv"; */
+sql_load:
+  IDENTIFIER IDENTIFIER FROM STRING {
+    if (!MatchKeyword($1, "load")) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoad, NULL);
+    SyntaxNodeAddChildren($$, $1);
+    SyntaxNodeAddChildren($$, $2);
+    SyntaxNodeAddChildren($$, $4);
+  }
+  | IDENTIFIER IDENTIFIER IDENTIFIER FROM STRING {
+    if (!MatchKeyword($1, "load") || !MatchKeyword($2, "data")) {
+      yyerror("syntax error");
+      YYABORT;
+    }
+    $$ = CreateSyntaxNode(kNodeLoad, NULL);
+    SyntaxNodeAddChildren($$, $1);
+    SyntaxNodeAddChildren($$, $3);
+    SyntaxNodeAddChildren($$, $5);
+  }
+  ;
+
 %%
 int yyerror(char* error) {
 	MinisqlParserSetError(error);
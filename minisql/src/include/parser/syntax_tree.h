@@ -43,7 +43,12 @@ typedef enum {
   kNodeIndexType,            /** type of index */
   kNodeTrxBegin,             /** begin recovery command */
   kNodeTrxCommit,            /** commit recovery command */
-  kNodeTrxRollback           /** rollback recovery command */
+  kNodeTrxRollback,          /** rollback recovery command */
+  kNodeShowStatus,           /** show <component> status command, eg: show bufferpool status */
+  kNodeResetStatus,          /** reset <component> status command, eg: reset bufferpool status */
+  kNodeSetVariable,          /** set <variable> = <number> command, eg: set buffer_pool_size = 4096 */
+  kNodeVacuum,               /** vacuum [<target>] command, eg: vacuum, vacuum t, vacuum file */
+  kNodeLoad                  /** load <table> from <file> command, eg: load t from "t.csv" */
 } SyntaxNodeType;
 
 /**
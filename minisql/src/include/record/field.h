@@ -67,6 +67,7 @@ class Field {
     len_ = other.len_;
     is_null_ = other.is_null_;
     manage_data_ = other.manage_data_;
+    overflow_page_id_ = other.overflow_page_id_;
     if (type_id_ == TypeId::kTypeChar && !is_null_ && manage_data_) {
       value_.chars_ = new char[len_];
       memcpy(value_.chars_, other.value_.chars_, len_);
@@ -83,6 +84,18 @@ class Field {
 
   inline bool IsNull() const { return is_null_; }
 
+  /**
+   * @return true for a CHAR value stored in overflow pages that was not read yet, it has a length but no data, see
+   * TableHeap::FetchOverflow
+   */
+  inline bool IsDeferred() const { return !is_null_ && type_id_ == TypeId::kTypeChar && value_.chars_ == nullptr; }
+
+  /** @return the first overflow page of a CHAR value stored out of line, INVALID_PAGE_ID for a value stored in row */
+  inline page_id_t GetOverflowPageId() const { return overflow_page_id_; }
+
+  /** Have the value serialized as a pointer to its overflow pages, INVALID_PAGE_ID to have it serialized in row. */
+  inline void SetOverflowPageId(page_id_t page_id) { overflow_page_id_ = page_id; }
+
   inline uint32_t GetLength() const { return Type::GetInstance(type_id_)->GetLength(*this); }
 
   inline TypeId GetTypeId() const { return type_id_; }
@@ -127,6 +140,7 @@ class Field {
     std::swap(first.len_, second.len_);
     std::swap(first.is_null_, second.is_null_);
     std::swap(first.manage_data_, second.manage_data_);
+    std::swap(first.overflow_page_id_, second.overflow_page_id_);
   }
 
   std::string toString() {
@@ -137,10 +151,7 @@ class Field {
     else if (type_id_ == kTypeFloat)
       return std::to_string(value_.float_);
     else {
-      char temp[len_ + 1];
-      memcpy(temp, value_.chars_, len_);
-      temp[len_] = '\0';
-      return {temp};
+      return {value_.chars_, strnlen(value_.chars_, len_)};
     }
   }
 
@@ -154,6 +165,7 @@ class Field {
   uint32_t len_;
   bool is_null_{false};
   bool manage_data_{false};
+  page_id_t overflow_page_id_{INVALID_PAGE_ID};
 };
 
 #endif  // MINISQL_FIELD_H
@@ -99,6 +99,15 @@ class TypeChar : public Type {
  public:
   explicit TypeChar() : Type(TypeId::kTypeChar) {}
 
+  /**
+   * Set in the serialized length of a value stored out of line, see Field::GetOverflowPageId. The length is followed
+   * by the first overflow page id instead of the data.
+   */
+  static constexpr uint32_t OVERFLOW_FLAG = 1U << 31;
+
+  /** Serialized size of a value stored out of line. */
+  static constexpr uint32_t SIZE_OVERFLOW_POINTER = sizeof(uint32_t) + sizeof(page_id_t);
+
   virtual uint32_t SerializeTo(const Field &field, char *buf) const override;
 
   virtual uint32_t DeserializeFrom(char *storage, Field **field, bool is_null) const override;
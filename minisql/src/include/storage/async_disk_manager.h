@@ -0,0 +1,170 @@
+#ifndef MINISQL_ASYNC_DISK_MANAGER_H
+#define MINISQL_ASYNC_DISK_MANAGER_H
+
+#include <sys/uio.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk_manager.h"
+
+/**
+ * How an AsyncDiskManager runs its I/O.
+ * IO_URING: one io_uring per AsyncDiskManager, requests are handed to the kernel in batches without blocking.
+ * THREAD_POOL: worker threads doing blocking reads and writes through the DiskManager.
+ * AUTO: io_uring if the build and the kernel support it, the thread pool otherwise.
+ */
+enum class AsyncIOEngine { AUTO, IO_URING, THREAD_POOL };
+
+/** Result of a request, tag is the value given when it was queued. */
+struct AsyncIOCompletion {
+  uint64_t tag_;
+  bool ok_;
+};
+
+/**
+ * AsyncDiskManager keeps up to queue_depth page reads and writes in flight. Requests are queued with QueueRead and
+ * QueueWrite, handed over in one batch by Submit, and reaped with WaitCompletions. A read past the end of the file
+ * returns zeros, like DiskManager::ReadPage. The page buffers must stay valid until the request completes.
+ *
+ * An AsyncDiskManager is used by a single thread at a time, each user of asynchronous I/O owns one. Pages of a
+ * DiskManager with the FSTREAM backend, and buffers that are not aligned for a DiskManager doing direct I/O, are read
+ * and written synchronously when queued.
+ */
+class AsyncDiskManager {
+ public:
+  explicit AsyncDiskManager(size_t queue_depth = DEFAULT_IO_QUEUE_DEPTH, AsyncIOEngine engine = AsyncIOEngine::AUTO);
+
+  /**
+   * Wait for the requests in flight, their completions are dropped.
+   */
+  ~AsyncDiskManager();
+
+  /**
+   * Queue a read of a logical page into page_data.
+   * @return false if queue_depth requests are queued or in flight already
+   */
+  bool QueueRead(DiskManager *disk_manager, page_id_t logical_page_id, char *page_data, uint64_t tag);
+
+  /**
+   * Queue a write of page_data to a logical page. Nothing is synced, see DiskManager::Sync.
+   * @return false if queue_depth requests are queued or in flight already
+   */
+  bool QueueWrite(DiskManager *disk_manager, page_id_t logical_page_id, const char *page_data, uint64_t tag);
+
+  /**
+   * Start the queued requests.
+   * @return the number of requests started
+   */
+  size_t Submit();
+
+  /**
+   * Wait until at least min_complete requests have completed, or all of them if fewer are in flight, and append the
+   * completions to completions. Queued requests are submitted first.
+   * @return the number of completions appended
+   */
+  size_t WaitCompletions(size_t min_complete, std::vector<AsyncIOCompletion> *completions);
+
+  /**
+   * Write a batch of pages, possibly of several files, keeping the queue full, and wait until every request in flight
+   * has completed. Their completions are dropped.
+   * @param pages disk manager, logical page id and data of every page to write
+   * @param[out] failed if not null, the indexes in pages of the writes that failed are appended to it
+   * @return false if a write failed
+   */
+  bool WritePages(const std::vector<std::tuple<DiskManager *, page_id_t, const char *>> &pages,
+                  std::vector<size_t> *failed = nullptr);
+
+  /** @return the number of requests queued or in flight, or completed and not handed out yet */
+  inline size_t GetNumPending() const { return num_pending_; }
+
+  inline size_t GetQueueDepth() const { return queue_depth_; }
+
+  /** @return the engine actually used, never AUTO */
+  inline AsyncIOEngine GetEngine() const { return engine_; }
+
+  /** Upper bound on the threads of the THREAD_POOL engine, whatever the queue depth. */
+  static constexpr size_t MAX_WORKERS = 16;
+
+ private:
+  struct Request {
+    DiskManager *disk_manager_;
+    page_id_t page_id_;
+    char *data_;
+    bool is_write_;
+    uint64_t tag_;
+    iovec iov_;  // read or written by the kernel until the request completes
+    std::chrono::steady_clock::time_point submitted_;  // io_uring only, for the I/O statistics of the disk manager
+    uint32_t num_done_bytes_;                          // io_uring only, the rest of a short transfer is submitted again
+  };
+
+  bool Queue(DiskManager *disk_manager, page_id_t logical_page_id, char *page_data, bool is_write, uint64_t tag);
+
+  /** @return false if io_uring is not available, the ring is left unset */
+  bool SetUpRing();
+
+  void TearDownRing();
+
+  /** Hand a finished request back to the caller and free its slot. */
+  void Complete(size_t slot, bool ok, std::vector<AsyncIOCompletion> *completions);
+
+  /** Reap the completions the kernel has posted, without blocking. */
+  size_t ReapRing(std::vector<AsyncIOCompletion> *completions);
+
+  /**
+   * Hand the entries of the submission ring the kernel has not taken yet over to it, and wait for min_complete
+   * completions if not 0.
+   * @return false if io_uring_enter failed for another reason than an interruption or a lack of resources
+   */
+  bool EnterRing(size_t min_complete);
+
+  /** Take the entries the kernel has not taken back out of the submission ring, and fail their requests. */
+  size_t FailUnsubmitted(std::vector<AsyncIOCompletion> *completions);
+
+  /** Body of a thread pool worker. */
+  void Worker();
+
+ private:
+  size_t queue_depth_;
+  AsyncIOEngine engine_;
+  std::vector<Request> requests_;             // one slot per request in flight, the user data of the ring is the slot
+  std::vector<size_t> free_slots_;
+  std::vector<size_t> queued_;                // slots queued but not submitted
+  size_t num_pending_{0};                     // requests queued or in flight
+  std::vector<AsyncIOCompletion> completed_;  // completions of synchronous requests not handed out yet
+
+  // io_uring engine
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  void *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  void *cqes_{nullptr};
+  unsigned num_unsubmitted_{0};  // entries at the tail of the submission ring the kernel has not taken yet
+
+  // thread pool engine
+  std::mutex latch_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::deque<size_t> work_;                           // slots submitted to the workers
+  std::vector<std::pair<size_t, bool>> worker_done_;  // slot and result of the requests done by the workers
+  std::vector<std::thread> workers_;
+  bool stop_{false};
+};
+
+#endif  // MINISQL_ASYNC_DISK_MANAGER_H
@@ -0,0 +1,130 @@
+#ifndef MINISQL_COMPRESSED_PAGE_STORE_H
+#define MINISQL_COMPRESSED_PAGE_STORE_H
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+/**
+ * CompressedPageStore keeps the data pages of a database file compressed, each one in a block of whole sectors of a
+ * block file. A block map file gives the block of every logical page:
+ *
+ * Block file: | block of page 7 | block of page 2 | free | block of page 3 | ...
+ * Block map file: | entry of page 0 | entry of page 1 | ... |   entry: | first sector | stored size | flags |
+ *
+ * A page that does not compress by a sector at least is stored as is. Every write of a page goes to a new block, the
+ * map points at it once it is written. The block the map on disk points at is never overwritten: the sectors a block
+ * leaves behind are reused only after the next Sync, once the block map on disk no longer points at them. The free
+ * sectors are not persisted, they are the gaps between the blocks of the map when the store is opened.
+ *
+ * Both files are hidden next to the database file. Pages are compressed and decompressed by the caller's thread, reads
+ * and writes of different pages go on concurrently.
+ */
+class CompressedPageStore {
+ public:
+  /**
+   * Open the store of a database file, creating its files if they do not exist.
+   * @throw std::runtime_error if the files cannot be opened
+   */
+  explicit CompressedPageStore(const std::string &db_file);
+
+  ~CompressedPageStore();
+
+  /** @return true if a database file has a store, i.e. its data pages are compressed */
+  static bool Exists(const std::string &db_file);
+
+  /** Delete the files of the store of a database file, if any. */
+  static void Remove(const std::string &db_file);
+
+  /** Read a page, zeros if it was never written or was freed. */
+  void ReadPage(page_id_t page_id, char *page_data);
+
+  void WritePage(page_id_t page_id, const char *page_data);
+
+  /** Drop the block of a freed page. */
+  void FreePage(page_id_t page_id);
+
+  /**
+   * Make the blocks written so far durable, then write back the block map as it was before, so that it only points at
+   * durable blocks. The blocks left behind before become reusable.
+   */
+  void Sync();
+
+  /**
+   * Cut the free sectors off the end of the block file.
+   * @return the number of bytes cut off
+   */
+  uint64_t Truncate();
+
+  /**
+   * @param file_size set to the size of both files
+   * @param disk_usage set to the space both files occupy on disk, holes excluded
+   */
+  void GetFileUsage(uint64_t *file_size, uint64_t *disk_usage);
+
+  /** @return the number of pages stored */
+  size_t GetNumPages();
+
+  /** @return the bytes the stored pages take compressed, sector padding excluded */
+  uint64_t GetStoredBytes();
+
+  /** Bytes in a sector, the unit blocks are allocated in. */
+  static constexpr size_t SECTOR_SIZE = 256;
+
+ private:
+  struct BlockMapEntry {
+    uint32_t first_sector_;
+    uint16_t stored_size_;  // 0 if the page has no block
+    uint16_t flags_;
+  };
+
+  /** Set in the flags of a page stored uncompressed. */
+  static constexpr uint16_t RAW_PAGE = 1;
+
+  /** Entries of the block map written back at once. */
+  static constexpr size_t MAP_CHUNK_SIZE = 512;
+
+  static inline uint32_t GetNumSectors(size_t stored_size) {
+    return static_cast<uint32_t>((stored_size + SECTOR_SIZE - 1) / SECTOR_SIZE);
+  }
+
+  static std::string GetBlockFileName(const std::string &db_file);
+
+  static std::string GetBlockMapFileName(const std::string &db_file);
+
+  /** @return the first sector of a new block, from the free sectors if a gap is large enough, at the end otherwise */
+  uint32_t AllocateSectors(uint32_t num_sectors);
+
+  /** Give sectors back to the free space, merged with their free neighbours. */
+  void AddFreeSectors(uint32_t first_sector, uint32_t num_sectors);
+
+  /** Keep sectors a block leaves behind until the next Sync. */
+  void ReleaseSectors(uint32_t first_sector, uint32_t num_sectors);
+
+  void MarkDirty(page_id_t page_id);
+
+ private:
+  std::string block_file_name_;
+  std::string block_map_file_name_;
+  int block_fd_{-1};
+  int block_map_fd_{-1};
+  std::mutex sync_latch_;  // serializes Sync, so that an older map is not written over a newer one
+  // everything below is protected by latch_
+  std::mutex latch_;
+  std::vector<BlockMapEntry> block_map_;                        // by logical page id
+  std::vector<bool> map_chunk_dirty_;                           // by chunk of MAP_CHUNK_SIZE entries
+  std::map<uint32_t, uint32_t> free_by_sector_;                 // first sector -> number of sectors of every gap
+  std::set<std::pair<uint32_t, uint32_t>> free_by_size_;        // number of sectors, first sector of every gap
+  std::vector<std::pair<uint32_t, uint32_t>> released_sectors_;  // first sector, number of sectors, until the next sync
+  uint32_t num_sectors_{0};                                     // end of the blocks, the last gap excluded
+  size_t num_pages_{0};
+  uint64_t stored_bytes_{0};
+};
+
+#endif  // MINISQL_COMPRESSED_PAGE_STORE_H
@@ -1,16 +1,36 @@
 #ifndef DISK_MGR_H
 #define DISK_MGR_H
 
+#include <sys/types.h>
+
 #include <atomic>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "common/macros.h"
 #include "page/bitmap_page.h"
 #include "page/disk_file_meta_page.h"
+#include "storage/compressed_page_store.h"
+#include "storage/io_stats.h"
+#include "storage/page_segment.h"
+
+/**
+ * How a DiskManager accesses its file.
+ * FSTREAM: one std::fstream, every access is serialized and every write is flushed to the OS.
+ * PREAD: a file descriptor with positional pread / pwrite, data pages are read and written concurrently without any
+ *        latch, writes reach the disk at the explicit Sync points only.
+ * MMAP: the file is opened read only and mapped into memory, pages are used in place through GetMappedPage, reads copy
+ *       out of the mapping and writes, allocations and frees are refused. For read-only copies of a database.
+ */
+enum class DiskIOBackend { FSTREAM, PREAD, MMAP };
 
 /**
  * DiskManager takes care of the allocation and de allocation of pages within a database. It performs the reading and
@@ -19,10 +39,30 @@
  * Disk page storage format: (Free Page BitMap Size = PAGE_SIZE * 8, we note it as N)
  * | Meta Page | Free Page BitMap 1 | Page 1 | Page 2 | ....
  *      | Page N | Free Page BitMap 2 | Page N+1 | ... | Page 2N | ... |
+ *
+ * The bitmap pages are read once and kept in memory, allocating or freeing a page does no I/O. The bitmap pages and
+ * the meta page modified since are written back by Sync and Close. Pages reserved for a segment and not handed out
+ * yet are written back as free, a crash does not leak them.
+ *
+ * With the PREAD backend, the space of the pages freed since the last Sync is returned to the file system by Sync
+ * with FALLOC_FL_PUNCH_HOLE, so dropping a table frees disk space even though the file keeps its size. Truncate cuts
+ * the free pages off the end of the file.
+ *
+ * A file created with compression keeps its data pages compressed in a CompressedPageStore instead, the meta page and
+ * the bitmap pages stay in the file. The buffer pool sees the pages uncompressed.
  */
 class DiskManager {
  public:
-  explicit DiskManager(const std::string &db_file);
+  /**
+   * @param direct_io open the file with O_DIRECT so that pages bypass the kernel page cache and are only cached by the
+   *                  buffer pool, PREAD backend only. Buffers not aligned to DIRECT_IO_ALIGNMENT go through a bounce
+   *                  buffer. Falls back to buffered I/O if the file system does not support it.
+   * @param compress compress the data pages of a new file. A file created with compression is always opened with it,
+   *                 one created without never is. Not available with the MMAP backend.
+   * @throw std::runtime_error if the file has another page size, or has compressed pages and the backend is MMAP
+   */
+  explicit DiskManager(const std::string &db_file, DiskIOBackend backend = DiskIOBackend::PREAD,
+                       bool direct_io = false, bool compress = false);
 
   ~DiskManager() {
     if (!closed) {
@@ -42,12 +82,37 @@ class DiskManager {
    */
   void WritePage(page_id_t logical_page_id, const char *page_data);
 
+  /**
+   * Write a batch of pages. The pages are sorted by physical page id and every run of physically contiguous pages is
+   * written with a single call, so flushing a large pool turns into a mostly sequential pass over the file.
+   * @param pages logical page id and data of every page to write, page ids must be distinct
+   */
+  void WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
   /**
    * Get next free page from disk
    * @return logical page id of allocated page
    */
   page_id_t AllocatePage();
 
+  /**
+   * Get next page of a segment, from the run of SEGMENT_RUN_SIZE contiguous pages reserved for it. Once the run is used
+   * up, the next one is reserved right after it if it is free, as near as possible otherwise. Falls back to
+   * AllocatePage() when no run is free anywhere.
+   * @return logical page id of allocated page
+   */
+  page_id_t AllocatePage(PageSegment *segment);
+
+  /**
+   * Free the pages reserved for a segment and not handed out yet. The segment can be used again afterwards.
+   */
+  void ReleaseSegment(PageSegment *segment);
+
+  /**
+   * Free the pages reserved for every segment, see ReleaseSegment. The segments reserve their next run from scratch.
+   */
+  void ReleaseSegments();
+
   /**
    * Free this page and reset bit map
    */
@@ -58,11 +123,73 @@ class DiskManager {
    */
   bool IsPageFree(page_id_t logical_page_id);
 
+  /**
+   * Write back the page allocation state and make the pages written so far durable. Called after a batch of writes,
+   * e.g. a flush of the whole pool, rather than after every page.
+   */
+  void Sync();
+
+  /**
+   * Shrink the file to its last allocated page, the bitmaps of the empty extents at the end included. The allocation
+   * state is written back.
+   * @return the number of bytes cut off the file
+   */
+  uint64_t Truncate();
+
+  /**
+   * @param file_size set to the size of the file
+   * @param disk_usage set to the space the file occupies on disk, holes excluded
+   */
+  void GetFileUsage(uint64_t *file_size, uint64_t *disk_usage);
+
+  /** @return the bytes of freed pages punched out of the file since it was opened */
+  inline uint64_t GetNumPunchedBytes() const { return punched_bytes_; }
+
   /**
    * Shut down the disk manager and close all the file resources.
    */
   void Close();
 
+  inline DiskIOBackend GetBackend() const { return backend_; }
+
+  inline const std::string &GetFileName() const { return file_name_; }
+
+  /** @return true if the file is opened read only, with the MMAP backend */
+  inline bool IsReadOnly() const { return backend_ == DiskIOBackend::MMAP; }
+
+  /**
+   * @return the data of a logical page in the mapping of the file, which must not be written, or nullptr if the page
+   *         lies beyond the end of the file. MMAP backend only.
+   */
+  const char *GetMappedPage(page_id_t logical_page_id);
+
+  /** @return true if the file is opened with O_DIRECT */
+  inline bool IsDirectIO() const { return direct_io_; }
+
+  /** @return true if a buffer can be used for I/O on the file without a bounce buffer */
+  inline bool IsAligned(const char *page_data) const {
+    return !direct_io_ || reinterpret_cast<uintptr_t>(page_data) % DIRECT_IO_ALIGNMENT == 0;
+  }
+
+  /** @return the descriptor of the file for asynchronous I/O, -1 with the FSTREAM backend or compressed pages */
+  inline int GetFd() const { return page_store_ == nullptr ? fd_ : -1; }
+
+  /** @return the store of the compressed data pages, nullptr if the pages are not compressed */
+  inline CompressedPageStore *GetPageStore() const { return page_store_.get(); }
+
+  /** @return the count and latency of the reads, writes and flushes of the file, by page class */
+  inline IOStats &GetIOStats() { return io_stats_; }
+
+  /** Account for a data page read or written without going through ReadPage or WritePage, by asynchronous I/O. */
+  inline void RecordIO(page_id_t logical_page_id, const char *page_data, IOType type, uint64_t latency_ns) {
+    io_stats_.Record(IOStats::ClassifyPage(logical_page_id, page_data), type, latency_ns);
+  }
+
+  /** @return the position of a logical page in the file, in bytes */
+  inline off_t GetPageOffset(page_id_t logical_page_id) {
+    return static_cast<off_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  }
+
   /**
    * Get Meta Page
    * Note: Used only for debug
@@ -71,6 +198,9 @@ class DiskManager {
 
   static constexpr size_t BITMAP_SIZE = BitmapPage<PAGE_SIZE>::GetMaxSupportedSize();
 
+  /** Pages reserved at once for a segment. */
+  static constexpr size_t SEGMENT_RUN_SIZE = BitmapPage<PAGE_SIZE>::RUN_SIZE;
+
  private:
   /**
    * Helper function to get disk file size
@@ -87,19 +217,81 @@ class DiskManager {
    */
   void WritePhysicalPage(page_id_t physical_page_id, const char *page_data);
 
+  /** Write the pages of WritePages, uncompressed, contiguous ones at once. */
+  void WritePageRuns(const std::vector<std::pair<page_id_t, const char *>> &pages);
+
+  /** Read or write the meta page or a bitmap page, accounted for as PageClass::META. */
+  void ReadMetaPage(page_id_t physical_page_id, char *page_data);
+
+  void WriteMetaPage(page_id_t physical_page_id, const char *page_data);
+
+  /**
+   * Record the page size in the meta page of a new file, or in one written before it was recorded. Files of 4 KB pages
+   * written before then are accepted by 4 KB builds only.
+   * @throw std::runtime_error if the pages of the file are not PAGE_SIZE bytes, the file is closed
+   */
+  void CheckPageSize();
+
+  /** Open the store of the compressed pages if the file has one, or if it is new and compress is set. */
+  void OpenPageStore(bool compress);
+
+  /** Close the file and throw a std::runtime_error, for a file that can not be opened. */
+  [[noreturn]] void CloseAndThrow(const std::string &message);
+
   /**
    * Map logical page id to physical page id
    */
   page_id_t MapPageId(page_id_t logical_page_id);
 
+  static inline page_id_t GetBitmapPhysicalPageId(uint32_t extent_id) { return 1 + extent_id * (BITMAP_SIZE + 1); }
+
+  /**
+   * @return the cached bitmap page of an extent, read from the file on first use. Its used page count in the meta page
+   *         is corrected if it disagrees with the bitmap.
+   */
+  BitmapPage<PAGE_SIZE> *GetBitmapPage(uint32_t extent_id);
+
+  /**
+   * Reserve a new run of pages for a segment.
+   * @return false if no run is free
+   */
+  bool ReserveRun(PageSegment *segment);
+
+  /** Account for pages just allocated in an extent in the meta page. */
+  void AddAllocatedPages(uint32_t extent_id, uint32_t num_pages);
+
+  /** Write back the bitmap pages and the meta page modified since the last call. */
+  void WriteAllocationState();
+
+  /** Punch the pages freed since the last call out of the file, those still free. */
+  void PunchFreedPages();
+
  private:
-  // stream to write db file
+  DiskIOBackend backend_;
+  // stream to write db file, FSTREAM backend
   std::fstream db_io_;
+  // descriptor of the db file, PREAD backend
+  int fd_{-1};
+  bool direct_io_{false};
+  // mapping of the whole file, MMAP backend
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
   std::string file_name_;
-  // with multiple buffer pool instances, need to protect file access
+  // with multiple buffer pool instances, need to protect file access. The PREAD backend only takes it for the meta and
+  // bitmap pages.
   std::recursive_mutex db_io_latch_;
   bool closed{false};
-  char meta_data_[PAGE_SIZE];
+  alignas(DIRECT_IO_ALIGNMENT) char meta_data_[PAGE_SIZE];
+  // page allocation state, protected by db_io_latch_
+  std::vector<std::unique_ptr<BitmapPage<PAGE_SIZE>>> bitmap_pages_;  // by extent, null until first used
+  std::vector<bool> bitmap_dirty_;
+  bool meta_dirty_{false};
+  std::unordered_set<PageSegment *> segments_;  // segments with pages reserved and not handed out yet
+  std::vector<page_id_t> freed_pages_;          // freed since the last sync, PREAD backend
+  bool punch_holes_{true};                      // cleared if the file system cannot punch holes
+  std::atomic<uint64_t> punched_bytes_{0};
+  std::unique_ptr<CompressedPageStore> page_store_;  // data pages, if compressed
+  IOStats io_stats_;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,120 @@
+#ifndef MINISQL_FREE_SPACE_MAP_H
+#define MINISQL_FREE_SPACE_MAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/config.h"
+
+/**
+ * FreeSpaceMap records the approximate free bytes of every page of a table heap, so that an insert goes straight to a
+ * page with room instead of trying the pages of the heap one by one. The free bytes of a page are kept in one byte, in
+ * units of PAGE_SIZE / 256 rounded down: a page the map says has room for a tuple does have it, unless the map is
+ * behind the page.
+ *
+ * The map is persisted in a chain of map pages, one entry per heap page in chain order:
+ *
+ * Map page: | page id (4) | next map page id (4) | num entries (4) | heap page ids (4 each) | free units (1 each) |
+ *
+ * The whole map is mirrored in memory once loaded, with the largest free units of every block of BLOCK_SIZE entries,
+ * so that a page with room is found without looking at the entries of full blocks. Every change of an entry is
+ * written through to its map page. Without a buffer pool that can allocate pages, e.g. on a read-only file, the map
+ * lives in memory only.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * @param first_page_id first map page, INVALID_PAGE_ID if the map has no pages yet, they are created by the first
+   * AddPage
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id = INVALID_PAGE_ID)
+      : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {}
+
+  /** @return the first map page, INVALID_PAGE_ID if the map is not persisted */
+  inline page_id_t GetFirstPageId() const { return first_page_id_; }
+
+  /** Read the map from its pages into memory, an empty map if it has none. The caller appends the pages it misses. */
+  void Load();
+
+  bool IsLoaded();
+
+  /** Forget the map in memory, the next Load reads it again from its pages. */
+  void Unload();
+
+  /** Append an entry for the next page of the heap, or update the entry of a page the map already has. */
+  void AddPage(page_id_t page_id, uint32_t free_bytes);
+
+  /** Record the free bytes of a page of the heap, nothing if the page has no entry. */
+  void UpdatePage(page_id_t page_id, uint32_t free_bytes);
+
+  /** @return true if the map says a page has at least size free bytes */
+  bool HasRoom(page_id_t page_id, uint32_t size);
+
+  /** @return a page with at least size free bytes, the first one in chain order, INVALID_PAGE_ID if there is none */
+  page_id_t FindPage(uint32_t size);
+
+  /** @return the last page of the heap, INVALID_PAGE_ID if the map is empty */
+  page_id_t GetLastPage();
+
+  /** @return the number of heap pages in the map */
+  size_t GetNumPages();
+
+  /** Delete the pages of the map. */
+  void FreePages();
+
+  /**
+   * Update the page ids kept in the map pages after pages of the file were moved, see BufferPoolManager::CompactFile.
+   * The map in memory is dropped, the next Load reads it again.
+   */
+  void RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved);
+
+  /** Entries in a map page. */
+  static constexpr size_t ENTRIES_PER_PAGE = (PAGE_SIZE - 12) / 5;
+
+  /** Entries summarized by one largest free units value in memory. */
+  static constexpr size_t BLOCK_SIZE = 256;
+
+  /** Free bytes in a unit of the map. */
+  static constexpr uint32_t UNIT_SIZE = PAGE_SIZE / 256;
+
+ private:
+  static constexpr size_t OFFSET_NEXT_PAGE_ID = 4;
+  static constexpr size_t OFFSET_NUM_ENTRIES = 8;
+  static constexpr size_t OFFSET_PAGE_IDS = 12;
+  static constexpr size_t OFFSET_FREE_UNITS = OFFSET_PAGE_IDS + 4 * ENTRIES_PER_PAGE;
+
+  /** @return the free units recorded for free bytes, rounded down */
+  static inline uint8_t ToUnits(uint32_t free_bytes) {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_bytes / UNIT_SIZE, UINT8_MAX));
+  }
+
+  /** @return the free units a page needs for size bytes, rounded up */
+  static inline uint32_t ToNeededUnits(uint32_t size) { return (size + UNIT_SIZE - 1) / UNIT_SIZE; }
+
+  /** Write an entry through to its map page, creating the page for the first entry of it. */
+  void WriteEntry(size_t entry);
+
+  /** Record the free units of an entry and write it through if they changed. */
+  void SetEntry(size_t entry, uint8_t units);
+
+  void UpdateBlockMax(size_t block);
+
+ private:
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_;
+  // everything below is protected by latch_
+  std::mutex latch_;
+  bool loaded_{false};
+  bool persisted_{true};                           // false once the map could not get a page, it stays in memory
+  std::vector<page_id_t> map_page_ids_;            // pages of the map, in chain order
+  std::vector<page_id_t> page_ids_;                // heap page of every entry, in chain order
+  std::vector<uint8_t> free_units_;                // free units of every entry
+  std::vector<uint8_t> block_max_;                 // largest free units of every block of entries
+  std::unordered_map<page_id_t, size_t> entries_;  // heap page id -> entry
+};
+
+#endif  // MINISQL_FREE_SPACE_MAP_H
@@ -0,0 +1,91 @@
+#ifndef MINISQL_IO_STATS_H
+#define MINISQL_IO_STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+#include "common/config.h"
+#include "common/latency_histogram.h"
+
+/** What a page of a database file holds, as far as its I/O is concerned. */
+enum class PageClass {
+  META = 0,  // file meta page and allocation bitmaps, written by the disk manager itself
+  CATALOG,   // catalog meta page, index roots page, table and index metadata
+  TABLE,     // table heap pages
+  INDEX,     // B+ tree pages
+  OTHER,     // free pages and anything not recognized
+};
+
+enum class IOType { READ = 0, WRITE };
+
+/**
+ * Count and latency distribution of the physical reads and writes of one database file, by page class, and of its
+ * flushes, which cover the whole file. Every I/O is timed, the cost of reading the clock is negligible next to a
+ * system call. Like BufferPoolStats the counters are updated without any latch.
+ */
+class IOStats {
+ public:
+  static constexpr size_t NUM_PAGE_CLASSES = 5;
+  static constexpr size_t NUM_IO_TYPES = 2;
+
+  inline void Record(PageClass page_class, IOType type, uint64_t latency_ns) {
+    size_t c = static_cast<size_t>(page_class);
+    size_t t = static_cast<size_t>(type);
+    latency_[c][t].Record(latency_ns);
+    total_ns_[c][t].fetch_add(latency_ns, std::memory_order_relaxed);
+  }
+
+  inline void RecordFlush(uint64_t latency_ns) {
+    flush_latency_.Record(latency_ns);
+    flush_total_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  }
+
+  inline const LatencyHistogram &GetLatency(PageClass page_class, IOType type) const {
+    return latency_[static_cast<size_t>(page_class)][static_cast<size_t>(type)];
+  }
+
+  inline uint64_t GetCount(PageClass page_class, IOType type) const { return GetLatency(page_class, type).GetTotal(); }
+
+  /** @return the time spent in the I/O of a class in ns */
+  inline uint64_t GetTotalLatency(PageClass page_class, IOType type) const {
+    return total_ns_[static_cast<size_t>(page_class)][static_cast<size_t>(type)].load(std::memory_order_relaxed);
+  }
+
+  inline const LatencyHistogram &GetFlushLatency() const { return flush_latency_; }
+
+  inline uint64_t GetNumFlushes() const { return flush_latency_.GetTotal(); }
+
+  inline uint64_t GetTotalFlushLatency() const { return flush_total_ns_.load(std::memory_order_relaxed); }
+
+  /** Add the counts of another file to this one, e.g. to sum up the tablespaces of a database. */
+  void Merge(const IOStats &other);
+
+  void Reset();
+
+  /**
+   * Write the counts as a JSON object: {"read": {"table": {"count": 3, "total_us": 120, "histogram": {"4-8us": 1,
+   * ...}}, ...}, "write": {...}, "flush": {"count": ..., "total_us": ..., "histogram": {...}}}. Empty classes and
+   * buckets are left out.
+   */
+  void WriteJson(std::ostream &out) const;
+
+  /**
+   * Tell the class of a data page from its content, the disk manager knows nothing about the pages it reads and
+   * writes. B+ tree and table pages are recognized by their own page id in their header, metadata by its magic number.
+   * @param logical_page_id id of the page in its file
+   */
+  static PageClass ClassifyPage(page_id_t logical_page_id, const char *page_data);
+
+  static const char *GetPageClassName(PageClass page_class);
+
+  static const char *GetIOTypeName(IOType type);
+
+ private:
+  LatencyHistogram latency_[NUM_PAGE_CLASSES][NUM_IO_TYPES];
+  std::atomic<uint64_t> total_ns_[NUM_PAGE_CLASSES][NUM_IO_TYPES]{};
+  LatencyHistogram flush_latency_;
+  std::atomic<uint64_t> flush_total_ns_{0};
+};
+
+#endif  // MINISQL_IO_STATS_H
@@ -0,0 +1,38 @@
+#ifndef MINISQL_PAGE_CODEC_H
+#define MINISQL_PAGE_CODEC_H
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * Fast LZ77 codec for pages, in the spirit of LZ4: a single greedy pass with a hash table of the last position of every
+ * 4 byte sequence, no entropy coding. Pages full of repeated CHAR values or of zeros shrink a lot, at a cost close to a
+ * memcpy to decompress.
+ *
+ * Compressed format: a series of sequences, each one
+ * | token | literal length bytes | literals | match offset (2 bytes) | match length bytes |
+ * The high 4 bits of the token are the number of literals, the low 4 bits the match length minus MIN_MATCH. A value of
+ * 15 is continued by bytes added to it, up to the first byte that is not 255. The last sequence has literals only.
+ */
+class PageCodec {
+ public:
+  /**
+   * @param capacity size of dst, compression gives up once it is reached
+   * @return the compressed size, or 0 if the data does not fit in capacity bytes
+   */
+  static size_t Compress(const char *src, size_t size, char *dst, size_t capacity);
+
+  /**
+   * @return false if the compressed data is malformed or does not decompress to exactly dst_size bytes
+   */
+  static bool Decompress(const char *src, size_t size, char *dst, size_t dst_size);
+
+  /** Shortest match worth encoding. */
+  static constexpr size_t MIN_MATCH = 4;
+
+  /** Largest size a page can compress to, for incompressible data. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE + PAGE_SIZE / 255 + 16;
+};
+
+#endif  // MINISQL_PAGE_CODEC_H
@@ -0,0 +1,53 @@
+#ifndef MINISQL_PAGE_SEGMENT_H
+#define MINISQL_PAGE_SEGMENT_H
+
+#include <cstddef>
+
+#include "common/config.h"
+
+/**
+ * The pages of one table heap or one index. DiskManager::AllocatePage(PageSegment *) reserves runs of contiguous pages
+ * for the segment and hands them out in order, so that the pages of a segment stay next to each other in the file
+ * whatever else is allocated meanwhile. Segments are created by BufferPoolManager::CreateSegment.
+ */
+struct PageSegment {
+  page_id_t next_page_id_{INVALID_PAGE_ID};  // next page of the reserved run to hand out
+  page_id_t end_page_id_{INVALID_PAGE_ID};   // end of the reserved run
+};
+
+/**
+ * Layout in the file of a chain of pages, e.g. the pages of a table heap in scan order. The fewer runs of consecutive
+ * page ids, the more sequential a scan of the chain.
+ */
+class FragmentationReport {
+ public:
+  /** Append the next page of the chain. */
+  inline void AddPage(page_id_t page_id) {
+    if (num_pages_ == 0 || page_id != last_page_id_ + 1) {
+      num_runs_++;
+    }
+    num_pages_++;
+    last_page_id_ = page_id;
+  }
+
+  inline size_t GetNumPages() const { return num_pages_; }
+
+  /** @return the number of maximal runs of pages with consecutive ids */
+  inline size_t GetNumRuns() const { return num_runs_; }
+
+  inline double GetAverageRunLength() const {
+    return num_runs_ == 0 ? 0 : static_cast<double>(num_pages_) / num_runs_;
+  }
+
+  /** @return 0 if the chain is a single run, up to 1 if no two pages of the chain follow each other */
+  inline double GetFragmentation() const {
+    return num_pages_ <= 1 ? 0 : static_cast<double>(num_runs_ - 1) / (num_pages_ - 1);
+  }
+
+ private:
+  size_t num_pages_{0};
+  size_t num_runs_{0};
+  page_id_t last_page_id_{INVALID_PAGE_ID};
+};
+
+#endif  // MINISQL_PAGE_SEGMENT_H
@@ -6,8 +6,38 @@
 #include "page/header_page.h"
 #include "page/table_page.h"
 #include "recovery/log_manager.h"
+#include "storage/free_space_map.h"
+#include "storage/page_segment.h"
 #include "storage/table_iterator.h"
 
+/** What a vacuum of a table heap did, see TableHeap::Vacuum. */
+struct VacuumReport {
+  size_t num_pages_before_{0};
+  size_t num_pages_after_{0};
+  size_t num_purged_rows_{0};  // rows marked deleted whose space was reclaimed
+  size_t num_moved_rows_{0};   // rows moved to an earlier page, their row ids changed
+  size_t num_freed_pages_{0};  // table and overflow pages deallocated
+
+  inline size_t GetNumBytesReclaimed() const { return num_freed_pages_ * PAGE_SIZE; }
+
+  /** @return how much faster a full scan gets, from the table pages it reads before and after, overflow values are
+   * read only when asked for */
+  inline double GetScanSpeedup() const {
+    return num_pages_after_ == 0 ? 1.0 : static_cast<double>(num_pages_before_) / num_pages_after_;
+  }
+};
+
+/**
+ * A table heap is a chain of table pages. A row larger than OVERFLOW_ROW_SIZE has its longest CHAR values stored out
+ * of line, each in a chain of overflow pages of its own, the row keeps the length of the value and its first overflow
+ * page, see TypeChar::OVERFLOW_FLAG:
+ *
+ * Overflow page: | page id (4) | next overflow page id (4) | data size (4) | data |
+ *
+ * Rows are read with their overflow values, except by a scan started with Begin(txn, false), whose rows have deferred
+ * fields in their place until FetchOverflow reads them. A scan that does not need the long values then reads only the
+ * table pages.
+ */
 class TableHeap {
   friend class TableIterator;
 
@@ -17,21 +47,38 @@ class TableHeap {
     return new TableHeap(buffer_pool_manager, schema, txn, log_manager, lock_manager);
   }
 
+  /**
+   * @param free_space_map_page_id first page of the free space map of the heap, INVALID_PAGE_ID if it has none, the map
+   * is then built from the pages of the heap by its first change
+   */
   static TableHeap *Create(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                           LogManager *log_manager, LockManager *lock_manager) {
-    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager);
+                           LogManager *log_manager, LockManager *lock_manager,
+                           page_id_t free_space_map_page_id = INVALID_PAGE_ID) {
+    return new TableHeap(buffer_pool_manager, first_page_id, schema, log_manager, lock_manager,
+                         free_space_map_page_id);
   }
 
   ~TableHeap() {}
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large (>= page_size) once its long CHAR values are moved to
+   * overflow pages, return false. The tuple goes to the last page if it has room, to the first page the free space map
+   * says has room otherwise, to a new last page if none has.
    * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
    * @param[in] txn The recovery performing the insert
    * @return true iff the insert is successful
    */
   bool InsertTuple(Row &row, Txn *txn);
 
+  /**
+   * Insert many tuples, appended to the last page and to new pages after it. A page stays pinned and latched until it
+   * is full, instead of being fetched again for every tuple.
+   * @param[in/out] rows Tuples to insert, the rid of every inserted tuple is set in its row
+   * @param[in] txn The recovery performing the insert
+   * @return the tuples inserted, the first ones of rows, all of them unless no page is left, none if one is too large
+   */
+  size_t BulkInsert(std::vector<Row> &rows, Txn *txn);
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param[in] rid Resource id of the tuple of delete
@@ -41,8 +88,8 @@ class TableHeap {
   bool MarkDelete(const RowId &rid, Txn *txn);
 
   /**
-   * if the new tuple is too large to fit in the old page, return false (will delete and insert)
-   * @param[in] row Tuple of new row
+   * if the new tuple is too large to fit in the old page, it is deleted there and inserted in another page
+   * @param[in/out] row Tuple of new row, the rid of the tuple is set in it, a new one if the tuple moved
    * @param[in] rid Rid of the old tuple
    * @param[in] txn Txn performing the update
    * @return true is update is successful.
@@ -70,6 +117,15 @@ class TableHeap {
    * @return true if the read was successful (i.e. the tuple exists)
    */
   bool GetTuple(Row *row, Txn *txn);
+
+  /**
+   * Read the overflow values of the deferred fields of a row read by a scan started with Begin(txn, false).
+   * @return false if an overflow page could not be read, the field is left deferred
+   */
+  bool FetchOverflow(Row *row);
+
+  /** Read the overflow values of the deferred fields of a row among the given columns only. */
+  bool FetchOverflow(Row *row, const std::vector<uint32_t> &column_ids);
   RowId GetNextTupleID(Row *row, Txn *txn);
 
   void FreeTableHeap() {
@@ -78,10 +134,12 @@ class TableHeap {
       auto old_page_id = next_page_id;
       auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(old_page_id));
       assert(page != nullptr);
+      FreeOverflow(page, false);
       next_page_id = page->GetNextPageId();
       buffer_pool_manager_->UnpinPage(old_page_id, false);
       buffer_pool_manager_->DeletePage(old_page_id);
     }
+    free_space_map_.FreePages();
   }
 
   /**
@@ -90,9 +148,10 @@ class TableHeap {
   void DeleteTable(page_id_t page_id = INVALID_PAGE_ID);
 
   /**
+   * @param fetch_overflow false to leave the overflow values of the rows deferred, see FetchOverflow
    * @return the begin iterator of this table
    */
-  TableIterator Begin(Txn *txn);
+  TableIterator Begin(Txn *txn, bool fetch_overflow = true);
 
   /**
    * @return the end iterator of this table
@@ -104,6 +163,64 @@ class TableHeap {
    */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * @return the first page of the free space map of this table, INVALID_PAGE_ID if it has none yet
+   */
+  inline page_id_t GetFreeSpaceMapPageId() const { return free_space_map_.GetFirstPageId(); }
+
+  /**
+   * Read the free space map of this table, building it from the pages of the table if it has none. Done by the first
+   * change of the table otherwise.
+   */
+  void LoadFreeSpaceMap();
+
+  /**
+   * @return the layout in the file of the pages of this table, in scan order
+   */
+  FragmentationReport GetFragmentation();
+
+  /**
+   * Update the page ids kept in the pages of this table after pages of the file were moved, see
+   * BufferPoolManager::CompactFile.
+   */
+  void RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved);
+
+  /**
+   * Reclaim the space of the rows marked deleted, their overflow pages included, and of sparse pages. Every page is
+   * compacted, see TablePage::Compact, then the rows of every page are moved, in order, into the free space of the
+   * page before it until one does not fit. A page left empty is unlinked from the chain and deleted, the first page
+   * never is. The free space map is rebuilt, its first page changes.
+   * @param[out] moved_rows the old row id and the row, with its new row id, of every moved row, for the indexes
+   * @return the pages and rows before and after
+   */
+  VacuumReport Vacuum(Txn *txn, std::vector<std::pair<RowId, Row>> &moved_rows);
+
+  /** @return the rows marked deleted since this table was opened or last vacuumed */
+  inline size_t GetNumDeadRows() const { return num_dead_rows_; }
+
+  /**
+   * @return true if the rows marked deleted since the last vacuum reach VACUUM_MIN_DEAD_ROWS and the VACUUM_DEAD_RATIO
+   * of the rows the last vacuum counted
+   */
+  inline bool NeedsVacuum() const {
+    return num_dead_rows_ >= std::max<size_t>(VACUUM_MIN_DEAD_ROWS, num_live_rows_ * VACUUM_DEAD_RATIO);
+  }
+
+  /** Dead rows that make a table worth vacuuming, whatever its size. */
+  static constexpr size_t VACUUM_MIN_DEAD_ROWS = 50;
+
+  /** Dead rows, as a ratio of the live ones, that make a table worth vacuuming. */
+  static constexpr double VACUUM_DEAD_RATIO = 0.2;
+
+  /** Rows larger than this have their longest CHAR values moved to overflow pages until they are not. */
+  static constexpr uint32_t OVERFLOW_ROW_SIZE = PAGE_SIZE / 4;
+
+  /** CHAR values shorter than this always stay in row, so do all the values an index key can hold. */
+  static constexpr uint32_t OVERFLOW_MIN_VALUE_SIZE = 256;
+
+  /** Bytes of a value held by one overflow page. */
+  static constexpr uint32_t OVERFLOW_PAGE_CAPACITY = PAGE_SIZE - 12;
+
  private:
   /**
    * create table heap and initialize first page
@@ -113,22 +230,80 @@ class TableHeap {
       : buffer_pool_manager_(buffer_pool_manager),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {
-    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_));
+        lock_manager_(lock_manager),
+        segment_(buffer_pool_manager->CreateSegment()),
+        free_space_map_(buffer_pool_manager),
+        overflow_segment_(buffer_pool_manager->CreateSegment()),
+        may_overflow_(HasCharColumn(schema)) {
+    auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(first_page_id_, segment_.get()));
     assert(first_page != nullptr);
     first_page->WLatch();
     first_page->Init(first_page_id_, INVALID_PAGE_ID, log_manager_, txn);
+    uint32_t free_bytes = first_page->GetFreeSpaceRemaining();
     first_page->WUnlatch();
     buffer_pool_manager_->UnpinPage(first_page_id_, true);
+    free_space_map_.Load();
+    free_space_map_.AddPage(first_page_id_, free_bytes);
   };
 
   explicit TableHeap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id, Schema *schema,
-                     LogManager *log_manager, LockManager *lock_manager)
+                     LogManager *log_manager, LockManager *lock_manager, page_id_t free_space_map_page_id)
       : buffer_pool_manager_(buffer_pool_manager),
         first_page_id_(first_page_id),
         schema_(schema),
         log_manager_(log_manager),
-        lock_manager_(lock_manager) {}
+        lock_manager_(lock_manager),
+        segment_(buffer_pool_manager->CreateSegment()),
+        free_space_map_(buffer_pool_manager, free_space_map_page_id),
+        overflow_segment_(buffer_pool_manager->CreateSegment()),
+        may_overflow_(HasCharColumn(schema)) {}
+
+  /** Append to the free space map the pages of the chain from page_id on, the map misses them or has them behind. */
+  void AddToFreeSpaceMap(page_id_t page_id);
+
+  /** @return the rows of a page, the ones marked deleted aside */
+  static size_t CountRows(TablePage *page);
+
+  static bool HasCharColumn(const Schema *schema);
+
+  /** Insert a tuple whose long values are already in overflow pages. */
+  bool InsertStoredTuple(Row &row, Txn *txn);
+
+  /** Read a tuple, its overflow values deferred. */
+  bool ReadTuple(Row *row, Txn *txn);
+
+  /** @return true if a row has to be copied by StoreOverflow before it is stored */
+  bool NeedsOverflow(const Row &row) const;
+
+  /**
+   * Copy a row into the row to store, with its long CHAR values written to new overflow pages, the values it has in
+   * the overflow pages of another tuple included.
+   * @return false if overflow pages could not be written, none are left then
+   */
+  bool StoreOverflow(const Row &row, Row &stored_row);
+
+  /** @return the first page of a new chain of overflow pages holding data, INVALID_PAGE_ID if one could not be had */
+  page_id_t WriteOverflow(const char *data, uint32_t size);
+
+  bool ReadOverflow(page_id_t page_id, char *data, uint32_t size);
+
+  /** Read the overflow value of a deferred field, nothing for any other field. */
+  bool FetchOverflowValue(Field *field);
+
+  /** Delete a chain of overflow pages, @return the pages deallocated */
+  size_t FreeOverflow(page_id_t page_id);
+
+  /** Delete the overflow pages of the values of a row stored out of line, @return the pages deallocated */
+  size_t FreeOverflow(const Row &row);
+
+  /**
+   * Delete the overflow pages of the tuples of a page, only of the ones marked deleted if deleted_only.
+   * @return the pages deallocated
+   */
+  size_t FreeOverflow(TablePage *page, bool deleted_only);
+
+  /** Update the page ids kept in a chain of overflow pages, @return the new first page of the chain */
+  page_id_t RelocateOverflow(const std::unordered_map<page_id_t, page_id_t> &moved, page_id_t page_id);
 
  private:
   BufferPoolManager *buffer_pool_manager_;
@@ -136,6 +311,12 @@ class TableHeap {
   Schema *schema_;
   [[maybe_unused]] LogManager *log_manager_;
   [[maybe_unused]] LockManager *lock_manager_;
+  std::shared_ptr<PageSegment> segment_;  // new pages of the table are taken from it
+  FreeSpaceMap free_space_map_;
+  size_t num_dead_rows_{0};  // marked deleted since the table was opened or last vacuumed
+  size_t num_live_rows_{0};  // counted by the last vacuum
+  std::shared_ptr<PageSegment> overflow_segment_;  // overflow pages, kept apart from the table pages
+  bool may_overflow_;                              // the schema has a CHAR column, values may be out of line
 };
 
 #endif  // MINISQL_TABLE_HEAP_H
\ No newline at end of file
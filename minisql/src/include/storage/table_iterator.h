@@ -1,16 +1,21 @@
 #ifndef MINISQL_TABLE_ITERATOR_H
 #define MINISQL_TABLE_ITERATOR_H
 
+#include <memory>
+
+#include "buffer/buffer_access_strategy.h"
 #include "common/rowid.h"
 #include "concurrency/txn.h"
 #include "record/row.h"
 
 class TableHeap;
+class TablePage;
 
 class TableIterator {
 public:
   // you may define your own constructor based on your member variables
-  explicit TableIterator(TableHeap *table_heap, Row row, Txn *txn);
+  /** @param fetch_overflow false to leave the overflow values of the rows deferred, see TableHeap::FetchOverflow */
+  explicit TableIterator(TableHeap *table_heap, Row row, Txn *txn, bool fetch_overflow = true);
 
   explicit TableIterator(const TableIterator &other);
 
@@ -33,10 +38,26 @@ public:
   TableIterator operator++(int);
 
 private:
+  /**
+   * Fetch the next page of the scan. Once the scan has read more than a fraction of the buffer pool it switches to a
+   * ring of frames, so that scanning a large table does not evict the working set.
+   */
+  TablePage *FetchPage(page_id_t page_id);
+
+  /**
+   * Called when the scan enters a new page. Keeps the prefetcher reading ahead along the page chain, issuing a new
+   * request whenever less than half of the previous read-ahead window is left.
+   */
+  void ReadAhead(TablePage *page);
+
   // add your own private member variables here
   TableHeap* heap;
   Row row;
   Txn* txn_;
+  size_t pages_visited_{0};
+  size_t prefetch_remaining_{0};  // pages left in the current read-ahead window
+  bool fetch_overflow_{true};
+  std::shared_ptr<BufferAccessStrategy> strategy_;  // shared by copies of the iterator, null until the scan is large
 };
 
 #endif  // MINISQL_TABLE_ITERATOR_H
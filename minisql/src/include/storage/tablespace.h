@@ -0,0 +1,56 @@
+#ifndef MINISQL_TABLESPACE_H
+#define MINISQL_TABLESPACE_H
+
+#include <memory>
+#include <string>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/disk_manager.h"
+
+/**
+ * Tablespace is the file of a single table heap or index, for a database laid out one file per table and per index.
+ * It has a disk manager of its own, attached to the buffer pool of the database, which addresses its pages by
+ * (file id, page id) like those of any other file. Reads and writes of different tablespaces thus go through different
+ * file descriptors, allocation bitmaps and latches.
+ *
+ * The first two pages are reserved like in the main database file: page 0 is unused and page 1 is the index roots page
+ * of an index, so that table heaps and B+ trees use a tablespace the same way as the main file.
+ */
+class Tablespace {
+ public:
+  /**
+   * Open the file of a table heap or index, with the I/O settings of the main database file.
+   * @param main_bpm buffer pool manager of the main database file, it must outlive the tablespace
+   * @param init create a new empty file, replacing any file left behind by a crash
+   * @throw std::runtime_error if the file cannot be opened
+   */
+  Tablespace(std::string file_name, BufferPoolManager *main_bpm, bool init);
+
+  /**
+   * Write back the pages of the file and close it, or delete it if it was dropped.
+   */
+  ~Tablespace();
+
+  inline BufferPoolManager *GetBufferPoolManager() const { return bpm_.get(); }
+
+  inline DiskManager *GetDiskManager() const { return disk_mgr_.get(); }
+
+  inline const std::string &GetFileName() const { return file_name_; }
+
+  /**
+   * Drop the pages of the file from the pool without writing them back, the file is deleted when the tablespace is.
+   * The table heap or index must be destroyed before the tablespace and must not be used meanwhile.
+   */
+  void Drop();
+
+  /** Delete a tablespace file, with the files of its compressed pages if any. */
+  static void Remove(const std::string &file_name);
+
+ private:
+  std::string file_name_;
+  std::unique_ptr<DiskManager> disk_mgr_;
+  std::unique_ptr<BufferPoolManager> bpm_;
+  bool dropped_{false};
+};
+
+#endif  // MINISQL_TABLESPACE_H
@@ -1,5 +1,6 @@
 #include "index/b_plus_tree.h"
 
+#include <cstring>
 #include <string>
 
 #include "glog/logging.h"
@@ -16,13 +17,14 @@ BPlusTree::BPlusTree(index_id_t index_id, BufferPoolManager *buffer_pool_manager
   buffer_pool_manager_(buffer_pool_manager),
   processor_(KM),
   leaf_max_size_(leaf_max_size),
-  internal_max_size_(internal_max_size) {
+  internal_max_size_(internal_max_size),
+  segment_(buffer_pool_manager->CreateSegment()) {
   if(leaf_max_size_ == 0)
   leaf_max_size_ = LEAF_PAGE_SIZE;
   if(internal_max_size_ == 0)
   internal_max_size_ = INTERNAL_PAGE_SIZE;
   //initialize root_page_id_
-  auto index_root_pages = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
+  auto index_root_pages = reinterpret_cast<IndexRootsPage *>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
   page_id_t root_page_id;
   if(index_root_pages->GetRootId(index_id_, &root_page_id)) {
   root_page_id_ = root_page_id;
@@ -135,6 +137,53 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction)
   else
     return InsertIntoLeaf(key, value, transaction);
 }
+/*
+ * Insert key & value pairs in ascending key order
+ * A leaf is searched for the first key only, the following keys are inserted
+ * into it as long as they are below the separator key after it and it does
+ * not need to split. The key that does goes through Insert.
+ * @return: the number of pairs inserted, duplicate keys are skipped.
+ */
+size_t BPlusTree::InsertSorted(const std::vector<GenericKey *> &keys, const std::vector<RowId> &values,
+                               Txn *transaction)
+{
+  size_t num_inserted = 0;
+  GenericKey *upper_bound = processor_.InitKey();
+  bool bounded = false;
+  Page *leaf_page = nullptr;
+  LeafPage *leaf_node = nullptr;
+  auto release_leaf = [&]() {
+    leaf_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf_page->GetPageId(), true);
+    leaf_page = nullptr;
+  };
+  for (size_t i = 0; i < keys.size(); i++)
+  {
+    if (leaf_page != nullptr &&
+        ((bounded && processor_.CompareKeys(keys[i], upper_bound) >= 0) || leaf_node->GetSize() + 1 >= leaf_max_size_))
+      release_leaf();                 // the key goes to another leaf, or this one splits
+    if (leaf_page == nullptr && !IsEmpty())
+    {
+      leaf_page = buffer_pool_manager_->FetchPage(FindLeafPageId(keys[i], upper_bound, bounded));
+      leaf_node = reinterpret_cast<LeafPage*>(leaf_page->GetData());
+      leaf_page->WLatch();
+      if (leaf_node->GetSize() + 1 >= leaf_max_size_)
+        release_leaf();
+    }
+    if (leaf_page == nullptr)         // empty tree or split, the usual way
+    {
+      num_inserted += Insert(keys[i], values[i], transaction);
+      continue;
+    }
+    if (leaf_node->Insert(keys[i], values[i], processor_) != -1)
+      num_inserted++;
+  }
+  if (leaf_page != nullptr)
+    release_leaf();
+  free(upper_bound);
+  return num_inserted;
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -143,7 +192,7 @@ bool BPlusTree::Insert(GenericKey *key, const RowId &value, Txn *transaction)
  */
 void BPlusTree::StartNewTree(GenericKey *key, const RowId &value) 
 {
-  auto page = buffer_pool_manager_->NewPage(root_page_id_);
+  auto page = buffer_pool_manager_->NewPage(root_page_id_, segment_.get());
   // has got page
   if (page)
   {
@@ -192,6 +241,7 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
     {
       auto new_sibling = Split(leaf_node, transaction);
       InsertIntoParent(leaf_node, new_sibling->KeyAt(0), new_sibling, transaction); // insert the first key of sibling to parent
+      buffer_pool_manager_->UnpinPage(new_sibling->GetPageId(), true);              // pinned by Split
     }
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(temp_page->GetPageId(), true); // has been modified
@@ -205,13 +255,15 @@ bool BPlusTree::InsertIntoLeaf(GenericKey *key, const RowId &value, Txn *transac
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
  * an "out of memory" exception if returned value is nullptr), then move half
  * of key & value pairs from input page to newly created page
+ * The new page is returned pinned, the caller unpins it once it is linked
+ * into the parent.
  */
 BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction) 
 {
    // the old and new page
    auto old_page = buffer_pool_manager_->FetchPage(node->GetPageId());
    page_id_t new_page_id;
-   auto new_page = buffer_pool_manager_->NewPage(new_page_id);
+   auto new_page = buffer_pool_manager_->NewPage(new_page_id, segment_.get());
    
    if (new_page == nullptr) // not enough memory
    {
@@ -224,8 +276,7 @@ BPlusTreeInternalPage *BPlusTree::Split(InternalPage *node, Txn *transaction)
     new_node->SetPageType(IndexPageType::INTERNAL_PAGE);                         // is internal
     new_node->Init(new_page_id, node->GetParentPageId(), node->GetKeySize(), internal_max_size_);
     node->MoveHalfTo(new_node, buffer_pool_manager_);
-    buffer_pool_manager_->UnpinPage(new_page_id, true);        // modified
-    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);  // modified
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);  // modified, the new page stays pinned for the caller
     return new_node;
   }
 }
@@ -235,7 +286,7 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction)
   // mostly like the above function
    auto old_page = buffer_pool_manager_->FetchPage(node->GetPageId());
    page_id_t new_page_id;
-   auto new_page = buffer_pool_manager_->NewPage(new_page_id);
+   auto new_page = buffer_pool_manager_->NewPage(new_page_id, segment_.get());
    if (new_page == nullptr)
    {
     LOG(ERROR) << "Out of memory" << std::endl;
@@ -250,8 +301,7 @@ BPlusTreeLeafPage *BPlusTree::Split(LeafPage *node, Txn *transaction)
     // need sibling connection
     new_node->SetNextPageId(node->GetNextPageId()); // right
     node->SetNextPageId(new_page_id);               // left
-    buffer_pool_manager_->UnpinPage(node->GetPageId(), true);
-    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    buffer_pool_manager_->UnpinPage(node->GetPageId(), true); // the new page stays pinned for the caller
     return new_node;
    }
 
@@ -271,7 +321,7 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
   // in this function, new_node means the sibling
   if (old_node->IsRootPage()) // the old root split
   {
-    auto new_page = buffer_pool_manager_->NewPage(root_page_id_);
+    auto new_page = buffer_pool_manager_->NewPage(root_page_id_, segment_.get());
     auto new_root_node = reinterpret_cast<InternalPage*>(new_page->GetData());
     
     new_root_node->SetPageType(IndexPageType::INTERNAL_PAGE);
@@ -293,6 +343,7 @@ void BPlusTree::InsertIntoParent(BPlusTreePage *old_node, GenericKey *key, BPlus
       auto new_parent_sibling = Split(parent_node, transaction);
       auto key = new_parent_sibling->KeyAt(0);
       InsertIntoParent(parent_node, key, new_parent_sibling, transaction);         // recursively call, propagate upward
+      buffer_pool_manager_->UnpinPage(new_parent_sibling->GetPageId(), true);      // pinned by Split
       buffer_pool_manager_->UnpinPage(parent_page->GetPageId(), true);             // modified
     }
     else // do not split
@@ -379,7 +430,7 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
 
   if (node_index == 0) // only has right sibling
   {
-    auto sibling_node = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(1)));
+    auto sibling_node = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(1))->GetData());
     
     // if can be merge
     if (node->IsLeafPage() ? 
@@ -403,7 +454,7 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
 
   if (node_index == (parent_node->GetSize() - 1))        // only has left sibling
   {
-    auto sibling_node = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(parent_node->GetSize() - 2)));
+    auto sibling_node = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(parent_node->GetSize() - 2))->GetData());
     if (node->IsLeafPage() ? 
     ( sibling_node->GetSize() + node->GetSize() < node->GetMaxSize())
     : (sibling_node->GetSize() + node->GetSize() <= node->GetMaxSize()))         // can coalesce
@@ -425,8 +476,8 @@ bool BPlusTree::CoalesceOrRedistribute(N *&node, Txn *transaction) {
   }
 
   // hase both left and right node
-  auto sibling_node_left = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(node_index - 1)));  // the left one
-  auto sibling_node_right = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(node_index + 1))); // the right one
+  auto sibling_node_left = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(node_index - 1))->GetData());  // the left one
+  auto sibling_node_right = reinterpret_cast<N*>(buffer_pool_manager_->FetchPage(parent_node->ValueAt(node_index + 1))->GetData()); // the right one
   if(node->IsLeafPage() ? 
   ((sibling_node_left->GetSize() + node->GetSize()) < node->GetMaxSize()) 
   : ((sibling_node_left->GetSize() + node->GetSize()) <= node->GetMaxSize()))
@@ -626,6 +677,83 @@ IndexIterator BPlusTree::End() {
 /*****************************************************************************
  * UTILITIES AND DEBUG
  *****************************************************************************/
+void BPlusTree::RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved,
+                              const std::unordered_map<page_id_t, page_id_t> *moved_rows) {
+  if (IsEmpty()) {
+    return;
+  }
+  page_id_t root_page_id = BufferPoolManager::GetRelocatedPageId(moved, root_page_id_);
+  if (root_page_id != root_page_id_) {
+    root_page_id_ = root_page_id;
+    UpdateRootPageId(0);
+  }
+  RelocateSubtree(root_page_id_, moved, moved_rows == nullptr ? moved : *moved_rows);
+}
+
+void BPlusTree::RelocateSubtree(page_id_t page_id, const std::unordered_map<page_id_t, page_id_t> &moved,
+                                const std::unordered_map<page_id_t, page_id_t> &moved_rows) {
+  auto page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    return;
+  }
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  page_id_t parent_page_id = BufferPoolManager::GetRelocatedPageId(moved, node->GetParentPageId());
+  bool is_dirty = node->GetPageId() != page_id || node->GetParentPageId() != parent_page_id;
+  node->SetPageId(page_id);
+  node->SetParentPageId(parent_page_id);
+  std::vector<page_id_t> children;
+  if (node->IsLeafPage()) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    page_id_t next_page_id = BufferPoolManager::GetRelocatedPageId(moved, leaf->GetNextPageId());
+    if (next_page_id != leaf->GetNextPageId()) {
+      leaf->SetNextPageId(next_page_id);
+      is_dirty = true;
+    }
+    // The row ids point into table pages, which may have moved as well.
+    for (int i = 0; i < leaf->GetSize(); i++) {
+      RowId rid = leaf->ValueAt(i);
+      page_id_t rid_page_id = BufferPoolManager::GetRelocatedPageId(moved_rows, rid.GetPageId());
+      if (rid_page_id != rid.GetPageId()) {
+        leaf->SetValueAt(i, RowId(rid_page_id, rid.GetSlotNum()));
+        is_dirty = true;
+      }
+    }
+  } else {
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    for (int i = 0; i < internal->GetSize(); i++) {
+      page_id_t child_page_id = BufferPoolManager::GetRelocatedPageId(moved, internal->ValueAt(i));
+      if (child_page_id != internal->ValueAt(i)) {
+        internal->SetValueAt(i, child_page_id);
+        is_dirty = true;
+      }
+      children.push_back(child_page_id);
+    }
+  }
+  buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+  for (auto child_page_id : children) {
+    RelocateSubtree(child_page_id, moved, moved_rows);
+  }
+}
+
+FragmentationReport BPlusTree::GetFragmentation() {
+  FragmentationReport report;
+  if (IsEmpty()) {
+    return report;
+  }
+  page_id_t page_id = FindLeafPage(nullptr, root_page_id_, true)->GetPageId();
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      break;
+    }
+    report.AddPage(page_id);
+    page_id_t next_page_id = reinterpret_cast<LeafPage *>(page->GetData())->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return report;
+}
+
 /*
  * Find leaf page containing particular key, if leftMost flag == true, find
  * the left most leaf page
@@ -655,6 +783,38 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
   }
 }
 
+/*
+ * Find the leaf page id of key from the root, keeping the separator key right
+ * after the child taken at every level; the one of the lowest level is the
+ * tightest.
+ */
+page_id_t BPlusTree::FindLeafPageId(const GenericKey *key, GenericKey *upper_bound, bool &bounded) {
+  bounded = false;
+  page_id_t page_id = root_page_id_;
+  while (true)
+  {
+    auto page = buffer_pool_manager_->FetchPage(page_id);
+    auto node = reinterpret_cast<BPlusTreePage*>(page->GetData());
+    if (node->IsLeafPage())
+    {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return page_id;
+    }
+    auto internal_node = reinterpret_cast<InternalPage*>(node);
+    page->RLatch();
+    page_id_t child_id = internal_node->Lookup(key, processor_);
+    int child_index = internal_node->ValueIndex(child_id);
+    if (child_index + 1 < internal_node->GetSize())
+    {
+      memcpy(upper_bound, internal_node->KeyAt(child_index + 1), processor_.GetKeySize());
+      bounded = true;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = child_id;
+  }
+}
+
 /*
  * Update/Insert root page id in header page(where page_id = INDEX_ROOTS_PAGE_ID,
  * header_page isdefined under include/page/header_page.h)
@@ -664,7 +824,7 @@ Page *BPlusTree::FindLeafPage(const GenericKey *key, page_id_t page_id, bool lef
  * updating it.
  */
 void BPlusTree::UpdateRootPageId(int insert_record) {
-  auto header_page = reinterpret_cast<IndexRootsPage*>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID));
+  auto header_page = reinterpret_cast<IndexRootsPage*>(buffer_pool_manager_->FetchPage(INDEX_ROOTS_PAGE_ID)->GetData());
   if (insert_record)            // insert_record == 1, add a new record(create a tree)
     header_page->Insert(index_id_, root_page_id_);
   else                          //  == 0, just update Used when the root changes due to a split or coalesce.
@@ -26,6 +26,19 @@ dberr_t BPlusTreeIndex::InsertEntry(const Row &key, RowId row_id, Txn *txn) {
   return DB_SUCCESS;
 }
 
+dberr_t BPlusTreeIndex::InsertEntries(const std::vector<Row> &keys, const std::vector<RowId> &row_ids, Txn *txn) {
+  std::vector<GenericKey *> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i] = processor_.InitKey();
+    processor_.SerializeFromKey(index_keys[i], keys[i], key_schema_);
+  }
+  size_t num_inserted = container_.InsertSorted(index_keys, row_ids, txn);
+  for (auto index_key : index_keys) {
+    free(index_key);
+  }
+  return num_inserted == keys.size() ? DB_SUCCESS : DB_FAILED;
+}
+
 dberr_t BPlusTreeIndex::RemoveEntry(const Row &key, RowId row_id, Txn *txn) {
   GenericKey *index_key = processor_.InitKey();
   processor_.SerializeFromKey(index_key, key, key_schema_);
@@ -7,7 +7,11 @@ IndexIterator::IndexIterator() = default;
 
 IndexIterator::IndexIterator(page_id_t page_id, BufferPoolManager *bpm, int index)
     : current_page_id(page_id), item_index(index), buffer_pool_manager(bpm) {
-    page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+    Page *leaf = buffer_pool_manager->FetchPage(current_page_id);
+    page = leaf == nullptr ? nullptr : reinterpret_cast<LeafPage *>(leaf->GetData());
+    if (page != nullptr) {
+      ReadAhead();
+    }
 }
 
 IndexIterator::~IndexIterator() {
@@ -36,6 +40,7 @@ IndexIterator &IndexIterator::operator++() {
       page = nullptr;
     }else{
       page = reinterpret_cast<LeafPage *>(buffer_pool_manager->FetchPage(current_page_id)->GetData());
+      ReadAhead();
     }
     item_index = 0;
   }else{
@@ -50,4 +55,18 @@ bool IndexIterator::operator==(const IndexIterator &itr) const {
 
 bool IndexIterator::operator!=(const IndexIterator &itr) const {
   return !(*this == itr);
-}
\ No newline at end of file
+}
+
+void IndexIterator::ReadAhead() {
+  size_t depth = buffer_pool_manager->GetPrefetchDepth();
+  if (prefetch_remaining_ > 0) {
+    prefetch_remaining_--;
+  }
+  if (depth == 0 || prefetch_remaining_ > depth / 2 || page->GetNextPageId() == INVALID_PAGE_ID) {
+    return;
+  }
+  buffer_pool_manager->PrefetchChain(page->GetNextPageId(), depth, [](const char *page_data) {
+    return reinterpret_cast<const LeafPage *>(page_data)->GetNextPageId();
+  });
+  prefetch_remaining_ = depth;
+}
@@ -106,7 +106,7 @@ void *LeafPage::PairPtrAt(int index) {
 }
 
 void LeafPage::PairCopy(void *dest, void *src, int pair_num) {
-  memcpy(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
+  memmove(dest, src, pair_num * (GetKeySize() + sizeof(RowId)));
 }
 /*
  * Helper method to find and return the key & value pair associated with input
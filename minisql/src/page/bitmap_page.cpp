@@ -1,48 +1,107 @@
 #include "page/bitmap_page.h"
 
+#include <algorithm>
+
 #include "dirent.h"
 #include "glog/logging.h"
 
-
-
 template <size_t PageSize>
 bool BitmapPage<PageSize>::AllocatePage(uint32_t &page_offset) {
-  if (page_allocated_ >=  8 * MAX_CHARS)
-    return false;// too large
-  uint32_t byte_index = next_free_page_ / 8;
-  uint32_t bit_index = next_free_page_ % 8;
-  bytes[byte_index] |= (1 << bit_index);
-  page_offset = next_free_page_;
-  for (uint32_t i = 0; i < MAX_CHARS*8; i++) {
-    if (((bytes[i / 8] & (1 << (i%8))) == 0)){
-      next_free_page_ = i;
-      break;
-    }
-
+  if (page_allocated_ >= 8 * MAX_CHARS) {
+    return false;
+  }
+  uint32_t offset = FindFreePage(next_free_page_);
+  if (offset >= 8 * MAX_CHARS) {
+    LOG(ERROR) << "Bitmap page header counts " << page_allocated_ << " pages but no page is free.";
+    return false;
   }
+  bytes[offset / 8] |= (1 << (offset % 8));
+  page_offset = offset;
+  // The pages below the one allocated are taken, the next search starts right after it.
+  next_free_page_ = offset + 1;
   page_allocated_ += 1;
   return true;
 }
 
+template <size_t PageSize>
+bool BitmapPage<PageSize>::AllocateRun(uint32_t page_offset, uint32_t &run_offset) {
+  if (page_allocated_ + RUN_SIZE > 8 * MAX_CHARS) {
+    return false;
+  }
+  uint32_t start_word = page_offset < 8 * MAX_CHARS ? page_offset / RUN_SIZE : 0;
+  for (uint32_t i = 0; i < NUM_WORDS; i++) {
+    uint32_t word_index = (start_word + i) % NUM_WORDS;
+    if (GetWord(word_index) == 0) {
+      memset(bytes + word_index * sizeof(uint64_t), 0xff, sizeof(uint64_t));
+      run_offset = word_index * RUN_SIZE;
+      page_allocated_ += RUN_SIZE;
+      return true;
+    }
+  }
+  return false;
+}
+
+template <size_t PageSize>
+bool BitmapPage<PageSize>::FindLastAllocatedPage(uint32_t &page_offset) const {
+  for (uint32_t word_index = NUM_WORDS; word_index-- > 0;) {
+    uint64_t word = GetWord(word_index);
+    if (word != 0) {
+      page_offset = word_index * RUN_SIZE + 63 - __builtin_clzll(word);
+      return true;
+    }
+  }
+  return false;
+}
+
 template <size_t PageSize>
 bool BitmapPage<PageSize>::DeAllocatePage(uint32_t page_offset) {
-  if (page_offset >= MAX_CHARS*8)
+  if (page_offset >= MAX_CHARS * 8) {
     return false;
+  }
   uint32_t byte_index = page_offset / 8;
   uint32_t bit_index = page_offset % 8;
-  // 判断该位页是否被分配出去
-  if (IsPageFreeLow(byte_index , bit_index)) {
+  if (IsPageFreeLow(byte_index, bit_index)) {
     return false;
-  }else {
-    bytes[byte_index] &= ~(1 << bit_index);//make it to zero
-    next_free_page_ = page_offset;
-    page_allocated_ -= 1;
-    return true;
   }
+  bytes[byte_index] &= ~(1 << bit_index);
+  // The lowest free page is handed out first, keeping the extent dense.
+  next_free_page_ = std::min(next_free_page_, page_offset);
+  page_allocated_ -= 1;
+  return true;
+}
 
-
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::FindFreePage(uint32_t page_offset) const {
+  if (page_offset >= 8 * MAX_CHARS) {
+    page_offset = 0;
+  }
+  uint32_t start_word = page_offset / 64;
+  for (uint32_t i = 0; i <= NUM_WORDS; i++) {
+    uint32_t word_index = (start_word + i) % NUM_WORDS;
+    uint64_t free = ~GetWord(word_index);
+    if (i == 0) {
+      // Only the pages from page_offset on in the first word, the ones below it come last.
+      free &= ~uint64_t{0} << (page_offset % 64);
+    }
+    if (free != 0) {
+      return word_index * 64 + __builtin_ctzll(free);
+    }
+  }
+  return 8 * MAX_CHARS;
 }
 
+template <size_t PageSize>
+uint32_t BitmapPage<PageSize>::RecountAllocatedPages() {
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < NUM_WORDS; i++) {
+    count += __builtin_popcountll(GetWord(i));
+  }
+  if (count != page_allocated_) {
+    LOG(WARNING) << "Bitmap page header counts " << page_allocated_ << " pages, " << count << " are allocated.";
+    page_allocated_ = count;
+  }
+  return count;
+}
 
 template <size_t PageSize>
 bool BitmapPage<PageSize>::IsPageFree(uint32_t page_offset) const {
@@ -71,4 +130,4 @@ template class BitmapPage<1024>;
 
 template class BitmapPage<2048>;
 
-template class BitmapPage<4096>;
\ No newline at end of file
+template class BitmapPage<PAGE_SIZE>;
\ No newline at end of file
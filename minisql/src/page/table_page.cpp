@@ -13,7 +13,7 @@ void TablePage::Init(page_id_t page_id, page_id_t prev_id, LogManager *log_mgr,
 bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *lock_manager, LogManager *log_manager) {
   uint32_t serialized_size = row.GetSerializedSize(schema);
   ASSERT(serialized_size > 0, "Can not have empty row.");
-  if (GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+  if (GetFreeSpaceRemaining() < serialized_size) {
     return false;
   }
   // Try to find a free slot to reuse.
@@ -25,6 +25,10 @@ bool TablePage::InsertTuple(Row &row, Schema *schema, Txn *txn, LockManager *loc
       break;
     }
   }
+  // A new slot takes room too.
+  if (i == GetTupleCount() && GetFreeSpaceRemaining() < serialized_size + SIZE_TUPLE) {
+    return false;
+  }
   // Otherwise we claim available free space..
   SetFreeSpacePointer(GetFreeSpacePointer() - serialized_size);
   uint32_t __attribute__((unused)) write_bytes = row.SerializeTo(GetData() + GetFreeSpacePointer(), schema);
@@ -129,6 +133,41 @@ void TablePage::ApplyDelete(const RowId &rid, Txn *txn, LogManager *log_manager)
   }
 }
 
+uint32_t TablePage::Compact(Txn *txn, LogManager *log_manager) {
+  uint32_t tuple_count = GetTupleCount();
+  uint32_t num_removed = 0;
+  char buffer[PAGE_SIZE];
+  uint32_t free_space_pointer = PAGE_SIZE;
+  uint32_t new_tuple_count = 0;
+  for (uint32_t i = 0; i < tuple_count; i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (IsDeleted(tuple_size)) {
+      num_removed += tuple_size != 0;
+      SetTupleSize(i, 0);
+      SetTupleOffsetAtSlot(i, 0);
+      continue;
+    }
+    free_space_pointer -= tuple_size;
+    memcpy(buffer + free_space_pointer, GetData() + GetTupleOffsetAtSlot(i), tuple_size);
+    SetTupleOffsetAtSlot(i, free_space_pointer);
+    new_tuple_count = i + 1;
+  }
+  memcpy(GetData() + free_space_pointer, buffer + free_space_pointer, PAGE_SIZE - free_space_pointer);
+  SetFreeSpacePointer(free_space_pointer);
+  SetTupleCount(new_tuple_count);
+  return num_removed;
+}
+
+void TablePage::ForEachTuple(const std::function<void(const RowId &rid, char *data, bool is_deleted)> &visit) {
+  for (uint32_t i = 0; i < GetTupleCount(); i++) {
+    uint32_t tuple_size = GetTupleSize(i);
+    if (UnsetDeletedFlag(tuple_size) == 0) {
+      continue;
+    }
+    visit(RowId(GetTablePageId(), i), GetData() + GetTupleOffsetAtSlot(i), IsDeleted(tuple_size));
+  }
+}
+
 void TablePage::RollbackDelete(const RowId &rid, Txn *txn, LogManager *log_manager) {
   uint32_t slot_num = rid.GetSlotNum();
   ASSERT(slot_num < GetTupleCount(), "We can't have more slots than tuples.");
@@ -171,6 +171,16 @@ const char *GetSyntaxNodeTypeStr(SyntaxNodeType type) {
       return "kNodeTrxCommit";
     case kNodeTrxRollback:
       return "kNodeTrxRollback";
+    case kNodeShowStatus:
+      return "kNodeShowStatus";
+    case kNodeResetStatus:
+      return "kNodeResetStatus";
+    case kNodeSetVariable:
+      return "kNodeSetVariable";
+    case kNodeVacuum:
+      return "kNodeVacuum";
+    case kNodeLoad:
+      return "kNodeLoad";
     default:
       return "error type";
   }
@@ -226,6 +226,12 @@ CmpBool TypeFloat::CompareGreaterThanEquals(const Field &left, const Field &righ
 
 // ==============================TypeChar=============================
 uint32_t TypeChar::SerializeTo(const Field &field, char *buf) const {
+  if (!field.IsNull() && field.overflow_page_id_ != INVALID_PAGE_ID) {
+    uint32_t len = GetLength(field) | OVERFLOW_FLAG;
+    memcpy(buf, &len, sizeof(uint32_t));
+    memcpy(buf + sizeof(uint32_t), &field.overflow_page_id_, sizeof(page_id_t));
+    return SIZE_OVERFLOW_POINTER;
+  }
   if (!field.IsNull()) {
     uint32_t len = GetLength(field);
     memcpy(buf, &len, sizeof(uint32_t));
@@ -241,6 +247,14 @@ uint32_t TypeChar::DeserializeFrom(char *storage, Field **field, bool is_null) c
     return 0;
   }
   uint32_t len = MACH_READ_UINT32(storage);
+  if (len & OVERFLOW_FLAG) {
+    // The value is left in its overflow pages until it is needed, the field is deferred.
+    *field = new Field(TypeId::kTypeChar, nullptr, 0, false);
+    (*field)->is_null_ = false;
+    (*field)->len_ = len & ~OVERFLOW_FLAG;
+    memcpy(&(*field)->overflow_page_id_, storage + sizeof(uint32_t), sizeof(page_id_t));
+    return SIZE_OVERFLOW_POINTER;
+  }
   *field = new Field(TypeId::kTypeChar, storage + sizeof(uint32_t), len, true);
   return len + sizeof(uint32_t);
 }
@@ -249,6 +263,9 @@ uint32_t TypeChar::GetSerializedSize(const Field &field, bool is_null) const {
   if (is_null) {
     return 0;
   }
+  if (field.overflow_page_id_ != INVALID_PAGE_ID) {
+    return SIZE_OVERFLOW_POINTER;
+  }
   uint32_t len = GetLength(field);
   return len + sizeof(uint32_t);
 }
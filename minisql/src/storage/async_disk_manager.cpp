@@ -0,0 +1,371 @@
+#include "storage/async_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef MINISQL_WITH_IO_URING
+#include <linux/io_uring.h>
+#endif
+
+#include "glog/logging.h"
+
+AsyncDiskManager::AsyncDiskManager(size_t queue_depth, AsyncIOEngine engine)
+    : queue_depth_(std::max<size_t>(1, queue_depth)), engine_(engine), requests_(queue_depth_) {
+  for (size_t i = queue_depth_; i > 0; i--) {
+    free_slots_.push_back(i - 1);
+  }
+  if (engine_ != AsyncIOEngine::THREAD_POOL) {
+    if (SetUpRing()) {
+      engine_ = AsyncIOEngine::IO_URING;
+      return;
+    }
+    if (engine_ == AsyncIOEngine::IO_URING) {
+      LOG(WARNING) << "io_uring is not available, falling back to a thread pool";
+    }
+  }
+  engine_ = AsyncIOEngine::THREAD_POOL;
+  for (size_t i = 0; i < std::min(queue_depth_, MAX_WORKERS); i++) {
+    workers_.emplace_back(&AsyncDiskManager::Worker, this);
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() {
+  std::vector<AsyncIOCompletion> dropped;
+  while (num_pending_ > 0) {
+    WaitCompletions(num_pending_, &dropped);
+  }
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  TearDownRing();
+}
+
+bool AsyncDiskManager::QueueRead(DiskManager *disk_manager, page_id_t logical_page_id, char *page_data,
+                                 uint64_t tag) {
+  return Queue(disk_manager, logical_page_id, page_data, false, tag);
+}
+
+bool AsyncDiskManager::QueueWrite(DiskManager *disk_manager, page_id_t logical_page_id, const char *page_data,
+                                  uint64_t tag) {
+  return Queue(disk_manager, logical_page_id, const_cast<char *>(page_data), true, tag);
+}
+
+bool AsyncDiskManager::Queue(DiskManager *disk_manager, page_id_t logical_page_id, char *page_data, bool is_write,
+                             uint64_t tag) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  if (num_pending_ >= queue_depth_) {
+    return false;
+  }
+  if (engine_ == AsyncIOEngine::IO_URING && (disk_manager->GetFd() < 0 || !disk_manager->IsAligned(page_data))) {
+    // The ring needs a file descriptor, and an aligned buffer for direct I/O.
+    if (is_write) {
+      disk_manager->WritePage(logical_page_id, page_data);
+    } else {
+      disk_manager->ReadPage(logical_page_id, page_data);
+    }
+    completed_.push_back({tag, true});
+    num_pending_++;
+    return true;
+  }
+  size_t slot = free_slots_.back();
+  free_slots_.pop_back();
+  requests_[slot] = {disk_manager, logical_page_id, page_data, is_write, tag, {page_data, PAGE_SIZE}, {}, 0};
+  queued_.push_back(slot);
+  num_pending_++;
+  return true;
+}
+
+size_t AsyncDiskManager::Submit() {
+  size_t num_queued = queued_.size();
+  if (num_queued == 0) {
+    if (num_unsubmitted_ > 0) {
+      EnterRing(0);
+    }
+    return 0;
+  }
+  if (engine_ == AsyncIOEngine::THREAD_POOL) {
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      work_.insert(work_.end(), queued_.begin(), queued_.end());
+    }
+    work_cv_.notify_all();
+    queued_.clear();
+    return num_queued;
+  }
+#ifdef MINISQL_WITH_IO_URING
+  unsigned tail = *sq_tail_;
+  auto now = std::chrono::steady_clock::now();
+  for (auto slot : queued_) {
+    Request &request = requests_[slot];
+    if (request.num_done_bytes_ == 0) {
+      request.submitted_ = now;
+    }
+    unsigned index = tail & *sq_mask_;
+    auto *sqe = static_cast<io_uring_sqe *>(sqes_) + index;
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = request.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+    sqe->fd = request.disk_manager_->GetFd();
+    sqe->addr = reinterpret_cast<uint64_t>(&request.iov_);
+    sqe->len = 1;
+    sqe->off = request.disk_manager_->GetPageOffset(request.page_id_) + request.num_done_bytes_;
+    sqe->user_data = slot;
+    sq_array_[index] = index;
+    tail++;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  num_unsubmitted_ += num_queued;
+  EnterRing(0);
+#endif
+  queued_.clear();
+  return num_queued;
+}
+
+size_t AsyncDiskManager::WaitCompletions(size_t min_complete, std::vector<AsyncIOCompletion> *completions) {
+  Submit();
+  min_complete = std::min(min_complete, num_pending_);
+  size_t num_done = completed_.size();
+  num_pending_ -= num_done;
+  completions->insert(completions->end(), completed_.begin(), completed_.end());
+  completed_.clear();
+  while (true) {
+    if (engine_ == AsyncIOEngine::IO_URING) {
+      num_done += ReapRing(completions);
+    } else {
+      std::vector<std::pair<size_t, bool>> done;
+      {
+        std::unique_lock<std::mutex> lock(latch_);
+        if (num_done < min_complete) {
+          done_cv_.wait(lock, [&] { return !worker_done_.empty(); });
+        }
+        done.swap(worker_done_);
+      }
+      for (const auto &request : done) {
+        Complete(request.first, request.second, completions);
+      }
+      num_done += done.size();
+    }
+    if (num_done >= min_complete) {
+      return num_done;
+    }
+    if (engine_ == AsyncIOEngine::IO_URING && !EnterRing(1)) {
+      // The entries the kernel did not take would never complete.
+      num_done += FailUnsubmitted(completions);
+    }
+  }
+}
+
+bool AsyncDiskManager::WritePages(const std::vector<std::tuple<DiskManager *, page_id_t, const char *>> &pages,
+                                  std::vector<size_t> *failed) {
+  std::vector<AsyncIOCompletion> completions;
+  for (size_t i = 0; i < pages.size(); i++) {
+    while (!QueueWrite(std::get<0>(pages[i]), std::get<1>(pages[i]), std::get<2>(pages[i]), i)) {
+      WaitCompletions(1, &completions);
+    }
+  }
+  WaitCompletions(num_pending_, &completions);
+  bool ok = true;
+  for (const auto &completion : completions) {
+    if (!completion.ok_) {
+      ok = false;
+      if (failed != nullptr) {
+        failed->push_back(completion.tag_);
+      }
+    }
+  }
+  return ok;
+}
+
+void AsyncDiskManager::Complete(size_t slot, bool ok, std::vector<AsyncIOCompletion> *completions) {
+  completions->push_back({requests_[slot].tag_, ok});
+  free_slots_.push_back(slot);
+  num_pending_--;
+}
+
+size_t AsyncDiskManager::ReapRing(std::vector<AsyncIOCompletion> *completions) {
+  size_t num_done = 0;
+#ifdef MINISQL_WITH_IO_URING
+  unsigned head = *cq_head_;
+  unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+  for (; head != tail; head++) {
+    const auto *cqe = static_cast<io_uring_cqe *>(cqes_) + (head & *cq_mask_);
+    size_t slot = cqe->user_data;
+    int res = cqe->res;
+    Request &request = requests_[slot];
+    bool ok = res > 0 || (res == 0 && !request.is_write_);
+    if (res > 0 && request.num_done_bytes_ + res < static_cast<uint32_t>(PAGE_SIZE)) {
+      // A short transfer, the rest of the page is submitted again.
+      request.num_done_bytes_ += res;
+      request.iov_ = {request.data_ + request.num_done_bytes_, PAGE_SIZE - request.num_done_bytes_};
+      queued_.push_back(slot);
+      continue;
+    }
+    if (ok && res == 0) {
+      // The end of the file, the rest of a page beyond it reads as zeros.
+      memset(request.data_ + request.num_done_bytes_, 0, PAGE_SIZE - request.num_done_bytes_);
+    }
+    if (!ok) {
+      LOG(ERROR) << "I/O error while " << (request.is_write_ ? "writing" : "reading") << " page "
+                 << request.page_id_;
+    } else {
+      request.disk_manager_->RecordIO(
+          request.page_id_, request.data_, request.is_write_ ? IOType::WRITE : IOType::READ,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - request.submitted_)
+              .count());
+    }
+    Complete(slot, ok, completions);
+    num_done++;
+  }
+  __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  Submit();
+#endif
+  return num_done;
+}
+
+bool AsyncDiskManager::EnterRing(size_t min_complete) {
+#ifdef MINISQL_WITH_IO_URING
+  unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+  while (true) {
+    int res = syscall(__NR_io_uring_enter, ring_fd_, num_unsubmitted_, min_complete, flags, nullptr, 0);
+    if (res >= 0) {
+      num_unsubmitted_ -= std::min<unsigned>(res, num_unsubmitted_);
+      return true;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN || errno == EBUSY) {
+      // The entries stay in the ring and go out with the next call, once completions are reaped.
+      return true;
+    }
+    LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+    return false;
+  }
+#else
+  return false;
+#endif
+}
+
+size_t AsyncDiskManager::FailUnsubmitted(std::vector<AsyncIOCompletion> *completions) {
+  size_t num_failed = num_unsubmitted_;
+#ifdef MINISQL_WITH_IO_URING
+  unsigned tail = *sq_tail_ - num_unsubmitted_;
+  for (unsigned i = 0; i < num_unsubmitted_; i++) {
+    const auto *sqe = static_cast<io_uring_sqe *>(sqes_) + sq_array_[(tail + i) & *sq_mask_];
+    size_t slot = sqe->user_data;
+    LOG(ERROR) << "I/O error while " << (requests_[slot].is_write_ ? "writing" : "reading") << " page "
+               << requests_[slot].page_id_;
+    Complete(slot, false, completions);
+  }
+  // The kernel only reads the entries when it is entered, they can be taken back.
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+  num_unsubmitted_ = 0;
+#endif
+  return num_failed;
+}
+
+void AsyncDiskManager::Worker() {
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    work_cv_.wait(lock, [this] { return stop_ || !work_.empty(); });
+    if (work_.empty()) {
+      return;
+    }
+    size_t slot = work_.front();
+    work_.pop_front();
+    lock.unlock();
+    // The slot belongs to this worker until the completion is posted.
+    const Request &request = requests_[slot];
+    if (request.is_write_) {
+      request.disk_manager_->WritePage(request.page_id_, request.data_);
+    } else {
+      request.disk_manager_->ReadPage(request.page_id_, request.data_);
+    }
+    lock.lock();
+    worker_done_.emplace_back(slot, true);
+    done_cv_.notify_one();
+  }
+}
+
+bool AsyncDiskManager::SetUpRing() {
+#ifdef MINISQL_WITH_IO_URING
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, queue_depth_, &params);
+  if (fd < 0) {
+    return false;
+  }
+  ring_fd_ = fd;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  void *sq_ring =
+      mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  sq_ring_ = sq_ring;
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    void *cq_ring =
+        mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cq_ring == MAP_FAILED) {
+      TearDownRing();
+      return false;
+    }
+    cq_ring_ = cq_ring;
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    TearDownRing();
+    return false;
+  }
+  sqes_ = sqes;
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AsyncDiskManager::TearDownRing() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+    ring_fd_ = -1;
+  }
+}
@@ -0,0 +1,330 @@
+#include "storage/compressed_page_store.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+
+#include "glog/logging.h"
+#include "storage/page_codec.h"
+
+namespace {
+
+/** @return the number of bytes read, short at the end of the file */
+size_t ReadFully(int fd, char *data, size_t size, off_t offset) {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t res = pread(fd, data + read_count, size - read_count, offset + read_count);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      break;
+    }
+    read_count += res;
+  }
+  return read_count;
+}
+
+bool WriteFully(int fd, const char *data, size_t size, off_t offset) {
+  size_t write_count = 0;
+  while (write_count < size) {
+    ssize_t res = pwrite(fd, data + write_count, size - write_count, offset + write_count);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      return false;
+    }
+    write_count += res;
+  }
+  return true;
+}
+
+}  // namespace
+
+CompressedPageStore::CompressedPageStore(const std::string &db_file)
+    : block_file_name_(GetBlockFileName(db_file)), block_map_file_name_(GetBlockMapFileName(db_file)) {
+  block_fd_ = open(block_file_name_.c_str(), O_RDWR | O_CREAT, 0666);
+  block_map_fd_ = open(block_map_file_name_.c_str(), O_RDWR | O_CREAT, 0666);
+  if (block_fd_ < 0 || block_map_fd_ < 0) {
+    if (block_fd_ >= 0) {
+      close(block_fd_);
+    }
+    if (block_map_fd_ >= 0) {
+      close(block_map_fd_);
+    }
+    throw std::runtime_error("Can not open the compressed pages of " + db_file);
+  }
+  struct stat stat_buf;
+  if (fstat(block_map_fd_, &stat_buf) == 0 && stat_buf.st_size > 0) {
+    block_map_.resize(stat_buf.st_size / sizeof(BlockMapEntry));
+    size_t size = block_map_.size() * sizeof(BlockMapEntry);
+    if (ReadFully(block_map_fd_, reinterpret_cast<char *>(block_map_.data()), size, 0) != size) {
+      LOG(ERROR) << "I/O error while reading " << block_map_file_name_;
+    }
+  }
+  map_chunk_dirty_.resize((block_map_.size() + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE, false);
+  // Whatever lies between the blocks is free.
+  std::vector<std::pair<uint32_t, uint32_t>> blocks;
+  for (const auto &entry : block_map_) {
+    if (entry.stored_size_ != 0) {
+      blocks.emplace_back(entry.first_sector_, GetNumSectors(entry.stored_size_));
+      num_pages_++;
+      stored_bytes_ += entry.stored_size_;
+    }
+  }
+  std::sort(blocks.begin(), blocks.end());
+  for (const auto &block : blocks) {
+    if (block.first > num_sectors_) {
+      AddFreeSectors(num_sectors_, block.first - num_sectors_);
+    }
+    num_sectors_ = std::max(num_sectors_, block.first + block.second);
+  }
+}
+
+CompressedPageStore::~CompressedPageStore() {
+  close(block_fd_);
+  close(block_map_fd_);
+}
+
+std::string CompressedPageStore::GetBlockFileName(const std::string &db_file) {
+  std::filesystem::path path = db_file;
+  return (path.parent_path() / ("." + path.filename().string() + ".blocks")).string();
+}
+
+std::string CompressedPageStore::GetBlockMapFileName(const std::string &db_file) {
+  std::filesystem::path path = db_file;
+  return (path.parent_path() / ("." + path.filename().string() + ".blockmap")).string();
+}
+
+bool CompressedPageStore::Exists(const std::string &db_file) {
+  return access(GetBlockMapFileName(db_file).c_str(), F_OK) == 0;
+}
+
+void CompressedPageStore::Remove(const std::string &db_file) {
+  remove(GetBlockFileName(db_file).c_str());
+  remove(GetBlockMapFileName(db_file).c_str());
+}
+
+void CompressedPageStore::ReadPage(page_id_t page_id, char *page_data) {
+  BlockMapEntry entry{0, 0, 0};
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    if (static_cast<size_t>(page_id) < block_map_.size()) {
+      entry = block_map_[page_id];
+    }
+  }
+  if (entry.stored_size_ == 0) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  off_t offset = static_cast<off_t>(entry.first_sector_) * SECTOR_SIZE;
+  if (entry.flags_ & RAW_PAGE) {
+    if (ReadFully(block_fd_, page_data, PAGE_SIZE, offset) != PAGE_SIZE) {
+      LOG(ERROR) << "I/O error while reading";
+      memset(page_data, 0, PAGE_SIZE);
+    }
+    return;
+  }
+  char block[PageCodec::MAX_COMPRESSED_SIZE];
+  if (ReadFully(block_fd_, block, entry.stored_size_, offset) != entry.stored_size_ ||
+      !PageCodec::Decompress(block, entry.stored_size_, page_data, PAGE_SIZE)) {
+    LOG(ERROR) << "Corrupted compressed page " << page_id << " in " << block_file_name_;
+    memset(page_data, 0, PAGE_SIZE);
+  }
+}
+
+void CompressedPageStore::WritePage(page_id_t page_id, const char *page_data) {
+  char block[PageCodec::MAX_COMPRESSED_SIZE];
+  // Compressing is only worth it if it saves a sector.
+  size_t stored_size = PageCodec::Compress(page_data, PAGE_SIZE, block, PAGE_SIZE - SECTOR_SIZE);
+  uint16_t flags = 0;
+  const char *data = block;
+  if (stored_size == 0) {
+    stored_size = PAGE_SIZE;
+    flags = RAW_PAGE;
+    data = page_data;
+  }
+  uint32_t num_sectors = GetNumSectors(stored_size);
+  uint32_t first_sector;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    first_sector = AllocateSectors(num_sectors);
+  }
+  bool written = WriteFully(block_fd_, data, stored_size, static_cast<off_t>(first_sector) * SECTOR_SIZE);
+  // The map points at the block only once it is written, a Sync that writes the entry back syncs the block first.
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (!written) {
+    LOG(ERROR) << "I/O error while writing";
+    AddFreeSectors(first_sector, num_sectors);
+    return;
+  }
+  if (static_cast<size_t>(page_id) >= block_map_.size()) {
+    block_map_.resize(page_id + 1, BlockMapEntry{0, 0, 0});
+    map_chunk_dirty_.resize((block_map_.size() + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE, false);
+  }
+  BlockMapEntry &entry = block_map_[page_id];
+  if (entry.stored_size_ != 0) {
+    ReleaseSectors(entry.first_sector_, GetNumSectors(entry.stored_size_));
+  } else {
+    num_pages_++;
+  }
+  stored_bytes_ = stored_bytes_ - entry.stored_size_ + stored_size;
+  entry = {first_sector, static_cast<uint16_t>(stored_size), flags};
+  MarkDirty(page_id);
+}
+
+void CompressedPageStore::FreePage(page_id_t page_id) {
+  std::scoped_lock<std::mutex> lock(latch_);
+  if (static_cast<size_t>(page_id) >= block_map_.size() || block_map_[page_id].stored_size_ == 0) {
+    return;
+  }
+  BlockMapEntry &entry = block_map_[page_id];
+  ReleaseSectors(entry.first_sector_, GetNumSectors(entry.stored_size_));
+  num_pages_--;
+  stored_bytes_ -= entry.stored_size_;
+  entry = {0, 0, 0};
+  MarkDirty(page_id);
+}
+
+void CompressedPageStore::Sync() {
+  std::scoped_lock<std::mutex> sync_lock(sync_latch_);
+  // The dirty chunks of the map as they are now, every block they point at is written already.
+  std::vector<std::pair<size_t, std::vector<BlockMapEntry>>> chunks;
+  std::vector<std::pair<uint32_t, uint32_t>> released_sectors;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t chunk = 0; chunk < map_chunk_dirty_.size(); chunk++) {
+      if (map_chunk_dirty_[chunk]) {
+        size_t begin = chunk * MAP_CHUNK_SIZE;
+        size_t end = std::min(begin + MAP_CHUNK_SIZE, block_map_.size());
+        chunks.emplace_back(chunk, std::vector<BlockMapEntry>(block_map_.begin() + begin, block_map_.begin() + end));
+        map_chunk_dirty_[chunk] = false;
+      }
+    }
+    released_sectors.swap(released_sectors_);
+  }
+  auto restore = [&]() {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (const auto &chunk : chunks) {
+      map_chunk_dirty_[chunk.first] = true;
+    }
+    released_sectors_.insert(released_sectors_.end(), released_sectors.begin(), released_sectors.end());
+  };
+  // The blocks reach the disk before the map that points at them.
+  if (fdatasync(block_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing " << block_file_name_;
+    restore();
+    return;
+  }
+  for (const auto &chunk : chunks) {
+    size_t begin = chunk.first * MAP_CHUNK_SIZE;
+    if (!WriteFully(block_map_fd_, reinterpret_cast<const char *>(chunk.second.data()),
+                    chunk.second.size() * sizeof(BlockMapEntry), static_cast<off_t>(begin * sizeof(BlockMapEntry)))) {
+      LOG(ERROR) << "I/O error while writing " << block_map_file_name_;
+      restore();
+      return;
+    }
+  }
+  if (!chunks.empty() && fdatasync(block_map_fd_) != 0) {
+    LOG(ERROR) << "I/O error while syncing " << block_map_file_name_;
+    restore();
+    return;
+  }
+  // No block on disk points at the sectors left behind before the snapshot any more.
+  std::scoped_lock<std::mutex> lock(latch_);
+  for (const auto &sectors : released_sectors) {
+    AddFreeSectors(sectors.first, sectors.second);
+  }
+}
+
+uint64_t CompressedPageStore::Truncate() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  struct stat stat_buf;
+  uint64_t size = static_cast<uint64_t>(num_sectors_) * SECTOR_SIZE;
+  if (fstat(block_fd_, &stat_buf) != 0 || static_cast<uint64_t>(stat_buf.st_size) <= size) {
+    return 0;
+  }
+  if (ftruncate(block_fd_, size) != 0) {
+    LOG(ERROR) << "Failed to truncate " << block_file_name_;
+    return 0;
+  }
+  return stat_buf.st_size - size;
+}
+
+void CompressedPageStore::GetFileUsage(uint64_t *file_size, uint64_t *disk_usage) {
+  *file_size = *disk_usage = 0;
+  for (int fd : {block_fd_, block_map_fd_}) {
+    struct stat stat_buf;
+    if (fstat(fd, &stat_buf) == 0) {
+      *file_size += stat_buf.st_size;
+      *disk_usage += static_cast<uint64_t>(stat_buf.st_blocks) * 512;
+    }
+  }
+}
+
+size_t CompressedPageStore::GetNumPages() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return num_pages_;
+}
+
+uint64_t CompressedPageStore::GetStoredBytes() {
+  std::scoped_lock<std::mutex> lock(latch_);
+  return stored_bytes_;
+}
+
+uint32_t CompressedPageStore::AllocateSectors(uint32_t num_sectors) {
+  // The smallest gap that is large enough, the rest of it stays free.
+  auto iter = free_by_size_.lower_bound({num_sectors, 0});
+  if (iter == free_by_size_.end()) {
+    uint32_t first_sector = num_sectors_;
+    num_sectors_ += num_sectors;
+    return first_sector;
+  }
+  auto [gap_size, first_sector] = *iter;
+  free_by_size_.erase(iter);
+  free_by_sector_.erase(first_sector);
+  if (gap_size > num_sectors) {
+    free_by_sector_.emplace(first_sector + num_sectors, gap_size - num_sectors);
+    free_by_size_.emplace(gap_size - num_sectors, first_sector + num_sectors);
+  }
+  return first_sector;
+}
+
+void CompressedPageStore::AddFreeSectors(uint32_t first_sector, uint32_t num_sectors) {
+  auto next = free_by_sector_.lower_bound(first_sector);
+  if (next != free_by_sector_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == first_sector) {
+      first_sector = prev->first;
+      num_sectors += prev->second;
+      free_by_size_.erase({prev->second, prev->first});
+      free_by_sector_.erase(prev);
+    }
+  }
+  if (next != free_by_sector_.end() && next->first == first_sector + num_sectors) {
+    num_sectors += next->second;
+    free_by_size_.erase({next->second, next->first});
+    free_by_sector_.erase(next);
+  }
+  if (first_sector + num_sectors == num_sectors_) {
+    // The end of the file moves back instead, Truncate cuts it off.
+    num_sectors_ = first_sector;
+    return;
+  }
+  free_by_sector_.emplace(first_sector, num_sectors);
+  free_by_size_.emplace(num_sectors, first_sector);
+}
+
+void CompressedPageStore::ReleaseSectors(uint32_t first_sector, uint32_t num_sectors) {
+  released_sectors_.emplace_back(first_sector, num_sectors);
+}
+
+void CompressedPageStore::MarkDirty(page_id_t page_id) { map_chunk_dirty_[page_id / MAP_CHUNK_SIZE] = true; }
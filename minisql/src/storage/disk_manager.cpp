@@ -1,12 +1,29 @@
 #include "storage/disk_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
-
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
 #include <filesystem>
 #include <stdexcept>
 
 #include "glog/logging.h"
 #include "page/bitmap_page.h"
+
+namespace {
+
+inline uint64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
 /*
 DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
@@ -176,8 +193,52 @@ void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page
 
 
 
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, DiskIOBackend backend, bool direct_io, bool compress)
+    : backend_(backend), file_name_(db_file) {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (backend_ == DiskIOBackend::MMAP) {
+    fd_ = open(db_file.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+      throw std::exception();
+    }
+    struct stat stat_buf;
+    if (fstat(fd_, &stat_buf) == 0 && stat_buf.st_size > 0) {
+      mapping_size_ = stat_buf.st_size;
+      void *mapping = mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd_, 0);
+      if (mapping == MAP_FAILED) {
+        close(fd_);
+        throw std::exception();
+      }
+      mapping_ = static_cast<char *>(mapping);
+    }
+    ReadMetaPage(META_PAGE_ID, meta_data_);
+    CheckPageSize();
+    OpenPageStore(compress);
+    return;
+  }
+  if (backend_ == DiskIOBackend::PREAD) {
+    std::filesystem::path p = db_file;
+    if (p.has_parent_path()) {
+      std::filesystem::create_directories(p.parent_path());
+    }
+    if (direct_io) {
+      fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0666);
+      direct_io_ = fd_ >= 0;
+      if (fd_ < 0 && errno == EINVAL) {
+        LOG(WARNING) << "O_DIRECT is not supported for " << db_file << ", using buffered I/O";
+      }
+    }
+    if (fd_ < 0) {
+      fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0666);
+    }
+    if (fd_ < 0) {
+      throw std::exception();
+    }
+    ReadMetaPage(META_PAGE_ID, meta_data_);
+    CheckPageSize();
+    OpenPageStore(compress);
+    return;
+  }
   db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
   if (!db_io_.is_open()) {
     db_io_.clear();
@@ -195,25 +256,245 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
       throw std::exception();
     }
   }
-  ReadPhysicalPage(META_PAGE_ID, meta_data_);
+  ReadMetaPage(META_PAGE_ID, meta_data_);
+  CheckPageSize();
+  OpenPageStore(compress);
+}
+
+void DiskManager::CheckPageSize() {
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t page_size = meta_page->GetPageSize();
+  if (page_size == PAGE_SIZE) {
+    return;
+  }
+  bool known = page_size >= MIN_PAGE_SIZE && page_size <= MAX_PAGE_SIZE && (page_size & (page_size - 1)) == 0;
+  bool empty = meta_page->GetExtentNums() == 0 && meta_page->GetAllocatedPages() == 0;
+  if (!known && !empty && !meta_page->HasLegacyLayout()) {
+    CloseAndThrow(file_name_ + " has an invalid page size " + std::to_string(page_size));
+  }
+  // a file written before the page size was recorded has 4 KB pages
+  if (known || (!empty && PAGE_SIZE != MIN_PAGE_SIZE)) {
+    CloseAndThrow(file_name_ + " has " + std::to_string(known ? page_size : MIN_PAGE_SIZE) +
+                  " byte pages, this build uses " + std::to_string(PAGE_SIZE) + " byte pages");
+  }
+  if (IsReadOnly()) {
+    return;
+  }
+  if (!empty) {
+    // The free extent hint moves to its current word, which held the used page count of an extent no file reaches. It
+    // is only kept as far as the extents below it are full.
+    uint32_t legacy_hint = std::min(meta_page->GetLegacyFreeExtentHint(), meta_page->GetExtentNums());
+    uint32_t hint = 0;
+    while (hint < legacy_hint && meta_page->GetExtentUsedPage(hint) == BITMAP_SIZE) {
+      hint++;
+    }
+    meta_page->SetFreeExtentHint(hint);
+  }
+  meta_page->SetPageSize(PAGE_SIZE);
+  meta_dirty_ = true;
+}
+
+void DiskManager::OpenPageStore(bool compress) {
+  bool exists = CompressedPageStore::Exists(file_name_);
+  if (IsReadOnly()) {
+    if (exists) {
+      CloseAndThrow(file_name_ + " has compressed pages, which can not be mapped");
+    }
+    return;
+  }
+  if (!exists && !compress) {
+    return;
+  }
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  if (!exists && (meta_page->GetExtentNums() > 0 || meta_page->GetAllocatedPages() > 0)) {
+    LOG(WARNING) << file_name_ << " has uncompressed pages already, its pages are not compressed";
+    return;
+  }
+  try {
+    page_store_ = std::make_unique<CompressedPageStore>(file_name_);
+  } catch (const std::runtime_error &ex) {
+    CloseAndThrow(ex.what());
+  }
+}
+
+void DiskManager::CloseAndThrow(const std::string &message) {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+    mapping_ = nullptr;
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  db_io_.close();
+  closed = true;
+  LOG(ERROR) << message;
+  throw std::runtime_error(message);
 }
 
 void DiskManager::Close() {
   std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
   if (!closed) {
-    db_io_.close();
+    Sync();
+    page_store_.reset();
+    if (mapping_ != nullptr) {
+      munmap(mapping_, mapping_size_);
+      mapping_ = nullptr;
+    }
+    if (backend_ != DiskIOBackend::FSTREAM) {
+      close(fd_);
+      fd_ = -1;
+    } else {
+      db_io_.close();
+    }
     closed = true;
   }
 }
 
+void DiskManager::Sync() {
+  if (backend_ == DiskIOBackend::MMAP) {
+    return;
+  }
+  {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    PunchFreedPages();
+    WriteAllocationState();
+  }
+  auto start = std::chrono::steady_clock::now();
+  if (page_store_ != nullptr) {
+    page_store_->Sync();
+  }
+  if (backend_ == DiskIOBackend::PREAD) {
+    if (fdatasync(fd_) != 0) {
+      LOG(ERROR) << "I/O error while syncing " << file_name_;
+    }
+    io_stats_.RecordFlush(ElapsedNs(start));
+    return;
+  }
+  // A stream can only hand its buffer over to the OS.
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  db_io_.flush();
+  io_stats_.RecordFlush(ElapsedNs(start));
+}
+
 void DiskManager::ReadPage(page_id_t logical_page_id, char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  auto start = std::chrono::steady_clock::now();
+  if (page_store_ != nullptr) {
+    page_store_->ReadPage(logical_page_id, page_data);
+  } else if (backend_ != DiskIOBackend::FSTREAM) {
+    ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  } else {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    ReadPhysicalPage(MapPageId(logical_page_id), page_data);
+  }
+  RecordIO(logical_page_id, page_data, IOType::READ, ElapsedNs(start));
 }
 
 void DiskManager::WritePage(page_id_t logical_page_id, const char *page_data) {
   ASSERT(logical_page_id >= 0, "Invalid page id.");
-  WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  auto start = std::chrono::steady_clock::now();
+  if (page_store_ != nullptr) {
+    page_store_->WritePage(logical_page_id, page_data);
+  } else if (backend_ != DiskIOBackend::FSTREAM) {
+    WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  } else {
+    std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+    WritePhysicalPage(MapPageId(logical_page_id), page_data);
+  }
+  RecordIO(logical_page_id, page_data, IOType::WRITE, ElapsedNs(start));
+}
+
+void DiskManager::WritePages(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  if (page_store_ != nullptr) {
+    for (const auto &page : pages) {
+      WritePage(page.first, page.second);
+    }
+    return;
+  }
+  // The pages go out in runs, each one is accounted for with an equal share of the time of the whole batch.
+  auto start = std::chrono::steady_clock::now();
+  WritePageRuns(pages);
+  if (!pages.empty()) {
+    uint64_t latency_ns = ElapsedNs(start) / pages.size();
+    for (const auto &page : pages) {
+      RecordIO(page.first, page.second, IOType::WRITE, latency_ns);
+    }
+  }
+}
+
+void DiskManager::WritePageRuns(const std::vector<std::pair<page_id_t, const char *>> &pages) {
+  std::vector<std::pair<page_id_t, const char *>> physical_pages;
+  physical_pages.reserve(pages.size());
+  for (const auto &page : pages) {
+    ASSERT(page.first >= 0, "Invalid page id.");
+    physical_pages.emplace_back(MapPageId(page.first), page.second);
+  }
+  std::sort(physical_pages.begin(), physical_pages.end());
+  if (backend_ == DiskIOBackend::MMAP) {
+    LOG(ERROR) << "Write to read-only file " << file_name_;
+    return;
+  }
+  if (backend_ == DiskIOBackend::PREAD) {
+    // Every run of contiguous pages goes out with one gather write, straight from the frames.
+    std::vector<iovec> iov;
+    size_t begin = 0;
+    while (begin < physical_pages.size()) {
+      if (!IsAligned(physical_pages[begin].second)) {
+        WritePhysicalPage(physical_pages[begin].first, physical_pages[begin].second);
+        begin++;
+        continue;
+      }
+      size_t end = begin + 1;
+      while (end < physical_pages.size() && end - begin < IOV_MAX &&
+             physical_pages[end].first == physical_pages[end - 1].first + 1 && IsAligned(physical_pages[end].second)) {
+        end++;
+      }
+      iov.clear();
+      for (size_t i = begin; i < end; i++) {
+        iov.push_back({const_cast<char *>(physical_pages[i].second), PAGE_SIZE});
+      }
+      ssize_t res;
+      do {
+        res = pwritev(fd_, iov.data(), iov.size(), static_cast<off_t>(physical_pages[begin].first) * PAGE_SIZE);
+      } while (res < 0 && errno == EINTR);
+      if (res < 0) {
+        LOG(ERROR) << "I/O error while writing: " << strerror(errno);
+        return;
+      }
+      // After a short write the rest of the run, starting with the page written in part, goes page by page.
+      for (size_t i = begin + res / PAGE_SIZE; i < end; i++) {
+        WritePhysicalPage(physical_pages[i].first, physical_pages[i].second);
+      }
+      begin = end;
+    }
+    return;
+  }
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  std::vector<char> run_data;
+  size_t begin = 0;
+  while (begin < physical_pages.size()) {
+    size_t end = begin + 1;
+    while (end < physical_pages.size() && physical_pages[end].first == physical_pages[end - 1].first + 1) {
+      end++;
+    }
+    db_io_.seekp(static_cast<size_t>(physical_pages[begin].first) * PAGE_SIZE);
+    if (end - begin == 1) {
+      db_io_.write(physical_pages[begin].second, PAGE_SIZE);
+    } else {
+      run_data.resize((end - begin) * PAGE_SIZE);
+      for (size_t i = begin; i < end; i++) {
+        memcpy(run_data.data() + (i - begin) * PAGE_SIZE, physical_pages[i].second, PAGE_SIZE);
+      }
+      db_io_.write(run_data.data(), run_data.size());
+    }
+    if (db_io_.bad()) {
+      LOG(ERROR) << "I/O error while writing";
+      return;
+    }
+    begin = end;
+  }
+  db_io_.flush();
 }
 /*
 page_id_t DiskManager::AllocatePage() {
@@ -250,56 +531,130 @@ page_id_t DiskManager::AllocatePage() {
 }
 */
 
-void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
-  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  uint32_t extent_num = meta_page->GetExtentNums();
-  uint32_t this_extent = logical_page_id / BITMAP_SIZE;
-  page_id_t physical_id = (logical_page_id/BITMAP_SIZE ) *(BITMAP_SIZE + 1) + 1 ;// 对应的物理页号 bitmap 的物理页号
-  char page_data[PAGE_SIZE];
-  ReadPhysicalPage(physical_id, page_data); // read the information
-  auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
-  if (!bitmap_page->DeAllocatePage(logical_page_id%BITMAP_SIZE)) {
-    LOG(ERROR) << "Failed to deallocate bitmap page.";
-  }else {
-    WritePhysicalPage(physical_id, page_data); //write back
-    meta_page->num_allocated_pages_ --;
-    meta_page->extent_used_page_[this_extent] --;
+page_id_t DiskManager::AllocatePage() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto const meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  if (IsReadOnly() || meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID) {
+    return INVALID_PAGE_ID;
   }
-
+  // The extents below the hint are full, the used page counts let the full ones after it be skipped without touching
+  // their bitmaps.
+  for (uint32_t extent_id = meta_page->GetFreeExtentHint(); extent_id < DiskFileMetaPage::MAX_EXTENTS; extent_id++) {
+    if (meta_page->GetExtentUsedPage(extent_id) >= BITMAP_SIZE) {
+      continue;
+    }
+    auto bitmap_page = GetBitmapPage(extent_id);
+    uint32_t page_offset = 0;
+    if (!bitmap_page->AllocatePage(page_offset)) {
+      continue;
+    }
+    AddAllocatedPages(extent_id, 1);
+    meta_page->SetFreeExtentHint(meta_page->extent_used_page_[extent_id] < BITMAP_SIZE ? extent_id : extent_id + 1);
+    return extent_id * BITMAP_SIZE + page_offset;
+  }
+  return INVALID_PAGE_ID;
 }
 
-
-page_id_t DiskManager::AllocatePage() {
-  auto const meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
-  if (meta_page->GetAllocatedPages() >= MAX_VALID_PAGE_ID)
+page_id_t DiskManager::AllocatePage(PageSegment *segment) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (IsReadOnly()) {
     return INVALID_PAGE_ID;
-  //tomuch
-  uint32_t extent_num = meta_page->GetExtentNums();
-  uint32_t free = 0;
-  for (free ; free < extent_num; free++) {
-    if (meta_page->extent_used_page_[free] < BITMAP_SIZE) {
-      break;
+  }
+  if (segment->next_page_id_ == segment->end_page_id_ && !ReserveRun(segment)) {
+    return AllocatePage();
+  }
+  page_id_t page_id = segment->next_page_id_++;
+  if (segment->next_page_id_ == segment->end_page_id_) {
+    segments_.erase(segment);
+  }
+  // The page is allocated in the file from now on, see WriteAllocationState.
+  bitmap_dirty_[page_id / BITMAP_SIZE] = true;
+  meta_dirty_ = true;
+  return page_id;
+}
+
+bool DiskManager::ReserveRun(PageSegment *segment) {
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t run_offset = 0;
+  // The extent of the previous run first, starting right after it, so that the segment stays one sequential run.
+  if (segment->end_page_id_ != INVALID_PAGE_ID && segment->end_page_id_ < MAX_VALID_PAGE_ID) {
+    uint32_t extent_id = segment->end_page_id_ / BITMAP_SIZE;
+    if (extent_id < meta_page->GetExtentNums() &&
+        meta_page->GetExtentUsedPage(extent_id) + SEGMENT_RUN_SIZE <= BITMAP_SIZE &&
+        GetBitmapPage(extent_id)->AllocateRun(segment->end_page_id_ % BITMAP_SIZE, run_offset)) {
+      AddAllocatedPages(extent_id, SEGMENT_RUN_SIZE);
+      segment->next_page_id_ = extent_id * BITMAP_SIZE + run_offset;
+      segment->end_page_id_ = segment->next_page_id_ + SEGMENT_RUN_SIZE;
+      segments_.insert(segment);
+      return true;
+    }
+  }
+  for (uint32_t extent_id = meta_page->GetFreeExtentHint(); extent_id < DiskFileMetaPage::MAX_EXTENTS; extent_id++) {
+    if (meta_page->GetExtentUsedPage(extent_id) + SEGMENT_RUN_SIZE > BITMAP_SIZE ||
+        !GetBitmapPage(extent_id)->AllocateRun(0, run_offset)) {
+      continue;
     }
+    AddAllocatedPages(extent_id, SEGMENT_RUN_SIZE);
+    segment->next_page_id_ = extent_id * BITMAP_SIZE + run_offset;
+    segment->end_page_id_ = segment->next_page_id_ + SEGMENT_RUN_SIZE;
+    segments_.insert(segment);
+    return true;
   }
+  return false;
+}
 
+void DiskManager::ReleaseSegment(PageSegment *segment) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  segments_.erase(segment);
+  while (segment->next_page_id_ != segment->end_page_id_) {
+    DeAllocatePage(segment->next_page_id_++);
+  }
+}
 
-  char page_data[PAGE_SIZE];
-  page_id_t physical_id = free * (BITMAP_SIZE + 1) + 1;
-  ReadPhysicalPage(physical_id, page_data);
+void DiskManager::ReleaseSegments() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  auto segments = std::move(segments_);
+  segments_.clear();
+  for (auto segment : segments) {
+    while (segment->next_page_id_ != segment->end_page_id_) {
+      DeAllocatePage(segment->next_page_id_++);
+    }
+    segment->next_page_id_ = segment->end_page_id_ = INVALID_PAGE_ID;
+  }
+}
 
+void DiskManager::AddAllocatedPages(uint32_t extent_id, uint32_t num_pages) {
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  meta_page->num_extents_ = std::max(meta_page->num_extents_, extent_id + 1);
+  meta_page->extent_used_page_[extent_id] += num_pages;
+  meta_page->num_allocated_pages_ += num_pages;
+  bitmap_dirty_[extent_id] = true;
+  meta_dirty_ = true;
+}
 
-  uint32_t page_offset = 0;
-  auto bitmap_page = reinterpret_cast<BitmapPage <PAGE_SIZE>*>(page_data);
-  if (!bitmap_page->AllocatePage(page_offset)) {
-    LOG(ERROR) << "Failed to allocate bitmap page.";
+void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (IsReadOnly()) {
+    LOG(ERROR) << "Failed to deallocate page of read-only file " << file_name_;
+    return;
   }
-  WritePhysicalPage(physical_id, page_data);
-  meta_page->extent_used_page_[free] ++;
-  meta_page->num_allocated_pages_++;
-  if (meta_page->extent_used_page_[free] == 1 ) {
-    meta_page->num_extents_ ++;
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t extent_id = logical_page_id / BITMAP_SIZE;
+  if (logical_page_id < 0 || logical_page_id >= MAX_VALID_PAGE_ID ||
+      !GetBitmapPage(extent_id)->DeAllocatePage(logical_page_id % BITMAP_SIZE)) {
+    LOG(ERROR) << "Failed to deallocate bitmap page.";
+    return;
+  }
+  bitmap_dirty_[extent_id] = true;
+  meta_page->num_allocated_pages_--;
+  meta_page->extent_used_page_[extent_id]--;
+  meta_page->SetFreeExtentHint(std::min(meta_page->GetFreeExtentHint(), extent_id));
+  meta_dirty_ = true;
+  if (page_store_ != nullptr) {
+    page_store_->FreePage(logical_page_id);
+  } else if (backend_ == DiskIOBackend::PREAD && punch_holes_) {
+    freed_pages_.push_back(logical_page_id);
   }
-  return free * BITMAP_SIZE + page_offset;
 }
 
 /*
@@ -325,17 +680,11 @@ void DiskManager::DeAllocatePage(page_id_t logical_page_id) {
 }*/
 
 bool DiskManager::IsPageFree(page_id_t logical_page_id) {
-  // 判断对应的bitmap中那一bit是0还是1
-  // 读取对应的bitmap
-  char bitmap[PAGE_SIZE];
-  size_t pages_per_extent = 1 + BITMAP_SIZE;
-  page_id_t bitmap_physical_id = 1 + MapPageId(logical_page_id) / pages_per_extent;
-  ReadPhysicalPage(bitmap_physical_id, bitmap);
-
-  BitmapPage<PAGE_SIZE> *bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(bitmap);
-  // 判断
-  if (bitmap_page->IsPageFree(logical_page_id % BITMAP_SIZE)) return true;
-  return false;
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (logical_page_id < 0 || logical_page_id >= MAX_VALID_PAGE_ID) {
+    return false;
+  }
+  return GetBitmapPage(logical_page_id / BITMAP_SIZE)->IsPageFree(logical_page_id % BITMAP_SIZE);
 }
 
 /*
@@ -360,6 +709,184 @@ bool DiskManager::IsPageFree(page_id_t logical_page_id) {
 page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
   return logical_page_id + 1 + 1 + logical_page_id / BITMAP_SIZE;
 }
+
+BitmapPage<PAGE_SIZE> *DiskManager::GetBitmapPage(uint32_t extent_id) {
+  if (extent_id >= bitmap_pages_.size()) {
+    bitmap_pages_.resize(extent_id + 1);
+    bitmap_dirty_.resize(extent_id + 1, false);
+  }
+  if (bitmap_pages_[extent_id] == nullptr) {
+    bitmap_pages_[extent_id] = std::make_unique<BitmapPage<PAGE_SIZE>>();
+    ReadMetaPage(GetBitmapPhysicalPageId(extent_id), reinterpret_cast<char *>(bitmap_pages_[extent_id].get()));
+    // The used page counts of the meta page are only as recent as the last sync, the bitmap is the reference.
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+    uint32_t used = bitmap_pages_[extent_id]->RecountAllocatedPages();
+    uint32_t recorded = meta_page->GetExtentUsedPage(extent_id);
+    if (used != recorded) {
+      meta_page->num_allocated_pages_ = meta_page->num_allocated_pages_ - recorded + used;
+      meta_page->extent_used_page_[extent_id] = used;
+      meta_page->num_extents_ = std::max(meta_page->num_extents_, extent_id + 1);
+      meta_dirty_ = true;
+    }
+  }
+  return bitmap_pages_[extent_id].get();
+}
+
+void DiskManager::WriteAllocationState() {
+  if (IsReadOnly()) {
+    return;
+  }
+  // The pages reserved for segments and not handed out yet are written as free, in copies of the pages.
+  std::vector<uint32_t> reserved(bitmap_pages_.size(), 0);
+  for (auto segment : segments_) {
+    reserved[segment->next_page_id_ / BITMAP_SIZE] += segment->end_page_id_ - segment->next_page_id_;
+  }
+  alignas(DIRECT_IO_ALIGNMENT) char page_data[PAGE_SIZE];
+  for (uint32_t extent_id = 0; extent_id < bitmap_pages_.size(); extent_id++) {
+    if (!bitmap_dirty_[extent_id]) {
+      continue;
+    }
+    auto bitmap_data = reinterpret_cast<char *>(bitmap_pages_[extent_id].get());
+    if (reserved[extent_id] != 0) {
+      memcpy(page_data, bitmap_data, PAGE_SIZE);
+      auto bitmap_page = reinterpret_cast<BitmapPage<PAGE_SIZE> *>(page_data);
+      for (auto segment : segments_) {
+        if (static_cast<uint32_t>(segment->next_page_id_ / BITMAP_SIZE) == extent_id) {
+          for (page_id_t page_id = segment->next_page_id_; page_id < segment->end_page_id_; page_id++) {
+            bitmap_page->DeAllocatePage(page_id % BITMAP_SIZE);
+          }
+        }
+      }
+      bitmap_data = page_data;
+    }
+    WriteMetaPage(GetBitmapPhysicalPageId(extent_id), bitmap_data);
+    bitmap_dirty_[extent_id] = false;
+  }
+  if (meta_dirty_) {
+    memcpy(page_data, meta_data_, PAGE_SIZE);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(page_data);
+    for (uint32_t extent_id = 0; extent_id < reserved.size(); extent_id++) {
+      meta_page->extent_used_page_[extent_id] -= reserved[extent_id];
+      meta_page->num_allocated_pages_ -= reserved[extent_id];
+    }
+    WriteMetaPage(META_PAGE_ID, page_data);
+    meta_dirty_ = false;
+  }
+}
+
+void DiskManager::PunchFreedPages() {
+  if (freed_pages_.empty()) {
+    return;
+  }
+  std::sort(freed_pages_.begin(), freed_pages_.end());
+  freed_pages_.erase(std::unique(freed_pages_.begin(), freed_pages_.end()), freed_pages_.end());
+  for (size_t i = 0; i < freed_pages_.size() && punch_holes_;) {
+    // Pages allocated again since they were freed may hold data already.
+    page_id_t first_page_id = freed_pages_[i++];
+    if (!IsPageFree(first_page_id)) {
+      continue;
+    }
+    // One hole per run of pages, a run stops at the bitmap page of the next extent.
+    page_id_t end_page_id = first_page_id + 1;
+    while (i < freed_pages_.size() && freed_pages_[i] == end_page_id && end_page_id % BITMAP_SIZE != 0 &&
+           IsPageFree(end_page_id)) {
+      end_page_id++;
+      i++;
+    }
+    off_t length = static_cast<off_t>(end_page_id - first_page_id) * PAGE_SIZE;
+    if (fallocate(fd_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, GetPageOffset(first_page_id), length) != 0) {
+      if (errno == EOPNOTSUPP) {
+        LOG(WARNING) << "Hole punching is not supported for " << file_name_ << ", freed pages keep their space";
+        punch_holes_ = false;
+      } else {
+        LOG(ERROR) << "Failed to punch freed pages out of " << file_name_;
+      }
+      continue;
+    }
+    punched_bytes_ += length;
+  }
+  freed_pages_.clear();
+}
+
+uint64_t DiskManager::Truncate() {
+  std::scoped_lock<std::recursive_mutex> lock(db_io_latch_);
+  if (IsReadOnly()) {
+    return 0;
+  }
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(meta_data_);
+  uint32_t num_extents = meta_page->GetExtentNums();
+  uint64_t file_size = PAGE_SIZE;  // the meta page
+  while (num_extents > 0) {
+    uint32_t page_offset;
+    if (meta_page->GetExtentUsedPage(num_extents - 1) != 0 &&
+        GetBitmapPage(num_extents - 1)->FindLastAllocatedPage(page_offset)) {
+      file_size = (static_cast<uint64_t>(MapPageId((num_extents - 1) * BITMAP_SIZE + page_offset)) + 1) * PAGE_SIZE;
+      break;
+    }
+    num_extents--;
+  }
+  if (num_extents < meta_page->GetExtentNums()) {
+    meta_page->num_extents_ = num_extents;
+    meta_page->SetFreeExtentHint(std::min(meta_page->GetFreeExtentHint(), num_extents));
+    meta_dirty_ = true;
+    if (bitmap_pages_.size() > num_extents) {
+      bitmap_pages_.resize(num_extents);
+      bitmap_dirty_.resize(num_extents);
+    }
+  }
+  WriteAllocationState();
+  uint64_t truncated_bytes = 0;
+  if (page_store_ != nullptr) {
+    page_store_->Sync();
+    truncated_bytes = page_store_->Truncate();
+  }
+  struct stat stat_buf;
+  if (stat(file_name_.c_str(), &stat_buf) != 0 || static_cast<uint64_t>(stat_buf.st_size) <= file_size) {
+    return truncated_bytes;
+  }
+  uint64_t old_file_size = stat_buf.st_size;
+  if (backend_ == DiskIOBackend::PREAD) {
+    if (ftruncate(fd_, file_size) != 0) {
+      LOG(ERROR) << "Failed to truncate " << file_name_;
+      return truncated_bytes;
+    }
+  } else {
+    db_io_.flush();
+    std::error_code error;
+    std::filesystem::resize_file(file_name_, file_size, error);
+    if (error) {
+      LOG(ERROR) << "Failed to truncate " << file_name_;
+      return truncated_bytes;
+    }
+  }
+  return truncated_bytes + old_file_size - file_size;
+}
+
+void DiskManager::GetFileUsage(uint64_t *file_size, uint64_t *disk_usage) {
+  struct stat stat_buf;
+  if (stat(file_name_.c_str(), &stat_buf) != 0) {
+    *file_size = *disk_usage = 0;
+    return;
+  }
+  *file_size = stat_buf.st_size;
+  *disk_usage = static_cast<uint64_t>(stat_buf.st_blocks) * 512;
+  if (page_store_ != nullptr) {
+    uint64_t store_size;
+    uint64_t store_usage;
+    page_store_->GetFileUsage(&store_size, &store_usage);
+    *file_size += store_size;
+    *disk_usage += store_usage;
+  }
+}
+
+const char *DiskManager::GetMappedPage(page_id_t logical_page_id) {
+  ASSERT(logical_page_id >= 0, "Invalid page id.");
+  size_t offset = static_cast<size_t>(MapPageId(logical_page_id)) * PAGE_SIZE;
+  if (offset + PAGE_SIZE > mapping_size_) {
+    return nullptr;
+  }
+  return mapping_ + offset;
+}
 //page_id_t DiskManager::MapPageId(page_id_t logical_page_id) {
 //if (logical_page_id >= MAX_VALID_PAGE_ID)
   //return INVALID_PAGE_ID;
@@ -373,7 +900,57 @@ int DiskManager::GetFileSize(const std::string &file_name) {
   return rc == 0 ? stat_buf.st_size : -1;
 }
 
+void DiskManager::ReadMetaPage(page_id_t physical_page_id, char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  ReadPhysicalPage(physical_page_id, page_data);
+  io_stats_.Record(PageClass::META, IOType::READ, ElapsedNs(start));
+}
+
+void DiskManager::WriteMetaPage(page_id_t physical_page_id, const char *page_data) {
+  auto start = std::chrono::steady_clock::now();
+  WritePhysicalPage(physical_page_id, page_data);
+  io_stats_.Record(PageClass::META, IOType::WRITE, ElapsedNs(start));
+}
+
 void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data) {
+  if (backend_ == DiskIOBackend::MMAP) {
+    size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
+    size_t read_count = offset < mapping_size_ ? std::min<size_t>(PAGE_SIZE, mapping_size_ - offset) : 0;
+    if (read_count > 0) {
+      memcpy(page_data, mapping_ + offset, read_count);
+    }
+    // if file ends before reading PAGE_SIZE
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    return;
+  }
+  if (backend_ == DiskIOBackend::PREAD) {
+    if (!IsAligned(page_data)) {
+      alignas(DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+      ReadPhysicalPage(physical_page_id, bounce);
+      memcpy(page_data, bounce, PAGE_SIZE);
+      return;
+    }
+    off_t offset = static_cast<off_t>(physical_page_id) * PAGE_SIZE;
+    ssize_t read_count = 0;
+    while (read_count < PAGE_SIZE) {
+      ssize_t res = pread(fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+      if (res < 0 && errno == EINTR) {
+        continue;
+      }
+      if (res < 0) {
+        LOG(ERROR) << "I/O error while reading";
+      }
+      if (res <= 0) {
+        break;
+      }
+      read_count += res;
+    }
+    // if file ends before reading PAGE_SIZE
+    if (read_count < PAGE_SIZE) {
+      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    }
+    return;
+  }
   int offset = physical_page_id * PAGE_SIZE;
   // check if read beyond file length
   if (offset >= GetFileSize(file_name_)) {
@@ -397,6 +974,32 @@ void DiskManager::ReadPhysicalPage(page_id_t physical_page_id, char *page_data)
 }
 
 void DiskManager::WritePhysicalPage(page_id_t physical_page_id, const char *page_data) {
+  if (backend_ == DiskIOBackend::MMAP) {
+    LOG(ERROR) << "Write to read-only file " << file_name_;
+    return;
+  }
+  if (backend_ == DiskIOBackend::PREAD) {
+    if (!IsAligned(page_data)) {
+      alignas(DIRECT_IO_ALIGNMENT) char bounce[PAGE_SIZE];
+      memcpy(bounce, page_data, PAGE_SIZE);
+      WritePhysicalPage(physical_page_id, bounce);
+      return;
+    }
+    off_t offset = static_cast<off_t>(physical_page_id) * PAGE_SIZE;
+    ssize_t write_count = 0;
+    while (write_count < PAGE_SIZE) {
+      ssize_t res = pwrite(fd_, page_data + write_count, PAGE_SIZE - write_count, offset + write_count);
+      if (res < 0 && errno == EINTR) {
+        continue;
+      }
+      if (res <= 0) {
+        LOG(ERROR) << "I/O error while writing: " << (res < 0 ? strerror(errno) : "no progress");
+        return;
+      }
+      write_count += res;
+    }
+    return;
+  }
   size_t offset = static_cast<size_t>(physical_page_id) * PAGE_SIZE;
   // set write cursor to offset
   db_io_.seekp(offset);
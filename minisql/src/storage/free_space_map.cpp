@@ -0,0 +1,260 @@
+#include "storage/free_space_map.h"
+
+#include <cstring>
+
+namespace {
+
+inline page_id_t ReadPageId(const char *data, size_t offset) {
+  page_id_t page_id;
+  memcpy(&page_id, data + offset, sizeof(page_id));
+  return page_id;
+}
+
+inline void WritePageId(char *data, size_t offset, page_id_t page_id) {
+  memcpy(data + offset, &page_id, sizeof(page_id));
+}
+
+}  // namespace
+
+void FreeSpaceMap::Load() {
+  std::scoped_lock lock(latch_);
+  if (loaded_) {
+    return;
+  }
+  loaded_ = true;
+  persisted_ = !buffer_pool_manager_->IsReadOnly();
+  for (page_id_t map_page_id = first_page_id_; map_page_id != INVALID_PAGE_ID;) {
+    Page *page = buffer_pool_manager_->FetchPage(map_page_id);
+    if (page == nullptr) {
+      break;
+    }
+    const char *data = page->GetData();
+    uint32_t num_entries;
+    memcpy(&num_entries, data + OFFSET_NUM_ENTRIES, sizeof(num_entries));
+    num_entries = std::min<uint32_t>(num_entries, ENTRIES_PER_PAGE);
+    map_page_ids_.push_back(map_page_id);
+    for (uint32_t i = 0; i < num_entries; i++) {
+      page_id_t page_id = ReadPageId(data, OFFSET_PAGE_IDS + sizeof(page_id_t) * i);
+      entries_.emplace(page_id, page_ids_.size());
+      page_ids_.push_back(page_id);
+      free_units_.push_back(static_cast<uint8_t>(data[OFFSET_FREE_UNITS + i]));
+    }
+    page_id_t next_map_page_id = ReadPageId(data, OFFSET_NEXT_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    // A map page that is not full is the last one, entries are only appended.
+    if (num_entries < ENTRIES_PER_PAGE) {
+      break;
+    }
+    map_page_id = next_map_page_id;
+  }
+  block_max_.assign((page_ids_.size() + BLOCK_SIZE - 1) / BLOCK_SIZE, 0);
+  for (size_t block = 0; block < block_max_.size(); block++) {
+    UpdateBlockMax(block);
+  }
+}
+
+bool FreeSpaceMap::IsLoaded() {
+  std::scoped_lock lock(latch_);
+  return loaded_;
+}
+
+void FreeSpaceMap::Unload() {
+  std::scoped_lock lock(latch_);
+  loaded_ = false;
+  map_page_ids_.clear();
+  page_ids_.clear();
+  free_units_.clear();
+  block_max_.clear();
+  entries_.clear();
+}
+
+void FreeSpaceMap::AddPage(page_id_t page_id, uint32_t free_bytes) {
+  std::scoped_lock lock(latch_);
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    SetEntry(iter->second, ToUnits(free_bytes));
+    return;
+  }
+  size_t entry = page_ids_.size();
+  entries_.emplace(page_id, entry);
+  page_ids_.push_back(page_id);
+  free_units_.push_back(ToUnits(free_bytes));
+  if (entry % BLOCK_SIZE == 0) {
+    block_max_.push_back(0);
+  }
+  block_max_.back() = std::max(block_max_.back(), free_units_.back());
+  WriteEntry(entry);
+}
+
+void FreeSpaceMap::UpdatePage(page_id_t page_id, uint32_t free_bytes) {
+  std::scoped_lock lock(latch_);
+  auto iter = entries_.find(page_id);
+  if (iter != entries_.end()) {
+    SetEntry(iter->second, ToUnits(free_bytes));
+  }
+}
+
+void FreeSpaceMap::SetEntry(size_t entry, uint8_t units) {
+  if (free_units_[entry] == units) {
+    return;
+  }
+  uint8_t old_units = free_units_[entry];
+  free_units_[entry] = units;
+  size_t block = entry / BLOCK_SIZE;
+  if (units > block_max_[block]) {
+    block_max_[block] = units;
+  } else if (old_units == block_max_[block]) {
+    UpdateBlockMax(block);
+  }
+  WriteEntry(entry);
+}
+
+bool FreeSpaceMap::HasRoom(page_id_t page_id, uint32_t size) {
+  std::scoped_lock lock(latch_);
+  auto iter = entries_.find(page_id);
+  return iter != entries_.end() && free_units_[iter->second] >= ToNeededUnits(size);
+}
+
+page_id_t FreeSpaceMap::FindPage(uint32_t size) {
+  std::scoped_lock lock(latch_);
+  uint32_t units = ToNeededUnits(size);
+  for (size_t block = 0; block < block_max_.size(); block++) {
+    if (block_max_[block] < units) {
+      continue;
+    }
+    size_t end = std::min(page_ids_.size(), (block + 1) * BLOCK_SIZE);
+    for (size_t entry = block * BLOCK_SIZE; entry < end; entry++) {
+      if (free_units_[entry] >= units) {
+        return page_ids_[entry];
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+page_id_t FreeSpaceMap::GetLastPage() {
+  std::scoped_lock lock(latch_);
+  return page_ids_.empty() ? INVALID_PAGE_ID : page_ids_.back();
+}
+
+size_t FreeSpaceMap::GetNumPages() {
+  std::scoped_lock lock(latch_);
+  return page_ids_.size();
+}
+
+void FreeSpaceMap::FreePages() {
+  std::scoped_lock lock(latch_);
+  for (page_id_t map_page_id = first_page_id_; map_page_id != INVALID_PAGE_ID;) {
+    Page *page = buffer_pool_manager_->FetchPage(map_page_id);
+    if (page == nullptr) {
+      break;
+    }
+    page_id_t next_map_page_id = ReadPageId(page->GetData(), OFFSET_NEXT_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    buffer_pool_manager_->DeletePage(map_page_id);
+    map_page_id = next_map_page_id;
+  }
+  first_page_id_ = INVALID_PAGE_ID;
+  map_page_ids_.clear();
+  page_ids_.clear();
+  free_units_.clear();
+  block_max_.clear();
+  entries_.clear();
+}
+
+void FreeSpaceMap::RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved) {
+  Unload();
+  std::scoped_lock lock(latch_);
+  first_page_id_ = BufferPoolManager::GetRelocatedPageId(moved, first_page_id_);
+  for (page_id_t map_page_id = first_page_id_; map_page_id != INVALID_PAGE_ID;) {
+    Page *page = buffer_pool_manager_->FetchPage(map_page_id);
+    if (page == nullptr) {
+      break;
+    }
+    char *data = page->GetData();
+    bool is_dirty = false;
+    auto relocate = [&](size_t offset) {
+      page_id_t page_id = ReadPageId(data, offset);
+      page_id_t new_page_id = BufferPoolManager::GetRelocatedPageId(moved, page_id);
+      if (new_page_id != page_id) {
+        WritePageId(data, offset, new_page_id);
+        is_dirty = true;
+      }
+    };
+    if (ReadPageId(data, 0) != map_page_id) {
+      WritePageId(data, 0, map_page_id);
+      is_dirty = true;
+    }
+    relocate(OFFSET_NEXT_PAGE_ID);
+    uint32_t num_entries;
+    memcpy(&num_entries, data + OFFSET_NUM_ENTRIES, sizeof(num_entries));
+    num_entries = std::min<uint32_t>(num_entries, ENTRIES_PER_PAGE);
+    for (uint32_t i = 0; i < num_entries; i++) {
+      relocate(OFFSET_PAGE_IDS + sizeof(page_id_t) * i);
+    }
+    page_id_t next_map_page_id =
+        num_entries < ENTRIES_PER_PAGE ? INVALID_PAGE_ID : ReadPageId(data, OFFSET_NEXT_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(map_page_id, is_dirty);
+    map_page_id = next_map_page_id;
+  }
+}
+
+void FreeSpaceMap::WriteEntry(size_t entry) {
+  if (!persisted_) {
+    return;
+  }
+  size_t map_page_index = entry / ENTRIES_PER_PAGE;
+  size_t slot = entry % ENTRIES_PER_PAGE;
+  if (map_page_index == map_page_ids_.size()) {
+    page_id_t new_page_id;
+    Page *new_page = buffer_pool_manager_->NewPage(new_page_id);
+    if (new_page == nullptr) {
+      // The entries from here on are in memory only, the next Load sees a shorter map and the heap adds them again.
+      persisted_ = false;
+      return;
+    }
+    char *data = new_page->GetData();
+    uint32_t num_entries = 0;
+    WritePageId(data, 0, new_page_id);
+    WritePageId(data, OFFSET_NEXT_PAGE_ID, INVALID_PAGE_ID);
+    memcpy(data + OFFSET_NUM_ENTRIES, &num_entries, sizeof(num_entries));
+    buffer_pool_manager_->UnpinPage(new_page_id, true);
+    if (map_page_ids_.empty()) {
+      first_page_id_ = new_page_id;
+    } else {
+      page_id_t last_page_id = map_page_ids_.back();
+      Page *last_page = buffer_pool_manager_->FetchPage(last_page_id);
+      if (last_page == nullptr) {
+        persisted_ = false;
+        return;
+      }
+      WritePageId(last_page->GetData(), OFFSET_NEXT_PAGE_ID, new_page_id);
+      buffer_pool_manager_->UnpinPage(last_page_id, true);
+    }
+    map_page_ids_.push_back(new_page_id);
+  }
+  page_id_t map_page_id = map_page_ids_[map_page_index];
+  Page *page = buffer_pool_manager_->FetchPage(map_page_id);
+  if (page == nullptr) {
+    return;
+  }
+  char *data = page->GetData();
+  WritePageId(data, OFFSET_PAGE_IDS + sizeof(page_id_t) * slot, page_ids_[entry]);
+  data[OFFSET_FREE_UNITS + slot] = static_cast<char>(free_units_[entry]);
+  uint32_t num_entries;
+  memcpy(&num_entries, data + OFFSET_NUM_ENTRIES, sizeof(num_entries));
+  if (num_entries <= slot) {
+    num_entries = slot + 1;
+    memcpy(data + OFFSET_NUM_ENTRIES, &num_entries, sizeof(num_entries));
+  }
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+}
+
+void FreeSpaceMap::UpdateBlockMax(size_t block) {
+  size_t end = std::min(page_ids_.size(), (block + 1) * BLOCK_SIZE);
+  uint8_t max_units = 0;
+  for (size_t entry = block * BLOCK_SIZE; entry < end; entry++) {
+    max_units = std::max(max_units, free_units_[entry]);
+  }
+  block_max_[block] = max_units;
+}
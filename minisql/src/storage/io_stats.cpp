@@ -0,0 +1,107 @@
+#include "storage/io_stats.h"
+
+#include <cstring>
+
+#include "catalog/indexes.h"
+#include "catalog/table.h"
+#include "page/b_plus_tree_page.h"
+
+namespace {
+
+void WriteHistogramJson(std::ostream &out, const LatencyHistogram &histogram, uint64_t total_ns) {
+  out << "{\"count\": " << histogram.GetTotal() << ", \"total_us\": " << total_ns / 1000 << ", \"histogram\": {";
+  bool first = true;
+  for (size_t b = 0; b < LatencyHistogram::NUM_BUCKETS; b++) {
+    if (histogram.GetCount(b) == 0) {
+      continue;
+    }
+    out << (first ? "" : ", ") << "\"" << LatencyHistogram::GetBucketLabel(b) << "\": " << histogram.GetCount(b);
+    first = false;
+  }
+  out << "}}";
+}
+
+}  // namespace
+
+void IOStats::Merge(const IOStats &other) {
+  for (size_t c = 0; c < NUM_PAGE_CLASSES; c++) {
+    for (size_t t = 0; t < NUM_IO_TYPES; t++) {
+      latency_[c][t].Merge(other.latency_[c][t]);
+      total_ns_[c][t].fetch_add(other.total_ns_[c][t].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+  }
+  flush_latency_.Merge(other.flush_latency_);
+  flush_total_ns_.fetch_add(other.GetTotalFlushLatency(), std::memory_order_relaxed);
+}
+
+void IOStats::Reset() {
+  for (size_t c = 0; c < NUM_PAGE_CLASSES; c++) {
+    for (size_t t = 0; t < NUM_IO_TYPES; t++) {
+      latency_[c][t].Reset();
+      total_ns_[c][t].store(0, std::memory_order_relaxed);
+    }
+  }
+  flush_latency_.Reset();
+  flush_total_ns_.store(0, std::memory_order_relaxed);
+}
+
+void IOStats::WriteJson(std::ostream &out) const {
+  out << "{";
+  for (size_t t = 0; t < NUM_IO_TYPES; t++) {
+    out << "\"" << GetIOTypeName(static_cast<IOType>(t)) << "\": {";
+    bool first = true;
+    for (size_t c = 0; c < NUM_PAGE_CLASSES; c++) {
+      if (latency_[c][t].GetTotal() == 0) {
+        continue;
+      }
+      out << (first ? "" : ", ") << "\"" << GetPageClassName(static_cast<PageClass>(c)) << "\": ";
+      WriteHistogramJson(out, latency_[c][t], total_ns_[c][t].load(std::memory_order_relaxed));
+      first = false;
+    }
+    out << "}, ";
+  }
+  out << "\"flush\": ";
+  WriteHistogramJson(out, flush_latency_, GetTotalFlushLatency());
+  out << "}";
+}
+
+PageClass IOStats::ClassifyPage(page_id_t logical_page_id, const char *page_data) {
+  if (logical_page_id == CATALOG_META_PAGE_ID || logical_page_id == INDEX_ROOTS_PAGE_ID) {
+    return PageClass::CATALOG;
+  }
+  // The page type is the first field of a B+ tree page header.
+  IndexPageType page_type;
+  memcpy(&page_type, page_data, sizeof(page_type));
+  if ((page_type == IndexPageType::LEAF_PAGE || page_type == IndexPageType::INTERNAL_PAGE) &&
+      reinterpret_cast<const BPlusTreePage *>(page_data)->GetPageId() == logical_page_id) {
+    return PageClass::INDEX;
+  }
+  // A table page starts with its own page id, see TablePage::GetTablePageId, so does a page of a free space map.
+  uint32_t first_word;
+  memcpy(&first_word, page_data, sizeof(first_word));
+  if (first_word == static_cast<uint32_t>(logical_page_id)) {
+    return PageClass::TABLE;
+  }
+  if (first_word == TableMetadata::TABLE_METADATA_FSM_MAGIC_NUM ||
+      first_word == TableMetadata::TABLE_METADATA_MAGIC_NUM || first_word == IndexMetadata::INDEX_METADATA_MAGIC_NUM) {
+    return PageClass::CATALOG;
+  }
+  return PageClass::OTHER;
+}
+
+const char *IOStats::GetPageClassName(PageClass page_class) {
+  switch (page_class) {
+    case PageClass::META:
+      return "meta";
+    case PageClass::CATALOG:
+      return "catalog";
+    case PageClass::TABLE:
+      return "table";
+    case PageClass::INDEX:
+      return "index";
+    default:
+      return "other";
+  }
+}
+
+const char *IOStats::GetIOTypeName(IOType type) { return type == IOType::READ ? "read" : "write"; }
@@ -0,0 +1,157 @@
+#include "storage/page_codec.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+constexpr int HASH_BITS = 12;
+constexpr size_t MAX_OFFSET = 65535;
+
+inline uint32_t Read32(const char *data) {
+  uint32_t value;
+  memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+/** Append the part of a length beyond the 15 of its token. */
+inline bool PutLength(size_t length, char *&op, const char *oend) {
+  while (length >= 255) {
+    if (op >= oend) {
+      return false;
+    }
+    *op++ = static_cast<char>(255);
+    length -= 255;
+  }
+  if (op >= oend) {
+    return false;
+  }
+  *op++ = static_cast<char>(length);
+  return true;
+}
+
+inline bool GetLength(const unsigned char *&ip, const unsigned char *iend, size_t &length) {
+  unsigned char byte;
+  do {
+    if (ip >= iend) {
+      return false;
+    }
+    byte = *ip++;
+    length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Append a sequence, match_length 0 for the last one. */
+bool PutSequence(const char *literals, size_t num_literals, size_t offset, size_t match_length, char *&op,
+                 const char *oend) {
+  if (op >= oend) {
+    return false;
+  }
+  char *token = op++;
+  size_t match_code = match_length == 0 ? 0 : match_length - PageCodec::MIN_MATCH;
+  *token = static_cast<char>((std::min<size_t>(num_literals, 15) << 4) | std::min<size_t>(match_code, 15));
+  if (num_literals >= 15 && !PutLength(num_literals - 15, op, oend)) {
+    return false;
+  }
+  if (static_cast<size_t>(oend - op) < num_literals) {
+    return false;
+  }
+  memcpy(op, literals, num_literals);
+  op += num_literals;
+  if (match_length == 0) {
+    return true;
+  }
+  if (oend - op < 2) {
+    return false;
+  }
+  *op++ = static_cast<char>(offset & 0xff);
+  *op++ = static_cast<char>(offset >> 8);
+  return match_code < 15 || PutLength(match_code - 15, op, oend);
+}
+
+}  // namespace
+
+size_t PageCodec::Compress(const char *src, size_t size, char *dst, size_t capacity) {
+  int32_t last_position[1 << HASH_BITS];
+  std::fill(std::begin(last_position), std::end(last_position), -1);
+  char *op = dst;
+  const char *oend = dst + capacity;
+  size_t anchor = 0;  // first byte not emitted yet
+  size_t pos = 0;
+  size_t misses = 0;
+  while (pos + MIN_MATCH <= size) {
+    uint32_t sequence = Read32(src + pos);
+    uint32_t hash = Hash(sequence);
+    int32_t candidate = last_position[hash];
+    last_position[hash] = static_cast<int32_t>(pos);
+    if (candidate < 0 || pos - candidate > MAX_OFFSET || Read32(src + candidate) != sequence) {
+      // Step faster through data that does not compress.
+      pos += 1 + (misses++ >> 6);
+      continue;
+    }
+    misses = 0;
+    size_t length = MIN_MATCH;
+    while (pos + length < size && src[candidate + length] == src[pos + length]) {
+      length++;
+    }
+    if (!PutSequence(src + anchor, pos - anchor, pos - candidate, length, op, oend)) {
+      return 0;
+    }
+    pos += length;
+    anchor = pos;
+  }
+  if (!PutSequence(src + anchor, size - anchor, 0, 0, op, oend)) {
+    return 0;
+  }
+  return op - dst;
+}
+
+bool PageCodec::Decompress(const char *src, size_t size, char *dst, size_t dst_size) {
+  auto ip = reinterpret_cast<const unsigned char *>(src);
+  auto iend = ip + size;
+  char *op = dst;
+  char *oend = dst + dst_size;
+  while (ip < iend) {
+    unsigned token = *ip++;
+    size_t num_literals = token >> 4;
+    if (num_literals == 15 && !GetLength(ip, iend, num_literals)) {
+      return false;
+    }
+    if (static_cast<size_t>(iend - ip) < num_literals || static_cast<size_t>(oend - op) < num_literals) {
+      return false;
+    }
+    memcpy(op, ip, num_literals);
+    op += num_literals;
+    ip += num_literals;
+    if (ip == iend) {
+      break;
+    }
+    if (iend - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    size_t length = (token & 15) + MIN_MATCH;
+    if ((token & 15) == 15 && !GetLength(ip, iend, length)) {
+      return false;
+    }
+    if (offset == 0 || offset > static_cast<size_t>(op - dst) || static_cast<size_t>(oend - op) < length) {
+      return false;
+    }
+    // The match may overlap the bytes it produces, copy it in chunks that do not, each a whole number of periods.
+    const char *match = op - offset;
+    size_t copied = 0;
+    while (copied < length) {
+      size_t chunk = std::min(length - copied, copied + offset);
+      memcpy(op + copied, match, chunk);
+      copied += chunk;
+    }
+    op += length;
+  }
+  return op == oend;
+}
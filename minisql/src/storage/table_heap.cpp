@@ -1,10 +1,47 @@
 #include "storage/table_heap.h"
+#include <algorithm>
 #include <cassert>
+#include <memory>
+
+namespace {
+
+constexpr size_t OFFSET_OVERFLOW_NEXT_PAGE_ID = 4;
+constexpr size_t OFFSET_OVERFLOW_SIZE = 8;
+constexpr size_t OFFSET_OVERFLOW_DATA = 12;
+
+inline page_id_t ReadPageId(const char *data, size_t offset) {
+  page_id_t page_id;
+  memcpy(&page_id, data + offset, sizeof(page_id));
+  return page_id;
+}
+
+inline void WritePageId(char *data, size_t offset, page_id_t page_id) {
+  memcpy(data + offset, &page_id, sizeof(page_id));
+}
+
+}  // namespace
+
 /**
  * TODO: Student Implement
  */
 
 bool TableHeap::InsertTuple(Row &row, Txn *txn) {
+  if (!NeedsOverflow(row)) {
+    return InsertStoredTuple(row, txn);
+  }
+  Row stored_row;
+  if (!StoreOverflow(row, stored_row)) {
+    return false;
+  }
+  if (!InsertStoredTuple(stored_row, txn)) {
+    FreeOverflow(stored_row);
+    return false;
+  }
+  row.SetRowId(stored_row.GetRowId());
+  return true;
+}
+
+bool TableHeap::InsertStoredTuple(Row &row, Txn *txn) {
   /**
     * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
     * @param[in/out] row Tuple Row to insert, the rid of the inserted tuple is wrapped in object row
@@ -59,49 +96,189 @@ bool TableHeap::InsertTuple(Row &row, Txn *txn) {
       }
     }
     return found;*/
-  for (auto page_id = first_page_id_; page_id != INVALID_PAGE_ID; ) {
-
-    // fetch page from buffer pool by page_id
+  uint32_t serialized_size = row.GetSerializedSize(schema_);
+  if (serialized_size > TablePage::SIZE_MAX_ROW) {
+    return false;
+  }
+  uint32_t size = serialized_size + TablePage::SIZE_TUPLE;
+  LoadFreeSpaceMap();
+  while (true) {
+    // Appends find room in the last page, the map is searched only once it is full.
+    page_id_t last_page_id = free_space_map_.GetLastPage();
+    page_id_t page_id = free_space_map_.HasRoom(last_page_id, size) ? last_page_id : free_space_map_.FindPage(size);
+    if (page_id == INVALID_PAGE_ID) {
+      break;
+    }
     auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-
     if (page == nullptr)
       return false;
     page->WLatch();
-
-    auto next_page_id = page->GetNextPageId();
-    if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
-      page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(page_id, true);
+    bool inserted = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    uint32_t free_bytes = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, inserted);
+    // The map may be behind the page, either way the page is not tried again unless it has room.
+    free_space_map_.UpdatePage(page_id, free_bytes);
+    if (inserted) {
       return true;
-    } else {
-      page->WUnlatch();
     }
+  }
 
-    // If the page is full, then create a new page.
-    if (next_page_id == INVALID_PAGE_ID) {
-      page_id_t new_page_id;
-      auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id));
-      if (new_page == nullptr)
-        return false;
+  // No page has room, create a new page after the last one.
+  page_id_t page_id = free_space_map_.GetLastPage();
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr)
+    return false;
+  page->WLatch();
+  page_id_t next_page_id = page->GetNextPageId();
+  if (next_page_id != INVALID_PAGE_ID) {
+    // Pages were linked after the last page the map knows of, they are tried first.
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    AddToFreeSpaceMap(next_page_id);
+    return InsertStoredTuple(row, txn);
+  }
+  if (segment_->end_page_id_ == INVALID_PAGE_ID) {
+    // First page allocated since the table was opened, ask for the pages right after the last one.
+    segment_->next_page_id_ = segment_->end_page_id_ = page_id + 1;
+  }
+  page_id_t new_page_id;
+  auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, segment_.get()));
+  if (new_page == nullptr) {
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    return false;
+  }
+  new_page->WLatch();
+  new_page->Init(new_page_id, page_id, log_manager_, txn);
+  page->SetNextPageId(new_page_id);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  bool inserted = new_page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+  uint32_t free_bytes = new_page->GetFreeSpaceRemaining();
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  free_space_map_.AddPage(new_page_id, free_bytes);
+  return inserted;
+}
 
-      page->WLatch();
-      new_page->WLatch();
+size_t TableHeap::BulkInsert(std::vector<Row> &rows, Txn *txn) {
+  // Rows with long values are inserted as copies with the values in overflow pages, the row ids are copied back.
+  std::vector<Row> stored_rows;
+  auto free_stored_rows = [&](size_t begin) {
+    for (size_t i = begin; i < stored_rows.size(); i++) {
+      FreeOverflow(stored_rows[i]);
+    }
+  };
+  if (std::any_of(rows.begin(), rows.end(), [this](const Row &row) { return NeedsOverflow(row); })) {
+    stored_rows.resize(rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+      if (!StoreOverflow(rows[i], stored_rows[i])) {
+        stored_rows.resize(i);
+        free_stored_rows(0);
+        return 0;
+      }
+    }
+  }
+  auto &insert_rows = stored_rows.empty() ? rows : stored_rows;
+  for (auto &row : insert_rows) {
+    if (row.GetSerializedSize(schema_) > TablePage::SIZE_MAX_ROW) {
+      free_stored_rows(0);
+      return 0;
+    }
+  }
+  if (rows.empty()) {
+    return 0;
+  }
+  LoadFreeSpaceMap();
+  page_id_t page_id = free_space_map_.GetLastPage();
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    free_stored_rows(0);
+    return 0;
+  }
+  page->WLatch();
+  while (page->GetNextPageId() != INVALID_PAGE_ID) {
+    // Pages were linked after the last page the map knows of, the rows go after them.
+    page_id_t next_page_id = page->GetNextPageId();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    AddToFreeSpaceMap(next_page_id);
+    page_id = free_space_map_.GetLastPage();
+    page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      free_stored_rows(0);
+      return 0;
+    }
+    page->WLatch();
+  }
+  bool is_dirty = false;
+  size_t num_inserted = 0;
+  for (; num_inserted < insert_rows.size(); num_inserted++) {
+    auto &row = insert_rows[num_inserted];
+    if (page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+      is_dirty = true;
+      continue;
+    }
+    // The page is full, go on in a new page after it.
+    if (segment_->end_page_id_ == INVALID_PAGE_ID) {
+      segment_->next_page_id_ = segment_->end_page_id_ = page_id + 1;
+    }
+    page_id_t new_page_id;
+    auto new_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(new_page_id, segment_.get()));
+    if (new_page == nullptr) {
+      break;
+    }
+    new_page->WLatch();
+    new_page->Init(new_page_id, page_id, log_manager_, txn);
+    page->SetNextPageId(new_page_id);
+    uint32_t free_bytes = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, true);
+    free_space_map_.UpdatePage(page_id, free_bytes);
+    free_space_map_.AddPage(new_page_id, new_page->GetFreeSpaceRemaining());
+    page = new_page;
+    page_id = new_page_id;
+    is_dirty = page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_);
+    ASSERT(is_dirty, "A tuple that is not too large fits in an empty page.");
+  }
+  uint32_t free_bytes = page->GetFreeSpaceRemaining();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+  free_space_map_.UpdatePage(page_id, free_bytes);
+  if (!stored_rows.empty()) {
+    for (size_t i = 0; i < num_inserted; i++) {
+      rows[i].SetRowId(stored_rows[i].GetRowId());
+    }
+    free_stored_rows(num_inserted);
+  }
+  return num_inserted;
+}
 
-      new_page->Init(new_page->GetPageId(), page_id, log_manager_, txn);
-      new_page->SetPrevPageId(page_id);
-      page->SetNextPageId(new_page_id);
-      new_page->SetNextPageId(INVALID_PAGE_ID);
+void TableHeap::LoadFreeSpaceMap() {
+  if (free_space_map_.IsLoaded()) {
+    return;
+  }
+  free_space_map_.Load();
+  // The map has every page of the heap but the ones linked after its last write, all of them if there is no map yet.
+  page_id_t last_page_id = free_space_map_.GetLastPage();
+  AddToFreeSpaceMap(last_page_id == INVALID_PAGE_ID ? first_page_id_ : last_page_id);
+}
 
-      page->WUnlatch();
-      new_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(new_page_id, true);
-    } else {
-      buffer_pool_manager_->UnpinPage(page_id, false);
-      page_id = next_page_id;
+void TableHeap::AddToFreeSpaceMap(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      break;
     }
+    page->RLatch();
+    uint32_t free_bytes = page->GetFreeSpaceRemaining();
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    free_space_map_.AddPage(page_id, free_bytes);
+    page_id = next_page_id;
   }
-
-  return false;
 }
 
 RowId TableHeap::GetNextTupleID(Row *row, Txn *txn) {
@@ -160,7 +337,9 @@ bool TableHeap::MarkDelete(const RowId &rid, Txn *txn) {
   }
   // Otherwise, mark the tuple as deleted.
   page->WLatch();
-  page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+  if (page->MarkDelete(rid, txn, lock_manager_, log_manager_)) {
+    num_dead_rows_++;
+  }
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
   return true;
@@ -173,29 +352,56 @@ bool TableHeap::UpdateTuple(Row &row, const RowId &rid, Txn *txn) {
   // Step1: Find the page which contains the tuple.
   // Step2: Update the tuple in the page.
   // Step3: Unpin the page.
+  LoadFreeSpaceMap();
+  // The old tuple keeps its overflow pages until it is replaced, the new one gets its own.
+  bool has_overflow = NeedsOverflow(row);
+  Row stored_row;
+  if (has_overflow && !StoreOverflow(row, stored_row)) {
+    return false;
+  }
+  Row &new_row = has_overflow ? stored_row : row;
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
-  if (page == nullptr)
+  if (page == nullptr) {
+    FreeOverflow(stored_row);
     return false;
+  }
   page->WLatch();
   Row old_row(rid);
 
-  TablePage::UpdateStatus status = page->UpdateTuple(row, &old_row, schema_, txn, lock_manager_, log_manager_);
+  TablePage::UpdateStatus status = page->UpdateTuple(new_row, &old_row, schema_, txn, lock_manager_, log_manager_);
   if (status == TablePage::UpdateStatus::updateSuccess) {
+    uint32_t free_bytes = page->GetFreeSpaceRemaining();
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+    free_space_map_.UpdatePage(rid.GetPageId(), free_bytes);
+    FreeOverflow(old_row);
+    row.SetRowId(rid);
     return true;
   } else if (status == TablePage::UpdateStatus::notEnoughSpace) {
+    // The new tuple is stored elsewhere before the old one is deleted, the page stays pinned in between. A failed
+    // insert leaves the old tuple and its overflow pages as they were.
+    page->WUnlatch();
+    if (!InsertStoredTuple(new_row, txn)) {
+      buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+      FreeOverflow(stored_row);
+      return false;
+    }
+    row.SetRowId(new_row.GetRowId());
+    page->WLatch();
+    if (may_overflow_) {
+      page->GetTuple(&old_row, schema_, txn, lock_manager_);
+    }
     page->ApplyDelete(rid, txn, log_manager_);
+    uint32_t free_bytes = page->GetFreeSpaceRemaining();
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
-    if (InsertTuple(row, txn)) {
-      return true;
-    } else {
-      return true;
-    }
+    free_space_map_.UpdatePage(rid.GetPageId(), free_bytes);
+    FreeOverflow(old_row);
+    return true;
   } else {
     page->WUnlatch();
     buffer_pool_manager_->UnpinPage(rid.GetPageId(), false);
+    FreeOverflow(stored_row);
     return false;
   }
 }
@@ -209,15 +415,28 @@ void TableHeap::ApplyDelete(const RowId &rid, Txn *txn) {
   // Step3: Unpin the page.
 
   // find the page which contains the tuple
+  LoadFreeSpaceMap();
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   if (page == nullptr) {
     LOG(ERROR) << "Page not found" << "in TableHeap::ApplyDelete()" <<std::endl;
     return;
   }
   page->WLatch();
+  if (may_overflow_) {
+    // The tuple may be marked deleted already, it is found among all the tuples of the page.
+    page->ForEachTuple([&](const RowId &tuple_rid, char *data, bool) {
+      if (tuple_rid == rid) {
+        Row row(rid);
+        row.DeserializeFrom(data, schema_);
+        FreeOverflow(row);
+      }
+    });
+  }
   page->ApplyDelete(rid, txn, log_manager_);
+  uint32_t free_bytes = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(rid.GetPageId(), true);
+  free_space_map_.UpdatePage(rid.GetPageId(), free_bytes);
 }
 void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
   // Find the page which contains the tuple.
@@ -230,10 +449,12 @@ void TableHeap::RollbackDelete(const RowId &rid, Txn *txn) {
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
+bool TableHeap::GetTuple(Row *row, Txn *txn) { return ReadTuple(row, txn) && FetchOverflow(row); }
+
 /**
  * TODO: Student Implement
  */
-bool TableHeap::GetTuple(Row *row, Txn *txn) {
+bool TableHeap::ReadTuple(Row *row, Txn *txn) {
   // Step1: Find the page which contains the tuple.
   // Step2: Read the tuple from the page.
   // Step3: Unpin the page.
@@ -265,11 +486,13 @@ bool TableHeap::GetTuple(Row *row, Txn *txn) {
 void TableHeap::DeleteTable(page_id_t page_id) {
   if (page_id != INVALID_PAGE_ID) {
     auto temp_table_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));  // 删除table_heap
+    FreeOverflow(temp_table_page, false);
     if (temp_table_page->GetNextPageId() != INVALID_PAGE_ID) DeleteTable(temp_table_page->GetNextPageId());
     buffer_pool_manager_->UnpinPage(page_id, false);
     buffer_pool_manager_->DeletePage(page_id);
   } else {
     DeleteTable(first_page_id_);
+    free_space_map_.FreePages();
   }
 }
 
@@ -294,7 +517,7 @@ void TableHeap::DeleteTable(page_id_t page_id) {
 //   buffer_pool_manager_->UnpinPage(first_page_id_, false);
 //   return this->End();
 // }
-TableIterator TableHeap::Begin(Txn *txn) {
+TableIterator TableHeap::Begin(Txn *txn, bool fetch_overflow) {
   page_id_t page_id = first_page_id_;
   RowId result_rid;
   while(1)
@@ -309,18 +532,368 @@ TableIterator TableHeap::Begin(Txn *txn) {
       buffer_pool_manager_->UnpinPage(page_id, false);
       break;
     }
+    page_id_t next_page_id = page->GetNextPageId();
     buffer_pool_manager_->UnpinPage(page_id, false);
-    page_id = page->GetNextPageId();
+    page_id = next_page_id;
   }
   if(page_id != INVALID_PAGE_ID)
   {
-    Row* result_row = new Row(result_rid);
-    GetTuple(result_row, txn);
-    return TableIterator(this, *result_row, txn);
+    Row result_row(result_rid);
+    if (fetch_overflow) {
+      GetTuple(&result_row, txn);
+    } else {
+      ReadTuple(&result_row, txn);
+    }
+    return TableIterator(this, result_row, txn, fetch_overflow);
   }
   return End();
 }
 
+void TableHeap::RelocatePages(const std::unordered_map<page_id_t, page_id_t> &moved) {
+  first_page_id_ = BufferPoolManager::GetRelocatedPageId(moved, first_page_id_);
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      break;
+    }
+    page_id_t prev_page_id = BufferPoolManager::GetRelocatedPageId(moved, page->GetPrevPageId());
+    page_id_t next_page_id = BufferPoolManager::GetRelocatedPageId(moved, page->GetNextPageId());
+    bool is_dirty = page->GetTablePageId() != page_id || page->GetPrevPageId() != prev_page_id ||
+                    page->GetNextPageId() != next_page_id;
+    if (is_dirty) {
+      page->SetTablePageId(page_id);
+      page->SetPrevPageId(prev_page_id);
+      page->SetNextPageId(next_page_id);
+    }
+    if (may_overflow_) {
+      // The pointers to overflow pages are rewritten in place, a pointer has the same size whatever the page id.
+      page->ForEachTuple([&](const RowId &rid, char *data, bool) {
+        Row row(rid);
+        row.DeserializeFrom(data, schema_);
+        bool is_moved = false;
+        for (size_t i = 0; i < row.GetFieldCount(); i++) {
+          Field *field = row.GetField(i);
+          if (field->GetOverflowPageId() != INVALID_PAGE_ID) {
+            page_id_t overflow_page_id = RelocateOverflow(moved, field->GetOverflowPageId());
+            is_moved = is_moved || overflow_page_id != field->GetOverflowPageId();
+            field->SetOverflowPageId(overflow_page_id);
+          }
+        }
+        if (is_moved) {
+          row.SerializeTo(data, schema_);
+          is_dirty = true;
+        }
+      });
+    }
+    buffer_pool_manager_->UnpinPage(page_id, is_dirty);
+    page_id = next_page_id;
+  }
+  free_space_map_.RelocatePages(moved);
+}
+
+VacuumReport TableHeap::Vacuum(Txn *txn, std::vector<std::pair<RowId, Row>> &moved_rows) {
+  VacuumReport report;
+  page_id_t page_id = first_page_id_;
+  auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    return report;
+  }
+  page->WLatch();
+  report.num_freed_pages_ += FreeOverflow(page, true);
+  report.num_purged_rows_ += page->Compact(txn, log_manager_);
+  report.num_pages_before_ = report.num_pages_after_ = 1;
+  size_t num_live_rows = 0;
+  // The page rows are moved to stays latched, the next one is compacted, then either merged into it or kept.
+  while (page->GetNextPageId() != INVALID_PAGE_ID) {
+    page_id_t next_page_id = page->GetNextPageId();
+    auto next_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    if (next_page == nullptr) {
+      break;
+    }
+    next_page->WLatch();
+    report.num_freed_pages_ += FreeOverflow(next_page, true);
+    report.num_purged_rows_ += next_page->Compact(txn, log_manager_);
+    report.num_pages_before_++;
+    // Move the rows of the next page until one does not fit, the next page is kept then, or deleted once empty.
+    RowId rid;
+    bool found = next_page->GetFirstTupleRid(&rid);
+    for (; found; found = next_page->GetNextTupleRid(rid, &rid)) {
+      Row row(rid);
+      next_page->GetTuple(&row, schema_, txn, lock_manager_);
+      if (!page->InsertTuple(row, schema_, txn, lock_manager_, log_manager_)) {
+        break;
+      }
+      next_page->MarkDelete(rid, txn, lock_manager_, log_manager_);
+      moved_rows.emplace_back(rid, row);
+      report.num_moved_rows_++;
+    }
+    if (found) {
+      next_page->Compact(txn, log_manager_);
+      num_live_rows += CountRows(page);
+      page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(page_id, true);
+      page = next_page;
+      page_id = next_page_id;
+      report.num_pages_after_++;
+      continue;
+    }
+    page_id_t after_page_id = next_page->GetNextPageId();
+    page->SetNextPageId(after_page_id);
+    next_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(next_page_id, false);
+    report.num_freed_pages_ += buffer_pool_manager_->DeletePage(next_page_id);
+    if (after_page_id != INVALID_PAGE_ID) {
+      auto after_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(after_page_id));
+      if (after_page != nullptr) {
+        after_page->WLatch();
+        after_page->SetPrevPageId(page_id);
+        after_page->WUnlatch();
+        buffer_pool_manager_->UnpinPage(after_page_id, true);
+      }
+    }
+  }
+  num_live_rows += CountRows(page);
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, true);
+  num_dead_rows_ = 0;
+  num_live_rows_ = num_live_rows;
+  // The pages of the chain changed all along it, the map is built again rather than patched.
+  free_space_map_.FreePages();
+  free_space_map_.Unload();
+  free_space_map_.Load();
+  AddToFreeSpaceMap(first_page_id_);
+  return report;
+}
+
+size_t TableHeap::CountRows(TablePage *page) {
+  size_t num_rows = 0;
+  RowId rid;
+  for (bool found = page->GetFirstTupleRid(&rid); found; found = page->GetNextTupleRid(rid, &rid)) {
+    num_rows++;
+  }
+  return num_rows;
+}
+
+bool TableHeap::HasCharColumn(const Schema *schema) {
+  if (schema == nullptr) {
+    return false;
+  }
+  const auto &columns = schema->GetColumns();
+  return std::any_of(columns.begin(), columns.end(),
+                     [](const Column *column) { return column->GetType() == TypeId::kTypeChar; });
+}
+
+bool TableHeap::NeedsOverflow(const Row &row) const {
+  if (!may_overflow_) {
+    return false;
+  }
+  for (size_t i = 0; i < row.GetFieldCount(); i++) {
+    if (row.GetField(i)->GetOverflowPageId() != INVALID_PAGE_ID) {
+      return true;
+    }
+  }
+  return row.GetSerializedSize(schema_) > OVERFLOW_ROW_SIZE;
+}
+
+bool TableHeap::StoreOverflow(const Row &row, Row &stored_row) {
+  // Values read from the overflow pages of a tuple are copied, the pages stay with that tuple.
+  stored_row = row;
+  if (!FetchOverflow(&stored_row)) {
+    return false;
+  }
+  for (size_t i = 0; i < stored_row.GetFieldCount(); i++) {
+    stored_row.GetField(i)->SetOverflowPageId(INVALID_PAGE_ID);
+  }
+  uint32_t size = stored_row.GetSerializedSize(schema_);
+  while (size > OVERFLOW_ROW_SIZE) {
+    Field *longest = nullptr;
+    for (size_t i = 0; i < stored_row.GetFieldCount(); i++) {
+      Field *field = stored_row.GetField(i);
+      if (field->GetTypeId() == TypeId::kTypeChar && !field->IsNull() &&
+          field->GetOverflowPageId() == INVALID_PAGE_ID && field->GetLength() >= OVERFLOW_MIN_VALUE_SIZE &&
+          (longest == nullptr || field->GetLength() > longest->GetLength())) {
+        longest = field;
+      }
+    }
+    if (longest == nullptr) {
+      break;
+    }
+    page_id_t page_id = WriteOverflow(longest->GetData(), longest->GetLength());
+    if (page_id == INVALID_PAGE_ID) {
+      FreeOverflow(stored_row);
+      return false;
+    }
+    longest->SetOverflowPageId(page_id);
+    size -= longest->GetLength() + sizeof(uint32_t) - TypeChar::SIZE_OVERFLOW_POINTER;
+  }
+  return true;
+}
+
+bool TableHeap::FetchOverflow(Row *row) {
+  bool fetched = true;
+  for (size_t i = 0; i < row->GetFieldCount(); i++) {
+    fetched = FetchOverflowValue(row->GetField(i)) && fetched;
+  }
+  return fetched;
+}
+
+bool TableHeap::FetchOverflow(Row *row, const std::vector<uint32_t> &column_ids) {
+  bool fetched = true;
+  for (uint32_t column_id : column_ids) {
+    if (column_id < row->GetFieldCount()) {
+      fetched = FetchOverflowValue(row->GetField(column_id)) && fetched;
+    }
+  }
+  return fetched;
+}
+
+bool TableHeap::FetchOverflowValue(Field *field) {
+  if (!field->IsDeferred()) {
+    return true;
+  }
+  std::unique_ptr<char[]> data(new char[field->GetLength()]);
+  if (!ReadOverflow(field->GetOverflowPageId(), data.get(), field->GetLength())) {
+    LOG(ERROR) << "Failed to read the overflow pages from " << field->GetOverflowPageId() << std::endl;
+    return false;
+  }
+  Field value(TypeId::kTypeChar, data.get(), field->GetLength(), true);
+  value.SetOverflowPageId(field->GetOverflowPageId());
+  *field = value;
+  return true;
+}
+
+page_id_t TableHeap::WriteOverflow(const char *data, uint32_t size) {
+  page_id_t first_page_id = INVALID_PAGE_ID;
+  page_id_t prev_page_id = INVALID_PAGE_ID;
+  Page *prev_page = nullptr;
+  // A page is linked from the one before it once it is allocated, two pages at most are pinned at a time.
+  for (uint32_t offset = 0; offset < size;) {
+    page_id_t page_id;
+    Page *page = buffer_pool_manager_->NewPage(page_id, overflow_segment_.get());
+    if (page == nullptr) {
+      if (prev_page != nullptr) {
+        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      }
+      FreeOverflow(first_page_id);
+      return INVALID_PAGE_ID;
+    }
+    uint32_t page_size = std::min(size - offset, OVERFLOW_PAGE_CAPACITY);
+    char *page_data = page->GetData();
+    WritePageId(page_data, 0, page_id);
+    WritePageId(page_data, OFFSET_OVERFLOW_NEXT_PAGE_ID, INVALID_PAGE_ID);
+    memcpy(page_data + OFFSET_OVERFLOW_SIZE, &page_size, sizeof(page_size));
+    memcpy(page_data + OFFSET_OVERFLOW_DATA, data + offset, page_size);
+    offset += page_size;
+    if (prev_page == nullptr) {
+      first_page_id = page_id;
+    } else {
+      WritePageId(prev_page->GetData(), OFFSET_OVERFLOW_NEXT_PAGE_ID, page_id);
+      buffer_pool_manager_->UnpinPage(prev_page_id, true);
+    }
+    prev_page = page;
+    prev_page_id = page_id;
+  }
+  if (prev_page != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, true);
+  }
+  return first_page_id;
+}
+
+bool TableHeap::ReadOverflow(page_id_t page_id, char *data, uint32_t size) {
+  uint32_t offset = 0;
+  while (offset < size && page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      return false;
+    }
+    const char *page_data = page->GetData();
+    uint32_t page_size;
+    memcpy(&page_size, page_data + OFFSET_OVERFLOW_SIZE, sizeof(page_size));
+    page_size = std::min({page_size, OVERFLOW_PAGE_CAPACITY, size - offset});
+    memcpy(data + offset, page_data + OFFSET_OVERFLOW_DATA, page_size);
+    offset += page_size;
+    page_id_t next_page_id = ReadPageId(page_data, OFFSET_OVERFLOW_NEXT_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return offset == size;
+}
+
+size_t TableHeap::FreeOverflow(page_id_t page_id) {
+  size_t num_freed_pages = 0;
+  while (page_id != INVALID_PAGE_ID) {
+    Page *page = buffer_pool_manager_->FetchPage(page_id);
+    if (page == nullptr) {
+      break;
+    }
+    page_id_t next_page_id = ReadPageId(page->GetData(), OFFSET_OVERFLOW_NEXT_PAGE_ID);
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    num_freed_pages += buffer_pool_manager_->DeletePage(page_id);
+    page_id = next_page_id;
+  }
+  return num_freed_pages;
+}
+
+size_t TableHeap::FreeOverflow(const Row &row) {
+  size_t num_freed_pages = 0;
+  for (size_t i = 0; i < row.GetFieldCount(); i++) {
+    num_freed_pages += FreeOverflow(row.GetField(i)->GetOverflowPageId());
+  }
+  return num_freed_pages;
+}
+
+size_t TableHeap::FreeOverflow(TablePage *page, bool deleted_only) {
+  if (!may_overflow_) {
+    return 0;
+  }
+  size_t num_freed_pages = 0;
+  page->ForEachTuple([&](const RowId &rid, char *data, bool is_deleted) {
+    if (is_deleted || !deleted_only) {
+      Row row(rid);
+      row.DeserializeFrom(data, schema_);
+      num_freed_pages += FreeOverflow(row);
+    }
+  });
+  return num_freed_pages;
+}
+
+page_id_t TableHeap::RelocateOverflow(const std::unordered_map<page_id_t, page_id_t> &moved, page_id_t page_id) {
+  page_id_t first_page_id = BufferPoolManager::GetRelocatedPageId(moved, page_id);
+  for (page_id_t overflow_page_id = first_page_id; overflow_page_id != INVALID_PAGE_ID;) {
+    Page *page = buffer_pool_manager_->FetchPage(overflow_page_id);
+    if (page == nullptr) {
+      break;
+    }
+    char *data = page->GetData();
+    page_id_t next_page_id =
+        BufferPoolManager::GetRelocatedPageId(moved, ReadPageId(data, OFFSET_OVERFLOW_NEXT_PAGE_ID));
+    bool is_dirty = ReadPageId(data, 0) != overflow_page_id ||
+                    ReadPageId(data, OFFSET_OVERFLOW_NEXT_PAGE_ID) != next_page_id;
+    if (is_dirty) {
+      WritePageId(data, 0, overflow_page_id);
+      WritePageId(data, OFFSET_OVERFLOW_NEXT_PAGE_ID, next_page_id);
+    }
+    buffer_pool_manager_->UnpinPage(overflow_page_id, is_dirty);
+    overflow_page_id = next_page_id;
+  }
+  return first_page_id;
+}
+
+FragmentationReport TableHeap::GetFragmentation() {
+  FragmentationReport report;
+  for (page_id_t page_id = first_page_id_; page_id != INVALID_PAGE_ID;) {
+    auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      break;
+    }
+    report.AddPage(page_id);
+    page_id_t next_page_id = page->GetNextPageId();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    page_id = next_page_id;
+  }
+  return report;
+}
+
 /**
  * TODO: Student Implement
  */
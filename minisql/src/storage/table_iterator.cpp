@@ -6,13 +6,17 @@
 /**
  * TODO: Student Implement
  */
-TableIterator::TableIterator(TableHeap *table_heap, Row row, Txn *txn_)
-  : heap(table_heap), row(row), txn_(txn_) {}
+TableIterator::TableIterator(TableHeap *table_heap, Row row, Txn *txn_, bool fetch_overflow)
+  : heap(table_heap), row(row), txn_(txn_), fetch_overflow_(fetch_overflow) {}
 
 TableIterator::TableIterator(const TableIterator &other) {
   heap = other.heap;
   row = other.row;
   txn_ = other.txn_;
+  pages_visited_ = other.pages_visited_;
+  prefetch_remaining_ = other.prefetch_remaining_;
+  fetch_overflow_ = other.fetch_overflow_;
+  strategy_ = other.strategy_;
 }
 
 TableIterator::TableIterator() {
@@ -45,6 +49,10 @@ TableIterator &TableIterator::operator=(const TableIterator &itr) noexcept {
   heap = itr.heap;
   row = itr.row;
   txn_ = itr.txn_;
+  pages_visited_ = itr.pages_visited_;
+  prefetch_remaining_ = itr.prefetch_remaining_;
+  fetch_overflow_ = itr.fetch_overflow_;
+  strategy_ = itr.strategy_;
   return *this;
 }
 
@@ -54,7 +62,7 @@ TableIterator &TableIterator::operator++() {
     return *this;
   }
   RowId next_rid;
-  auto page = reinterpret_cast<TablePage *>(heap->buffer_pool_manager_->FetchPage(row.GetRowId().GetPageId()));
+  auto page = FetchPage(row.GetRowId().GetPageId());
   page->RLatch();
   if (page->GetNextTupleRid(row.GetRowId(), &next_rid)) {
     row.destroy();
@@ -62,6 +70,9 @@ TableIterator &TableIterator::operator++() {
     page->GetTuple(&row, heap->schema_, txn_, heap->lock_manager_);
     page->RUnlatch();
     heap->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    if (fetch_overflow_) {
+      heap->FetchOverflow(&row);
+    }
     return *this;
   }
   else {
@@ -70,16 +81,22 @@ TableIterator &TableIterator::operator++() {
     while (next_page_id != INVALID_PAGE_ID) {
       page->RUnlatch();
       heap->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
-      page = reinterpret_cast<TablePage *>(heap->buffer_pool_manager_->FetchPage(next_page_id));
+      page = FetchPage(next_page_id);
+      pages_visited_++;
       page->RLatch();
+      ReadAhead(page);
       if (page->GetFirstTupleRid(&next_rid)) {
         row.destroy();
         row.SetRowId(next_rid);
         page->GetTuple(&row, heap->schema_, txn_, heap->lock_manager_);
         page->RUnlatch();
         heap->buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+        if (fetch_overflow_) {
+          heap->FetchOverflow(&row);
+        }
         return *this;
       }
+      next_page_id = page->GetNextPageId();
     }
   }
   page->RUnlatch();
@@ -95,3 +112,28 @@ TableIterator TableIterator::operator++(int) {
   ++(*this);
   return TableIterator(old);
 }
+
+TablePage *TableIterator::FetchPage(page_id_t page_id) {
+  auto bpm = heap->buffer_pool_manager_;
+  if (strategy_ == nullptr && pages_visited_ > bpm->GetPoolSize() / BufferPoolManager::BULK_READ_THRESHOLD_RATIO) {
+    strategy_ = bpm->GetBulkReadStrategy();
+  }
+  if (strategy_ != nullptr) {
+    return reinterpret_cast<TablePage *>(bpm->FetchPage(page_id, strategy_.get()));
+  }
+  return reinterpret_cast<TablePage *>(bpm->FetchPage(page_id));
+}
+
+void TableIterator::ReadAhead(TablePage *page) {
+  auto bpm = heap->buffer_pool_manager_;
+  size_t depth = bpm->GetPrefetchDepth();
+  if (prefetch_remaining_ > 0) {
+    prefetch_remaining_--;
+  }
+  if (depth == 0 || prefetch_remaining_ > depth / 2 || page->GetNextPageId() == INVALID_PAGE_ID) {
+    return;
+  }
+  bpm->PrefetchChain(page->GetNextPageId(), depth,
+                     [](const char *page_data) { return TablePage::GetNextPageId(page_data); });
+  prefetch_remaining_ = depth;
+}
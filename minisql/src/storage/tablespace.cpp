@@ -0,0 +1,43 @@
+#include "storage/tablespace.h"
+
+#include <stdexcept>
+
+#include "storage/compressed_page_store.h"
+
+Tablespace::Tablespace(std::string file_name, BufferPoolManager *main_bpm, bool init)
+    : file_name_(std::move(file_name)) {
+  DiskManager *main_disk_mgr = main_bpm->GetDiskManager();
+  if (init) {
+    Remove(file_name_);
+  }
+  disk_mgr_ = std::make_unique<DiskManager>(file_name_, main_disk_mgr->GetBackend(), main_disk_mgr->IsDirectIO(),
+                                            main_disk_mgr->GetPageStore() != nullptr);
+  bpm_ = std::make_unique<BufferPoolManager>(main_bpm->GetSharedPool(), disk_mgr_.get());
+  if (init) {
+    page_id_t page_id;
+    for (page_id_t reserved_page_id : {CATALOG_META_PAGE_ID, INDEX_ROOTS_PAGE_ID}) {
+      if (bpm_->NewPage(page_id) == nullptr || page_id != reserved_page_id) {
+        throw std::runtime_error("Failed to allocate the reserved pages of " + file_name_);
+      }
+      bpm_->UnpinPage(page_id, true);
+    }
+  }
+}
+
+Tablespace::~Tablespace() {
+  bpm_.reset();
+  disk_mgr_.reset();
+  if (dropped_) {
+    Remove(file_name_);
+  }
+}
+
+void Tablespace::Drop() {
+  bpm_->Discard();
+  dropped_ = true;
+}
+
+void Tablespace::Remove(const std::string &file_name) {
+  remove(file_name.c_str());
+  CompressedPageStore::Remove(file_name);
+}
@@ -1,10 +1,21 @@
 #include "buffer/buffer_pool_manager.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "gtest/gtest.h"
+#include "page/table_page.h"
 
 TEST(BufferPoolManagerTest, BinaryDataTest) {
   const std::string db_name = "bpm_test.db";
@@ -71,4 +82,619 @@ TEST(BufferPoolManagerTest, BinaryDataTest) {
 
   delete bpm;
   delete disk_manager;
-}
\ No newline at end of file
+}
+
+/**
+ * Fetch and unpin random pages of page_ids from num_threads threads at once, checking every fetched page.
+ * @return the number of operations per second
+ */
+static double FetchUnpinConcurrently(BufferPoolManager *bpm, const std::vector<page_id_t> &page_ids,
+                                     size_t num_threads, int ops_per_thread) {
+  std::vector<std::thread> threads;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t]() {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<size_t> dist(0, page_ids.size() - 1);
+      for (int i = 0; i < ops_per_thread; i++) {
+        page_id_t page_id = page_ids[dist(rng)];
+        Page *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        ASSERT_EQ(page_id, page->GetPageId());
+        ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return num_threads * ops_per_thread / elapsed.count();
+}
+
+TEST(BufferPoolManagerTest, ConcurrentFetchUnpinTest) {
+  const std::string db_name = "bpm_concurrent_test.db";
+  const int num_pages = 256;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  // More pages than frames, so that the threads also evict pages of each other.
+  auto *bpm = new BufferPoolManager(64, disk_manager, 4);
+  std::vector<page_id_t> page_ids(num_pages);
+  for (int i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_ids[i]));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+  FetchUnpinConcurrently(bpm, page_ids, 4, 5000);
+  ASSERT_TRUE(bpm->CheckAllUnpinned());
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, DISABLED_ConcurrentFetchUnpinBenchmark) {
+  const std::string db_name = "bpm_bench_test.db";
+  const size_t buffer_pool_size = DEFAULT_BUFFER_POOL_SIZE;
+  const int num_pages = 2048;
+  const int ops_per_thread = 200000;
+  const size_t max_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  // Compare a single latched pool against the default hash-partitioned layout.
+  for (size_t num_instances : {static_cast<size_t>(1), static_cast<size_t>(0)}) {
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, num_instances);
+    std::vector<page_id_t> page_ids(num_pages);
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(page_ids[i]));
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+    }
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+      double ops = FetchUnpinConcurrently(bpm, page_ids, num_threads, ops_per_thread);
+      printf("instances: %zu, threads: %zu, %.0f ops/s\n", bpm->GetNumInstances(), num_threads, ops);
+    }
+    ASSERT_TRUE(bpm->CheckAllUnpinned());
+    for (auto page_id : page_ids) {
+      ASSERT_TRUE(bpm->DeletePage(page_id));
+    }
+    delete bpm;
+  }
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, BulkReadRingTest) {
+  const std::string db_name = "bpm_ring_test.db";
+  const size_t buffer_pool_size = 64;
+  const int hot_pages = 16;
+  const int table_pages = 512;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1, ReplacerType::LRU);
+  page_id_t page_id;
+  std::vector<page_id_t> table_page_ids;
+  for (int i = 0; i < table_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    snprintf(bpm->FetchPage(page_id)->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    table_page_ids.push_back(page_id);
+  }
+  std::vector<page_id_t> hot_page_ids;
+  for (int i = 0; i < hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    hot_page_ids.push_back(page_id);
+  }
+
+  // Scenario: a scan through a ring keeps the hot pages resident and still sees every page.
+  auto strategy = bpm->GetBulkReadStrategy();
+  for (auto table_page_id : table_page_ids) {
+    Page *page = bpm->FetchPage(table_page_id, strategy.get());
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(table_page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(table_page_id, false));
+  }
+  // The tail of the table may still be resident from when it was written.
+  EXPECT_GE(strategy->GetNumRingReads(), table_pages - buffer_pool_size);
+  for (auto hot_page_id : hot_page_ids) {
+    EXPECT_TRUE(bpm->CheckPageResident(hot_page_id));
+  }
+
+  // Scenario: the same scan through the shared pool evicts them.
+  for (auto table_page_id : table_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(table_page_id));
+    ASSERT_TRUE(bpm->UnpinPage(table_page_id, false));
+  }
+  for (auto hot_page_id : hot_page_ids) {
+    EXPECT_FALSE(bpm->CheckPageResident(hot_page_id));
+  }
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, PrefetchChainTest) {
+  const std::string db_name = "bpm_prefetch_test.db";
+  const size_t buffer_pool_size = 64;
+  const int chain_length = 32;
+  const size_t depth = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> chain(chain_length);
+  for (int i = 0; i < chain_length; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(chain[i]));
+  }
+  for (int i = 0; i < chain_length; i++) {
+    auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(chain[i]));
+    page->SetNextPageId(i + 1 < chain_length ? chain[i + 1] : INVALID_PAGE_ID);
+    ASSERT_TRUE(bpm->UnpinPage(chain[i], true));
+    ASSERT_TRUE(bpm->UnpinPage(chain[i], true));
+  }
+  // Start over with a cold pool, the old one writes the chain back on destruction.
+  delete bpm;
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+
+  // Scenario: the prefetcher follows the chain in the background, up to the requested depth.
+  bpm->PrefetchChain(chain[0], depth, [](const char *page_data) { return TablePage::GetNextPageId(page_data); });
+  for (int retry = 0; retry < 1000 && !bpm->CheckPageResident(chain[depth - 1]); retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  for (int i = 0; i < chain_length; i++) {
+    EXPECT_EQ(i < static_cast<int>(depth), bpm->CheckPageResident(chain[i]));
+  }
+
+  // Scenario: fetching the prefetched pages counts them as used, the rest of the chain is read synchronously.
+  for (int i = 0; i < chain_length; i++) {
+    auto page = reinterpret_cast<TablePage *>(bpm->FetchPage(chain[i]));
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i + 1 < chain_length ? chain[i + 1] : INVALID_PAGE_ID, page->GetNextPageId());
+    ASSERT_TRUE(bpm->UnpinPage(chain[i], false));
+  }
+  EXPECT_EQ(depth, bpm->GetNumPrefetchUsed());
+  EXPECT_EQ(0, bpm->GetNumPrefetchWasted());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, BackgroundWriterTest) {
+  const std::string db_name = "bpm_writer_test.db";
+  const size_t buffer_pool_size = 64;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: with every frame dirty, the writer cleans its target share of the pool in the background.
+  const size_t clean_target = buffer_pool_size / SharedBufferPool::BG_WRITER_CLEAN_RATIO;
+  for (int retry = 0; retry < 100 && bpm->GetNumBackgroundWrites() < clean_target; retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(SharedBufferPool::BG_WRITER_INTERVAL_MS / 4));
+  }
+  EXPECT_EQ(clean_target, bpm->GetNumBackgroundWrites());
+  EXPECT_GT(bpm->GetBackgroundWriterThroughput(), 0);
+
+  // Scenario: the flush on shutdown writes the rest, a fresh pool reads every page back.
+  delete bpm;
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  for (auto page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetNumDirtyEvictions());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, StatsTest) {
+  const std::string db_name = "bpm_stats_test.db";
+  const size_t buffer_pool_size = 16;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids(2 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  const auto &stats = bpm->GetInstanceStats(0);
+  EXPECT_EQ(page_ids.size(), stats.new_pages_);
+  EXPECT_EQ(buffer_pool_size, stats.evictions_);
+  EXPECT_EQ(0, stats.pinned_frames_);
+
+  // Scenario: the last buffer_pool_size pages are resident, the first ones have to be read back.
+  for (auto page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(page_ids.size(), stats.fetches_);
+  EXPECT_EQ(stats.fetches_, stats.hits_ + stats.misses_);
+  EXPECT_GE(stats.misses_, buffer_pool_size);
+  EXPECT_EQ(stats.misses_ / BufferPoolStats::READ_LATENCY_SAMPLE_RATE, stats.read_latency_.GetTotal());
+
+  // Scenario: pinning a page twice counts one pinned frame.
+  const size_t num_pinned = buffer_pool_size / 2;
+  for (size_t i = 0; i < num_pinned; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+  }
+  EXPECT_EQ(num_pinned, stats.pinned_frames_);
+
+  // Scenario: a reset zeroes the counters but keeps the pinned frame gauge.
+  bpm->ResetStats();
+  EXPECT_EQ(0, stats.fetches_);
+  EXPECT_EQ(0, stats.hits_);
+  EXPECT_EQ(0, stats.misses_);
+  EXPECT_EQ(0, stats.evictions_);
+  EXPECT_EQ(0, stats.new_pages_);
+  EXPECT_EQ(0, stats.read_latency_.GetTotal());
+  EXPECT_EQ(num_pinned, stats.pinned_frames_);
+
+  for (size_t i = 0; i < num_pinned; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(0, stats.pinned_frames_);
+  ASSERT_TRUE(bpm->DeletePage(page_ids.back()));
+  EXPECT_EQ(1, stats.deleted_pages_);
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, WarmUpTest) {
+  const std::string db_name = "bpm_warmup_test.db";
+  const std::string warmup_file_name = "bpm_warmup_test.warmup";
+  const size_t buffer_pool_size = 32;
+
+  remove(db_name.c_str());
+  remove(warmup_file_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  std::vector<page_id_t> page_ids(4 * buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // The hot set is touched last, after a scan over every page.
+  std::vector<page_id_t> hot_pages;
+  for (size_t i = 0; i < page_ids.size(); i += 8) {
+    hot_pages.push_back(page_ids[i]);
+  }
+  for (auto page_id : hot_pages) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  ASSERT_TRUE(bpm->SaveResidentPages(warmup_file_name));
+  delete bpm;
+
+  // Scenario: a fresh pool loads the pages resident at shutdown in the background and consumes the file.
+  bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+  bpm->StartWarmUp(warmup_file_name);
+  Page *page = bpm->FetchPage(page_ids.back());
+  ASSERT_NE(nullptr, page);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids.back(), false));
+  for (int retry = 0; retry < 100 && bpm->IsWarmingUp(); retry++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_FALSE(bpm->IsWarmingUp());
+  EXPECT_GT(bpm->GetNumWarmedUpPages(), 0);
+  EXPECT_EQ(0, bpm->GetNumEvictions());
+  EXPECT_TRUE(bpm->CheckAllUnpinned());
+  for (auto page_id : hot_pages) {
+    EXPECT_TRUE(bpm->CheckPageResident(page_id));
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  std::ifstream warmup_file(warmup_file_name);
+  EXPECT_FALSE(warmup_file.is_open());
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  remove(warmup_file_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, ResizeTest) {
+  const std::string db_name = "bpm_resize_test.db";
+  const size_t buffer_pool_size = 32;
+
+  remove(db_name.c_str());
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager, 1);
+  std::vector<page_id_t> page_ids(buffer_pool_size);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+  }
+
+  // Scenario: growing adds free frames, pinned pages stay where they are.
+  Page *pinned_page = bpm->FetchPage(page_ids.back());
+  ASSERT_TRUE(bpm->Resize(2 * buffer_pool_size));
+  EXPECT_EQ(2 * buffer_pool_size, bpm->GetPoolSize());
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "page %d", page_id);
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(0, bpm->GetNumEvictions());
+  for (auto page_id : page_ids) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ("page " + std::to_string(page_ids[buffer_pool_size - 1]), std::string(pinned_page->GetData()));
+
+  // Scenario: shrinking waits for the page still pinned in a retired frame instead of failing.
+  std::atomic<bool> resized{false};
+  std::thread resizer([&] {
+    EXPECT_TRUE(bpm->Resize(buffer_pool_size / 2));
+    resized = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(resized);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[buffer_pool_size - 1], false));
+  resizer.join();
+  EXPECT_TRUE(resized);
+  EXPECT_EQ(buffer_pool_size / 2, bpm->GetPoolSize());
+
+  // Scenario: the evicted pages were written back, only the remaining frames can be pinned.
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    Page *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_ids[i]), std::string(page->GetData()));
+  }
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids.back()));
+  for (size_t i = 0; i < buffer_pool_size / 2; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  for (auto page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_FALSE(bpm->Resize(0));
+
+  delete bpm;
+  disk_manager->Close();
+  remove(db_name.c_str());
+  delete disk_manager;
+}
+
+TEST(BufferPoolManagerTest, SharedPoolTest) {
+  const std::string db_name_a = "bpm_shared_a_test.db";
+  const std::string db_name_b = "bpm_shared_b_test.db";
+  const size_t buffer_pool_size = 16;
+  const size_t num_pages = buffer_pool_size / 2;
+
+  remove(db_name_a.c_str());
+  remove(db_name_b.c_str());
+  auto *pool = new SharedBufferPool(buffer_pool_size, 1);
+  auto *disk_manager_a = new DiskManager(db_name_a);
+  auto *disk_manager_b = new DiskManager(db_name_b);
+  auto *bpm_a = new BufferPoolManager(pool, disk_manager_a);
+  auto *bpm_b = new BufferPoolManager(pool, disk_manager_b);
+  EXPECT_NE(bpm_a->GetFileId(), bpm_b->GetFileId());
+  auto fill = [](BufferPoolManager *bpm, const std::string &prefix, size_t count, std::vector<page_id_t> *page_ids) {
+    for (size_t i = 0; i < count; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%s %d", prefix.c_str(), page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids->push_back(page_id);
+    }
+  };
+  auto check = [](BufferPoolManager *bpm, const std::string &prefix, const std::vector<page_id_t> &page_ids) {
+    for (auto page_id : page_ids) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(prefix + " " + std::to_string(page_id), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  };
+
+  // Scenario: both databases use the same page ids, the pool keeps them apart. The first one may use at most a
+  // quarter of the pool, so it replaces its own pages while the other one takes the free frames.
+  bpm_a->SetShare(0, buffer_pool_size / 4);
+  std::vector<page_id_t> page_ids_a;
+  std::vector<page_id_t> page_ids_b;
+  fill(bpm_a, "a", num_pages, &page_ids_a);
+  fill(bpm_b, "b", num_pages, &page_ids_b);
+  EXPECT_EQ(page_ids_a, page_ids_b);
+  EXPECT_EQ(buffer_pool_size / 4, bpm_a->GetNumResidentPages());
+  EXPECT_EQ(num_pages, bpm_b->GetNumResidentPages());
+  check(bpm_a, "a", page_ids_a);
+  check(bpm_b, "b", page_ids_b);
+  EXPECT_EQ(buffer_pool_size / 4, bpm_a->GetNumResidentPages());
+
+  // Scenario: the pages of a database within its minimum share survive the other database filling the pool.
+  bpm_b->SetShare(num_pages, 0);
+  bpm_a->SetShare(0, 0);
+  fill(bpm_a, "a", buffer_pool_size, &page_ids_a);
+  for (auto page_id : page_ids_b) {
+    EXPECT_TRUE(bpm_b->CheckPageResident(page_id));
+  }
+  EXPECT_EQ(buffer_pool_size - num_pages, bpm_a->GetNumResidentPages());
+
+  // Scenario: detaching a database writes back and drops only its own pages.
+  delete bpm_a;
+  EXPECT_EQ(num_pages, bpm_b->GetNumResidentPages());
+  bpm_a = new BufferPoolManager(pool, disk_manager_a);
+  EXPECT_EQ(0, bpm_a->GetNumResidentPages());
+  check(bpm_a, "a", page_ids_a);
+  check(bpm_b, "b", page_ids_b);
+  EXPECT_TRUE(pool->CheckAllUnpinned());
+
+  delete bpm_a;
+  delete bpm_b;
+  delete pool;
+  disk_manager_a->Close();
+  disk_manager_b->Close();
+  remove(db_name_a.c_str());
+  remove(db_name_b.c_str());
+  delete disk_manager_a;
+  delete disk_manager_b;
+}
+
+// Resident set of the process in KiB.
+static size_t GetRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmRSS:", 0) == 0) {
+      return std::stoul(line.substr(6));
+    }
+  }
+  return 0;
+}
+
+// Pages of a file held by the kernel page cache.
+static size_t GetCachedPages(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  struct stat st;
+  fstat(fd, &st);
+  size_t num_pages = (st.st_size + sysconf(_SC_PAGESIZE) - 1) / sysconf(_SC_PAGESIZE);
+  void *addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  std::vector<unsigned char> resident(num_pages);
+  mincore(addr, st.st_size, resident.data());
+  munmap(addr, st.st_size);
+  close(fd);
+  size_t res = 0;
+  for (auto page : resident) {
+    res += page & 1;
+  }
+  return res;
+}
+
+// Write a file of num_pages allocated pages, each holding "page <id>".
+static void WriteTaggedFile(const std::string &db_name, page_id_t num_pages) {
+  remove(db_name.c_str());
+  DiskManager disk_manager(db_name);
+  std::vector<char> data(num_pages * PAGE_SIZE);
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(i, disk_manager.AllocatePage());
+    snprintf(data.data() + i * PAGE_SIZE, PAGE_SIZE, "page %d", i);
+    pages.emplace_back(i, data.data() + i * PAGE_SIZE);
+  }
+  disk_manager.WritePages(pages);
+}
+
+TEST(BufferPoolManagerTest, DirectIOTest) {
+  const std::string db_name = "bpm_direct_io_test.db";
+  const page_id_t num_pages = 1024;
+  WriteTaggedFile(db_name, num_pages);
+
+  // Scenario: random reads and writes through a pool a quarter of the file, every page goes through O_DIRECT.
+  {
+    DiskManager disk_manager(db_name, DiskIOBackend::PREAD, true);
+    ASSERT_TRUE(disk_manager.IsDirectIO());
+    BufferPoolManager bpm(num_pages / 4, &disk_manager);
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+    for (int i = 0; i < 4000; i++) {
+      page_id_t page_id = dist(rng);
+      Page *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % DIRECT_IO_ALIGNMENT);
+      std::string data(page->GetData());
+      ASSERT_TRUE(data == "page " + std::to_string(page_id) || data == "new page " + std::to_string(page_id));
+      if (i % 2 == 0) {
+        snprintf(page->GetData(), PAGE_SIZE, "new page %d", page_id);
+      }
+      bpm.UnpinPage(page_id, i % 2 == 0);
+    }
+  }
+
+  // Every page written back reads the same through the buffered path.
+  DiskManager disk_manager(db_name);
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+  std::vector<bool> written(num_pages, false);
+  for (int i = 0; i < 4000; i++) {
+    page_id_t page_id = dist(rng);
+    written[page_id] = written[page_id] || i % 2 == 0;
+  }
+  char buf[PAGE_SIZE];
+  for (page_id_t i = 0; i < num_pages; i++) {
+    disk_manager.ReadPage(i, buf);
+    ASSERT_EQ((written[i] ? "new page " : "page ") + std::to_string(i), std::string(buf));
+  }
+  disk_manager.Close();
+  remove(db_name.c_str());
+}
+
+TEST(BufferPoolManagerTest, DISABLED_DirectIOBenchmark) {
+  const std::string db_name = "bpm_direct_io_bench_test.db";
+  const page_id_t num_pages = 16384;
+  const size_t buffer_pool_size = 4096;
+  const int num_fetches = 50000;
+  WriteTaggedFile(db_name, num_pages);
+
+  // Scenario: random reads over a file four times the pool, starting from a cold page cache. Buffered reads leave a
+  // second copy of every page read in the page cache, direct reads only fill the pool.
+  for (bool direct_io : {false, true}) {
+    int fd = open(db_name.c_str(), O_RDONLY);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+    size_t rss_before = GetRssKb();
+    auto *disk_manager = new DiskManager(db_name, DiskIOBackend::PREAD, direct_io);
+    ASSERT_EQ(direct_io, disk_manager->IsDirectIO());
+    auto *bpm = new BufferPoolManager(buffer_pool_size, disk_manager);
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_fetches; i++) {
+      page_id_t page_id = dist(rng);
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ("page " + std::to_string(page_id), page->GetData());
+      ASSERT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % DIRECT_IO_ALIGNMENT);
+      bpm->UnpinPage(page_id, false);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    size_t rss_kb = GetRssKb() - rss_before;
+    size_t cached_kb = GetCachedPages(db_name) * sysconf(_SC_PAGESIZE) / 1024;
+    printf("%s: %.0f fetches/s, RSS +%zu KiB, page cache %zu KiB\n", direct_io ? "direct" : "buffered",
+           num_fetches / elapsed.count(), rss_kb, cached_kb);
+    if (direct_io) {
+      EXPECT_LT(cached_kb, buffer_pool_size * PAGE_SIZE / 1024);
+    }
+    delete bpm;
+    delete disk_manager;
+  }
+  remove(db_name.c_str());
+}
@@ -0,0 +1,117 @@
+#include "buffer/lru_k_replacer.h"
+
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "gtest/gtest.h"
+
+TEST(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Scenario: frames 1-6 are accessed once, frame 1 is accessed a second time.
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.RecordAccess(i);
+  }
+  lru_k_replacer.RecordAccess(1);
+  for (frame_id_t i = 1; i <= 6; i++) {
+    lru_k_replacer.Unpin(i);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Scenario: frames with a single access have an infinite k-distance and go first, in access order.
+  int value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(4, value);
+  EXPECT_EQ(3, lru_k_replacer.Size());
+
+  // Scenario: pinned frames are not victimized, pinning a victimized frame has no effect.
+  lru_k_replacer.Pin(3);
+  lru_k_replacer.Pin(5);
+  EXPECT_EQ(2, lru_k_replacer.Size());
+
+  // Scenario: frame 5 gets its second access, its k-distance is now smaller than the one of frame 1.
+  lru_k_replacer.RecordAccess(5);
+  lru_k_replacer.Unpin(5);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(6, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(5, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+/**
+ * Replays a page access trace against a pool of pool_size frames managed by the given replacer and returns the hit
+ * rate. Every access pins the page and unpins it right away, the same way a point lookup or a scan step does.
+ */
+static double SimulateHitRate(Replacer *replacer, size_t pool_size, const std::vector<page_id_t> &trace) {
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frames(pool_size, INVALID_PAGE_ID);
+  size_t next_free = 0;
+  size_t hits = 0;
+  for (auto page_id : trace) {
+    frame_id_t frame_id;
+    auto iter = page_table.find(page_id);
+    if (iter != page_table.end()) {
+      hits++;
+      frame_id = iter->second;
+    } else {
+      if (next_free < pool_size) {
+        frame_id = static_cast<frame_id_t>(next_free++);
+      } else {
+        EXPECT_TRUE(replacer->Victim(&frame_id));
+        page_table.erase(frames[frame_id]);
+      }
+      frames[frame_id] = page_id;
+      page_table[page_id] = frame_id;
+    }
+    replacer->RecordAccess(frame_id);
+    replacer->Pin(frame_id);
+    replacer->Unpin(frame_id);
+  }
+  return static_cast<double>(hits) / trace.size();
+}
+
+TEST(LRUKReplacerTest, ScanResistanceTest) {
+  const size_t pool_size = 256;
+  const page_id_t hot_pages = 128;
+  const page_id_t table_pages = 4096;
+
+  // Point lookups on a hot set that fits in the pool, interleaved with full scans of a table four times larger than
+  // the whole pool.
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> hot_dist(0, hot_pages - 1);
+  std::vector<page_id_t> trace;
+  for (int round = 0; round < 4; round++) {
+    for (page_id_t i = 0; i < table_pages; i++) {
+      trace.push_back(hot_pages + i);
+      for (int j = 0; j < 2; j++) {
+        trace.push_back(hot_dist(rng));
+      }
+    }
+  }
+
+  LRUReplacer lru_replacer(pool_size);
+  CLOCKReplacer clock_replacer(pool_size);
+  LRUKReplacer lru_k_replacer(pool_size);
+  double lru_hit_rate = SimulateHitRate(&lru_replacer, pool_size, trace);
+  double clock_hit_rate = SimulateHitRate(&clock_replacer, pool_size, trace);
+  double lru_k_hit_rate = SimulateHitRate(&lru_k_replacer, pool_size, trace);
+  printf("hit rate: LRU %.3f, CLOCK %.3f, LRU-%zu %.3f\n", lru_hit_rate, clock_hit_rate, LRUK_REPLACER_K,
+         lru_k_hit_rate);
+
+  // Scanned pages are only touched once, so LRU-K keeps the whole hot set resident.
+  EXPECT_GT(lru_k_hit_rate, lru_hit_rate);
+  EXPECT_GT(lru_k_hit_rate, clock_hit_rate);
+  EXPECT_GT(lru_k_hit_rate, 0.6);
+}
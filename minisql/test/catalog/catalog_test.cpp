@@ -1,5 +1,8 @@
 #include "catalog/catalog.h"
 
+#include <filesystem>
+#include <thread>
+
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "utils/utils.h"
@@ -126,4 +129,263 @@ TEST(CatalogTest, CatalogIndexTest) {
     ASSERT_EQ(rid.Get(), ret_02[i].Get());
   }
   delete db_02;
-}
\ No newline at end of file
+}
+/** Check every row of a table with ids 0 to num_rows - 1, through a scan and through its index on id. */
+static void CheckVacuumedTable(CatalogManager *catalog, int num_rows) {
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->GetTable("kept", table_info));
+  int64_t rows = 0, id_sum = 0;
+  for (auto iter = table_info->GetTableHeap()->Begin(nullptr); iter != table_info->GetTableHeap()->End(); ++iter) {
+    rows++;
+    id_sum += std::stoi(iter->GetField(0)->toString());
+  }
+  ASSERT_EQ(num_rows, rows);
+  ASSERT_EQ(static_cast<int64_t>(num_rows) * (num_rows - 1) / 2, id_sum);
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->GetIndex("kept", "kept_id", index_info));
+  for (int i = 0; i < num_rows; i += 97) {
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+    Row key(key_fields);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+    ASSERT_EQ(1, result.size());
+    Row row(result[0]);
+    ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, nullptr));
+    ASSERT_EQ(std::to_string(i), row.GetField(0)->toString());
+  }
+}
+
+TEST(CatalogTest, VacuumFileTest) {
+  const std::string db_name = "catalog_vacuum_test.db";
+  const int num_rows = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  {
+    DBStorageEngine db(db_name, true);
+    auto catalog = db.catalog_mgr_;
+    // Scenario: a large table created first and dropped, leaving the pages of the table kept at the end of the file.
+    TableInfo *old_table = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("old", schema.get(), nullptr, old_table));
+    for (int i = 0; i < num_rows * 4; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(old_table->GetTableHeap()->InsertTuple(row, nullptr));
+    }
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("kept", schema.get(), nullptr, table_info));
+    IndexInfo *index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("kept", "kept_id", {"id"}, nullptr, index_info, "bptree"));
+    for (int i = 0; i < num_rows; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), nullptr));
+    }
+    db.bpm_->FlushAllPages();
+    uint64_t file_size, disk_usage;
+    db.disk_mgr_->GetFileUsage(&file_size, &disk_usage);
+    ASSERT_EQ(DB_SUCCESS, catalog->DropTable("old"));
+
+    // The pages of the dropped table are punched out of the file at the next sync.
+    db.bpm_->FlushAllPages();
+    uint64_t punched_file_size, punched_disk_usage;
+    db.disk_mgr_->GetFileUsage(&punched_file_size, &punched_disk_usage);
+    EXPECT_EQ(file_size, punched_file_size);
+    if (db.disk_mgr_->GetNumPunchedBytes() > 0) {
+      EXPECT_LT(punched_disk_usage, disk_usage);
+    }
+
+    size_t num_moved_pages;
+    uint64_t truncated_bytes;
+    ASSERT_EQ(DB_SUCCESS, catalog->VacuumFile(num_moved_pages, truncated_bytes));
+    uint64_t vacuumed_file_size, vacuumed_disk_usage;
+    db.disk_mgr_->GetFileUsage(&vacuumed_file_size, &vacuumed_disk_usage);
+    std::cout << "moved " << num_moved_pages << " pages, file " << file_size << " -> " << vacuumed_file_size
+              << " bytes" << std::endl;
+    ASSERT_GT(num_moved_pages, 0);
+    ASSERT_GT(truncated_bytes, 0);
+    ASSERT_EQ(punched_file_size - truncated_bytes, vacuumed_file_size);
+    CheckVacuumedTable(catalog, num_rows);
+  }
+
+  // Everything refers to the new page ids after a restart as well.
+  DBStorageEngine db(db_name, false);
+  CheckVacuumedTable(db.catalog_mgr_, num_rows);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(db.disk_mgr_->GetMetaData());
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(meta_page->GetAllocatedPages()); page_id++) {
+    ASSERT_FALSE(db.disk_mgr_->IsPageFree(page_id));
+  }
+}
+
+TEST(CatalogTest, VacuumTableTest) {
+  const std::string db_name = "catalog_vacuum_table_test.db";
+  const int num_rows = 6000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  auto check_table = [&](CatalogManager *catalog) {
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->GetTable("t", table_info));
+    IndexInfo *index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->GetIndex("t", "t_id", index_info));
+    for (int i = 0; i < num_rows; i++) {
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      std::vector<RowId> result;
+      if (i % 4 != 0) {
+        ASSERT_EQ(DB_KEY_NOT_FOUND, index_info->GetIndex()->ScanKey(key, result, nullptr));
+        continue;
+      }
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+      Row row(result[0]);
+      ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, nullptr));
+      ASSERT_EQ(std::to_string(i), row.GetField(0)->toString());
+    }
+  };
+  {
+    DBStorageEngine db(db_name, true);
+    auto catalog = db.catalog_mgr_;
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("t", schema.get(), nullptr, table_info));
+    IndexInfo *index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("t", "t_id", {"id"}, nullptr, index_info, "bptree"));
+    TableHeap *table_heap = table_info->GetTableHeap();
+    std::vector<RowId> rids;
+    for (int i = 0; i < num_rows; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), nullptr));
+      rids.push_back(row.GetRowId());
+    }
+    // Deletes as the delete executor does them: the row is marked, its key removed.
+    for (int i = 0; i < num_rows; i++) {
+      if (i % 4 != 0) {
+        ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+        std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+        Row key(key_fields);
+        ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->RemoveEntry(key, rids[i], nullptr));
+      }
+    }
+    VacuumReport report;
+    ASSERT_EQ(DB_TABLE_NOT_EXIST, catalog->VacuumTable("missing", report));
+    ASSERT_EQ(DB_SUCCESS, catalog->VacuumTable("t", report));
+    ASSERT_EQ(num_rows - num_rows / 4, report.num_purged_rows_);
+    ASSERT_GT(report.num_moved_rows_, 0);
+    ASSERT_LT(report.num_pages_after_ * 2, report.num_pages_before_);
+    ASSERT_EQ(table_heap->GetFreeSpaceMapPageId(), table_info->GetFreeSpaceMapPageId());
+    check_table(catalog);
+  }
+
+  // The moved index entries and the new free space map survive a restart.
+  DBStorageEngine db(db_name, false);
+  check_table(db.catalog_mgr_);
+}
+
+TEST(CatalogTest, FilePerTableTest) {
+  const std::string db_name = "catalog_file_per_table_test.db";
+  const std::string tablespace_dir = DBStorageEngine::GetTablespaceDirectory(db_name);
+  const int num_rows = 5000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  auto fill_table = [&](TableInfo *table_info, IndexInfo *index_info) {
+    char name[64];
+    memset(name, 'x', sizeof(name));
+    for (int i = 0; i < num_rows; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), nullptr));
+    }
+  };
+  auto check_table = [&](CatalogManager *catalog, const std::string &table_name) {
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->GetTable(table_name, table_info));
+    IndexInfo *index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, catalog->GetIndex(table_name, table_name + "_id", index_info));
+    int rows = 0;
+    for (auto iter = table_info->GetTableHeap()->Begin(nullptr); iter != table_info->GetTableHeap()->End(); ++iter) {
+      rows++;
+    }
+    ASSERT_EQ(num_rows, rows);
+    for (int i = 0; i < num_rows; i += 97) {
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      std::vector<RowId> result;
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+      ASSERT_EQ(1, result.size());
+      Row row(result[0]);
+      ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, nullptr));
+      ASSERT_EQ(std::to_string(i), row.GetField(0)->toString());
+    }
+  };
+
+  {
+    DBStorageEngine db(db_name, true, DEFAULT_BUFFER_POOL_SIZE, nullptr, false, false, false, true);
+    ASSERT_TRUE(db.IsFilePerTable());
+    auto catalog = db.catalog_mgr_;
+    // Scenario: two tables, each with an index, filled concurrently, every one of them in a file of its own.
+    TableInfo *tables[2] = {nullptr, nullptr};
+    IndexInfo *indexes[2] = {nullptr, nullptr};
+    for (int t = 0; t < 2; t++) {
+      std::string table_name = "table" + std::to_string(t);
+      ASSERT_EQ(DB_SUCCESS, catalog->CreateTable(table_name, schema.get(), nullptr, tables[t]));
+      ASSERT_EQ(DB_SUCCESS,
+                catalog->CreateIndex(table_name, table_name + "_id", {"id"}, nullptr, indexes[t], "bptree"));
+      ASSERT_NE(nullptr, tables[t]->GetTablespace());
+      ASSERT_NE(nullptr, indexes[t]->GetTablespace());
+    }
+    std::thread writer([&] { fill_table(tables[1], indexes[1]); });
+    fill_table(tables[0], indexes[0]);
+    writer.join();
+    ASSERT_NE(tables[0]->GetTablespace()->GetBufferPoolManager()->GetFileId(), db.bpm_->GetFileId());
+    ASSERT_NE(tables[0]->GetTablespace()->GetBufferPoolManager()->GetFileId(),
+              tables[1]->GetTablespace()->GetBufferPoolManager()->GetFileId());
+  }
+
+  // Only the catalog is left in the database file, the tables and indexes come back from their own files.
+  uint64_t table_file_size = std::filesystem::file_size(tablespace_dir + "/table_1");
+  ASSERT_LT(std::filesystem::file_size("./databases/" + db_name), table_file_size);
+  {
+    DBStorageEngine db(db_name, false);
+    ASSERT_TRUE(db.IsFilePerTable());
+    check_table(db.catalog_mgr_, "table0");
+    check_table(db.catalog_mgr_, "table1");
+
+    // Dropping a table or an index deletes its file.
+    ASSERT_TRUE(std::filesystem::exists(tablespace_dir + "/index_2"));
+    ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->DropIndex("table1", "table1_id"));
+    ASSERT_FALSE(std::filesystem::exists(tablespace_dir + "/index_2"));
+    ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->DropTable("table1"));
+    ASSERT_FALSE(std::filesystem::exists(tablespace_dir + "/table_2"));
+    ASSERT_TRUE(std::filesystem::exists(tablespace_dir + "/table_1"));
+
+    size_t num_moved_pages;
+    uint64_t truncated_bytes;
+    ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->VacuumFile(num_moved_pages, truncated_bytes));
+    check_table(db.catalog_mgr_, "table0");
+  }
+  {
+    DBStorageEngine db(db_name, false);
+    check_table(db.catalog_mgr_, "table0");
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_TABLE_NOT_EXIST, db.catalog_mgr_->GetTable("table1", table_info));
+  }
+
+  // A new database with the same name starts with no tablespaces.
+  DBStorageEngine db(db_name, true);
+  ASSERT_FALSE(db.IsFilePerTable());
+  ASSERT_FALSE(std::filesystem::exists(tablespace_dir));
+}
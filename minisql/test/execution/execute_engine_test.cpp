@@ -0,0 +1,115 @@
+#include "executor/execute_engine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+/**
+ * Run a statement that takes a database name, e.g. use or create database.
+ */
+static dberr_t ExecuteOnDatabase(ExecuteEngine *engine, SyntaxNodeType type, const std::string &db_name) {
+  MinisqlParserInit();
+  pSyntaxNode ast = CreateSyntaxNode(type, nullptr);
+  SyntaxNodeAddChildren(ast, CreateSyntaxNode(kNodeIdentifier, const_cast<char *>(db_name.c_str())));
+  dberr_t res = engine->Execute(ast);
+  MinisqlParserFinish();
+  return res;
+}
+
+TEST(ExecuteEngineTest, LazyOpenTest) {
+  const std::vector<std::string> db_names{"lazy_open_test_0", "lazy_open_test_1", "lazy_open_test_2"};
+  {
+    ExecuteEngine engine;
+    for (const auto &db_name : db_names) {
+      ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeCreateDB, db_name));
+    }
+  }
+
+  // Scenario: databases are registered at startup but only opened by their first use.
+  ExecuteEngine engine(std::chrono::milliseconds(200));
+  EXPECT_EQ(0, engine.GetNumOpenDatabases());
+  ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeUseDB, db_names[0]));
+  EXPECT_EQ(1, engine.GetNumOpenDatabases());
+  ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeUseDB, db_names[1]));
+  EXPECT_EQ(2, engine.GetNumOpenDatabases());
+  EXPECT_EQ(DB_NOT_EXIST, ExecuteOnDatabase(&engine, kNodeUseDB, "lazy_open_test_missing"));
+
+  // Scenario: an idle database is closed by the next statement, the current one stays open.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeUseDB, db_names[2]));
+  EXPECT_EQ(2, engine.GetNumOpenDatabases());
+  ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeUseDB, db_names[0]));
+  EXPECT_EQ(3, engine.GetNumOpenDatabases());
+
+  for (const auto &db_name : db_names) {
+    ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeDropDB, db_name));
+  }
+  EXPECT_EQ(0, engine.GetNumOpenDatabases());
+}
+
+TEST(ExecuteEngineTest, ReadOnlyTest) {
+  const std::string db_name = "read_only_test";
+  {
+    ExecuteEngine engine;
+    ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeCreateDB, db_name));
+  }
+
+  // Scenario: a reporting copy opened read only reads the database in place and refuses every modification.
+  {
+    ExecuteEngine engine(std::chrono::seconds(DEFAULT_DB_IDLE_TIMEOUT), true);
+    ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeUseDB, db_name));
+    EXPECT_EQ(DB_READ_ONLY, ExecuteOnDatabase(&engine, kNodeCreateTable, "t"));
+    EXPECT_EQ(DB_READ_ONLY, ExecuteOnDatabase(&engine, kNodeDropIndex, "idx"));
+    EXPECT_EQ(DB_READ_ONLY, ExecuteOnDatabase(&engine, kNodeDropDB, db_name));
+    EXPECT_EQ(DB_READ_ONLY, ExecuteOnDatabase(&engine, kNodeCreateDB, "read_only_test_new"));
+  }
+
+  ExecuteEngine engine;
+  ASSERT_EQ(DB_SUCCESS, ExecuteOnDatabase(&engine, kNodeDropDB, db_name));
+}
+
+TEST(ExecuteEngineTest, DISABLED_StartupBenchmark) {
+  for (size_t num_databases : {100, 1000}) {
+    std::vector<std::string> db_names;
+    {
+      SharedBufferPool pool(DEFAULT_BUFFER_POOL_SIZE);
+      for (size_t i = 0; i < num_databases; i++) {
+        db_names.push_back("startup_bench_" + std::to_string(i));
+        delete new DBStorageEngine(db_names.back(), true, DEFAULT_BUFFER_POOL_SIZE, &pool);
+      }
+    }
+
+    // What the engine used to do before the first prompt: open every database and load its catalog.
+    auto start = std::chrono::steady_clock::now();
+    {
+      SharedBufferPool pool(DEFAULT_BUFFER_POOL_SIZE);
+      std::vector<DBStorageEngine *> dbs;
+      for (const auto &db_name : db_names) {
+        dbs.push_back(new DBStorageEngine(db_name, false, DEFAULT_BUFFER_POOL_SIZE, &pool));
+      }
+      for (auto db : dbs) {
+        delete db;
+      }
+    }
+    double eager_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    {
+      ExecuteEngine engine;
+      EXPECT_EQ(0, engine.GetNumOpenDatabases());
+    }
+    double lazy_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << num_databases << " databases: eager open " << eager_ms << " ms, lazy startup " << lazy_ms << " ms"
+              << std::endl;
+
+    for (const auto &db_name : db_names) {
+      remove(("./databases/" + db_name).c_str());
+      remove(DBStorageEngine::GetWarmUpFileName(db_name).c_str());
+    }
+  }
+}
@@ -2,12 +2,17 @@
 // Created by njz on 2023/1/26.
 //
 #include "executor/plans/delete_plan.h"
+#include "executor/plans/index_scan_plan.h"
 #include "executor/plans/insert_plan.h"
 #include "executor/plans/seq_scan_plan.h"
 #include "executor/plans/update_plan.h"
 #include "executor/plans/values_plan.h"
 #include "executor_test_util.h"  // NOLINT
 
+#include <chrono>
+
+#include "executor/executors/insert_executor.h"
+
 // SELECT id FROM table-1 WHERE id < 500
 TEST_F(ExecutorTest, SimpleSeqScanTest) {
   // Construct query plan
@@ -155,3 +160,213 @@ TEST_F(ExecutorTest, SimpleUpdateTest) {
     ASSERT_TRUE(row.GetField(1)->CompareEquals(Field(kTypeChar, const_cast<char *>("minisql"), 7, false)));
   }
 }
+
+// UPDATE documents SET doc = <a longer document> WHERE id = i: the rows no longer fit their page, the index follows
+// them. The rows are found by the index, a sequential scan would find a moved row again and update it twice.
+TEST_F(ExecutorTest, UpdateMovedRowTest) {
+  auto catalog = GetExecutorContext()->GetCatalog();
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("doc", TypeId::kTypeChar, 1024, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("documents", schema.get(), GetTxn(), table_info));
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex("documents", "documents-id", index_keys, GetTxn(), index_info, "bptree"));
+  const int row_nums = 100;
+  std::string short_doc(8, 'a');
+  std::vector<RowId> old_rids;
+  for (int i = 0; i < row_nums; i++) {
+    Fields fields{Field(kTypeInt, i), Field(kTypeChar, short_doc.data(), short_doc.size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+    old_rids.push_back(row.GetRowId());
+    Row key_row;
+    row.GetKeyFromRow(table_info->GetSchema(), index_info->GetIndexKeySchema(), key_row);
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key_row, row.GetRowId(), GetTxn()));
+  }
+
+  const Schema *table_schema = table_info->GetSchema();
+  auto col_id = MakeColumnValueExpression(*table_schema, 0, "id");
+  std::string long_doc(1000, 'b');
+  std::unordered_map<uint32_t, AbstractExpressionRef> update_attrs{};
+  update_attrs.emplace(1, MakeConstantValueExpression(Field(kTypeChar, long_doc.data(), long_doc.size(), true)));
+  std::vector<Row> result_set{};
+  for (int i = 0; i < row_nums; i++) {
+    auto predicate = MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, i)), "=");
+    auto scan_plan = make_shared<IndexScanPlanNode>(table_schema, "documents", std::vector<IndexInfo *>{index_info},
+                                                    false, predicate);
+    auto update_plan = std::make_shared<UpdatePlanNode>(table_schema, scan_plan, "documents", update_attrs);
+    GetExecutionEngine()->ExecutePlan(update_plan, &result_set, GetTxn(), GetExecutorContext());
+  }
+
+  size_t num_moved = 0;
+  for (int i = 0; i < row_nums; i++) {
+    Fields key_fields{Field(kTypeInt, i)};
+    Row key(key_fields);
+    std::vector<RowId> rids;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+    ASSERT_EQ(1, rids.size());
+    Row row(rids[0]);
+    ASSERT_TRUE(table_info->GetTableHeap()->GetTuple(&row, nullptr));
+    ASSERT_TRUE(row.GetField(0)->CompareEquals(Field(kTypeInt, i)));
+    ASSERT_EQ(long_doc, row.GetField(1)->toString());
+    num_moved += rids[0] != old_rids[i];
+  }
+  ASSERT_GT(num_moved, 0);
+}
+
+// INSERT INTO table-1 VALUES (1001, "aaa", 2.33), (1002, "bbb", 2.33), (1003, "ccc", 2.33);
+TEST_F(ExecutorTest, MultiRowInsertTest) {
+  TableInfo *table_info;
+  GetExecutorContext()->GetCatalog()->GetTable("table-1", table_info);
+  IndexInfo *index_info = nullptr;
+  std::vector<std::string> index_keys{"id"};
+  ASSERT_EQ(DB_SUCCESS, GetExecutorContext()->GetCatalog()->CreateIndex("table-1", "index-1", index_keys, GetTxn(),
+                                                                        index_info, "bptree"));
+  auto make_values = [this](const std::vector<int> &ids) {
+    std::vector<std::vector<AbstractExpressionRef>> raw_values;
+    for (int id : ids) {
+      raw_values.push_back({MakeConstantValueExpression(Field(kTypeInt, id)),
+                            MakeConstantValueExpression(Field(kTypeChar, const_cast<char *>("aaa"), 3, false)),
+                            MakeConstantValueExpression(Field(kTypeFloat, static_cast<float>(2.33)))});
+    }
+    return std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+  };
+
+  // The rows are inserted in one batch, in the order of the statement.
+  std::vector<Row> result_set{};
+  auto insert_plan = std::make_shared<InsertPlanNode>(nullptr, make_values({1003, 1001, 1002}), "table-1");
+  GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(3, result_set.size());
+  result_set.clear();
+  std::vector<Row> rows;
+  for (auto iter = table_info->GetTableHeap()->Begin(GetTxn()); iter != table_info->GetTableHeap()->End(); ++iter) {
+    rows.push_back(*iter);
+  }
+  ASSERT_EQ(1003, rows.size());
+  ASSERT_TRUE(rows[1000].GetField(0)->CompareEquals(Field(kTypeInt, 1003)));
+  ASSERT_TRUE(rows[1001].GetField(0)->CompareEquals(Field(kTypeInt, 1001)));
+  ASSERT_TRUE(rows[1002].GetField(0)->CompareEquals(Field(kTypeInt, 1002)));
+  for (int id : {1001, 1002, 1003}) {
+    std::vector<RowId> rids;
+    Fields key_fields{Field(kTypeInt, id)};
+    Row key(key_fields);
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+    ASSERT_EQ(1, rids.size());
+  }
+
+  // A key already in the index, or twice in the batch, and nothing is inserted.
+  for (const auto &batch : {std::vector<int>{1004, 1001}, std::vector<int>{1004, 1005, 1004}}) {
+    insert_plan = std::make_shared<InsertPlanNode>(nullptr, make_values(batch), "table-1");
+    GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_TRUE(result_set.empty());
+    std::vector<RowId> rids;
+    Fields key_fields{Field(kTypeInt, 1004)};
+    Row key(key_fields);
+    ASSERT_EQ(DB_KEY_NOT_FOUND, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+  }
+}
+
+TEST_F(ExecutorTest, OverflowSeqScanTest) {
+  auto catalog = GetExecutorContext()->GetCatalog();
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("doc", TypeId::kTypeChar, 2 * PAGE_SIZE, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, catalog->CreateTable("documents", schema.get(), GetTxn(), table_info));
+  const int row_nums = 100;
+  std::vector<std::string> docs;
+  for (int i = 0; i < row_nums; i++) {
+    docs.emplace_back(PAGE_SIZE + i, static_cast<char>('a' + i % 26));
+    Fields fields{Field(kTypeInt, i), Field(kTypeChar, docs[i].data(), docs[i].size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+  }
+  const Schema *table_schema = table_info->GetSchema();
+  auto col_id = MakeColumnValueExpression(*table_schema, 0, "id");
+  auto col_doc = MakeColumnValueExpression(*table_schema, 0, "doc");
+
+  // SELECT id FROM documents WHERE id < 50: the documents are never read.
+  auto predicate = MakeComparisonExpression(col_id, MakeConstantValueExpression(Field(kTypeInt, 50)), "<");
+  auto plan = make_shared<SeqScanPlanNode>(MakeOutputSchema({{"id", col_id}}), "documents", predicate);
+  std::vector<Row> result_set{};
+  GetExecutionEngine()->ExecutePlan(plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(50, result_set.size());
+
+  // SELECT id, doc FROM documents WHERE doc = <the document of row 7>: the predicate reads them, the output too.
+  Field doc_7(kTypeChar, docs[7].data(), docs[7].size(), true);
+  predicate = MakeComparisonExpression(col_doc, MakeConstantValueExpression(doc_7), "=");
+  plan = make_shared<SeqScanPlanNode>(MakeOutputSchema({{"id", col_id}, {"doc", col_doc}}), "documents", predicate);
+  result_set.clear();
+  GetExecutionEngine()->ExecutePlan(plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(1, result_set.size());
+  ASSERT_TRUE(result_set[0].GetField(0)->CompareEquals(Field(kTypeInt, 7)));
+  ASSERT_FALSE(result_set[0].GetField(1)->IsDeferred());
+  ASSERT_EQ(docs[7], result_set[0].GetField(1)->toString());
+}
+
+TEST_F(ExecutorTest, DISABLED_BulkInsertBenchmark) {
+  const int row_nums = 1000000;
+  auto catalog = GetExecutorContext()->GetCatalog();
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::vector<std::string> index_keys{"id"};
+  char name[32];
+  // Scenario: the same rows loaded one INSERT per row, then by one batch in random key order, into an indexed table and
+  // into a table without index.
+  for (bool indexed : {true, false}) {
+    double seconds[2];
+    for (bool bulk : {false, true}) {
+      std::string table_name = std::string(bulk ? "bulk" : "per-row") + (indexed ? "-indexed" : "");
+      TableInfo *table_info = nullptr;
+      IndexInfo *index_info = nullptr;
+      std::vector<IndexInfo *> indexes;
+      ASSERT_EQ(DB_SUCCESS, catalog->CreateTable(table_name, schema.get(), GetTxn(), table_info));
+      if (indexed) {
+        ASSERT_EQ(DB_SUCCESS, catalog->CreateIndex(table_name, table_name + "-id", index_keys, GetTxn(), index_info,
+                                                   "bptree"));
+        indexes.push_back(index_info);
+      }
+      std::vector<Row> rows;
+      for (int i = 0; i < row_nums; i++) {
+        int id = static_cast<int>((i * 7919LL) % row_nums);
+        snprintf(name, sizeof(name), "name %d", id);
+        Fields fields{Field(kTypeInt, id), Field(kTypeChar, name, strlen(name), true)};
+        rows.emplace_back(fields);
+      }
+      auto start = std::chrono::steady_clock::now();
+      if (bulk) {
+        ASSERT_EQ(DB_SUCCESS, InsertExecutor::InsertRows(GetExecutorContext(), table_info, indexes, rows));
+      } else {
+        for (auto &row : rows) {
+          std::vector<std::vector<AbstractExpressionRef>> raw_values{
+              {MakeConstantValueExpression(*row.GetField(0)), MakeConstantValueExpression(*row.GetField(1))}};
+          auto value_plan = std::make_shared<ValuesPlanNode>(nullptr, raw_values);
+          auto insert_plan = std::make_shared<InsertPlanNode>(nullptr, value_plan, table_name);
+          std::vector<Row> result_set{};
+          GetExecutionEngine()->ExecutePlan(insert_plan, &result_set, GetTxn(), GetExecutorContext());
+          ASSERT_EQ(1, result_set.size());
+        }
+      }
+      seconds[bulk] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      std::cout << table_name << ": " << static_cast<size_t>(row_nums / seconds[bulk]) << " rows/s" << std::endl;
+      int64_t count = 0;
+      for (auto iter = table_info->GetTableHeap()->Begin(GetTxn()); iter != table_info->GetTableHeap()->End();
+           ++iter) {
+        count++;
+      }
+      ASSERT_EQ(row_nums, count);
+      for (int id = 0; indexed && id < row_nums; id += 997) {
+        std::vector<RowId> rids;
+        Fields key_fields{Field(kTypeInt, id)};
+        Row key(key_fields);
+        ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, rids, GetTxn()));
+        ASSERT_EQ(1, rids.size());
+      }
+    }
+    std::cout << (indexed ? "indexed" : "no index") << " speedup " << seconds[0] / seconds[1] << std::endl;
+    ASSERT_LT(seconds[1], seconds[0]);
+  }
+}
@@ -1,10 +1,15 @@
 #include "index/b_plus_tree_index.h"
 
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
 #include <string>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
 #include "index/generic_key.h"
+#include "storage/table_heap.h"
 
 static const std::string db_name = "bp_tree_index_test.db";
 
@@ -78,4 +83,107 @@ TEST(BPlusTreeTests, BPlusTreeIndexSimpleTest) {
   delete index;
   delete bpm_;
   delete disk_mgr_;
-}
\ No newline at end of file
+}
+
+/**
+ * A table with an index on its id, loaded in random id order, then queried by point lookups and range scans of
+ * range_size rows from a fresh pool.
+ */
+static void IndexedTableWorkload(int row_nums, int num_lookups, int num_range_scans, int range_size) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  TableSchema table_schema(columns);
+  std::vector<uint32_t> index_key_map{0};
+  std::unique_ptr<IndexSchema> index_schema(Schema::ShallowCopySchema(&table_schema, index_key_map));
+  const size_t key_size = 16;
+  std::vector<int> ids(row_nums);
+  for (int i = 0; i < row_nums; i++) {
+    ids[i] = i;
+  }
+  std::mt19937 rng(42);
+  std::shuffle(ids.begin(), ids.end(), rng);
+  remove(db_name.c_str());
+
+  page_id_t first_page_id;
+  double insert_seconds;
+  {
+    DiskManager disk_mgr(db_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    page_id_t id;
+    ASSERT_NE(nullptr, bpm.NewPage(id));
+    ASSERT_EQ(CATALOG_META_PAGE_ID, id);
+    ASSERT_NE(nullptr, bpm.NewPage(id));
+    ASSERT_EQ(INDEX_ROOTS_PAGE_ID, id);
+    bpm.UnpinPage(CATALOG_META_PAGE_ID, false);
+    bpm.UnpinPage(INDEX_ROOTS_PAGE_ID, false);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, &table_schema, nullptr, nullptr, nullptr));
+    BPlusTreeIndex index(0, index_schema.get(), key_size, &bpm);
+    char name[32];
+    auto start = std::chrono::steady_clock::now();
+    for (int i : ids) {
+      snprintf(name, sizeof(name), "name %d", i);
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true),
+                                Field(TypeId::kTypeFloat, static_cast<float>(i))};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      ASSERT_EQ(DB_SUCCESS, index.InsertEntry(key, row.GetRowId(), nullptr));
+    }
+    bpm.FlushAllPages();
+    insert_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    first_page_id = table_heap->GetFirstPageId();
+  }
+
+  DiskManager disk_mgr(db_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, first_page_id, &table_schema, nullptr, nullptr));
+  BPlusTreeIndex index(0, index_schema.get(), key_size, &bpm);
+  std::uniform_int_distribution<int> random_id(0, row_nums - 1);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_lookups; i++) {
+    int id = random_id(rng);
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, id)};
+    Row key(key_fields);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index.ScanKey(key, result, nullptr));
+    ASSERT_EQ(1, result.size());
+    Row row(result[0]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(CmpBool::kTrue, row.GetField(0)->CompareEquals(key_fields[0]));
+  }
+  double lookup_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  KeyManager key_manager(index_schema.get(), key_size);
+  GenericKey *range_key = key_manager.InitKey();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < num_range_scans; i++) {
+    int low = random_id(rng) % (row_nums - range_size);
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, low)};
+    Row key(key_fields);
+    key_manager.SerializeFromKey(range_key, key, index_schema.get());
+    auto iter = index.GetBeginIterator(range_key);
+    for (int j = 0; j < range_size; j++, ++iter) {
+      ASSERT_NE(index.GetEndIterator(), iter);
+      Row row((*iter).second);
+      ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+      ASSERT_EQ(std::to_string(low + j), row.GetField(0)->toString());
+    }
+  }
+  double range_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  free(range_key);
+
+  std::cout << "page size " << PAGE_SIZE << ": insert " << static_cast<size_t>(row_nums / insert_seconds)
+            << " rows/s, point lookup " << static_cast<size_t>(num_lookups / lookup_seconds)
+            << " lookups/s, range scan " << static_cast<size_t>(num_range_scans * range_size / range_seconds)
+            << " rows/s, " << index.GetFragmentation().GetNumPages() << " leaf pages, "
+            << table_heap->GetFragmentation().GetNumPages() << " table pages" << std::endl;
+  remove(db_name.c_str());
+}
+
+TEST(BPlusTreeTests, IndexedTableWorkloadTest) { IndexedTableWorkload(5000, 2000, 20, 500); }
+
+// Run by page_size_bench.sh once per MINISQL_PAGE_SIZE to compare page sizes.
+TEST(BPlusTreeTests, DISABLED_PageSizeBenchmark) { IndexedTableWorkload(50000, 20000, 200, 500); }
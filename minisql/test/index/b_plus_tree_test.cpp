@@ -151,3 +151,50 @@ TEST(BPlusTreeTests, SearchNonExistentKeysTest) {
     EXPECT_FALSE(tree.GetValue(key, result)) << "Key " << key_val << " should not be found.";
   }
 }
+
+TEST(BPlusTreeTests, InsertSortedTest) {
+  DBStorageEngine engine(db_name);
+  std::vector<Column *> columns = {
+      new Column("int", TypeId::kTypeInt, 0, false, false),
+  };
+  Schema *table_schema = new Schema(columns);
+  KeyManager KP(table_schema, 17);
+  BPlusTree tree(0, engine.bpm_, KP);
+  const int n = 6000;
+  vector<GenericKey *> keys;
+  vector<RowId> values;
+  for (int i = 0; i < n; i++) {
+    GenericKey *key = KP.InitKey();
+    std::vector<Field> fields{Field(TypeId::kTypeInt, i)};
+    KP.SerializeFromKey(key, Row(fields), table_schema);
+    keys.push_back(key);
+    values.push_back(RowId(i));
+  }
+  // A third of the keys is in the tree already, in several leaves.
+  vector<GenericKey *> existing;
+  for (int i = 0; i < n; i += 3) {
+    existing.push_back(keys[i]);
+  }
+  ShuffleArray(existing);
+  for (auto key : existing) {
+    ASSERT_TRUE(tree.Insert(key, RowId(-1)));
+  }
+  // The other keys go between them, the ones already there are skipped.
+  ASSERT_EQ(n - existing.size(), tree.InsertSorted(keys, values));
+  ASSERT_TRUE(tree.Check());
+  for (int i = 0; i < n; i++) {
+    vector<RowId> ans;
+    ASSERT_TRUE(tree.GetValue(keys[i], ans));
+    ASSERT_EQ(i % 3 == 0 ? RowId(-1) : values[i], ans[0]);
+  }
+  int count = 0;
+  for (auto iter = tree.Begin(); iter != tree.End(); ++iter) {
+    ASSERT_EQ(0, KP.CompareKeys((*iter).first, keys[count]));
+    count++;
+  }
+  ASSERT_EQ(n, count);
+  ASSERT_TRUE(tree.Check());
+  for (auto key : keys) {
+    free(key);
+  }
+}
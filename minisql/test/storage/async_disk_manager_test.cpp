@@ -0,0 +1,152 @@
+#include "storage/async_disk_manager.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+static const char *EngineName(AsyncIOEngine engine) {
+  return engine == AsyncIOEngine::IO_URING ? "io_uring" : "thread pool";
+}
+
+TEST(AsyncDiskManagerTest, ReadWriteTest) {
+  std::string db_name = "async_disk_test.db";
+  const page_id_t num_pages = 100;
+  for (auto engine : {AsyncIOEngine::AUTO, AsyncIOEngine::THREAD_POOL}) {
+    for (auto backend : {DiskIOBackend::PREAD, DiskIOBackend::FSTREAM}) {
+      remove(db_name.c_str());
+      DiskManager disk_mgr(db_name, backend);
+      AsyncDiskManager aio(8, engine);
+      ASSERT_NE(AsyncIOEngine::AUTO, aio.GetEngine());
+      for (page_id_t i = 0; i < num_pages; i++) {
+        ASSERT_EQ(i, disk_mgr.AllocatePage());
+      }
+      std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+      std::vector<std::tuple<DiskManager *, page_id_t, const char *>> pages;
+      for (page_id_t i = 0; i < num_pages; i++) {
+        snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+        pages.emplace_back(&disk_mgr, i, data[i].data());
+      }
+      ASSERT_TRUE(aio.WritePages(pages));
+      ASSERT_EQ(0, aio.GetNumPending());
+
+      // The queue refuses requests beyond its depth until some complete.
+      std::vector<std::vector<char>> read(num_pages, std::vector<char>(PAGE_SIZE, 'x'));
+      std::vector<AsyncIOCompletion> completions;
+      page_id_t next = 0;
+      while (completions.size() < static_cast<size_t>(num_pages)) {
+        while (next < num_pages && aio.QueueRead(&disk_mgr, next, read[next].data(), next)) {
+          next++;
+        }
+        ASSERT_LE(aio.GetNumPending(), aio.GetQueueDepth());
+        aio.WaitCompletions(1, &completions);
+      }
+      ASSERT_EQ(0, aio.GetNumPending());
+      for (const auto &completion : completions) {
+        ASSERT_TRUE(completion.ok_);
+        ASSERT_EQ("page " + std::to_string(completion.tag_), std::string(read[completion.tag_].data()));
+      }
+
+      // Past the end of the file reads as zeros.
+      std::vector<char> buf(PAGE_SIZE, 'x');
+      ASSERT_TRUE(aio.QueueRead(&disk_mgr, 10 * num_pages, buf.data(), 0));
+      completions.clear();
+      ASSERT_EQ(1, aio.WaitCompletions(1, &completions));
+      ASSERT_TRUE(completions[0].ok_);
+      ASSERT_EQ(std::vector<char>(PAGE_SIZE, 0), buf);
+
+      // The sync path agrees with what was written asynchronously.
+      disk_mgr.ReadPage(num_pages - 1, buf.data());
+      ASSERT_EQ("page " + std::to_string(num_pages - 1), std::string(buf.data()));
+
+      // A page cut short by the end of the file is read up to there, the rest is zeros.
+      if (backend == DiskIOBackend::PREAD) {
+        ASSERT_EQ(0, truncate(db_name.c_str(), disk_mgr.GetPageOffset(num_pages - 1) + PAGE_SIZE / 2));
+        std::vector<char> expected(PAGE_SIZE, 0);
+        memcpy(expected.data(), data[num_pages - 1].data(), PAGE_SIZE / 2);
+        ASSERT_TRUE(aio.QueueRead(&disk_mgr, num_pages - 1, buf.data(), 0));
+        completions.clear();
+        ASSERT_EQ(1, aio.WaitCompletions(1, &completions));
+        ASSERT_TRUE(completions[0].ok_);
+        ASSERT_EQ(expected, buf);
+      }
+      disk_mgr.Close();
+    }
+  }
+  remove(db_name.c_str());
+}
+
+TEST(AsyncDiskManagerTest, DISABLED_QueueDepthBenchmark) {
+  std::string db_name = "async_disk_bench_test.db";
+  const page_id_t num_pages = 4096;
+  const size_t num_reads = 8192;
+  remove(db_name.c_str());
+  DiskManager disk_mgr(db_name);
+  {
+    std::vector<std::pair<page_id_t, const char *>> pages;
+    std::vector<std::vector<char>> contents(num_pages, std::vector<char>(PAGE_SIZE));
+    for (page_id_t i = 0; i < num_pages; i++) {
+      snprintf(contents[i].data(), PAGE_SIZE, "page %d", i);
+      pages.emplace_back(i, contents[i].data());
+    }
+    disk_mgr.WritePages(pages);
+    disk_mgr.Sync();
+  }
+
+  // Scenario: random page reads with 1 to 64 of them in flight, the page cache is dropped before every run so the
+  // reads reach the device.
+  for (auto engine : {AsyncIOEngine::IO_URING, AsyncIOEngine::THREAD_POOL}) {
+    for (size_t depth : {1, 4, 16, 64}) {
+      AsyncDiskManager aio(depth, engine);
+      if (aio.GetEngine() != engine) {
+        std::cout << EngineName(engine) << ": not available" << std::endl;
+        break;
+      }
+      posix_fadvise(disk_mgr.GetFd(), 0, 0, POSIX_FADV_DONTNEED);
+      std::vector<std::vector<char>> buffers(depth, std::vector<char>(PAGE_SIZE));
+      std::vector<page_id_t> slot_pages(depth);
+      std::vector<size_t> free_slots;
+      for (size_t i = 0; i < depth; i++) {
+        free_slots.push_back(i);
+      }
+      std::default_random_engine rng(depth);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      std::vector<AsyncIOCompletion> completions;
+      size_t issued = 0;
+      size_t mismatches = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (size_t done = 0; done < num_reads;) {
+        while (issued < num_reads && !free_slots.empty()) {
+          size_t slot = free_slots.back();
+          free_slots.pop_back();
+          slot_pages[slot] = dist(rng);
+          ASSERT_TRUE(aio.QueueRead(&disk_mgr, slot_pages[slot], buffers[slot].data(), slot));
+          issued++;
+        }
+        completions.clear();
+        done += aio.WaitCompletions(1, &completions);
+        for (const auto &completion : completions) {
+          if (!completion.ok_ ||
+              "page " + std::to_string(slot_pages[completion.tag_]) != buffers[completion.tag_].data()) {
+            mismatches++;
+          }
+          free_slots.push_back(completion.tag_);
+        }
+      }
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      EXPECT_EQ(0, mismatches);
+      std::cout << EngineName(engine) << ": queue depth " << depth << ", "
+                << static_cast<size_t>(num_reads / seconds) << " pages/s" << std::endl;
+    }
+  }
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
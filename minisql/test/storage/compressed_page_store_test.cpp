@@ -0,0 +1,232 @@
+#include "storage/compressed_page_store.h"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "record/field.h"
+#include "record/schema.h"
+#include "storage/disk_manager.h"
+#include "storage/page_codec.h"
+#include "storage/table_heap.h"
+
+using Fields = std::vector<Field>;
+
+/** Round trip a page through the codec, @return the compressed size, 0 if it did not compress */
+static size_t RoundTrip(const char *page_data) {
+  char compressed[PageCodec::MAX_COMPRESSED_SIZE];
+  size_t size = PageCodec::Compress(page_data, PAGE_SIZE, compressed, sizeof(compressed));
+  EXPECT_NE(0, size);
+  char decompressed[PAGE_SIZE];
+  EXPECT_TRUE(PageCodec::Decompress(compressed, size, decompressed, PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page_data, decompressed, PAGE_SIZE));
+  // A truncation of the data is caught, unless only an empty last sequence is cut, none reads or writes out of bounds.
+  for (size_t length = 0; length < size; length++) {
+    if (PageCodec::Decompress(compressed, length, decompressed, PAGE_SIZE)) {
+      EXPECT_EQ(0, memcmp(page_data, decompressed, PAGE_SIZE));
+    }
+  }
+  return PageCodec::Compress(page_data, PAGE_SIZE, compressed, PAGE_SIZE - CompressedPageStore::SECTOR_SIZE);
+}
+
+TEST(CompressedPageStoreTest, PageCodecTest) {
+  char page_data[PAGE_SIZE];
+  memset(page_data, 0, PAGE_SIZE);
+  size_t size = RoundTrip(page_data);
+  EXPECT_LT(size, PAGE_SIZE / 64);
+
+  // Rows with a repetitive CHAR column, then free space.
+  memset(page_data, 0, PAGE_SIZE);
+  for (int i = 0, offset = 0; offset + 64 < PAGE_SIZE / 2; i++, offset += 64) {
+    snprintf(page_data + offset, 64, "row %d customer name padded to the full column width", i);
+  }
+  size = RoundTrip(page_data);
+  EXPECT_NE(0, size);
+  EXPECT_LT(size, PAGE_SIZE / 4);
+
+  // Random bytes do not compress, they are still encoded and decoded exactly.
+  std::mt19937 rng(7);
+  for (int i = 0; i < PAGE_SIZE; i++) {
+    page_data[i] = static_cast<char>(rng());
+  }
+  EXPECT_EQ(0, RoundTrip(page_data));
+}
+
+TEST(CompressedPageStoreTest, PersistenceTest) {
+  std::string db_name = "compressed_store_test.db";
+  remove(db_name.c_str());
+  CompressedPageStore::Remove(db_name);
+  const int num_pages = 200;
+  std::mt19937 rng(11);
+  // Page i holds i in its first bytes, then random bytes for odd pages and zeros for even ones.
+  auto fill_page = [&](char *page_data, int i, bool random) {
+    memset(page_data, 0, PAGE_SIZE);
+    if (random) {
+      for (int j = 0; j < PAGE_SIZE; j++) {
+        page_data[j] = static_cast<char>(rng());
+      }
+    }
+    memcpy(page_data, &i, sizeof(i));
+  };
+  char page_data[PAGE_SIZE];
+  {
+    DiskManager disk_mgr(db_name, DiskIOBackend::PREAD, false, true);
+    ASSERT_NE(nullptr, disk_mgr.GetPageStore());
+    ASSERT_EQ(-1, disk_mgr.GetFd());
+    for (int i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr.AllocatePage());
+      fill_page(page_data, i, i % 2 == 1);
+      disk_mgr.WritePage(i, page_data);
+    }
+    EXPECT_EQ(num_pages, disk_mgr.GetPageStore()->GetNumPages());
+    EXPECT_LT(disk_mgr.GetPageStore()->GetStoredBytes(), static_cast<uint64_t>(num_pages) * PAGE_SIZE * 3 / 4);
+    // Pages that grow and pages that shrink, each to a new block.
+    for (int i = 0; i < 20; i++) {
+      fill_page(page_data, i, i % 2 == 0);
+      disk_mgr.WritePage(i, page_data);
+    }
+    disk_mgr.DeAllocatePage(num_pages - 1);
+  }
+
+  uint64_t file_size;
+  uint64_t disk_usage;
+  {
+    DiskManager disk_mgr(db_name);
+    ASSERT_NE(nullptr, disk_mgr.GetPageStore());
+    EXPECT_EQ(num_pages - 1, disk_mgr.GetPageStore()->GetNumPages());
+    // Regenerate the same bytes in the same order as they were written.
+    rng.seed(11);
+    std::vector<std::vector<char>> pages(num_pages, std::vector<char>(PAGE_SIZE));
+    for (int i = 0; i < num_pages; i++) {
+      fill_page(pages[i].data(), i, i % 2 == 1);
+    }
+    for (int i = 0; i < 20; i++) {
+      fill_page(pages[i].data(), i, i % 2 == 0);
+    }
+    memset(pages[num_pages - 1].data(), 0, PAGE_SIZE);
+    for (int i = 0; i < num_pages; i++) {
+      disk_mgr.ReadPage(i, page_data);
+      ASSERT_EQ(0, memcmp(pages[i].data(), page_data, PAGE_SIZE)) << "page " << i;
+    }
+    // Once synced, the sectors of a freed page are reused before the file grows.
+    disk_mgr.Truncate();
+    disk_mgr.GetFileUsage(&file_size, &disk_usage);
+    disk_mgr.DeAllocatePage(21);
+    disk_mgr.Sync();
+    fill_page(page_data, 22, true);
+    disk_mgr.WritePage(22, page_data);
+    uint64_t new_file_size;
+    disk_mgr.GetFileUsage(&new_file_size, &disk_usage);
+    EXPECT_LE(new_file_size, file_size);
+  }
+
+  // A compressed file can not be mapped read only.
+  EXPECT_THROW(DiskManager disk_mgr(db_name, DiskIOBackend::MMAP), std::runtime_error);
+  remove(db_name.c_str());
+  CompressedPageStore::Remove(db_name);
+}
+
+TEST(CompressedPageStoreTest, UnsyncedRewriteTest) {
+  std::string db_name = "compressed_store_test.db";
+  CompressedPageStore::Remove(db_name);
+  char old_page[PAGE_SIZE];
+  char new_page[PAGE_SIZE];
+  char page_data[PAGE_SIZE];
+  memset(old_page, 0, PAGE_SIZE);
+  snprintf(old_page, PAGE_SIZE, "old version");
+  memset(new_page, 0, PAGE_SIZE);
+  snprintf(new_page, PAGE_SIZE, "new version");
+  {
+    CompressedPageStore store(db_name);
+    store.WritePage(0, old_page);
+    store.Sync();
+    // The new version fits in the block of the old one, that block is left as it is all the same.
+    store.WritePage(0, new_page);
+    store.ReadPage(0, page_data);
+    ASSERT_EQ(0, memcmp(new_page, page_data, PAGE_SIZE));
+    // Opened again as after a crash before the next Sync, the map on disk still gives the old version.
+    CompressedPageStore reopened(db_name);
+    reopened.ReadPage(0, page_data);
+    ASSERT_EQ(0, memcmp(old_page, page_data, PAGE_SIZE));
+    store.Sync();
+  }
+  CompressedPageStore store(db_name);
+  store.ReadPage(0, page_data);
+  ASSERT_EQ(0, memcmp(new_page, page_data, PAGE_SIZE));
+  CompressedPageStore::Remove(db_name);
+}
+
+/**
+ * Write a table of row_nums rows with repetitive CHAR columns with and without compression, then scan it.
+ */
+static void CompressTable(int row_nums) {
+  std::string db_name = "compressed_store_bench_test.db";
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false),
+                                   new Column("city", TypeId::kTypeChar, 32, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const char *cities[] = {"Hangzhou", "Shanghai", "Beijing", "Shenzhen"};
+
+  // Scenario: a table with repetitive CHAR columns written out by a flush, then scanned from a fresh pool.
+  for (bool compress : {false, true}) {
+    remove(db_name.c_str());
+    CompressedPageStore::Remove(db_name);
+    page_id_t first_page_id;
+    size_t num_pages;
+    double write_seconds;
+    {
+      DiskManager disk_mgr(db_name, DiskIOBackend::PREAD, false, compress);
+      BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+      std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+      char name[64];
+      for (int i = 0; i < row_nums; i++) {
+        snprintf(name, sizeof(name), "customer %08d of the store", i);
+        Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true),
+                      Field(TypeId::kTypeChar, const_cast<char *>(cities[i % 4]), strlen(cities[i % 4]), true)};
+        Row row(fields);
+        ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      }
+      first_page_id = table_heap->GetFirstPageId();
+      num_pages = table_heap->GetFragmentation().GetNumPages();
+      auto start = std::chrono::steady_clock::now();
+      bpm.FlushAllPages();
+      write_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    DiskManager disk_mgr(db_name);
+    ASSERT_EQ(compress, disk_mgr.GetPageStore() != nullptr);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr));
+    int64_t rows = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+      rows++;
+    }
+    double read_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(row_nums, rows);
+    uint64_t file_size;
+    uint64_t disk_usage;
+    disk_mgr.GetFileUsage(&file_size, &disk_usage);
+    double megabytes = static_cast<double>(num_pages) * PAGE_SIZE / (1 << 20);
+    std::cout << (compress ? "compressed" : "uncompressed") << ": " << num_pages << " pages, disk usage "
+              << disk_usage << " bytes";
+    if (compress) {
+      auto page_store = disk_mgr.GetPageStore();
+      double ratio = static_cast<double>(page_store->GetNumPages()) * PAGE_SIZE / page_store->GetStoredBytes();
+      std::cout << ", ratio " << ratio;
+      EXPECT_GT(ratio, 2);
+    }
+    std::cout << ", write " << megabytes / write_seconds << " MB/s, read " << megabytes / read_seconds << " MB/s"
+              << std::endl;
+  }
+  remove(db_name.c_str());
+  CompressedPageStore::Remove(db_name);
+}
+
+TEST(CompressedPageStoreTest, CompressionTest) { CompressTable(2000); }
+
+TEST(CompressedPageStoreTest, DISABLED_CompressionBenchmark) { CompressTable(20000); }
@@ -1,7 +1,18 @@
 #include "storage/disk_manager.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
+#include "common/instance.h"
 #include "gtest/gtest.h"
 
 TEST(DiskManagerTest, BitMapPageTest) {
@@ -56,4 +67,416 @@ TEST(DiskManagerTest, FreePageAllocationTest) {
   EXPECT_EQ(extent_nums * DiskManager::BITMAP_SIZE - 5, meta_page->GetAllocatedPages());
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 2, meta_page->GetExtentUsedPage(0));
   EXPECT_EQ(DiskManager::BITMAP_SIZE - 3, meta_page->GetExtentUsedPage(1));
-}
\ No newline at end of file
+}
+
+TEST(DiskManagerTest, BatchWriteTest) {
+  std::string db_name = "disk_batch_test.db";
+  remove(db_name.c_str());
+  DiskManager *disk_mgr = new DiskManager(db_name);
+  // Two contiguous runs with a gap, crossing into the second extent, handed over in random order.
+  std::vector<page_id_t> page_ids;
+  for (page_id_t i = 0; i < 16; i++) {
+    page_ids.push_back(i);
+    page_ids.push_back(DiskManager::BITMAP_SIZE - 8 + i);
+  }
+  std::shuffle(page_ids.begin(), page_ids.end(), std::default_random_engine(0));
+  std::vector<std::vector<char>> data(page_ids.size(), std::vector<char>(PAGE_SIZE));
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    snprintf(data[i].data(), PAGE_SIZE, "page %d", page_ids[i]);
+    pages.emplace_back(page_ids[i], data[i].data());
+  }
+  disk_mgr->WritePages(pages);
+  char buf[PAGE_SIZE];
+  for (auto page_id : page_ids) {
+    disk_mgr->ReadPage(page_id, buf);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(buf));
+  }
+  disk_mgr->Close();
+  delete disk_mgr;
+  remove(db_name.c_str());
+}
+
+/**
+ * Write num_pages pages tagged with their id to a new file.
+ */
+static void WriteTaggedPages(const std::string &db_name, page_id_t num_pages) {
+  remove(db_name.c_str());
+  DiskManager disk_mgr(db_name);
+  std::vector<std::vector<char>> data(num_pages, std::vector<char>(PAGE_SIZE));
+  std::vector<std::pair<page_id_t, const char *>> pages;
+  for (page_id_t i = 0; i < num_pages; i++) {
+    snprintf(data[i].data(), PAGE_SIZE, "page %d", i);
+    pages.emplace_back(i, data[i].data());
+  }
+  disk_mgr.WritePages(pages);
+}
+
+/**
+ * Read random pages of a file written by WriteTaggedPages from several threads at once.
+ * @return the number of reads that did not return the page asked for
+ */
+static size_t ReadConcurrently(DiskManager *disk_mgr, page_id_t num_pages, size_t num_threads,
+                               size_t reads_per_thread) {
+  std::atomic<size_t> mismatches{0};
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      std::default_random_engine rng(t);
+      std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+      char buf[PAGE_SIZE];
+      for (size_t i = 0; i < reads_per_thread; i++) {
+        page_id_t page_id = dist(rng);
+        disk_mgr->ReadPage(page_id, buf);
+        if ("page " + std::to_string(page_id) != buf) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return mismatches;
+}
+
+TEST(DiskManagerTest, ConcurrentReadTest) {
+  std::string db_name = "disk_read_test.db";
+  const page_id_t num_pages = 256;
+  WriteTaggedPages(db_name, num_pages);
+  for (auto backend : {DiskIOBackend::FSTREAM, DiskIOBackend::PREAD}) {
+    DiskManager disk_mgr(db_name, backend);
+    EXPECT_EQ(0, ReadConcurrently(&disk_mgr, num_pages, 4, 1000));
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DISABLED_ConcurrentReadBenchmark) {
+  std::string db_name = "disk_read_bench_test.db";
+  const page_id_t num_pages = 4096;
+  const size_t num_threads = 4;
+  const size_t reads_per_thread = 20000;
+  WriteTaggedPages(db_name, num_pages);
+
+  // Scenario: both backends read the same file, the fstream one serializes every read on its latch.
+  for (auto backend : {DiskIOBackend::FSTREAM, DiskIOBackend::PREAD}) {
+    DiskManager disk_mgr(db_name, backend);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, ReadConcurrently(&disk_mgr, num_pages, num_threads, reads_per_thread));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << (backend == DiskIOBackend::PREAD ? "pread" : "fstream") << ": " << num_threads << " threads, "
+              << static_cast<size_t>(num_threads * reads_per_thread / seconds) << " pages/s" << std::endl;
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, AllocationPersistenceTest) {
+  std::string db_name = "disk_alloc_test.db";
+  remove(db_name.c_str());
+  const page_id_t extent_size = DiskManager::BITMAP_SIZE;
+  const page_id_t num_pages = extent_size * 2 + 100;
+  {
+    DiskManager disk_mgr(db_name);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr.AllocatePage());
+    }
+    // Freed pages are handed out again lowest first, whatever the order they were freed in.
+    for (page_id_t page_id : {extent_size + 7, 3, extent_size - 1}) {
+      disk_mgr.DeAllocatePage(page_id);
+      ASSERT_TRUE(disk_mgr.IsPageFree(page_id));
+    }
+    ASSERT_EQ(3, disk_mgr.AllocatePage());
+    ASSERT_EQ(extent_size - 1, disk_mgr.AllocatePage());
+  }
+
+  // The bitmaps and the meta page reach the file at close, free extent hint included.
+  DiskManager disk_mgr(db_name);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+  EXPECT_EQ(num_pages - 1, meta_page->GetAllocatedPages());
+  EXPECT_EQ(3, meta_page->GetExtentNums());
+  EXPECT_EQ(1, meta_page->GetFreeExtentHint());
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i == extent_size + 7, disk_mgr.IsPageFree(i));
+  }
+  ASSERT_TRUE(disk_mgr.IsPageFree(num_pages));
+  EXPECT_EQ(extent_size + 7, disk_mgr.AllocatePage());
+  EXPECT_EQ(num_pages, disk_mgr.AllocatePage());
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, PageSizeTest) {
+  std::string db_name = "disk_page_size_test.db";
+  remove(db_name.c_str());
+  const std::streamoff page_size_offset = MIN_PAGE_SIZE - sizeof(uint32_t);
+  auto write_word = [&](std::streamoff offset, uint32_t value) {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+  };
+  {
+    DiskManager disk_mgr(db_name);
+    for (page_id_t i = 0; i < 10; i++) {
+      ASSERT_EQ(i, disk_mgr.AllocatePage());
+    }
+  }
+  {
+    DiskManager disk_mgr(db_name);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+    EXPECT_EQ(PAGE_SIZE, meta_page->GetPageSize());
+    EXPECT_EQ(10, meta_page->GetAllocatedPages());
+  }
+
+  // A file of another page size is refused, read only or not.
+  write_word(page_size_offset, PAGE_SIZE == MIN_PAGE_SIZE ? 2 * MIN_PAGE_SIZE : MIN_PAGE_SIZE);
+  EXPECT_THROW(DiskManager disk_mgr(db_name), std::runtime_error);
+  EXPECT_THROW(DiskManager disk_mgr(db_name, DiskIOBackend::MMAP), std::runtime_error);
+
+  // A file written before the page size was recorded has 4 KB pages and a free extent hint in its place.
+  write_word(page_size_offset, 1);
+  if (PAGE_SIZE != MIN_PAGE_SIZE) {
+    EXPECT_THROW(DiskManager disk_mgr(db_name), std::runtime_error);
+  } else {
+    DiskManager disk_mgr(db_name);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+    EXPECT_EQ(PAGE_SIZE, meta_page->GetPageSize());
+    EXPECT_EQ(0, meta_page->GetFreeExtentHint());
+    EXPECT_EQ(10, disk_mgr.AllocatePage());
+  }
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, LegacyMetaPageTest) {
+  std::string db_name = "disk_legacy_meta_test.db";
+  remove(db_name.c_str());
+  const page_id_t num_pages = DiskManager::BITMAP_SIZE + 5;
+  {
+    DiskManager disk_mgr(db_name);
+    for (page_id_t i = 0; i < num_pages; i++) {
+      ASSERT_EQ(i, disk_mgr.AllocatePage());
+    }
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+    ASSERT_EQ(1, meta_page->GetFreeExtentHint());
+  }
+
+  // Rewrite the meta page the way builds that kept the free extent hint but not the page size wrote it: one more used
+  // page count, 0 for an extent no file reaches, then the hint in the last word of the first 4 KB.
+  {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    uint32_t words[2] = {0, 1};
+    file.seekp(MIN_PAGE_SIZE - sizeof(words));
+    file.write(reinterpret_cast<const char *>(words), sizeof(words));
+  }
+  if (PAGE_SIZE != MIN_PAGE_SIZE) {
+    EXPECT_THROW(DiskManager disk_mgr(db_name), std::runtime_error);
+    remove(db_name.c_str());
+    return;
+  }
+  {
+    DiskManager disk_mgr(db_name);
+    auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+    EXPECT_EQ(PAGE_SIZE, meta_page->GetPageSize());
+    EXPECT_EQ(1, meta_page->GetFreeExtentHint());
+    EXPECT_EQ(num_pages, meta_page->GetAllocatedPages());
+    EXPECT_EQ(2, meta_page->GetExtentNums());
+    disk_mgr.DeAllocatePage(DiskManager::BITMAP_SIZE + 1);
+    EXPECT_EQ(DiskManager::BITMAP_SIZE + 1, disk_mgr.AllocatePage());
+    EXPECT_EQ(num_pages, disk_mgr.AllocatePage());
+  }
+
+  // The file is written back in the current layout.
+  DiskManager disk_mgr(db_name);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+  EXPECT_EQ(PAGE_SIZE, meta_page->GetPageSize());
+  EXPECT_EQ(1, meta_page->GetFreeExtentHint());
+  EXPECT_EQ(num_pages + 1, meta_page->GetAllocatedPages());
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, DISABLED_AllocateBenchmark) {
+  std::string db_name = "disk_alloc_bench_test.db";
+  remove(db_name.c_str());
+  const page_id_t num_pages = 200000;
+  DiskManager disk_mgr(db_name);
+
+  // Scenario: a bulk load allocating pages one at a time, then a churn of frees and allocations in the full extents.
+  auto start = std::chrono::steady_clock::now();
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr.AllocatePage());
+  }
+  double alloc_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::default_random_engine rng(0);
+  std::uniform_int_distribution<page_id_t> dist(0, num_pages - 1);
+  start = std::chrono::steady_clock::now();
+  for (page_id_t i = 0; i < num_pages; i++) {
+    page_id_t page_id = dist(rng);
+    disk_mgr.DeAllocatePage(page_id);
+    ASSERT_EQ(page_id, disk_mgr.AllocatePage());
+  }
+  double churn_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  disk_mgr.Sync();
+  double sync_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "allocate: " << static_cast<size_t>(num_pages / alloc_seconds) << " pages/s, free + allocate: "
+            << static_cast<size_t>(num_pages / churn_seconds) << " pairs/s, sync of "
+            << num_pages / DiskManager::BITMAP_SIZE + 1 << " bitmaps: " << sync_seconds * 1000 << " ms" << std::endl;
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, SegmentAllocationTest) {
+  std::string db_name = "disk_segment_test.db";
+  remove(db_name.c_str());
+  const page_id_t run_size = DiskManager::SEGMENT_RUN_SIZE;
+  std::vector<page_id_t> first_pages, second_pages;
+  {
+    DiskManager disk_mgr(db_name);
+    PageSegment first, second;
+    // Two segments growing at the same time, with single pages allocated in between, each stays in whole runs.
+    for (page_id_t i = 0; i < run_size * 3; i++) {
+      first_pages.push_back(disk_mgr.AllocatePage(&first));
+      second_pages.push_back(disk_mgr.AllocatePage(&second));
+      disk_mgr.AllocatePage();
+    }
+    for (const auto &pages : {first_pages, second_pages}) {
+      for (size_t i = 1; i < pages.size(); i++) {
+        if (i % run_size != 0) {
+          ASSERT_EQ(pages[i - 1] + 1, pages[i]);
+        }
+      }
+    }
+    // Pages of the second segment reserved but not handed out yet.
+    second_pages.push_back(disk_mgr.AllocatePage(&second));
+    ASSERT_FALSE(disk_mgr.IsPageFree(second_pages.back() + 1));
+    disk_mgr.ReleaseSegment(&first);
+  }
+
+  // Reserved pages are written back as free, released or not.
+  DiskManager disk_mgr(db_name);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+  EXPECT_EQ(run_size * 3 * 3 + 1, meta_page->GetAllocatedPages());
+  for (const auto &pages : {first_pages, second_pages}) {
+    for (page_id_t page_id : pages) {
+      ASSERT_FALSE(disk_mgr.IsPageFree(page_id));
+    }
+  }
+  ASSERT_TRUE(disk_mgr.IsPageFree(second_pages.back() + 1));
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, TruncateTest) {
+  std::string db_name = "disk_truncate_test.db";
+  remove(db_name.c_str());
+  const page_id_t num_pages = DiskManager::BITMAP_SIZE + 100;
+  const page_id_t num_kept_pages = 10;
+  DiskManager disk_mgr(db_name);
+  char data[PAGE_SIZE];
+  memset(data, 'x', PAGE_SIZE);
+  for (page_id_t i = 0; i < num_pages; i++) {
+    ASSERT_EQ(i, disk_mgr.AllocatePage());
+    disk_mgr.WritePage(i, data);
+  }
+  for (page_id_t i = num_kept_pages; i < num_pages; i++) {
+    disk_mgr.DeAllocatePage(i);
+  }
+  disk_mgr.Sync();
+  uint64_t file_size, disk_usage;
+  disk_mgr.GetFileUsage(&file_size, &disk_usage);
+  if (disk_mgr.GetNumPunchedBytes() > 0) {
+    // The freed pages are holes, the bitmap of the second extent lies in between.
+    EXPECT_EQ(static_cast<uint64_t>(num_pages - num_kept_pages) * PAGE_SIZE, disk_mgr.GetNumPunchedBytes());
+    EXPECT_LE(disk_usage, file_size - disk_mgr.GetNumPunchedBytes());
+  }
+
+  // Meta page, bitmap and the pages kept, the empty second extent is gone with its bitmap.
+  const uint64_t truncated_size = (num_kept_pages + 2) * PAGE_SIZE;
+  EXPECT_EQ(file_size - truncated_size, disk_mgr.Truncate());
+  disk_mgr.GetFileUsage(&file_size, &disk_usage);
+  EXPECT_EQ(truncated_size, file_size);
+  EXPECT_EQ(1, reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData())->GetExtentNums());
+  EXPECT_EQ(num_kept_pages, disk_mgr.AllocatePage());
+  disk_mgr.Close();
+  remove(db_name.c_str());
+}
+
+TEST(DiskManagerTest, IOStatsTest) {
+  const std::string db_name = "io_stats_test.db";
+  const int num_rows = 3000;
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[32];
+  memset(name, 'x', sizeof(name));
+
+  // Every write goes to the class of the page written.
+  {
+    DBStorageEngine db(db_name, true);
+    TableInfo *table_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->CreateTable("t", schema.get(), nullptr, table_info));
+    IndexInfo *index_info = nullptr;
+    ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->CreateIndex("t", "t_id", {"id"}, nullptr, index_info, "bptree"));
+    for (int i = 0; i < num_rows; i++) {
+      std::vector<Field> fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_info->GetTableHeap()->InsertTuple(row, nullptr));
+      std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+      Row key(key_fields);
+      ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->InsertEntry(key, row.GetRowId(), nullptr));
+    }
+    db.bpm_->FlushAllPages();
+    db.disk_mgr_->Sync();
+    const IOStats &stats = db.disk_mgr_->GetIOStats();
+    EXPECT_GT(stats.GetCount(PageClass::TABLE, IOType::WRITE), 0);
+    EXPECT_GT(stats.GetCount(PageClass::INDEX, IOType::WRITE), 0);
+    EXPECT_GT(stats.GetCount(PageClass::CATALOG, IOType::WRITE), 0);
+    EXPECT_GT(stats.GetCount(PageClass::META, IOType::WRITE), 0);
+    EXPECT_EQ(0, stats.GetCount(PageClass::OTHER, IOType::WRITE));
+    EXPECT_GT(stats.GetNumFlushes(), 0);
+    EXPECT_GT(stats.GetTotalLatency(PageClass::TABLE, IOType::WRITE), 0);
+  }
+
+  // After a restart, a scan reads table pages and lookups read index pages.
+  remove(DBStorageEngine::GetWarmUpFileName(db_name).c_str());
+  DBStorageEngine db(db_name, false);
+  IOStats &stats = db.disk_mgr_->GetIOStats();
+  stats.Reset();
+  TableInfo *table_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->GetTable("t", table_info));
+  IndexInfo *index_info = nullptr;
+  ASSERT_EQ(DB_SUCCESS, db.catalog_mgr_->GetIndex("t", "t_id", index_info));
+  int rows = 0;
+  for (auto iter = table_info->GetTableHeap()->Begin(nullptr); iter != table_info->GetTableHeap()->End(); ++iter) {
+    rows++;
+  }
+  ASSERT_EQ(num_rows, rows);
+  for (int i = 0; i < num_rows; i += 101) {
+    std::vector<Field> key_fields{Field(TypeId::kTypeInt, i)};
+    Row key(key_fields);
+    std::vector<RowId> result;
+    ASSERT_EQ(DB_SUCCESS, index_info->GetIndex()->ScanKey(key, result, nullptr));
+  }
+  EXPECT_GT(stats.GetCount(PageClass::TABLE, IOType::READ), 0);
+  EXPECT_GT(stats.GetCount(PageClass::INDEX, IOType::READ), 0);
+  EXPECT_EQ(0, stats.GetCount(PageClass::TABLE, IOType::WRITE));
+  std::cout << "table reads " << stats.GetCount(PageClass::TABLE, IOType::READ) << ", p50 < "
+            << stats.GetLatency(PageClass::TABLE, IOType::READ).GetPercentile(50) << "us, index reads "
+            << stats.GetCount(PageClass::INDEX, IOType::READ) << std::endl;
+
+  // The dump only lists what was recorded, and sums of files add up.
+  std::stringstream json;
+  stats.WriteJson(json);
+  EXPECT_NE(std::string::npos, json.str().find("\"read\": {"));
+  EXPECT_NE(std::string::npos, json.str().find("\"table\": {\"count\": "));
+  EXPECT_EQ(std::string::npos, json.str().find("\"other\""));
+  IOStats total;
+  total.Merge(stats);
+  total.Merge(stats);
+  EXPECT_EQ(2 * stats.GetCount(PageClass::TABLE, IOType::READ), total.GetCount(PageClass::TABLE, IOType::READ));
+
+  char page_data[PAGE_SIZE];
+  memset(page_data, 0, PAGE_SIZE);
+  EXPECT_EQ(PageClass::OTHER, IOStats::ClassifyPage(5, page_data));
+  EXPECT_EQ(PageClass::CATALOG, IOStats::ClassifyPage(CATALOG_META_PAGE_ID, page_data));
+}
@@ -1,10 +1,14 @@
 #include "storage/table_heap.h"
 
+#include <chrono>
+#include <cstring>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include "common/instance.h"
 #include "gtest/gtest.h"
+#include "page/disk_file_meta_page.h"
 #include "record/field.h"
 #include "record/schema.h"
 #include "utils/utils.h"
@@ -61,3 +65,556 @@ TEST(TableHeapTest, TableHeapSampleTest) {
   }
   ASSERT_EQ(size, 0);
 }
+
+/**
+ * Scan a table of row_nums rows num_scans times through a fresh pool, with the normal and the read-only mapped backend.
+ */
+static void ReadOnlyScan(int row_nums, int num_scans) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_file_name.c_str());
+  page_id_t first_page_id;
+  {
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    char name[32];
+    for (int i = 0; i < row_nums; i++) {
+      snprintf(name, sizeof(name), "name %d", i);
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true),
+                    Field(TypeId::kTypeFloat, static_cast<float>(i))};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+    first_page_id = table_heap->GetFirstPageId();
+    bpm.FlushAllPages();
+  }
+
+  // Scenario: full scans of a table whose file is in the page cache, copied into a fresh pool by the normal path, used
+  // in place by the read-only mapping.
+  for (auto backend : {DiskIOBackend::PREAD, DiskIOBackend::MMAP}) {
+    DiskManager disk_mgr(db_file_name, backend);
+    ASSERT_EQ(backend == DiskIOBackend::MMAP, disk_mgr.IsReadOnly());
+    double seconds = 0;
+    for (int scan = 0; scan < num_scans; scan++) {
+      BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+      std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr));
+      int64_t rows = 0;
+      int64_t id_sum = 0;
+      auto start = std::chrono::steady_clock::now();
+      for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+        rows++;
+        id_sum += std::stoi(iter->GetField(0)->toString());
+      }
+      seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      ASSERT_EQ(row_nums, rows);
+      ASSERT_EQ(static_cast<int64_t>(row_nums) * (row_nums - 1) / 2, id_sum);
+      if (backend == DiskIOBackend::MMAP) {
+        // Nothing goes through the pool, and nothing can be written.
+        ASSERT_EQ(0, bpm.GetNumResidentPages());
+        page_id_t page_id;
+        ASSERT_EQ(nullptr, bpm.NewPage(page_id));
+      }
+    }
+    std::cout << (backend == DiskIOBackend::MMAP ? "mmap" : "pread") << ": "
+              << static_cast<size_t>(num_scans * row_nums / seconds) << " rows/s" << std::endl;
+  }
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, ReadOnlyScanTest) { ReadOnlyScan(5000, 1); }
+
+TEST(TableHeapTest, DISABLED_ReadOnlyScanBenchmark) { ReadOnlyScan(100000, 5); }
+
+TEST(TableHeapTest, InterleavedInsertFragmentationTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  remove(db_file_name.c_str());
+  DiskManager disk_mgr(db_file_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  {
+    // Scenario: two tables loaded at the same time, every page of one is allocated right after a page of the other.
+    std::unique_ptr<TableHeap> first(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    std::unique_ptr<TableHeap> second(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    char name[64];
+    memset(name, 'x', sizeof(name));
+    // enough rows for a few hundred pages whatever the page size
+    const int row_nums = 20000 * (PAGE_SIZE / MIN_PAGE_SIZE);
+    for (int i = 0; i < row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row first_row(fields);
+      ASSERT_TRUE(first->InsertTuple(first_row, nullptr));
+      Row second_row(fields);
+      ASSERT_TRUE(second->InsertTuple(second_row, nullptr));
+    }
+    for (auto table_heap : {first.get(), second.get()}) {
+      auto report = table_heap->GetFragmentation();
+      std::cout << report.GetNumPages() << " pages in " << report.GetNumRuns() << " runs, fragmentation "
+                << report.GetFragmentation() << std::endl;
+      ASSERT_GT(report.GetNumPages(), 2 * DiskManager::SEGMENT_RUN_SIZE);
+      // At most one run per reserved run of pages, where page by page allocation would give one run per page.
+      ASSERT_LE(report.GetNumRuns(), (report.GetNumPages() + DiskManager::SEGMENT_RUN_SIZE - 1) /
+                                         DiskManager::SEGMENT_RUN_SIZE);
+    }
+  }
+  bpm.FlushAllPages();
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, FreeSpaceMapTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  Fields fields{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+  remove(db_file_name.c_str());
+  page_id_t first_page_id;
+  page_id_t free_space_map_page_id;
+  page_id_t freed_page_id;
+  size_t num_pages;
+  {
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    first_page_id = table_heap->GetFirstPageId();
+    free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+    ASSERT_NE(INVALID_PAGE_ID, free_space_map_page_id);
+    std::vector<RowId> rids;
+    for (int i = 0; i < 5000; i++) {
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      rids.push_back(row.GetRowId());
+    }
+    num_pages = table_heap->GetFragmentation().GetNumPages();
+    ASSERT_GT(num_pages, 10);
+    // Empty a page in the middle of the table, once the last page is full inserts go there instead of a new page.
+    page_id_t last_page_id = rids.back().GetPageId();
+    freed_page_id = rids[rids.size() / 2].GetPageId();
+    for (auto &rid : rids) {
+      if (rid.GetPageId() == freed_page_id) {
+        table_heap->ApplyDelete(rid, nullptr);
+      }
+    }
+    Row row(fields);
+    do {
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    } while (row.GetRowId().GetPageId() == last_page_id);
+    ASSERT_EQ(freed_page_id, row.GetRowId().GetPageId());
+    // A row larger than a page has its value moved to overflow pages, the rest fits without growing the table.
+    std::vector<char> huge(PAGE_SIZE);
+    Fields huge_fields{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeChar, huge.data(), PAGE_SIZE, true)};
+    Row huge_row(huge_fields);
+    ASSERT_TRUE(table_heap->InsertTuple(huge_row, nullptr));
+    ASSERT_EQ(num_pages, table_heap->GetFragmentation().GetNumPages());
+    bpm.FlushAllPages();
+  }
+
+  // The map is persisted, a reopened table still fills the freed page first.
+  DiskManager disk_mgr(db_file_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  std::unique_ptr<TableHeap> table_heap(
+      TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id));
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  ASSERT_EQ(freed_page_id, row.GetRowId().GetPageId());
+  ASSERT_EQ(free_space_map_page_id, table_heap->GetFreeSpaceMapPageId());
+  // Without its map, the table rebuilds one from its pages.
+  std::unique_ptr<TableHeap> rebuilt(TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr));
+  rebuilt->LoadFreeSpaceMap();
+  ASSERT_NE(INVALID_PAGE_ID, rebuilt->GetFreeSpaceMapPageId());
+  ASSERT_NE(free_space_map_page_id, rebuilt->GetFreeSpaceMapPageId());
+  Row other_row(fields);
+  ASSERT_TRUE(rebuilt->InsertTuple(other_row, nullptr));
+  ASSERT_EQ(freed_page_id, other_row.GetRowId().GetPageId());
+  ASSERT_EQ(num_pages, rebuilt->GetFragmentation().GetNumPages());
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Insert row_nums rows one at a time into a new table, the cost of an insert must not grow with the number of pages.
+ */
+static void InsertRows(int row_nums) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("account", TypeId::kTypeFloat, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[32];
+  {
+    remove(db_file_name.c_str());
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    bpm.ResetStats();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < row_nums; i++) {
+      snprintf(name, sizeof(name), "name %d", i);
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true),
+                    Field(TypeId::kTypeFloat, static_cast<float>(i))};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t fetches = 0;
+    for (size_t i = 0; i < bpm.GetNumInstances(); i++) {
+      fetches += bpm.GetInstanceStats(i).fetches_;
+    }
+    double fetches_per_insert = static_cast<double>(fetches) / row_nums;
+    std::cout << row_nums << " rows: " << static_cast<size_t>(row_nums / seconds) << " rows/s, "
+              << fetches_per_insert << " page fetches per insert" << std::endl;
+    // The last page and the map page of its entry, the chain of pages is never walked.
+    ASSERT_LT(fetches_per_insert, 3);
+  }
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, InsertFetchesTest) { InsertRows(10000); }
+
+// Scenario: bulk loads of growing tables.
+TEST(TableHeapTest, DISABLED_InsertThroughputBenchmark) {
+  for (int row_nums : {1000, 10000, 100000, 1000000, 10000000}) {
+    InsertRows(row_nums);
+  }
+}
+
+TEST(TableHeapTest, BulkInsertTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  char name[64];
+  remove(db_file_name.c_str());
+  DiskManager disk_mgr(db_file_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+  auto make_rows = [&](int from, int to) {
+    std::vector<Row> rows;
+    for (int i = from; i < to; i++) {
+      snprintf(name, sizeof(name), "name %d", i);
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true)};
+      rows.emplace_back(fields);
+    }
+    return rows;
+  };
+  Fields first_fields{Field(TypeId::kTypeInt, -1), Field(TypeId::kTypeChar, name, 0, true)};
+  Row first_row(first_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(first_row, nullptr));
+
+  // The batch fills the last page first, then new pages, each fetched once.
+  std::vector<Row> rows = make_rows(0, 10000);
+  bpm.ResetStats();
+  ASSERT_EQ(rows.size(), table_heap->BulkInsert(rows, nullptr));
+  size_t fetches = 0;
+  for (size_t i = 0; i < bpm.GetNumInstances(); i++) {
+    fetches += bpm.GetInstanceStats(i).fetches_;
+  }
+  size_t num_pages = table_heap->GetFragmentation().GetNumPages();
+  ASSERT_LT(fetches, num_pages * 4);
+  ASSERT_EQ(first_row.GetRowId().GetPageId(), rows.front().GetRowId().GetPageId());
+  int expected = -1;
+  auto iter = table_heap->Begin(nullptr);
+  for (; iter != table_heap->End(); ++iter, expected++) {
+    ASSERT_TRUE(iter->GetField(0)->CompareEquals(Field(TypeId::kTypeInt, expected)));
+    if (expected >= 0) {
+      ASSERT_EQ(rows[expected].GetRowId(), iter->GetRowId());
+    }
+  }
+  ASSERT_EQ(10000, expected);
+
+  // A row larger than a page goes in with the batch, its value in overflow pages.
+  std::vector<char> huge(PAGE_SIZE);
+  std::vector<Row> huge_rows = make_rows(10000, 10010);
+  Fields huge_fields{Field(TypeId::kTypeInt, 0), Field(TypeId::kTypeChar, huge.data(), PAGE_SIZE, true)};
+  huge_rows.emplace_back(huge_fields);
+  ASSERT_EQ(huge_rows.size(), table_heap->BulkInsert(huge_rows, nullptr));
+  Row huge_row(huge_rows.back().GetRowId());
+  ASSERT_TRUE(table_heap->GetTuple(&huge_row, nullptr));
+  ASSERT_EQ(PAGE_SIZE, huge_row.GetField(1)->GetLength());
+  ASSERT_EQ(0, memcmp(huge.data(), huge_row.GetField(1)->GetData(), PAGE_SIZE));
+  // Later inserts go on after the batch.
+  Fields last_fields{Field(TypeId::kTypeInt, 10000), Field(TypeId::kTypeChar, name, 0, true)};
+  Row last_row(last_fields);
+  ASSERT_TRUE(table_heap->InsertTuple(last_row, nullptr));
+  ASSERT_EQ(huge_rows.back().GetRowId().GetPageId(), last_row.GetRowId().GetPageId());
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, VacuumTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 64, 1, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const int row_nums = 10000;
+  char name[64];
+  memset(name, 'x', sizeof(name));
+  remove(db_file_name.c_str());
+  page_id_t first_page_id;
+  page_id_t free_space_map_page_id;
+  {
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    first_page_id = table_heap->GetFirstPageId();
+    std::unordered_map<int32_t, RowId> rids;
+    for (int i = 0; i < row_nums; i++) {
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+      rids.emplace(i, row.GetRowId());
+    }
+    // Scenario: churn deletes two rows out of three, the deleted rows only get marked.
+    for (int i = 0; i < row_nums; i++) {
+      if (i % 3 != 0) {
+        ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+        rids.erase(i);
+      }
+    }
+    ASSERT_TRUE(table_heap->NeedsVacuum());
+    auto time_scan = [&]() {
+      auto start = std::chrono::steady_clock::now();
+      size_t num_rows = 0;
+      for (auto iter = table_heap->Begin(nullptr); iter != table_heap->End(); ++iter) {
+        num_rows++;
+      }
+      EXPECT_EQ(rids.size(), num_rows);
+      return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto count_fetches = [&]() {
+      bpm.ResetStats();
+      time_scan();
+      size_t fetches = 0;
+      for (size_t i = 0; i < bpm.GetNumInstances(); i++) {
+        fetches += bpm.GetInstanceStats(i).fetches_;
+      }
+      return fetches;
+    };
+    double scan_before = time_scan();
+    size_t fetches_before = count_fetches();
+
+    std::vector<std::pair<RowId, Row>> moved_rows;
+    VacuumReport report = table_heap->Vacuum(nullptr, moved_rows);
+    ASSERT_EQ(row_nums - rids.size(), report.num_purged_rows_);
+    ASSERT_EQ(moved_rows.size(), report.num_moved_rows_);
+    ASSERT_EQ(table_heap->GetFragmentation().GetNumPages(), report.num_pages_after_);
+    ASSERT_LE(report.num_pages_after_ * 2, report.num_pages_before_);
+    ASSERT_FALSE(table_heap->NeedsVacuum());
+    // The rows that stayed in their page kept their row ids.
+    for (auto &moved : moved_rows) {
+      int32_t id = std::stoi(moved.second.GetField(0)->toString());
+      ASSERT_EQ(rids[id], moved.first);
+      rids[id] = moved.second.GetRowId();
+    }
+    for (auto &iter : rids) {
+      Row row(iter.second);
+      ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+      ASSERT_EQ(std::to_string(iter.first), row.GetField(0)->toString());
+    }
+    double scan_after = time_scan();
+    size_t fetches_after = count_fetches();
+    std::cout << report.num_pages_before_ << " -> " << report.num_pages_after_ << " pages, scan " << scan_before * 1000
+              << " -> " << scan_after * 1000 << " ms, " << fetches_before << " -> " << fetches_after << " fetches"
+              << std::endl;
+    ASSERT_LT(fetches_after, fetches_before);
+    free_space_map_page_id = table_heap->GetFreeSpaceMapPageId();
+    bpm.FlushAllPages();
+  }
+
+  // The rebuilt free space map is persisted, new rows fill the last page of the compacted chain.
+  DiskManager disk_mgr(db_file_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  std::unique_ptr<TableHeap> table_heap(
+      TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr, free_space_map_page_id));
+  size_t num_pages = table_heap->GetFragmentation().GetNumPages();
+  Fields fields{Field(TypeId::kTypeInt, row_nums), Field(TypeId::kTypeChar, name, sizeof(name), true)};
+  Row row(fields);
+  ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+  ASSERT_EQ(num_pages, table_heap->GetFragmentation().GetNumPages());
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, OverflowTest) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("doc", TypeId::kTypeChar, 4 * PAGE_SIZE, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  const int row_nums = 300;
+  // Scenario: documents from a few bytes to a few pages long, next to a short name.
+  std::vector<std::string> docs;
+  for (int i = 0; i < 2 * row_nums; i++) {
+    docs.emplace_back((i * 397) % (3 * PAGE_SIZE), static_cast<char>('a' + i % 26));
+  }
+  remove(db_file_name.c_str());
+  DiskManager disk_mgr(db_file_name);
+  BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+  auto meta_page = reinterpret_cast<DiskFileMetaPage *>(disk_mgr.GetMetaData());
+  std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+  uint32_t num_pages_empty = meta_page->GetAllocatedPages();
+  std::unordered_map<int32_t, RowId> rids;
+  for (int i = 0; i < row_nums; i++) {
+    std::string name = "row " + std::to_string(i);
+    Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name.data(), name.size(), true),
+                  Field(TypeId::kTypeChar, docs[i].data(), docs[i].size(), true)};
+    Row row(fields);
+    ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    // The row of the caller keeps its values in row.
+    ASSERT_EQ(INVALID_PAGE_ID, row.GetField(2)->GetOverflowPageId());
+    rids.emplace(i, row.GetRowId());
+  }
+  auto check_rows = [&](bool fetch_overflow) {
+    size_t num_rows = 0;
+    size_t num_deferred = 0;
+    for (auto iter = table_heap->Begin(nullptr, fetch_overflow); iter != table_heap->End(); ++iter) {
+      Row row(*iter);
+      int32_t id = std::stoi(row.GetField(0)->toString());
+      EXPECT_EQ(rids[id], row.GetRowId());
+      EXPECT_EQ("row " + std::to_string(id), row.GetField(1)->toString());
+      EXPECT_EQ(docs[id].size(), row.GetField(2)->GetLength());
+      num_deferred += row.GetField(2)->IsDeferred();
+      EXPECT_TRUE(table_heap->FetchOverflow(&row, {2}));
+      EXPECT_FALSE(row.GetField(2)->IsDeferred());
+      EXPECT_EQ(docs[id], row.GetField(2)->toString());
+      num_rows++;
+    }
+    EXPECT_EQ(rids.size(), num_rows);
+    return num_deferred;
+  };
+  // A scan reads the overflow values only when asked to, a row read by its id has all of them.
+  ASSERT_EQ(0, check_rows(true));
+  ASSERT_GT(check_rows(false), row_nums / 2);
+  for (auto &iter : rids) {
+    Row row(iter.second);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    ASSERT_EQ(docs[iter.first], row.GetField(2)->toString());
+  }
+  uint32_t num_pages_full = meta_page->GetAllocatedPages();
+  ASSERT_GT(num_pages_full, num_pages_empty + row_nums);
+
+  // An update gives the row new overflow pages and frees the old ones, whether the row stays in its page or not.
+  for (int i = 0; i < row_nums; i += 2) {
+    Row row(rids[i]);
+    ASSERT_TRUE(table_heap->GetTuple(&row, nullptr));
+    std::swap(docs[i], docs[row_nums + i]);
+    Field doc(TypeId::kTypeChar, docs[i].data(), docs[i].size(), true);
+    *row.GetField(2) = doc;
+    ASSERT_TRUE(table_heap->UpdateTuple(row, rids[i], nullptr));
+    rids[i] = row.GetRowId();
+  }
+  check_rows(false);
+
+  // A vacuum frees the overflow pages of the deleted rows and keeps the ones of the moved rows.
+  for (int i = 0; i < row_nums; i++) {
+    if (i % 3 != 0) {
+      ASSERT_TRUE(table_heap->MarkDelete(rids[i], nullptr));
+      rids.erase(i);
+    }
+  }
+  std::vector<std::pair<RowId, Row>> moved_rows;
+  VacuumReport report = table_heap->Vacuum(nullptr, moved_rows);
+  ASSERT_FALSE(moved_rows.empty());
+  ASSERT_GT(report.num_freed_pages_, report.num_pages_before_ - report.num_pages_after_);
+  for (auto &moved : moved_rows) {
+    rids[std::stoi(moved.second.GetField(0)->toString())] = moved.second.GetRowId();
+  }
+  check_rows(false);
+  // The file keeps the table pages, and as many other pages as a table of only the rows left has: no overflow page of
+  // a deleted or updated value is left.
+  {
+    std::string fresh_file_name = "fresh_" + db_file_name;
+    remove(fresh_file_name.c_str());
+    DiskManager fresh_disk_mgr(fresh_file_name);
+    BufferPoolManager fresh_bpm(DEFAULT_BUFFER_POOL_SIZE, &fresh_disk_mgr);
+    auto fresh_meta_page = reinterpret_cast<DiskFileMetaPage *>(fresh_disk_mgr.GetMetaData());
+    std::unique_ptr<TableHeap> fresh_heap(TableHeap::Create(&fresh_bpm, schema.get(), nullptr, nullptr, nullptr));
+    for (auto &iter : rids) {
+      std::string name = "row " + std::to_string(iter.first);
+      Fields fields{Field(TypeId::kTypeInt, iter.first), Field(TypeId::kTypeChar, name.data(), name.size(), true),
+                    Field(TypeId::kTypeChar, docs[iter.first].data(), docs[iter.first].size(), true)};
+      Row row(fields);
+      ASSERT_TRUE(fresh_heap->InsertTuple(row, nullptr));
+    }
+    // The runs reserved for the segments and not handed out yet are not counted.
+    disk_mgr.ReleaseSegments();
+    fresh_disk_mgr.ReleaseSegments();
+    size_t num_other_pages = fresh_meta_page->GetAllocatedPages() - fresh_heap->GetFragmentation().GetNumPages();
+    ASSERT_EQ(num_other_pages + table_heap->GetFragmentation().GetNumPages(), meta_page->GetAllocatedPages());
+    ASSERT_LT(meta_page->GetAllocatedPages(), num_pages_full);
+    remove(fresh_file_name.c_str());
+  }
+
+  // Moving the pages of the file moves the overflow pages along, the rows follow them.
+  bpm.FlushAllPages();
+  auto moved_pages = bpm.CompactFile();
+  ASSERT_FALSE(moved_pages.empty());
+  table_heap->RelocatePages(moved_pages);
+  check_rows(false);
+
+  for (auto &iter : rids) {
+    ASSERT_TRUE(table_heap->MarkDelete(iter.second, nullptr));
+  }
+  rids.clear();
+  table_heap->Vacuum(nullptr, moved_rows);
+  // Not even the pages reserved for the table when it was created are left.
+  ASSERT_LE(meta_page->GetAllocatedPages(), num_pages_empty);
+  remove(db_file_name.c_str());
+}
+
+/**
+ * Scan a table of row_nums rows with a wide column stored in overflow pages, without and with the wide column.
+ */
+static void OverflowScan(int row_nums) {
+  std::vector<Column *> columns = {new Column("id", TypeId::kTypeInt, 0, false, false),
+                                   new Column("name", TypeId::kTypeChar, 32, 1, true, false),
+                                   new Column("doc", TypeId::kTypeChar, PAGE_SIZE, 2, true, false)};
+  auto schema = std::make_shared<Schema>(columns);
+  std::string doc(PAGE_SIZE / 2, 'd');
+  remove(db_file_name.c_str());
+  page_id_t first_page_id;
+  {
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, schema.get(), nullptr, nullptr, nullptr));
+    char name[32];
+    for (int i = 0; i < row_nums; i++) {
+      snprintf(name, sizeof(name), "name %d", i);
+      Fields fields{Field(TypeId::kTypeInt, i), Field(TypeId::kTypeChar, name, strlen(name), true),
+                    Field(TypeId::kTypeChar, doc.data(), doc.size(), true)};
+      Row row(fields);
+      ASSERT_TRUE(table_heap->InsertTuple(row, nullptr));
+    }
+    first_page_id = table_heap->GetFirstPageId();
+    std::cout << "table pages " << table_heap->GetFragmentation().GetNumPages() << " for " << row_nums
+              << " rows of " << doc.size() << " byte documents" << std::endl;
+    bpm.FlushAllPages();
+  }
+
+  // Scenario: scans from a fresh pool of the short columns of a table with a wide one, then of all the columns, which
+  // reads as many pages as when the wide column was stored in row.
+  double seconds[2];
+  uint64_t reads[2];
+  for (bool fetch_overflow : {false, true}) {
+    DiskManager disk_mgr(db_file_name);
+    BufferPoolManager bpm(DEFAULT_BUFFER_POOL_SIZE, &disk_mgr);
+    std::unique_ptr<TableHeap> table_heap(TableHeap::Create(&bpm, first_page_id, schema.get(), nullptr, nullptr));
+    int64_t rows = 0;
+    int64_t id_sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto iter = table_heap->Begin(nullptr, fetch_overflow); iter != table_heap->End(); ++iter) {
+      rows++;
+      id_sum += std::stoi(iter->GetField(0)->toString());
+    }
+    seconds[fetch_overflow] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ASSERT_EQ(row_nums, rows);
+    ASSERT_EQ(static_cast<int64_t>(row_nums) * (row_nums - 1) / 2, id_sum);
+    reads[fetch_overflow] = disk_mgr.GetIOStats().GetCount(PageClass::TABLE, IOType::READ);
+    std::cout << (fetch_overflow ? "all columns" : "short columns") << ": " << reads[fetch_overflow]
+              << " page reads, " << static_cast<size_t>(row_nums / seconds[fetch_overflow]) << " rows/s" << std::endl;
+  }
+  std::cout << "speedup " << seconds[1] / seconds[0] << std::endl;
+  ASSERT_LT(reads[0] * 10, reads[1]);
+  remove(db_file_name.c_str());
+}
+
+TEST(TableHeapTest, OverflowScanTest) { OverflowScan(500); }
+
+TEST(TableHeapTest, DISABLED_OverflowScanBenchmark) { OverflowScan(5000); }